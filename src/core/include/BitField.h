@@ -35,7 +35,9 @@ namespace MFM {
 
   /**
    * A field of up to 32 contiguous bits (64 for VD::BITS) of a
-   * BitVector, interpreted as some type VD:::Type
+   * BitVector, interpreted as some type VD:::Type.  Its position is
+   * fixed at compile time, so its Read and Write compile to a masked
+   * load or store (see BitVector::Read<POS,LEN>).
    */
   template <class BV, VD::Type VT, u32 LEN, u32 IDX>
   class BitField
@@ -72,7 +74,7 @@ namespace MFM {
      */
     static u32 Read(const BV & bv)
     {
-      return bv.Read(START,LENGTH);
+      return bv.template Read<START,LENGTH>();
     }
 
     /**
@@ -83,7 +85,7 @@ namespace MFM {
      */
     static void Write(BV & bv, u32 val)
     {
-      bv.Write(START,LENGTH,val);
+      bv.template Write<START,LENGTH>(val);
     }
 
     /**
@@ -97,7 +99,7 @@ namespace MFM {
      */
     static u64 ReadLong(const BV & bv)
     {
-      return bv.ReadLong(START,LENGTH);
+      return bv.template ReadLong<START,LENGTH>();
     }
 
     /**
@@ -108,7 +110,7 @@ namespace MFM {
      */
     static void WriteLong(BV & bv, u64 val)
     {
-      bv.WriteLong(START,LENGTH,val);
+      bv.template WriteLong<START,LENGTH>(val);
     }
 
     /**
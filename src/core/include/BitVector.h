@@ -31,7 +31,7 @@
 #include "itype.h"
 #include "ByteSink.h"
 #include "ByteSource.h"
-#include "Util.h"   /* for MakeMaskClip */
+#include "Util.h"   /* for MakeMaskClip, COMPILATION_REQUIREMENT */
 #include <climits>  /* for CHAR_BIT */
 #include <stdlib.h> /* for abort */
 
@@ -45,6 +45,58 @@ namespace MFM {
 
   typedef BitVector<8192> BV8K;
 
+  /**
+   * Compile-time access to a field of LEN bits starting FIRST bits
+   * into the 32-bit unit at units[0].  KIND is 0 for an empty field,
+   * 1 for one that fits in units[0], and 2 for one that straddles
+   * into units[1], which is handled as a single 64-bit window.
+   * Used by the BitVector::Read<POS,LEN> family.
+   */
+  template <u32 FIRST, u32 LEN, u32 KIND = (LEN == 0 ? 0 : (FIRST + LEN <= 32 ? 1 : 2))>
+  struct BitVectorUnitField
+  {
+    static u32 Read(const u32 * units) { return 0; }
+    static void Write(u32 * units, const u32 value) { }
+  };
+
+  template <u32 FIRST, u32 LEN>
+  struct BitVectorUnitField<FIRST, LEN, 1>
+  {
+    enum { SHIFT = 32 - (FIRST + LEN) };
+
+    static u32 Read(const u32 * units)
+    {
+      return (units[0] >> SHIFT) & MakeMaskClip(LEN);
+    }
+
+    static void Write(u32 * units, const u32 value)
+    {
+      const u32 mask = MakeMaskClip(LEN) << SHIFT;
+      units[0] = (units[0] & ~mask) | ((value << SHIFT) & mask);
+    }
+  };
+
+  template <u32 FIRST, u32 LEN>
+  struct BitVectorUnitField<FIRST, LEN, 2>
+  {
+    enum { SHIFT = 64 - (FIRST + LEN) };
+
+    static u32 Read(const u32 * units)
+    {
+      const u64 window = (((u64) units[0]) << 32) | units[1];
+      return (u32) (window >> SHIFT) & MakeMaskClip(LEN);
+    }
+
+    static void Write(u32 * units, const u32 value)
+    {
+      const u64 mask = ((u64) MakeMaskClip(LEN)) << SHIFT;
+      u64 window = (((u64) units[0]) << 32) | units[1];
+      window = (window & ~mask) | ((((u64) value) << SHIFT) & mask);
+      units[0] = (u32) (window >> 32);
+      units[1] = (u32) window;
+    }
+  };
+
   /**
    * A bit vector with reasonably fast operations
    *
@@ -272,6 +324,67 @@ namespace MFM {
 
     } //Write
 
+    /**
+     * Reads the LEN bits starting at POS, both fixed at compile time,
+     * in a single masked load when they lie within one storage unit,
+     * else in one 64-bit window over the two they straddle.  Checks
+     * nothing at runtime.
+     *
+     * @returns The bits read, right-justified.
+     *
+     * @sa Read(const u32, const u32)
+     */
+    template <u32 POS, u32 LEN>
+    inline u32 Read() const
+    {
+      COMPILATION_REQUIREMENT<(LEN <= 32 && POS + LEN <= B)>();
+      return BitVectorUnitField<POS % 32, LEN>::Read(m_bits + POS / 32);
+    }
+
+    /**
+     * Writes the low LEN bits of value to the LEN bits starting at
+     * POS, both fixed at compile time, as for Read<POS,LEN>().
+     *
+     * @sa Write(const u32, const u32, const u32)
+     */
+    template <u32 POS, u32 LEN>
+    inline void Write(const u32 value)
+    {
+      COMPILATION_REQUIREMENT<(LEN <= 32 && POS + LEN <= B)>();
+      BitVectorUnitField<POS % 32, LEN>::Write(m_bits + POS / 32, value);
+    }
+
+    /**
+     * Reads up to 64 bits starting at POS, both fixed at compile
+     * time.  \sa ReadLong(const u32, const u32)
+     */
+    template <u32 POS, u32 LEN>
+    inline u64 ReadLong() const
+    {
+      enum { FIRST_LEN = LEN < 32 ? LEN : 32, SECOND_LEN = LEN - FIRST_LEN };
+      u64 ret = Read<POS + SECOND_LEN, FIRST_LEN>();
+      if (SECOND_LEN > 0)
+      {
+        ret |= ((u64) Read<POS, SECOND_LEN>()) << FIRST_LEN;
+      }
+      return ret;
+    }
+
+    /**
+     * Writes up to 64 bits starting at POS, both fixed at compile
+     * time.  \sa WriteLong(const u32, const u32, const u64)
+     */
+    template <u32 POS, u32 LEN>
+    inline void WriteLong(const u64 value)
+    {
+      enum { FIRST_LEN = LEN < 32 ? LEN : 32, SECOND_LEN = LEN - FIRST_LEN };
+      Write<POS + SECOND_LEN, FIRST_LEN>((u32) value);
+      if (SECOND_LEN > 0)
+      {
+        Write<POS, SECOND_LEN>((u32) (value >> FIRST_LEN));
+      }
+    }
+
     /**
      * Reads up to 64 bits of a particular section of this BitVector.
      *
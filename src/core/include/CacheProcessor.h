@@ -34,6 +34,7 @@
 #include "Point.h"
 #include "Packet.h"
 #include "ChannelEnd.h"
+#include "SharedCacheChannel.h"
 #include "MDist.h"  /* for EVENT_WINDOW_SITES */
 #include "Logger.h"
 
@@ -152,6 +153,25 @@ namespace MFM {
      */
     bool m_useAdaptiveRedundancy;
 
+    /**
+       How many more untouched event window sites to pass over before
+       the next redundant CHECK of one.  Drawn afresh after each such
+       check, to average m_checkOdds - 1, so one untouched site in
+       m_checkOdds gets checked, as if each had been offered to
+       MaybeSendAtom.
+     */
+    u32 m_cleanSitesToSkip;
+
+    u32 DrawCleanSitesToSkip()
+    {
+      return (u32) GetTile().GetRandom().Between(0, 2 * (m_checkOdds - 1));
+    }
+
+    /**
+       Save atom, as of siteNumber, for shipment.
+     */
+    void QueueToSend(const T & atom, const T & prior, bool changed, u16 siteNumber) ;
+
     u32 GetCheckOdds() const
     {
       return m_checkOdds;
@@ -198,6 +218,7 @@ namespace MFM {
 
     struct CachePacketInfo {
       T m_atom;                // What to send
+      T m_prior;               // What the peer should have now, for deltas
       u16 m_siteNumber;        // Where it lives
       PacketTypeCode m_type;   // PACKET_UPDATE or PACKET_CHECK, currently
     };
@@ -275,6 +296,69 @@ namespace MFM {
      */
     ChannelEnd m_channelEnd;
 
+    /**
+       Or, when connected in-process, where to exchange whole cache
+       updates with our peer instead, and which side of it we're on.
+     */
+    SharedCacheChannel<EC> * m_sharedChannel;
+    bool m_onSideA;
+
+    /**
+       Delta encoding negotiation: whether we accept DELTAS packets
+       (and so will send them), whether our peer said it does, and
+       whether we have told our peer our current position.
+     */
+    bool m_deltaOffered;
+    bool m_peerAcceptsDeltas;
+    bool m_encodingsSent;
+
+    /**
+       Whether the update now shipping is being sent as DELTAS.
+     */
+    bool m_shippingDeltas;
+
+    /**
+       Active-side traffic, indexed by whether the update was sent as
+       DELTAS: total bytes (including packet length bytes) and number
+       of updates.
+     */
+    u64 m_shippedBytes[2];
+    u64 m_shippedUpdates[2];
+
+    /**
+       False if our last update found the remote cache inconsistent.
+       Deltas are only meaningful against a good remote cache, so
+       after that we ship full atoms until an update comes back clean.
+     */
+    bool m_lastReplyClean;
+
+    /**
+       Updates shipped again as full atoms by ResendWhole.
+     */
+    u64 m_wholeResends;
+
+    /**
+       Ship the update just sent as DELTAS again, every site as a full
+       CHECK atom.  A site whose digest didn't match is only reported
+       inconsistent by our peer, not repaired, and no later CHECK
+       could repair it while we keep shipping deltas, so this is done
+       before letting go of the locks.
+     */
+    void ResendWhole() ;
+
+    bool ShouldShipDeltas() const
+    {
+      return m_deltaOffered && m_peerAcceptsDeltas && m_lastReplyClean;
+    }
+
+    bool AdvanceSharedReceiving() ;
+
+    /**
+       The part of claiming a cache processor that doesn't depend on
+       how it's connected.  Returns true if we are on side A.
+     */
+    bool ClaimCommon(Tile<EC>& tile, LonglivedLock & lock, Dir toCache) ;
+
     void SetStateInternal(State state)
     {
       MFM_LOG_DBG6(("CP %s %s %d[%s %s %s] (%d,%d): %s->%s",
@@ -326,6 +410,7 @@ namespace MFM {
         break;
       case ADAPTIVE:
         m_useAdaptiveRedundancy = true;
+        break;
       default:
         FAIL(ILLEGAL_ARGUMENT);
       }
@@ -393,7 +478,73 @@ namespace MFM {
        Check if this atom is visible to far end cache, and if so,
        maybe save it for shipment.
      */
-    void MaybeSendAtom(const T & atom, bool changed, u16 siteNumber) ;
+    void MaybeSendAtom(const T & atom, const T & prior, bool changed, u16 siteNumber) ;
+
+    /**
+       Consider the sites of the event window that the event left
+       untouched, and so did not offer to MaybeSendAtom, for redundant
+       checks at the same odds.  Bit j of untouched stands for window
+       site firstSite + j.  Called once per window mask word, so the
+       cost is in the checks rather than in the sites.
+     */
+    void SpotCheckUntouched(u32 untouched, u32 firstSite) ;
+
+    /**
+       Offer (or stop offering) to exchange DELTAS packets with our
+       peer.  Deltas are used in both directions only when both
+       sides offer them.
+     */
+    void SetDeltaEncoding(bool offered)
+    {
+      m_deltaOffered = offered;
+      m_encodingsSent = false;
+    }
+
+    bool IsDeltaEncodingOffered() const
+    {
+      return m_deltaOffered;
+    }
+
+    /**
+       Return true if both we and our peer accept DELTAS packets.
+     */
+    bool IsDeltaEncodingNegotiated() const
+    {
+      return m_deltaOffered && m_peerAcceptsDeltas;
+    }
+
+    /**
+       Handle our peer's announcement of the PacketEncodings it accepts.
+     */
+    void ReceiveEncodings(u8 encodings)
+    {
+      m_peerAcceptsDeltas = (encodings & PacketEncoding::DELTA) != 0;
+    }
+
+    /**
+       Get what we hold at siteNumber relative to the event center of
+       the update being received, for applying deltas against.
+     */
+    const T & GetCachedAtom(u16 siteNumber) const ;
+
+    u64 GetShippedBytes(bool asDeltas) const
+    {
+      return m_shippedBytes[asDeltas ? 1 : 0];
+    }
+
+    u64 GetShippedUpdates(bool asDeltas) const
+    {
+      return m_shippedUpdates[asDeltas ? 1 : 0];
+    }
+
+    /**
+       Return how many DELTAS updates found the remote cache
+       inconsistent and were shipped again as full atoms.
+     */
+    u64 GetWholeResends() const
+    {
+      return m_wholeResends;
+    }
 
     /**
        Handle an inbound atom that our neighbor cache processor
@@ -414,7 +565,8 @@ namespace MFM {
 
     /**
        Handle the ACK that our neighbor cache processor sent us
-       in reply to our update end.
+       in reply to our update end.  An inconsistent reply to DELTAS
+       starts a ResendWhole rather than BLOCKING.
      */
     void ReceiveReply(u32 consistentCount) ;
 
@@ -449,31 +601,30 @@ namespace MFM {
 
     bool IsConnected() const
     {
-      return m_channelEnd.IsConnected();
+      return m_sharedChannel != 0 || m_channelEnd.IsConnected();
     }
 
-    void ClaimCacheProcessor(Tile<EC>& tile, AbstractChannel& channel, LonglivedLock & lock, Dir toCache)
+    /**
+       Return true if we exchange cache updates through a
+       SharedCacheChannel rather than as packets.
+     */
+    bool IsSharedChannel() const
     {
-      MFM_API_ASSERT_STATE(!m_tile && !m_longlivedLock);
-
-      m_tile = &tile;
-      m_longlivedLock = &lock;
-      m_cacheDir = toCache;
-      m_cpState = IDLE;
-
-      // Map their full untransformed origin to our full untransformed frame
-      bool isStaggered = m_tile->IsTileGridLayoutStaggered();
-      SPoint remoteOrigin;
-      Dirs::FillDir(remoteOrigin, m_cacheDir, isStaggered);
-
-      SPoint ownedph(m_tile->OWNED_WIDTH/2, m_tile->OWNED_HEIGHT/2);
-
-      m_farSideOrigin = remoteOrigin * ownedph;
+      return m_sharedChannel != 0;
+    }
 
-      bool onSideA = (m_cacheDir >= Dirs::NORTHEAST && m_cacheDir <= Dirs::SOUTH);
+    void ClaimCacheProcessor(Tile<EC>& tile, AbstractChannel& channel, LonglivedLock & lock, Dir toCache)
+    {
+      bool onSideA = ClaimCommon(tile, lock, toCache);
       m_channelEnd.ClaimChannelEnd(channel, onSideA);
     }
 
+    void ClaimCacheProcessor(Tile<EC>& tile, SharedCacheChannel<EC>& channel, LonglivedLock & lock, Dir toCache)
+    {
+      m_onSideA = ClaimCommon(tile, lock, toCache);
+      m_sharedChannel = &channel;
+    }
+
     void AssertConnected() const
     {
       MFM_API_ASSERT_STATE(m_tile && m_longlivedLock);
@@ -534,11 +685,22 @@ namespace MFM {
       , m_checkOdds(INITIAL_CHECK_ODDS)
       , m_remoteConsistentAtomCount(0)
       , m_useAdaptiveRedundancy(true)
+      , m_cleanSitesToSkip(0)
       , m_cpState(UNCLAIMED)
       , m_eventCenter(0,0)
       , m_farSideOrigin(0,0)
+      , m_sharedChannel(0)
+      , m_onSideA(false)
+      , m_deltaOffered(true)
+      , m_peerAcceptsDeltas(false)
+      , m_encodingsSent(false)
+      , m_shippingDeltas(false)
+      , m_lastReplyClean(true)
+      , m_wholeResends(0)
     {
       m_lockRegions[0] = (Dir) -1;
+      m_shippedBytes[0] = m_shippedBytes[1] = 0;
+      m_shippedUpdates[0] = m_shippedUpdates[1] = 0;
     }
 
   };
@@ -27,9 +27,51 @@ namespace MFM
     LOG.Log(level,"    ToSendCount: %d", m_toSendCount);
     LOG.Log(level,"    SentCount:   %d", m_sentCount);
 
+    if (m_sharedChannel)
+    {
+      LOG.Log(level,"    Shared channel side %s: %d updates, %d sites sent",
+              m_onSideA ? "A" : "B",
+              (u32) m_sharedChannel->GetUpdatesPosted(m_onSideA),
+              (u32) m_sharedChannel->GetSitesPosted(m_onSideA));
+      return;
+    }
+    LOG.Log(level,"    Delta encoding: %s",
+            IsDeltaEncodingNegotiated() ? "negotiated" :
+            (m_deltaOffered ? "offered" : "off"));
+    for (u32 d = 0; d < 2; ++d)
+    {
+      const u64 updates = m_shippedUpdates[d];
+      LOG.Log(level,"    %s updates: %d, %d bytes/update",
+              d ? "Delta" : "Full",
+              (u32) updates,
+              updates ? (u32) (m_shippedBytes[d] / updates) : 0);
+    }
+    LOG.Log(level,"    Whole resends: %d", (u32) m_wholeResends);
     m_channelEnd.ReportChannelEndStatus(level);
   }
 
+  template <class EC>
+  bool CacheProcessor<EC>::ClaimCommon(Tile<EC>& tile, LonglivedLock & lock, Dir toCache)
+  {
+    MFM_API_ASSERT_STATE(!m_tile && !m_longlivedLock);
+
+    m_tile = &tile;
+    m_longlivedLock = &lock;
+    m_cacheDir = toCache;
+    m_cpState = IDLE;
+
+    // Map their full untransformed origin to our full untransformed frame
+    bool isStaggered = m_tile->IsTileGridLayoutStaggered();
+    SPoint remoteOrigin;
+    Dirs::FillDir(remoteOrigin, m_cacheDir, isStaggered);
+
+    SPoint ownedph(m_tile->OWNED_WIDTH/2, m_tile->OWNED_HEIGHT/2);
+
+    m_farSideOrigin = remoteOrigin * ownedph;
+
+    return (m_cacheDir >= Dirs::NORTHEAST && m_cacheDir <= Dirs::SOUTH);
+  }
+
   template <class EC>
   bool CacheProcessor<EC>::IsSiteNumberVisible(u16 siteNumber)
   {
@@ -62,6 +104,13 @@ namespace MFM
     // Now it's about shipping
     SetStateInternal(SHIPPING);
 
+    if (m_sharedChannel)
+    {
+      return;  // The update begins when AdvanceShipping posts it whole
+    }
+
+    m_shippingDeltas = ShouldShipDeltas();
+
     PacketIO pbuffer;
     if (!pbuffer.SendUpdateBegin(*this, m_eventCenter))
     {
@@ -80,7 +129,7 @@ namespace MFM
   }
 
   template <class EC>
-  void CacheProcessor<EC>::MaybeSendAtom(const T & atom, bool changed, u16 siteNumber)
+  void CacheProcessor<EC>::MaybeSendAtom(const T & atom, const T & prior, bool changed, u16 siteNumber)
   {
     MFM_API_ASSERT_STATE(m_cpState == LOADING);
 
@@ -100,6 +149,40 @@ namespace MFM
       return;
     }
 
+    QueueToSend(atom, prior, changed, siteNumber);
+  }
+
+  template <class EC>
+  void CacheProcessor<EC>::SpotCheckUntouched(u32 untouched, u32 firstSite)
+  {
+    MFM_API_ASSERT_STATE(m_cpState == LOADING);
+
+    const MDist<R> & md = MDist<R>::get();
+    Tile<EC> & t = GetTile();
+
+    // Skip to each site due a check; carry the rest of the skip over
+    for (u32 here = PopCount(untouched); m_cleanSitesToSkip < here; here = PopCount(untouched))
+    {
+      for (u32 k = m_cleanSitesToSkip; k > 0; --k)
+      {
+        untouched &= untouched - 1;
+      }
+      const u16 siteNumber = (u16) (firstSite + __builtin_ctz(untouched)); // GCC
+      untouched &= untouched - 1;
+      m_cleanSitesToSkip = DrawCleanSitesToSkip();
+
+      if (IsSiteNumberVisible(siteNumber))
+      {
+        const T & atom = *t.GetAtom(md.GetPoint(siteNumber) + m_eventCenter);
+        QueueToSend(atom, atom, false, siteNumber);
+      }
+    }
+    m_cleanSitesToSkip -= PopCount(untouched);
+  }
+
+  template <class EC>
+  void CacheProcessor<EC>::QueueToSend(const T & atom, const T & prior, bool changed, u16 siteNumber)
+  {
     // Time to pack this puppy up for travel
     MFM_API_ASSERT_STATE(m_toSendCount < SITE_COUNT);  // You say ship a whole window or more?
 
@@ -120,6 +203,7 @@ namespace MFM
     CachePacketInfo & cpi = m_toSend[m_toSendCount++];
 
     cpi.m_atom = atom;
+    cpi.m_prior = prior;
     cpi.m_siteNumber = siteNumber;
     cpi.m_type = changed ? PacketType::UPDATE : PacketType::CHECK;
   }
@@ -138,6 +222,10 @@ namespace MFM
     u8 byte = (u8) plen;  // plen<128 since OString128..
     m_channelEnd.Write(&byte, 1);  // Packet length, then data
     m_channelEnd.Write((const u8 *) pb.GetBuffer(), plen);
+    if (m_cpState == SHIPPING)
+    {
+      m_shippedBytes[m_shippingDeltas ? 1 : 0] += plen + 1;
+    }
     return true;
   }
 
@@ -175,6 +263,14 @@ namespace MFM
     ++m_receivedSiteCount;
   }
 
+  template <class EC>
+  const typename CacheProcessor<EC>::T & CacheProcessor<EC>::GetCachedAtom(u16 siteNumber) const
+  {
+    MFM_API_ASSERT_STATE(m_cpState == PASSIVE && m_tile != 0);
+    const MDist<R> & md = MDist<R>::get();
+    return *m_tile->GetAtom(md.GetPoint(siteNumber) + m_eventCenter);
+  }
+
   template <class EC>
   void CacheProcessor<EC>::ApplyCacheUpdate()
   {
@@ -253,8 +349,15 @@ namespace MFM
     MFM_API_ASSERT_STATE(m_cpState == PASSIVE);
     MFM_LOG_DBG7(("Replying to UE, %d consistent",m_consistentAtomCount));
     ApplyCacheUpdate();
-    PacketIO pbuffer;
-    pbuffer.SendReply(m_consistentAtomCount, *this);
+    if (m_sharedChannel)
+    {
+      m_sharedChannel->PostReply(m_onSideA, m_consistentAtomCount);
+    }
+    else
+    {
+      PacketIO pbuffer;
+      pbuffer.SendReply(m_consistentAtomCount, *this);
+    }
     SetIdle();
   }
 
@@ -263,7 +366,8 @@ namespace MFM
   {
     MFM_API_ASSERT_STATE(m_cpState == RECEIVING);
 
-    if (consistentCount != m_toSendCount)
+    m_lastReplyClean = consistentCount == m_toSendCount;
+    if (!m_lastReplyClean)
     {
       ReportCheckFailure();
     }
@@ -282,9 +386,37 @@ namespace MFM
                   m_toSendCount,
                   m_checkOdds));
 
+    if (!m_lastReplyClean && m_shippingDeltas)
+    {
+      ResendWhole();
+      return;
+    }
     SetStateInternal(BLOCKING);
   }
 
+  template <class EC>
+  void CacheProcessor<EC>::ResendWhole()
+  {
+    MFM_API_ASSERT_STATE(m_cpState == RECEIVING && m_shippingDeltas);
+
+    // A CHECK places its atom if the peer's cache differs
+    for (u32 i = 0; i < m_toSendCount; ++i)
+    {
+      m_toSend[i].m_type = PacketType::CHECK;
+    }
+    ++m_wholeResends;
+
+    SetStateInternal(SHIPPING);
+    m_shippingDeltas = false;
+    m_sentCount = 0;
+
+    PacketIO pbuffer;
+    if (!pbuffer.SendUpdateBegin(*this, m_eventCenter))
+    {
+      FAIL(ILLEGAL_STATE);
+    }
+  }
+
   template <class EC>
   bool CacheProcessor<EC>::Advance()
   {
@@ -306,6 +438,13 @@ namespace MFM
                     GetStateName(m_cpState)));
     }
 
+    if (m_cpState == IDLE && !m_encodingsSent && m_channelEnd.IsConnected())
+    {
+      PacketIO pbuffer;
+      m_encodingsSent =
+        pbuffer.SendEncodings(m_deltaOffered ? PacketEncoding::DELTA : 0, *this);
+    }
+
     switch (m_cpState)
     {
     case SHIPPING: return AdvanceShipping();
@@ -345,8 +484,57 @@ namespace MFM
                   m_farSideOrigin.GetX(),
                   m_farSideOrigin.GetY()));
     bool didWork = false;
+
+    if (m_sharedChannel)
+    {
+      typename SharedCacheChannel<EC>::SharedUpdate * su =
+        m_sharedChannel->GetOutboundUpdate(m_onSideA);
+      if (!su)
+      {
+        return didWork;  // Peer hasn't taken the last one yet
+      }
+      su->m_center = LocalToRemote(m_eventCenter);
+      su->m_count = m_toSendCount;
+      for (u32 i = 0; i < m_toSendCount; ++i)
+      {
+        const CachePacketInfo & cpi = m_toSend[i];
+        typename SharedCacheChannel<EC>::SharedSite & ss = su->m_sites[i];
+        ss.m_atom = cpi.m_atom;
+        ss.m_siteNumber = cpi.m_siteNumber;
+        ss.m_isUpdate = cpi.m_type == PacketType::UPDATE;
+      }
+      m_sharedChannel->PostUpdate(m_onSideA);
+      m_sentCount = m_toSendCount;
+      SetStateInternal(RECEIVING);
+      return true;
+    }
+
     PacketIO pbuffer;
 
+    // Try to send any unsent sites, as many per packet as will fit
+    while (m_shippingDeltas && m_sentCount < m_toSendCount)
+    {
+      pbuffer.StartDeltas();
+      u32 packed = m_sentCount;
+      while (packed < m_toSendCount)
+      {
+        CachePacketInfo & cpi = m_toSend[packed];
+        if (!pbuffer.AddDelta(*this, cpi.m_type == PacketType::UPDATE,
+                              cpi.m_siteNumber, cpi.m_atom, cpi.m_prior))
+        {
+          break;
+        }
+        ++packed;
+      }
+      MFM_API_ASSERT_STATE(packed > m_sentCount);  // Even one site didn't fit?
+      if (!pbuffer.ShipDeltas(*this))
+      {
+        return didWork;
+      }
+      didWork = true;
+      m_sentCount = packed;
+    }
+
     // Try to send any unsent packets
     while (m_sentCount < m_toSendCount)
     {
@@ -376,6 +564,7 @@ namespace MFM
         return didWork;
       }
       didWork = true;
+      ++m_shippedUpdates[m_shippingDeltas ? 1 : 0];
     }
 
     SetStateInternal(RECEIVING);
@@ -391,6 +580,11 @@ namespace MFM
       return didWork;
     }
 
+    if (m_sharedChannel)
+    {
+      return AdvanceSharedReceiving();
+    }
+
     PacketIO pio;
     while (true)
     {
@@ -407,6 +601,35 @@ namespace MFM
     }
   }
 
+  template <class EC>
+  bool CacheProcessor<EC>::AdvanceSharedReceiving()
+  {
+    u32 consistentCount;
+    if (m_sharedChannel->TakeReply(m_onSideA, consistentCount))
+    {
+      ReceiveReply(consistentCount);
+      return true;
+    }
+
+    const typename SharedCacheChannel<EC>::SharedUpdate * su =
+      m_sharedChannel->GetInboundUpdate(m_onSideA);
+    if (!su)
+    {
+      return false;
+    }
+
+    // Same sequence HandlePacket would drive, minus the decoding
+    BeginUpdate(su->m_center);
+    for (u32 i = 0; i < su->m_count; ++i)
+    {
+      const typename SharedCacheChannel<EC>::SharedSite & ss = su->m_sites[i];
+      ReceiveAtom(ss.m_isUpdate, ss.m_siteNumber, ss.m_atom);
+    }
+    m_sharedChannel->ReleaseUpdate(m_onSideA);
+    ReceiveUpdateEnd();
+    return true;
+  }
+
   template <class EC>
   void CacheProcessor<EC>::Unblock()
   {
@@ -36,6 +36,7 @@ namespace MFM
 {
 
   template <class EC> class Element; // FORWARD
+  template <class EC> class UlamElement; // FORWARD
   template <class EC> class EventWindow; // FORWARD
 
   typedef u32 ElementType;
@@ -155,6 +156,19 @@ namespace MFM
      */
     const Element<EC> * Lookup(const u8 * symbol) const;
 
+    /**
+     * Gets the UlamElement stored in this ElementTable under a type,
+     * as Lookup(elementType)->AsUlamElement() would, but without the
+     * virtual call: each entry notes its UlamElement when inserted.
+     *
+     * @param elementType the type of the UlamElement to find.
+     *
+     * @returns A pointer to the immutable UlamElement of this type,
+     *          or NULL if there is no Element of this type or it is
+     *          not an UlamElement.
+     */
+    const UlamElement<EC> * LookupUlamElement(u32 elementType) const;
+
 #if 0 /* Now handled in eventwindow */
     /**
      * Executes the behavior method of the Element in the center of a
@@ -246,10 +260,12 @@ namespace MFM
     struct ElementEntry {
       void Clear() {
         m_element = 0;
+        m_ulamElement = 0;
         m_elementDataStart = 0;
         m_elementDataLength = 0;
       }
       const Element<EC>* m_element;
+      const UlamElement<EC>* m_ulamElement;  // m_element->AsUlamElement()
       u16 m_elementDataStart;
       u16 m_elementDataLength;
     } m_hash[SIZE];
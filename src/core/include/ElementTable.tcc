@@ -46,6 +46,7 @@ namespace MFM {
       if (++m_hashSlotsInUse > SIZE/2)
         FAIL(OUT_OF_ROOM);
       m_hash[slotFor].m_element = &theElement;
+      m_hash[slotFor].m_ulamElement = theElement.AsUlamElement();
 
     }
   }
@@ -65,6 +66,7 @@ namespace MFM {
     //    MFM_ASSERT_API_STATE(old != &newEmptyElement);   // Must not be the same guy (can we require this?  loses idempotency)
 
     m_hash[eslot].m_element = &newEmptyElement; // And so the deed is done; have mercy on our souls.
+    m_hash[eslot].m_ulamElement = newEmptyElement.AsUlamElement();
 
     return old;
   }
@@ -76,6 +78,12 @@ namespace MFM {
     return m_hash[SlotFor(elementType)].m_element;
   }
 
+  template <class EC>
+  const UlamElement<EC> * ElementTable<EC>::LookupUlamElement(u32 elementType) const
+  {
+    return m_hash[SlotFor(elementType)].m_ulamElement;
+  }
+
   template <class EC>
   const Element<EC> * ElementTable<EC>::Lookup(const u8 * symbol) const
   {
@@ -56,6 +56,13 @@ namespace MFM {
      */
     enum { EVENT_WINDOW_RADIUS = R };
 
+    /**
+     * SITE_STATS is nonzero if the SITE keeps per-site event
+     * statistics.  When it does not, site event counts and ages all
+     * read as zero, and events are never rejected on recency.
+     */
+    enum { SITE_STATS = SITE::SITE_STATS };
+
     /**
      * ELEMENT_TYPE_BITS is the number of bits used to represent an
      * element type number.  For now we're hardcoding this at 16,
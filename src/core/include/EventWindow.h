@@ -37,6 +37,10 @@
 #include "Base.h"
 #include "ByteSink.h"
 #include "BitStorage.h"
+#include "SiteClaimMap.h"
+#ifdef __SSE2__
+#include <emmintrin.h>  /* For MatchTypeLanes */
+#endif
 
 namespace MFM
 {
@@ -97,6 +101,13 @@ namespace MFM
     enum { R = EC::EVENT_WINDOW_RADIUS };
   public:
     enum { SITE_COUNT = EVENT_WINDOW_SITES(R) };
+
+    /**
+     * The number of u32s in a SiteMask, which has one bit per window
+     * index, with index i at bit i % 32 of word i / 32.
+     */
+    enum { SITE_MASK_WORDS = (SITE_COUNT + 31) / 32 };
+    typedef u32 SiteMask[SITE_MASK_WORDS];
     enum {MAX_LOCK_DIRS = 3 };
     typedef Dir THREEDIR[MAX_LOCK_DIRS]; //copy of CacheProcessor.h
 
@@ -115,9 +126,20 @@ namespace MFM
     u64 m_eventWindowsAttempted;
     u64 m_eventWindowsExecuted;
     u64 m_eventWindowSitesAccessed; // Sum of within-boundary sites
+    u64 m_emptyCenterEvents;        // Executed events retired by the empty fast path
+
+    u8 m_claimOwner;   // Our id in the tile's SiteClaimMap, if it has one
+    Random * m_random; // Our own PRNG, or null to use the tile's
 
     void RecordEventAtTileCoord(const SPoint tcoord) ;
 
+    /**
+     * The body of TryEventAt, once the center is claimed (if claims
+     * is non-null).  Claims the rest of the window if the event gets
+     * that far; TryEventAt releases whatever was claimed.
+     */
+    bool TryClaimedEventAt(const SPoint & tcenter, SiteClaimMap<R> * claims) ;
+
     /**
      * Note the atom buffer is maintained in 'direct' coordinates, as
      * if the chosen symmetry is always PSYM_NORMAL.  For accesses by
@@ -127,6 +149,72 @@ namespace MFM
     AtomBitStorage<EC>  m_atomBuffer[SITE_COUNT];
     bool m_isLiveSite[SITE_COUNT];
 
+    /**
+     * m_siteOffsets[i] is the distance, in the tile's site planes,
+     * from the event center to the site at window index i.  The tile
+     * width never changes, so this is computed once, at construction.
+     */
+    s32 m_siteOffsets[SITE_COUNT];
+
+    /**
+     * One bit per window index, set for every site the behavior may
+     * have written, so StoreToTile need not compare or place the
+     * others; the cache processors just sample those for redundant
+     * checks.  Handing out a modifiable AtomBitStorage counts as a
+     * write.
+     */
+    enum { DIRTY_WORDS = SITE_MASK_WORDS };
+    SiteMask m_dirtySites;
+
+    /**
+     * m_siteTypes[i] is the type of the atom LoadFromTile put at
+     * window index i, packed so MatchTypeDirect can compare a whole
+     * mask word's worth of sites at once.  It goes stale at dirty
+     * sites.  Entries past SITE_COUNT are padding, never live.
+     */
+    u16 m_siteTypes[32 * SITE_MASK_WORDS];
+
+    /**
+     * m_isLiveSite as a SiteMask, with bits only within the boundary
+     */
+    SiteMask m_liveSites;
+
+    void MarkSiteDirty(u32 siteNumber)
+    {
+      m_dirtySites[siteNumber / 32] |= 1u << (siteNumber % 32);
+    }
+
+    void ClearDirtySites()
+    {
+      for (u32 i = 0; i < DIRTY_WORDS; m_dirtySites[i++] = 0);
+    }
+
+    bool IsSiteDirty(u32 siteNumber) const
+    {
+      return (m_dirtySites[siteNumber / 32] >> (siteNumber % 32)) & 1;
+    }
+
+    /**
+     * A bit for each of the 32 types at types, set if it is type
+     */
+    static u32 MatchTypeLanes(const u16 * types, const u32 type) ;
+
+    /**
+     * The bits of SiteMask word w for window indices first through
+     * last
+     */
+    static u32 SiteRangeMask(u32 w, u32 first, u32 last)
+    {
+      const u32 lo = 32 * w, hi = lo + 31;
+      if (last < lo || first > hi) return 0;
+      u32 mask = 0xffffffff;
+      if (first > lo) mask &= 0xffffffff << (first - lo);
+      if (last < hi) mask &= 0xffffffff >> (hi - last);
+      return mask;
+    }
+
+    void InitSiteOffsets() ;
+
     Base<AC> m_centerBase;
 
     SPoint m_center;
@@ -260,7 +348,7 @@ namespace MFM
      */
     bool InitForEvent(const SPoint & center, bool tryForLocks = true) ;
 
-    const Site<AC> & GetSite() const
+    typename Tile<EC>::CONST_SITE_REF GetSite() const
     {
       return GetTile().GetSite(m_center);
     }
@@ -290,6 +378,16 @@ namespace MFM
       return m_eventWindowSitesAccessed;
     }
 
+    /**
+     * Gets the number of executed events whose center was empty, and
+     * so were retired without locks or a window load.  These are
+     * included in GetEventWindowsExecuted().
+     */
+    u64 GetEmptyCenterEvents() const
+    {
+      return m_emptyCenterEvents;
+    }
+
     void SetEventWindowsAttempted(u64 attempts)
     {
       m_eventWindowsAttempted = attempts;
@@ -448,7 +546,27 @@ namespace MFM
      */
     Random & GetRandom()
     {
-      return GetTile().GetRandom();
+      return m_random ? *m_random : GetTile().GetRandom();
+    }
+
+    /**
+     * The id this EventWindow claims sites under when its tile runs
+     * several event windows at once.  The tile's own window is
+     * PRIMARY_CLAIM_OWNER.
+     */
+    enum { PRIMARY_CLAIM_OWNER = 1 };
+
+    /**
+     * Make this an additional, concurrent, event window for its tile,
+     * with claimOwner as its id in the tile's SiteClaimMap, and
+     * drawing its random numbers from random rather than the tile's
+     * PRNG.
+     */
+    void SetConcurrentIdentity(u8 claimOwner, Random & random)
+    {
+      MFM_API_ASSERT_ARG(claimOwner > PRIMARY_CLAIM_OWNER);
+      m_claimOwner = claimOwner;
+      m_random = &random;
     }
 
     /**
@@ -542,6 +660,28 @@ namespace MFM
       return m_isLiveSite[siteNumber];
     }
 
+    /**
+     * Find the live sites, among window indices first through last
+     * (using the direct mapping), that hold an atom of a given type.
+     * Compares the types LoadFromTile packed for every site at once,
+     * rechecking only sites the behavior may have written since.
+     *
+     * @param matches Set to have bit i set for each such index i, and
+     *                no others.
+     *
+     * @returns The number of such sites.
+     *
+     * FAILs with ILLEGAL_ARGUMENT if first > last or last is outside
+     * the boundary.
+     */
+    u32 MatchTypeDirect(const u32 type, const u32 first, const u32 last, SiteMask & matches) const ;
+
+    /**
+     * @returns The window index of the nth (counting from 0) bit set
+     *          in matches, which must have more than n bits set.
+     */
+    static u32 SelectSiteDirect(const SiteMask & matches, u32 n) ;
+
     /**
      * Constructs a new EventWindow which takes place on a specified
      * Tile with the default PointSymmetry of PSYM_NORMAL .
@@ -585,7 +725,9 @@ namespace MFM
      */
     AtomBitStorage<EC>& GetAtomBitStorage(u32 siteNumber)
     {
-      return m_atomBuffer[MapIndexToIndexSymValid(siteNumber)];
+      u32 idx = MapIndexToIndexSymValid(siteNumber);
+      MarkSiteDirty(idx);
+      return m_atomBuffer[idx];
     }
 
     /**
@@ -603,6 +745,7 @@ namespace MFM
      */
     AtomBitStorage<EC>& GetCenterAtomBitStorage()
     {
+      MarkSiteDirty(0);
       return m_atomBuffer[0];
     }
 
@@ -658,6 +801,7 @@ namespace MFM
     void SetAtomDirect(u32 siteNumber, const T & newAtom)
     {
       MFM_API_ASSERT_ARG(siteNumber < SITE_COUNT);
+      MarkSiteDirty(siteNumber);
       m_atomBuffer[siteNumber].WriteAtom(newAtom);
     }
 
@@ -667,7 +811,7 @@ namespace MFM
      */
     void SetAtomSym(u32 siteNumber, const T & newAtom)
     {
-      m_atomBuffer[MapIndexToIndexSymValid(siteNumber)].WriteAtom(newAtom);
+      SetAtomDirect(MapIndexToIndexSymValid(siteNumber), newAtom);
     }
 
     /**
@@ -679,6 +823,7 @@ namespace MFM
      */
     void SetCenterAtomDirect(const T& atom)
     {
+      MarkSiteDirty(0);
       m_atomBuffer[0].WriteAtom(atom);
     }
 
@@ -692,6 +837,7 @@ namespace MFM
      */
     void SetCenterAtomSym(const T& atom)
     {
+      MarkSiteDirty(0);
       m_atomBuffer[0].WriteAtom(atom);
     }
 
@@ -55,11 +55,53 @@ namespace MFM {
 
     ++m_eventWindowsAttempted;
 
+    // With concurrent windows, first claim the center, which is all
+    // the empty fast path looks at
+    SiteClaimMap<R> * claims = t.GetSiteClaims();
+    if (claims && !claims->TryClaim(tcenter, m_claimOwner, 1))
+    {
+      return false;
+    }
+
+    const bool executed = TryClaimedEventAt(tcenter, claims);
+
+    if (claims)
+    {
+      claims->Release(tcenter, m_claimOwner);
+    }
+    return executed;
+  }
+
+  template <class EC>
+  bool EventWindow<EC>::TryClaimedEventAt(const SPoint & tcenter, SiteClaimMap<R> * claims)
+  {
+    Tile<EC> & t = GetTile();
+
+    // Recency filtering comes first, so empty and occupied centers
+    // are selected alike, and event ages mean the same either way
     if (RejectOnRecency(tcenter))
     {
       return false;
     }
 
+    // An empty center has no behavior to run, so retire the event
+    // right away, skipping locks and the window load.  The center is
+    // owned, and owned sites are only written by this tile's threads,
+    // under claims if there are several, so it is safe to peek at it
+    // without a lock.
+    const T & catom = t.GetSite(tcenter).GetAtom();
+    if (catom.GetType() == T::ATOM_EMPTY_TYPE && catom.IsSane())
+    {
+      ++m_emptyCenterEvents;
+      RecordEventAtTileCoord(tcenter);
+      return true;
+    }
+
+    if (claims && !claims->TryClaim(tcenter, m_claimOwner, SITE_COUNT))
+    {
+      return false;
+    }
+
     if (!InitForEvent(tcenter))
     {
       return false;
@@ -80,14 +122,23 @@ namespace MFM {
     ++m_eventWindowsExecuted;
 
     SPoint owned = Tile<EC>::TileCoordToOwned(tcoord);
-    t.m_lastEventCenterOwned = owned;
+    if (m_claimOwner == PRIMARY_CLAIM_OWNER)
+    {
+      t.m_lastEventCenterOwned = owned;
+    }
     //t.GetSite(owned).SetLastEventEventNumber(m_eventWindowsExecuted);
-    t.GetSite(tcoord).RecordEventAtSite(m_eventWindowsExecuted);
+
+    // Number site events by the tile-wide count, which is what
+    // GetUncachedEventAge measures ages against.  With one window
+    // that is just m_eventWindowsExecuted, as it always was; with
+    // several, a window's own count would make ages meaningless.
+    t.GetSite(tcoord).RecordEventAtSite(t.GetEventsExecuted());
   }
 
   template <class EC>
   bool EventWindow<EC>::RejectOnRecency(const SPoint tcoord)
   {
+    if (!EC::SITE_STATS) return false;  // No event ages to go by
     Tile<EC> & t = GetTile();
     MFM_API_ASSERT_STATE(!t.IsDummyTile()); //sanity
     const u32 warpFactor = t.GetWarpFactor();
@@ -271,7 +322,8 @@ namespace MFM {
 
     SetBoundary(m_element->GetEventWindowBoundary());
 
-    if (tryForLocks && !AcquireAllLocks(center, m_eventWindowBoundary))
+    // A sequential tile's neighbors are never running, so it needs no locks
+    if (tryForLocks && !tile.IsSequential() && !AcquireAllLocks(center, m_eventWindowBoundary))
     {
       MFM_LOG_DBG6(("EW::InitForEvent (%d,%d) %s - abandoned",
 		    center.GetX(),center.GetY(),
@@ -489,6 +541,9 @@ namespace MFM {
     , m_eventWindowsAttempted(0)
     , m_eventWindowsExecuted(0)
     , m_eventWindowSitesAccessed(0)
+    , m_emptyCenterEvents(0)
+    , m_claimOwner(PRIMARY_CLAIM_OWNER)
+    , m_random(0)
     , m_center(0,0)
     , m_sym(PSYM_NORMAL)
     , m_ewState(FREE)
@@ -496,11 +551,28 @@ namespace MFM {
     m_cpli.Shuffle(GetRandom());
 
     for (u32 i = 0; i < SITE_COUNT; m_isLiveSite[i++] = false);
+    for (u32 i = 0; i < 32 * SITE_MASK_WORDS; m_siteTypes[i++] = 0);
+    for (u32 i = 0; i < SITE_MASK_WORDS; m_liveSites[i++] = 0);
+
+    ClearDirtySites();
+    InitSiteOffsets();
 
     for (u32 i = 0; i < MAX_CACHES_TO_UPDATE; m_cacheProcessorsLocked[i++] = 0);
 
   }
 
+  template <class EC>
+  void EventWindow<EC>::InitSiteOffsets()
+  {
+    const s32 width = (s32) GetTile().GetTileWidth();
+    const MDist<R> & md = MDist<R>::get();
+    for (u32 i = 0; i < SITE_COUNT; ++i)
+    {
+      const SPoint & pt = md.GetPoint(i);
+      m_siteOffsets[i] = pt.GetY() * width + pt.GetX();
+    }
+  }
+
   template <class EC>
   SPoint EventWindow<EC>::MapToTileSymValid(const SPoint& offset) const
   {
@@ -528,17 +600,128 @@ namespace MFM {
   {
     Tile<EC> & tile = GetTile();
 
-    m_centerBase = tile.GetSite(m_center).GetBase();
+    ClearDirtySites();
+
+    const u32 center = tile.GetSiteInTileNumber(m_center);
+    m_centerBase = tile.GetPlaneBase(center);
+
+    // If the whole window is owned, every site is live and no
+    // coordinate checks are needed: just gather along the offsets
+    const s32 reach = 2 * R;
+    const s32 x = m_center.GetX(), y = m_center.GetY();
+    if (x >= reach && x < (s32) tile.GetTileWidth() - reach &&
+        y >= reach && y < (s32) tile.GetTileHeight() - reach &&
+        !tile.IsForegroundRadiationEnabled())
+    {
+      for (u32 i = 0; i < m_boundedSiteCount; ++i)
+      {
+        const T & atom = tile.GetPlaneAtom(center + m_siteOffsets[i]);
+        m_atomBuffer[i].WriteAtom(atom);
+        m_siteTypes[i] = atom.GetType();
+        m_isLiveSite[i] = true;
+      }
+      for (u32 w = 0; w < SITE_MASK_WORDS; ++w)
+      {
+        m_liveSites[w] = SiteRangeMask(w, 0, m_boundedSiteCount - 1);
+      }
+      return;
+    }
+
+    for (u32 w = 0; w < SITE_MASK_WORDS; m_liveSites[w++] = 0);
+
     const MDist<R> & md = MDist<R>::get();
     for (u32 i = 0; i < m_boundedSiteCount; ++i)
     {
       const SPoint & pt = md.GetPoint(i) + m_center;
       //m_atomBuffer[i] = tile.GetAtomForEventWindow(pt);
-      m_atomBuffer[i].WriteAtom(tile.GetAtomForEventWindow(pt));
+      const T & atom = tile.GetAtomForEventWindow(pt);
+      m_atomBuffer[i].WriteAtom(atom);
+      m_siteTypes[i] = atom.GetType();
       m_isLiveSite[i] = tile.IsLiveSite(pt);
+      m_liveSites[i / 32] |= (u32) m_isLiveSite[i] << (i % 32);
     }
   }
 
+  template <class EC>
+  u32 EventWindow<EC>::MatchTypeDirect(const u32 type, const u32 first, const u32 last,
+                                       SiteMask & matches) const
+  {
+    MFM_API_ASSERT_ARG(first <= last && last < m_boundedSiteCount);
+
+    for (u32 w = 0; w < SITE_MASK_WORDS; matches[w++] = 0);
+
+    u32 count = 0;
+    for (u32 w = first / 32; w <= last / 32; ++w)
+    {
+      u32 bits = MatchTypeLanes(&m_siteTypes[32 * w], type);
+
+      for (u32 dirty = m_dirtySites[w]; dirty != 0; dirty &= dirty - 1)
+      {
+        const u32 j = __builtin_ctz(dirty);
+        if (m_atomBuffer[32 * w + j].GetAtom().GetType() == type)
+        {
+          bits |= 1u << j;
+        }
+        else
+        {
+          bits &= ~(1u << j);
+        }
+      }
+
+      bits &= m_liveSites[w] & SiteRangeMask(w, first, last);
+      matches[w] = bits;
+      count += PopCount(bits);
+    }
+    return count;
+  }
+
+  template <class EC>
+  u32 EventWindow<EC>::MatchTypeLanes(const u16 * types, const u32 type)
+  {
+    if (type > U16_MAX)
+    {
+      return 0;
+    }
+#ifdef __SSE2__
+    // Compare 8 lanes per instruction, then pack the 0/0xffff
+    // results to bytes and gather their high bits
+    const __m128i key = _mm_set1_epi16((s16) type);
+    const __m128i * lanes = (const __m128i *) types;
+    const __m128i lo = _mm_packs_epi16(_mm_cmpeq_epi16(_mm_loadu_si128(lanes + 0), key),
+                                       _mm_cmpeq_epi16(_mm_loadu_si128(lanes + 1), key));
+    const __m128i hi = _mm_packs_epi16(_mm_cmpeq_epi16(_mm_loadu_si128(lanes + 2), key),
+                                       _mm_cmpeq_epi16(_mm_loadu_si128(lanes + 3), key));
+    return (u32) _mm_movemask_epi8(lo) | ((u32) _mm_movemask_epi8(hi) << 16);
+#else
+    u32 bits = 0;
+    for (u32 j = 0; j < 32; ++j)
+    {
+      bits |= (u32) (types[j] == type) << j;
+    }
+    return bits;
+#endif
+  }
+
+  template <class EC>
+  u32 EventWindow<EC>::SelectSiteDirect(const SiteMask & matches, u32 n)
+  {
+    for (u32 w = 0; w < SITE_MASK_WORDS; ++w)
+    {
+      u32 bits = matches[w];
+      const u32 here = PopCount(bits);
+      if (n < here)
+      {
+        while (n-- > 0)
+        {
+          bits &= bits - 1;
+        }
+        return 32 * w + __builtin_ctz(bits);
+      }
+      n -= here;
+    }
+    FAIL(ILLEGAL_ARGUMENT);
+  }
+
   template <class EC>
   void EventWindow<EC>::StoreToTile()
   {
@@ -565,35 +748,63 @@ namespace MFM {
 
     // Record the event in the tile history
     EventHistoryBuffer<EC> & ehb = tile.GetEventHistoryBuffer();
-    ehb.AddEventWindow(*this);
+    {
+      typename Tile<EC>::WindowSharedScope shared(tile);
+      ehb.AddEventWindow(*this);
+    }
 
     // Write back base changes if any
-    tile.GetSite(m_center).GetBase() = m_centerBase;
+    const u32 center = tile.GetSiteInTileNumber(m_center);
+    tile.GetPlaneBase(center) = m_centerBase;
 
-    for (u32 i = 0; i < m_boundedSiteCount; ++i)
+    // Only sites the behavior may have written need storing
+    for (u32 w = 0; w < DIRTY_WORDS; ++w)
     {
-      const SPoint & pt = md.GetPoint(i) + m_center;
-      bool dirty = false;
-      if (m_isLiveSite[i])
+      for (u32 bits = m_dirtySites[w]; bits != 0; bits &= bits - 1)
       {
-        //if (m_atomBuffer[i] != *tile.GetAtom(pt))
-	if (m_atomBuffer[i].GetAtom() != *tile.GetAtom(pt))
+        const u32 i = w * 32 + __builtin_ctz(bits); // GCC
+        if (i >= m_boundedSiteCount || !m_isLiveSite[i])
         {
+          continue;
+        }
+
+        const u32 site = center + m_siteOffsets[i];
+        const T prior = tile.GetPlaneAtom(site);  // What the CPs' peers have now
+        bool dirty = false;
+        if (m_atomBuffer[i].GetAtom() != prior)
+        {
+          const SPoint & pt = md.GetPoint(i) + m_center;
           tile.PlaceAtom(m_atomBuffer[i].GetAtom(), pt);
           dirty = true;
+          if (tile.IsSequential())
+          {
+            tile.WriteThrough(pt);
+          }
         }
 
-        // Let the CPs see even some unchanged atoms, for spot checks
+        // Let the CPs see written-but-unchanged atoms, for spot checks
         for (u32 j = 0; j < MAX_CACHES_TO_UPDATE; ++j)
         {
           if (m_cacheProcessorsLocked[j] != 0)
           {
-            m_cacheProcessorsLocked[j]->MaybeSendAtom( *tile.GetAtom(pt), dirty, i);
+            m_cacheProcessorsLocked[j]->MaybeSendAtom(tile.GetPlaneAtom(site), prior, dirty, i);
           }
         }
       }
     }
 
+    // The untouched sites still get their share of redundant checks
+    for (u32 j = 0; j < MAX_CACHES_TO_UPDATE; ++j)
+    {
+      if (m_cacheProcessorsLocked[j] != 0)
+      {
+        for (u32 w = 0; w < DIRTY_WORDS; ++w)
+        {
+          m_cacheProcessorsLocked[j]->SpotCheckUntouched(m_liveSites[w] & ~m_dirtySites[w], 32 * w);
+        }
+      }
+    }
+
     MFM_LOG_DBG6(("EW::StoreToTile releasing %s",tile.GetLabel()));
     // Finally, release the cache processors to take it from here
     for (m_cpli.ShuffleOrReset(random); m_cpli.HasNext(); )
@@ -616,6 +827,7 @@ namespace MFM {
     if (m_isLiveSite[idx])
     {
       //m_atomBuffer[idx] = atom;
+      MarkSiteDirty(idx);
       m_atomBuffer[idx].WriteAtom(atom); //a copy
       return true;
     }
@@ -630,6 +842,7 @@ namespace MFM {
     if (m_isLiveSite[idx])
     {
       //m_atomBuffer[idx] = atom;
+      MarkSiteDirty(idx);
       m_atomBuffer[idx].WriteAtom(atom);
       return true;
     }
@@ -683,6 +896,9 @@ namespace MFM {
     MFM_API_ASSERT_ARG(idxa < m_boundedSiteCount);
     MFM_API_ASSERT_ARG(idxb < m_boundedSiteCount);
 
+    MarkSiteDirty(idxa);
+    MarkSiteDirty(idxb);
+
     T tmp = m_atomBuffer[idxa].GetAtom();
     //m_atomBuffer[idxa] = m_atomBuffer[idxb];
     //m_atomBuffer[idxb] = tmp;
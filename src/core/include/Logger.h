@@ -33,9 +33,11 @@
 #include "ByteSerializable.h"
 #include "Util.h"
 #include "Mutex.h"
+#include <pthread.h> /* for pthread_t, pthread_key_t */
 #include <stdarg.h>
 #include <strings.h> /* for strcasecmp */
 #include <stdlib.h>  /* for abort(), strtol() */
+#include <time.h>    /* for struct timespec, clock_gettime */
 
 #define MFM_LOG_DBG3(args) do {if (__builtin_expect(LOG.IfLog((Logger::Level) 3),0)) {LOG.Message args ;}} while (0)
 #define MFM_LOG_DBG4(args) do {if (__builtin_expect(LOG.IfLog((Logger::Level) 4),0)) {LOG.Debug args ;}} while (0)
@@ -293,12 +295,76 @@ namespace MFM
       m_sink(&sink),
       m_logLevel(initialLevel),
       m_includeFlags(INCLUDE_ALL),
-      m_timeStamper(&m_defaultTimeStamper)
+      m_defaultTimeStamper(*this),
+      m_timeStamper(&m_defaultTimeStamper),
+      m_async(false),
+      m_drainerRunning(false),
+      m_stopDrainer(false),
+      m_ringKeyMade(false),
+      m_rings(0),
+      m_stampSequence(0),
+      m_droppedRecords(0),
+      m_reportedDrops(0),
+      m_forkGeneration(0)
     {
     }
 
-    ~Logger()
+    ~Logger() ;
+
+    /**
+     * The number of records each thread can have waiting to be
+     * written in async mode, and the most bytes of text each can
+     * hold (longer ones are cut short and end with 'X').
+     */
+    enum { ASYNC_RING_RECORDS = 256, ASYNC_RECORD_BYTES = 512 };
+
+    /**
+     * Switch this Logger to async mode.  In async mode a logging
+     * thread formats the text of each record, and captures its
+     * StampCapture, into a ring buffer of its own, taking no lock,
+     * and a single background thread writes the records to the
+     * ByteSink, calling the time stamper and adding the level and
+     * the rest.  Records from one thread stay in order, but
+     * records from different threads may interleave differently than
+     * they were logged.  If a thread's ring is full, its record is
+     * dropped and counted instead; see GetDroppedRecords().
+     *
+     * @returns \c true if async mode is on, \c false if the
+     *          background thread could not be started, in which case
+     *          logging stays synchronous.
+     */
+    bool StartAsync() ;
+
+    /**
+     * Write all waiting records, stop the background thread, and
+     * return to logging synchronously.  Records logged by threads
+     * racing this call may instead be written by the next
+     * FlushAsync(), StartAsync(), or the destructor.
+     */
+    void StopAsync() ;
+
+    /**
+     * In async mode, write all records waiting at the time of the
+     * call before returning.  Call this before anything that may end
+     * the process without running the destructor.
+     */
+    void FlushAsync() ;
+
+    /**
+     * @returns \c true if this Logger is in async mode.
+     */
+    bool IsAsync() const
     {
+      return m_async;
+    }
+
+    /**
+     * @returns The number of records dropped, over this Logger's
+     *          lifetime, because a thread's ring was full.
+     */
+    u64 GetDroppedRecords() const
+    {
+      return m_droppedRecords;
     }
 
     /**
@@ -346,7 +412,7 @@ namespace MFM
      */
     bool Log(Level level, ByteSource & bs )
     {
-      if (IfLog(level))
+      if (IfLog(level) && !(m_async && AsyncReport(level, 0, 0, &bs)))
       {
         Mutex::ScopeLock lock(m_mutex); // Hold lock for this block
         unwind_protect(
@@ -354,7 +420,7 @@ namespace MFM
           abort(); // Logger is not prepared to handle failures during printing!
         },
         {
-          if (m_includeFlags & INCLUDE_TIMESTAMP) m_sink->Printf("%@",m_timeStamper);
+          if (m_includeFlags & INCLUDE_TIMESTAMP) PrintStamp();
           if (m_includeFlags & INCLUDE_LEVEL) m_sink->Printf("%s", StrLevel(level));
           if (m_includeFlags & INCLUDE_SEPARATOR) m_sink->Printf(": ");
           if (m_includeFlags & INCLUDE_TEXT) m_sink->Printf("%<", &bs);
@@ -378,7 +444,7 @@ namespace MFM
      */
     void Vreport(Level level, const char * format, va_list & ap)
     {
-      if (IfLog(level))
+      if (IfLog(level) && !(m_async && AsyncReport(level, format, &ap, 0)))
       {
         Mutex::ScopeLock lock(m_mutex); // Hold lock for this block
         unwind_protect(
@@ -386,7 +452,7 @@ namespace MFM
           abort(); // Logger is not prepared to handle failures during printing!
         },
         {
-          if (m_includeFlags & INCLUDE_TIMESTAMP) m_sink->Printf("%@",m_timeStamper);
+          if (m_includeFlags & INCLUDE_TIMESTAMP) PrintStamp();
           if (m_includeFlags & INCLUDE_LEVEL) m_sink->Printf("%s", StrLevel(level));
           if (m_includeFlags & INCLUDE_SEPARATOR) m_sink->Printf(": ");
           if (m_includeFlags & INCLUDE_TEXT) m_sink->Vprintf(format, ap);
@@ -482,6 +548,9 @@ namespace MFM
     /**
      * Sets the Time Stamper to be used by this Logger , a device used
      * to keep track of the number of messages that have been logged.
+     * It should print from GetStampCapture() rather than looking at
+     * the clock or the calling thread itself, since in async mode it
+     * is called by the background thread, after the fact.
      *
      * @param stamper The ByteSerializable that will be printed as a
      *                prefix to each logging message.
@@ -489,7 +558,27 @@ namespace MFM
     void SetTimeStamper(ByteSerializable * stamper)
     {
       m_timeStamper = stamper? stamper : &m_defaultTimeStamper;
-      m_defaultTimeStamper.Reset();
+      __atomic_store_n(&m_stampSequence, 0, __ATOMIC_RELAXED);
+    }
+
+    /**
+     * What a time stamp is made from, captured when its record is
+     * logged.
+     */
+    struct StampCapture
+    {
+      u64 m_sequence;     // 1 for the first record since SetTimeStamper
+      timespec m_time;    // CLOCK_REALTIME
+      pthread_t m_thread; // The logging thread
+    };
+
+    /**
+     * @returns The StampCapture of the record being stamped.  Only
+     *          meaningful inside the time stamper's PrintTo.
+     */
+    const StampCapture & GetStampCapture() const
+    {
+      return m_stampCapture;
     }
 
    
@@ -507,13 +596,12 @@ namespace MFM
 
     class DefaultTimeStamper : public ByteSerializable
     {
-      u32 m_calls;
+      const Logger & m_logger;
     public:
-      DefaultTimeStamper() : m_calls(0) { }
-      void Reset() { m_calls = 0; }
+      DefaultTimeStamper(const Logger & logger) : m_logger(logger) { }
       virtual Result PrintTo(ByteSink & byteSink, s32 argument = 0)
       {
-        byteSink.Print(++m_calls, Format::LEX32);
+        byteSink.Print((u32) m_logger.GetStampCapture().m_sequence, Format::LEX32);
         byteSink.Print(": ");
         return SUCCESS;
       }
@@ -524,6 +612,72 @@ namespace MFM
     } m_defaultTimeStamper;
     ByteSerializable * m_timeStamper;
 
+    struct AsyncRecord;
+    struct AsyncRing;
+
+    volatile bool m_async;
+    pthread_t m_drainer;
+    bool m_drainerRunning;       // m_drainer needs joining
+    volatile bool m_stopDrainer;
+    pthread_key_t m_ringKey;     // Each thread's AsyncRing
+    bool m_ringKeyMade;
+
+    /**
+     * Every thread's AsyncRing.  m_ringsMutex guards the list, and
+     * whoever holds it is the one consumer of every ring.
+     */
+    AsyncRing * m_rings;
+    Mutex m_ringsMutex;
+
+    u64 m_stampSequence;         // Records stamped since SetTimeStamper
+    StampCapture m_stampCapture; // For m_timeStamper; guarded by m_mutex
+
+    /**
+     * Capture the sequence number, time, and thread of a record being
+     * logged now.  Takes no lock.
+     */
+    void CaptureStamp(StampCapture & stamp) ;
+
+    /**
+     * Print a time stamp for a record logged now.  Caller holds
+     * m_mutex.
+     */
+    void PrintStamp()
+    {
+      CaptureStamp(m_stampCapture);
+      m_sink->Printf("%@",m_timeStamper);
+    }
+
+    u64 m_droppedRecords;
+    u64 m_reportedDrops;         // Already noted in the log
+    u32 m_forkGeneration;        // When async mode started
+
+    /**
+     * Put a record with the text of format and *ap, or else of *bs,
+     * in the calling thread's ring.  Returns false if the caller
+     * should log it synchronously instead.
+     */
+    bool AsyncReport(Level level, const char * format, va_list * ap, ByteSource * bs) ;
+
+    AsyncRing * GetAsyncRing() ;
+
+    bool IsForkedChild() const ;
+
+    /**
+     * Write every waiting record to m_sink.  Returns the number
+     * written.
+     */
+    u32 DrainRings() ;
+
+    /**
+     * Write record to m_sink.  Caller holds m_mutex.
+     */
+    void WriteRecord(const AsyncRecord & record) ;
+
+    static void * DrainRunner(void * arg) ;
+
+    static void ReleaseRing(void * ring) ;
+
   };
 
   extern Logger LOG;
@@ -32,20 +32,46 @@
 #include "Fail.h"
 #include "Mutex.h"
 #include "Logger.h"
+#include <time.h>  /* For struct timespec, clock_gettime */
 
 namespace MFM
 {
   /**
    * An LonglivedLock mediates long-duration locking between a set of
-   * possible owners
+   * possible owners.
+   *
+   * By default the owner pointer is updated with an atomic
+   * compare-and-swap.  Define LONGLIVEDLOCK_MUTEX to guard it with a
+   * Mutex instead, as was done historically; the TryLock, Unlock and
+   * GetOwnerIndex semantics are the same either way.
+   *
+   * Each lock also counts its lock attempts, failed attempts and
+   * successful acquisitions, so that contended locks can be
+   * identified (see #GetAttempts and friends).  Hold times cost two
+   * clock reads, so only one acquisition in HOLD_SAMPLE_INTERVAL is
+   * timed (see #GetHoldNanos and #GetHoldSamples).
    */
   class LonglivedLock
   {
   private:
+#ifdef LONGLIVEDLOCK_MUTEX
     Mutex m_shortLivedLock;
-    void * m_longlivedLockOwner;
+#endif
+    void * volatile m_longlivedLockOwner;
     void * m_lastLonglivedLockOwner;
 
+    /* Contention accounting.  The counters are updated and read with
+       relaxed atomics, since they may be read by any thread;
+       m_timingHold and m_lockedAt are only touched by the current
+       owner. */
+    u32 m_attempts;
+    u32 m_failures;
+    u32 m_acquisitions;
+    u32 m_holdSamples;
+    u64 m_holdNanos;
+    bool m_timingHold;
+    timespec m_lockedAt;
+
     enum ThreeWayResult { RESULT_TRUE, RESULT_FALSE, RESULT_FAIL };
 
     bool DecodeResult(ThreeWayResult res)
@@ -61,6 +87,7 @@ namespace MFM
       }
     }
 
+#ifdef LONGLIVEDLOCK_MUTEX
     ThreeWayResult TryLockInternal(void * arg)
     {
       Mutex::ScopeLock scopeLock(m_shortLivedLock);
@@ -92,14 +119,56 @@ namespace MFM
 
       return RESULT_FAIL;
     }
+#else /* LONGLIVEDLOCK_MUTEX */
+    ThreeWayResult TryLockInternal(void * arg)
+    {
+      void * prev = __sync_val_compare_and_swap(&m_longlivedLockOwner, (void *) 0, arg);
+
+      if (prev == 0)
+      {
+        m_lastLonglivedLockOwner = arg;
+        return RESULT_TRUE;
+      }
+
+      if (prev == arg)
+      {
+        return RESULT_FAIL;
+      }
+
+      return RESULT_FALSE;
+    }
+
+    ThreeWayResult UnlockInternal(void * arg)
+    {
+      if (__sync_bool_compare_and_swap(&m_longlivedLockOwner, arg, (void *) 0))
+      {
+        return RESULT_TRUE;
+      }
+
+      return RESULT_FAIL;
+    }
+#endif /* LONGLIVEDLOCK_MUTEX */
 
   public:
 
+    enum
+    {
+      /** Time the hold of every this-many acquisitions */
+      HOLD_SAMPLE_INTERVAL = 64
+    };
+
     /**
      * Initialize this LonglivedLock.
      */
     LonglivedLock()
       : m_longlivedLockOwner(0)
+      , m_lastLonglivedLockOwner(0)
+      , m_attempts(0)
+      , m_failures(0)
+      , m_acquisitions(0)
+      , m_holdSamples(0)
+      , m_holdNanos(0)
+      , m_timingHold(false)
     { }
 
     /**
@@ -117,7 +186,9 @@ namespace MFM
      */
     void * GetOwnerIndex()
     {
+#ifdef LONGLIVEDLOCK_MUTEX
       Mutex::ScopeLock scopeLock(m_shortLivedLock);
+#endif
       return m_longlivedLockOwner;
     }
 
@@ -132,7 +203,22 @@ namespace MFM
     {
       MFM_API_ASSERT_NONNULL(who);
       MFM_API_ASSERT(who != (void*) (intptr_t) -1,ILLEGAL_ARGUMENT);
-      return DecodeResult(TryLockInternal(who));
+      __atomic_fetch_add(&m_attempts, 1, __ATOMIC_RELAXED);
+      bool ret = DecodeResult(TryLockInternal(who));
+      if (ret)
+      {
+        const u32 acquisition = __atomic_fetch_add(&m_acquisitions, 1, __ATOMIC_RELAXED);
+        m_timingHold = (acquisition % HOLD_SAMPLE_INTERVAL) == 0;
+        if (m_timingHold)
+        {
+          clock_gettime(CLOCK_MONOTONIC, &m_lockedAt);
+        }
+      }
+      else
+      {
+        __atomic_fetch_add(&m_failures, 1, __ATOMIC_RELAXED);
+      }
+      return ret;
     }
 
     /**
@@ -145,8 +231,79 @@ namespace MFM
     {
       MFM_API_ASSERT_NONNULL(who);
       MFM_API_ASSERT(who != (void*) (intptr_t) -1,ILLEGAL_ARGUMENT);
+
+      // Account while we still own the lock
+      if (m_longlivedLockOwner == who && m_timingHold)
+      {
+        const u64 BILLION = 1000000000;
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        const u64 held =
+          ((u64) now.tv_sec * BILLION + now.tv_nsec) -
+          ((u64) m_lockedAt.tv_sec * BILLION + m_lockedAt.tv_nsec);
+        __atomic_fetch_add(&m_holdNanos, held, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&m_holdSamples, 1, __ATOMIC_RELAXED);
+        m_timingHold = false;
+      }
+
       return DecodeResult(UnlockInternal(who));
     }
+
+    /**
+     * Get the number of TryLock calls made on this lock
+     */
+    u32 GetAttempts() const
+    {
+      return __atomic_load_n(&m_attempts, __ATOMIC_RELAXED);
+    }
+
+    /**
+     * Get the number of TryLock calls that found the lock held by
+     * another owner
+     */
+    u32 GetFailures() const
+    {
+      return __atomic_load_n(&m_failures, __ATOMIC_RELAXED);
+    }
+
+    /**
+     * Get the number of times this lock has been acquired
+     */
+    u32 GetAcquisitions() const
+    {
+      return __atomic_load_n(&m_acquisitions, __ATOMIC_RELAXED);
+    }
+
+    /**
+     * Get the number of completed acquisitions whose hold time was
+     * measured; about one in HOLD_SAMPLE_INTERVAL of them.
+     */
+    u32 GetHoldSamples() const
+    {
+      return __atomic_load_n(&m_holdSamples, __ATOMIC_RELAXED);
+    }
+
+    /**
+     * Get the total time, in nanoseconds, that this lock was held
+     * across the sampled acquisitions (see #GetHoldSamples).
+     */
+    u64 GetHoldNanos() const
+    {
+      return __atomic_load_n(&m_holdNanos, __ATOMIC_RELAXED);
+    }
+
+    /**
+     * Zero the contention accounting of this lock.  Only approximate
+     * if the lock is in use.
+     */
+    void ResetCounters()
+    {
+      __atomic_store_n(&m_attempts, 0, __ATOMIC_RELAXED);
+      __atomic_store_n(&m_failures, 0, __ATOMIC_RELAXED);
+      __atomic_store_n(&m_acquisitions, 0, __ATOMIC_RELAXED);
+      __atomic_store_n(&m_holdSamples, 0, __ATOMIC_RELAXED);
+      __atomic_store_n(&m_holdNanos, 0, __ATOMIC_RELAXED);
+    }
   };
 }
 
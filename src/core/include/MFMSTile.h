@@ -43,7 +43,7 @@ namespace MFM
 
   public:
 
-    MFMSTile(const u32 tileWidth, const u32 tileHeight, const GridLayoutPattern gridlayout, S * sites, const u32 eventbuffersize, EventHistoryItem * items)
+    MFMSTile(const u32 tileWidth, const u32 tileHeight, const GridLayoutPattern gridlayout, const typename S::PLANES & sites, const u32 eventbuffersize, EventHistoryItem * items)
       : Super(tileWidth, tileHeight, gridlayout, sites, eventbuffersize, items)
     { }
 
@@ -29,7 +29,8 @@
 #define MUTEX_H
 
 #include <pthread.h>  /* for pthread_mutex_t etc */
-#include <errno.h>    /* for EBUSY */
+#include <errno.h>    /* for EBUSY, ETIMEDOUT */
+#include <time.h>     /* for timespec, clock_gettime */
 #include "itype.h"
 #include "Fail.h"
 
@@ -66,6 +67,9 @@ namespace MFM
 
     void CondWait(pthread_cond_t & condvar)
     {
+      // The wait releases the lock without going through
+      // Mutex::Unlock; simulate its effects
+      m_locked = false;
       MFM_API_ASSERT(!pthread_cond_wait(&condvar, &m_lock), LOCK_FAILURE);
 
       // The signal gave us back the lock without going through
@@ -76,6 +80,24 @@ namespace MFM
       m_locked = true;
     }
 
+    /**
+     * As CondWait, but give up at \c deadline (CLOCK_REALTIME).
+     * Returns false if the deadline passed without a signal.
+     */
+    bool CondTimedWait(pthread_cond_t & condvar, const timespec & deadline)
+    {
+      m_locked = false;
+      int status = pthread_cond_timedwait(&condvar, &m_lock, &deadline);
+      MFM_API_ASSERT(status == 0 || status == ETIMEDOUT, LOCK_FAILURE);
+
+      // Either way we have the lock back; simulate Mutex::Lock
+      MFM_API_ASSERT(!m_locked, LOCK_FAILURE);
+
+      m_threadId = pthread_self();
+      m_locked = true;
+      return status == 0;
+    }
+
    public:
 
     class ScopeLock
@@ -140,6 +162,36 @@ namespace MFM
         }
       }
 
+      /**
+       * As WaitForCondition, but give up after about \c usec
+       * microseconds.  Returns the final value of the predicate.
+       */
+      bool WaitForConditionFor(u32 usec)
+      {
+        m_mutex.AssertIHoldTheLock();
+        m_threadIdOfWaiter = m_mutex.m_threadId;
+        m_wakeupsThisWait = 0;
+
+        const u64 BILLION = 1000000000;
+        timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        u64 nanos = (u64) now.tv_nsec + (u64) usec * 1000;
+        timespec deadline;
+        deadline.tv_sec = now.tv_sec + nanos / BILLION;
+        deadline.tv_nsec = nanos % BILLION;
+
+        while (!EvaluatePredicate())
+        {
+          MFM_API_ASSERT(EvaluatePrecondition(), LOCK_FAILURE);
+          if (!m_mutex.CondTimedWait(m_condvar, deadline))
+          {
+            return EvaluatePredicate();
+          }
+          ++m_wakeupsThisWait;
+        }
+        return true;
+      }
+
       void SignalCondition()
       {
         m_mutex.AssertIHoldTheLock();
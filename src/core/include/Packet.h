@@ -84,8 +84,42 @@ namespace MFM
      */
     static const u8 UPDATE_ACK = 'a';
 
+    /**
+     * The PacketType when an updater is supplying a batch of sites
+     * as deltas against what the updatee should already have.  Each
+     * entry's HEADER holds the count of site numbers skipped since
+     * the previous entry (or since 0) in its upper seven bits, and
+     * whether it is an UPDATE (1) or a CHECK (0) in its low bit.  An
+     * UPDATE carries a bitmask of which bytes of the atom changed,
+     * then each changed byte XORed with its old value, then a
+     * 16-bit CHECK digest of the new atom.  A CHECK carries just the
+     * CHECK digest of the unchanged atom.  Format: DELTAS + (u8:HEADER
+     * + [MASK + XORBYTES] + u16:CHECK)*
+     */
+    static const u8 DELTAS = 'd';
+
+    /**
+     * The PacketType when a cache processor is announcing which
+     * optional PacketEncodings it will accept from its peer.  Format:
+     * ENCODINGS + u8:PACKET_ENCODING_BITS
+     */
+    static const u8 ENCODINGS = 'n';
+
   } /* namespace PacketType */
 
+  /**
+     Bits for the optional packet encodings a cache processor can
+     accept, as announced in a PacketType::ENCODINGS packet.
+   */
+  namespace PacketEncoding
+  {
+    /**
+     * Will accept PacketType::DELTAS packets.
+     */
+    static const u8 DELTA = 0x01;
+
+  } /* namespace PacketEncoding */
+
 } /* namespace MFM */
 
 #endif /*PACKET_H*/
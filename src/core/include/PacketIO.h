@@ -39,7 +39,12 @@ namespace MFM
 
   class PacketIO {
     PacketBuffer m_buffer;
+    u32 m_nextDeltaSite;  // Site number an entry with no gap would have
   public:
+    PacketIO()
+      : m_nextDeltaSite(0)
+    { }
+
     template <class EC>
     bool SendUpdateBegin(CacheProcessor<EC> & cxn, const SPoint & localCenter) ;
 
@@ -53,6 +58,46 @@ namespace MFM
     template <class EC>
     bool SendReply(PacketTypeCode ptype, CacheProcessor<EC> & cxn) ;
 
+    template <class EC>
+    bool SendEncodings(u8 encodings, CacheProcessor<EC> & cxn) ;
+
+    /**
+       Begin a PacketType::DELTAS packet, to be filled by AddDelta and
+       sent by ShipDeltas.
+     */
+    void StartDeltas()
+    {
+      m_buffer.Reset();
+      m_buffer.Printf("%c", PacketType::DELTAS);
+      m_nextDeltaSite = 0;
+    }
+
+    /**
+       Append one site to the DELTAS packet begun by StartDeltas.  \a
+       prior is what the peer should have now at siteNumber, and is
+       ignored if \a isUpdate is false.  \returns false, leaving the
+       packet unchanged, if the site doesn't fit in this packet,
+       either for lack of space or because site numbers within a
+       packet must increase.
+     */
+    template <class EC>
+    bool AddDelta(CacheProcessor<EC> & cxn, bool isUpdate, u16 siteNumber,
+                  const typename EC::ATOM_CONFIG::ATOM_TYPE & atom,
+                  const typename EC::ATOM_CONFIG::ATOM_TYPE & prior) ;
+
+    template <class EC>
+    bool ShipDeltas(CacheProcessor<EC> & cxn) ;
+
+    /**
+       A 16-bit digest of atom, used to check what a delta produced or
+       what a CHECK refers to.  Sent as DIGEST_BYTES bytes, high byte
+       first, so a stale cache slips past it one time in 65536.
+     */
+    enum { DIGEST_BYTES = 2 };
+
+    template <class EC>
+    static u16 GetCheckDigest(const typename EC::ATOM_CONFIG::ATOM_TYPE & atom) ;
+
     /**
        Parse (and dispatch to ReceiveXXX methods herein) to deal with
        the packet in buf.  \returns true if all went well, \returns
@@ -73,6 +118,12 @@ namespace MFM
     template <class EC>
     bool ReceiveReply(CacheProcessor<EC> & cxn, ByteSource & buf) ;
 
+    template <class EC>
+    bool ReceiveDeltas(CacheProcessor<EC> & cxn, ByteSource & buf) ;
+
+    template <class EC>
+    bool ReceiveEncodings(CacheProcessor<EC> & cxn, ByteSource & buf) ;
+
   };
 
 } /* namespace MFM */
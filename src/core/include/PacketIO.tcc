@@ -108,6 +108,190 @@ namespace MFM
     return true;
   }
 
+  template <class EC>
+  bool PacketIO::SendEncodings(u8 encodings, CacheProcessor<EC> & cxn)
+  {
+    m_buffer.Reset();
+    m_buffer.Printf("%c%c", PacketType::ENCODINGS, encodings);
+    return cxn.ShipBufferAsPacket(m_buffer);
+  }
+
+  template <class EC>
+  bool PacketIO::ReceiveEncodings(CacheProcessor<EC> & cxn, ByteSource & bs)
+  {
+    u8 ptype;
+    u8 encodings;
+    if (bs.Scanf("%c%c", &ptype, &encodings) != 2 || ptype != PacketType::ENCODINGS)
+    {
+      return false;
+    }
+
+    cxn.ReceiveEncodings(encodings);
+    return true;
+  }
+
+  template <class EC>
+  u16 PacketIO::GetCheckDigest(const typename EC::ATOM_CONFIG::ATOM_TYPE & atom)
+  {
+    enum { ATOM_BYTES = EC::ATOM_CONFIG::BITS_PER_ATOM / 8 };
+    const BitVector<EC::ATOM_CONFIG::BITS_PER_ATOM> & bits = Element<EC>::GetBits(atom);
+
+    // FNV-1a, folded to 16 bits
+    u32 hash = 2166136261u;
+    for (u32 i = 0; i < ATOM_BYTES; ++i)
+    {
+      hash = (hash ^ bits.Read(i * 8, 8)) * 16777619u;
+    }
+    hash ^= hash >> 16;
+    return (u16) hash;
+  }
+
+  template <class EC>
+  bool PacketIO::AddDelta(CacheProcessor<EC> & cxn, bool isUpdate, u16 siteNumber,
+                          const typename EC::ATOM_CONFIG::ATOM_TYPE & atom,
+                          const typename EC::ATOM_CONFIG::ATOM_TYPE & prior)
+  {
+    enum {
+      BITS = EC::ATOM_CONFIG::BITS_PER_ATOM,
+      ATOM_BYTES = BITS / 8,
+      MASK_BYTES = (ATOM_BYTES + 7) / 8,
+      MAX_ENTRY_BYTES = 1 + MASK_BYTES + ATOM_BYTES + DIGEST_BYTES,
+      MAX_PACKET_BYTES = 128
+    };
+    COMPILATION_REQUIREMENT< BITS % 8 == 0 >();
+    COMPILATION_REQUIREMENT< EVENT_WINDOW_SITES(EC::EVENT_WINDOW_RADIUS) <= 128 >();
+
+    if (siteNumber < m_nextDeltaSite ||
+        m_buffer.GetLength() + MAX_ENTRY_BYTES > MAX_PACKET_BYTES)
+    {
+      return false;
+    }
+
+    const u8 header = (u8) (((siteNumber - m_nextDeltaSite) << 1) | (isUpdate ? 1 : 0));
+    m_buffer.WriteByte(header);
+    m_nextDeltaSite = siteNumber + 1;
+
+    if (isUpdate)
+    {
+      const BitVector<BITS> & newBits = Element<EC>::GetBits(atom);
+      const BitVector<BITS> & oldBits = Element<EC>::GetBits(prior);
+
+      u8 xors[ATOM_BYTES];
+      u8 mask[MASK_BYTES];
+      for (u32 m = 0; m < MASK_BYTES; ++m)
+      {
+        mask[m] = 0;
+      }
+      for (u32 i = 0; i < ATOM_BYTES; ++i)
+      {
+        xors[i] = (u8) (newBits.Read(i * 8, 8) ^ oldBits.Read(i * 8, 8));
+        if (xors[i])
+        {
+          mask[i / 8] |= (u8) (1 << (i % 8));
+        }
+      }
+      m_buffer.WriteBytes(mask, MASK_BYTES);
+      for (u32 i = 0; i < ATOM_BYTES; ++i)
+      {
+        if (xors[i])
+        {
+          m_buffer.WriteByte(xors[i]);
+        }
+      }
+    }
+
+    const u16 digest = GetCheckDigest<EC>(atom);
+    m_buffer.WriteByte((u8) (digest >> 8));
+    m_buffer.WriteByte((u8) digest);
+    return true;
+  }
+
+  template <class EC>
+  bool PacketIO::ShipDeltas(CacheProcessor<EC> & cxn)
+  {
+    return cxn.ShipBufferAsPacket(m_buffer);
+  }
+
+  template <class EC>
+  bool PacketIO::ReceiveDeltas(CacheProcessor<EC> & cxn, ByteSource & bs)
+  {
+    typedef typename EC::ATOM_CONFIG::ATOM_TYPE T;
+    enum {
+      BITS = EC::ATOM_CONFIG::BITS_PER_ATOM,
+      ATOM_BYTES = BITS / 8,
+      MASK_BYTES = (ATOM_BYTES + 7) / 8,
+      SITE_COUNT = EVENT_WINDOW_SITES(EC::EVENT_WINDOW_RADIUS)
+    };
+
+    if (bs.Read() != PacketType::DELTAS)
+    {
+      return false;
+    }
+
+    u32 nextSite = 0;
+    for (s32 header = bs.Read(); header >= 0; header = bs.Read())
+    {
+      const u32 siteNumber = nextSite + (header >> 1);
+      const bool isUpdate = header & 1;
+      if (siteNumber >= SITE_COUNT)
+      {
+        return false;
+      }
+      nextSite = siteNumber + 1;
+
+      const T cached = cxn.GetCachedAtom((u16) siteNumber);
+      T atom = cached;
+      if (isUpdate)
+      {
+        u8 mask[MASK_BYTES];
+        for (u32 m = 0; m < MASK_BYTES; ++m)
+        {
+          s32 ch = bs.Read();
+          if (ch < 0)
+          {
+            return false;
+          }
+          mask[m] = (u8) ch;
+        }
+
+        BitVector<BITS> & bits = Element<EC>::GetBits(atom);
+        for (u32 i = 0; i < ATOM_BYTES; ++i)
+        {
+          if (mask[i / 8] & (1 << (i % 8)))
+          {
+            s32 ch = bs.Read();
+            if (ch < 0)
+            {
+              return false;
+            }
+            bits.Write(i * 8, 8, bits.Read(i * 8, 8) ^ (u32) ch);
+          }
+        }
+      }
+
+      const s32 checkHi = bs.Read();
+      const s32 checkLo = bs.Read();
+      if (checkHi < 0 || checkLo < 0)
+      {
+        return false;
+      }
+
+      if ((u32) ((checkHi << 8) | checkLo) != GetCheckDigest<EC>(atom))
+      {
+        // Our cache didn't hold what the peer thought it did.  Report
+        // an UPDATE that changed nothing, which counts as inconsistent
+        // and leaves the site alone; the peer will ship the update
+        // again as full atoms to repair it (see ResendWhole).
+        cxn.ReceiveAtom(true, siteNumber, cached);
+      }
+      else
+      {
+        cxn.ReceiveAtom(isUpdate, siteNumber, atom);
+      }
+    }
+    return true;
+  }
+
   template <class EC>
   bool PacketIO::HandlePacket(CacheProcessor<EC> & cxn, PacketBuffer & buf)
   {
@@ -127,6 +311,12 @@ namespace MFM
     case PacketType::UPDATE_ACK:
       return ReceiveReply(cxn, cbs);
 
+    case PacketType::DELTAS:
+      return ReceiveDeltas(cxn, cbs);
+
+    case PacketType::ENCODINGS:
+      return ReceiveEncodings(cxn, cbs);
+
     default:
       FAIL(ILLEGAL_STATE);
     }
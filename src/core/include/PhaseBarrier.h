@@ -0,0 +1,103 @@
+/*  -*- mode:C++ -*- */
+/*
+  PhaseBarrier.h Wait for a set of tiles to finish a phase
+  Copyright (C) 2014 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file PhaseBarrier.h Wait for a set of tiles to finish a phase
+  \author David H. Ackley.
+  \date (C) 2014 All rights reserved.
+  \lgpl
+ */
+#ifndef PHASEBARRIER_H
+#define PHASEBARRIER_H
+
+#include "itype.h"
+#include "Fail.h"
+#include "Mutex.h"
+
+namespace MFM
+{
+  /**
+   * A PhaseBarrier counts the tiles yet to finish a deterministic
+   * phase (see Tile::StartDeterministicPhase).  One thread calls
+   * Begin and then Await; each tile's thread calls Finish once, and
+   * the last of them wakes the awaiting thread.
+   */
+  class PhaseBarrier
+  {
+  private:
+    Mutex m_lock;
+
+    struct AllFinished : public Mutex::Predicate
+    {
+      u32 m_pending;  // Tiles yet to call Finish
+
+      AllFinished(Mutex & lock)
+        : Mutex::Predicate(lock)
+        , m_pending(0)
+      { }
+
+      virtual bool EvaluatePrecondition() { return true; }
+      virtual bool EvaluatePredicate() { return m_pending == 0; }
+    };
+    AllFinished m_allFinished;
+
+  public:
+
+    PhaseBarrier()
+      : m_allFinished(m_lock)
+    { }
+
+    /**
+     * Expect \c tiles calls to Finish before Await returns.  FAILs
+     * with ILLEGAL_STATE if the previous phase is still pending.
+     */
+    void Begin(u32 tiles)
+    {
+      Mutex::ScopeLock lock(m_lock);
+      MFM_API_ASSERT_STATE(m_allFinished.m_pending == 0);
+      m_allFinished.m_pending = tiles;
+    }
+
+    /**
+     * Report one tile done with the phase.
+     */
+    void Finish()
+    {
+      Mutex::ScopeLock lock(m_lock);
+      MFM_API_ASSERT_STATE(m_allFinished.m_pending > 0);
+      if (--m_allFinished.m_pending == 0)
+      {
+        m_allFinished.SignalCondition();
+      }
+    }
+
+    /**
+     * Block until every tile expected by Begin has called Finish.
+     */
+    void Await()
+    {
+      Mutex::ScopeLock lock(m_lock);
+      m_allFinished.WaitForCondition();
+    }
+  };
+}
+
+#endif /* PHASEBARRIER_H */
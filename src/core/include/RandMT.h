@@ -115,6 +115,15 @@ public:
   // ACKLEYHAX: This seeding function hacked for MFM
   void seedMT_MFM(uint32 s) ;
 
+  // ACKLEYHAX: The generator interface Random uses, shared with
+  // Xoshiro128.  MT has no cheap jump-ahead, so Jump and Split just
+  // reseed from its own output.  (And copying an MT is unsafe --
+  // 'next' points into the state -- so Split seeds rather than copies.)
+  inline uint32 Next() { return randomMT(); }
+  void Seed(uint32 s) { seedMT_MFM(s); }
+  void Jump() { seedMT_MFM(randomMT()); }
+  void Split(RandMT & into) { into.seedMT_MFM(randomMT()); }
+
 };
 
 } /* namespace MFM */
@@ -33,6 +33,7 @@
 
 #include "itype.h"
 #include "RandMT.h"
+#include "Xoshiro128.h"
 #include "BitVector.h"
 #include "FXP.h"
 #include "Fail.h"
@@ -41,8 +42,16 @@
 namespace MFM
 {
 
+#ifdef MFM_RANDOM_MT
+  typedef RandMT RandomGenerator;      // The old Mersenne Twister, for comparison
+#else
+  typedef Xoshiro128 RandomGenerator;  // Smaller, faster, and able to jump ahead
+#endif
+
   /**
-   * An interface for easy PRNG interaction.
+   * An interface for easy PRNG interaction.  The underlying
+   * generator is a RandomGenerator, which is Xoshiro128 unless
+   * MFM_RANDOM_MT is defined at build time.
    */
   class Random
   {
@@ -73,7 +82,40 @@ namespace MFM
      */
     inline u32 Create()
     {
-      return _generator.randomMT();
+      return (u32) _generator.Next();
+    }
+
+    /**
+     * Fills count words at out with pseudo-random bits, as if by
+     * count calls to Create().
+     */
+    void Fill(u32 * out, u32 count)
+    {
+      for (u32 i = 0; i < count; ++i)
+      {
+        out[i] = (u32) _generator.Next();
+      }
+    }
+
+    /**
+     * Fills count words at out with uniform pseudo-random numbers from
+     * 0..maxval-1, using about one draw per number.  FAILs
+     * ILLEGAL_ARGUMENT if maxval==0.  The numbers are not the ones
+     * count calls to Create(maxval) would have made.
+     */
+    void Fill(u32 * out, u32 count, u32 maxval)
+    {
+      MFM_API_ASSERT_ARG(maxval > 0);
+      const u32 threshold = (0u - maxval) % maxval;  // 2**32 mod maxval
+      for (u32 i = 0; i < count; ++i)
+      {
+        u64 product;
+        do
+        {  // Rejects less than maxval in 2**32 draws
+          product = ((u64) (u32) _generator.Next()) * maxval;
+        } while ((u32) product < threshold);
+        out[i] = (u32) (product >> 32);
+      }
     }
 
     /**
@@ -199,14 +241,40 @@ namespace MFM
      */
     void SetSeed(u32 seed)
     {
-      _generator.seedMT_MFM(seed);
+      _generator.Seed(seed);
+      _bitsRemaining = 0;
+      _bitBuffer = 0;
+    }
+
+    /**
+     * Advances the PRNG past the next 2**64 numbers, or, if the
+     * generator cannot jump ahead, reseeds it from its own output.
+     */
+    void Jump()
+    {
+      _generator.Jump();
+      _bitsRemaining = 0;
+    }
+
+    /**
+     * Gives into a stream of its own, independent of this one and of
+     * any other split from it, and moves this one past it.  Splitting
+     * one seeded Random repeatedly gives each tile its own stream,
+     * all reproducible from the one seed.
+     *
+     * @param into The Random to take the new stream.
+     */
+    void Split(Random & into)
+    {
+      _generator.Split(into._generator);
+      into._bitsRemaining = 0;
       _bitsRemaining = 0;
     }
 
   private:
     s32 _bitsRemaining;
     u32 _bitBuffer;
-    RandMT _generator;
+    RandomGenerator _generator;
 
   };
 
@@ -0,0 +1,285 @@
+/*                                              -*- mode:C++ -*-
+  SharedCacheChannel.h In-process cache update exchange between neighbor tiles
+  Copyright (C) 2015 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file SharedCacheChannel.h In-process cache update exchange between neighbor tiles
+  \author David H. Ackley.
+  \date (C) 2015 All rights reserved.
+  \lgpl
+ */
+#ifndef SHAREDCACHECHANNEL_H
+#define SHAREDCACHECHANNEL_H
+
+#include "itype.h"
+#include "Fail.h"
+#include "Point.h"
+#include "Mutex.h"
+#include "MDist.h"  /* for EVENT_WINDOW_SITES */
+#include "Util.h"   /* for MAX */
+#include <time.h>   /* for clock_gettime */
+
+namespace MFM
+{
+  /**
+     A SharedCacheChannel connects two CacheProcessors on neighboring
+     tiles of the same process, in place of a packet-carrying
+     AbstractChannel.  Rather than encoding each atom into a packet
+     and decoding it on the far side, the active side copies its
+     whole cache update -- the event center and the sites to UPDATE
+     or CHECK -- straight into a boundary buffer, and the passive
+     side reads it from there; the reply comes back the same way.
+
+     The cache update protocol is otherwise unchanged.  Since the
+     active side holds its long-lived lock until the reply arrives,
+     there is at most one update and one reply in flight in each
+     direction, so each direction needs just one buffer of each.
+     The Mutex guards only the handoff of a buffer between the two
+     sides, not the copying into and out of it.
+
+     Like a GridTransceiver, a channel can model a data rate.  Each
+     update and reply is charged the bytes its full packet encoding
+     would have taken, and is withheld from the peer until that many
+     bytes could have crossed at the rate, after whatever was sent
+     before it in the same direction.  So skipping the encoding saves
+     the CPU time it costs, but not the modeled transmission time.
+     At a data rate of 0, the default, handoffs are immediate.  (As
+     with a GridTransceiver whose max in flight is 0, no latency is
+     modeled beyond the transmission time.)
+   */
+  template <class EC>
+  class SharedCacheChannel
+  {
+    // Extract short names for parameter types
+    typedef typename EC::ATOM_CONFIG AC;
+    typedef typename AC::ATOM_TYPE T;
+    enum { R = EC::EVENT_WINDOW_RADIUS };
+
+  public:
+    enum { SITE_COUNT = EVENT_WINDOW_SITES(R) };
+
+    /**
+       What PacketIO's full encoding ships, counting each packet's
+       length byte
+     */
+    enum {
+      ATOM_BYTES = (AC::BITS_PER_ATOM + 31) / 32 * 4,
+      UPDATE_BEGIN_BYTES = 1 + 1 + 2 + 2,
+      SITE_BYTES = 1 + 1 + 1 + ATOM_BYTES,
+      UPDATE_END_BYTES = 1 + 1,
+      REPLY_BYTES = 1 + 1 + 1
+    };
+
+    struct SharedSite {
+      T m_atom;          // What was sent
+      u16 m_siteNumber;  // Where it lives, relative to m_center
+      bool m_isUpdate;   // true for an UPDATE, false for a CHECK
+    };
+
+    struct SharedUpdate {
+      SPoint m_center;   // In the receiver's full untransformed coordinates
+      u32 m_count;       // Used length of m_sites
+      SharedSite m_sites[SITE_COUNT];
+    };
+
+  private:
+    Mutex m_access;
+
+    // Indexed by receiving side: 0 for side A, 1 for side B
+    SharedUpdate m_updates[2];
+    bool m_updateFull[2];
+    u32 m_replies[2];
+    bool m_replyFull[2];
+
+    u64 m_updatesPosted[2];
+    u64 m_sitesPosted[2];
+
+    u32 m_bytesPerSecond;      // 0 for immediate handoffs
+    u64 m_lineFreeAt[2];       // When the last posting will have crossed
+    u64 m_updateArrivesAt[2];
+    u64 m_replyArrivesAt[2];
+
+    static u32 Inbound(bool onSideA) { return onSideA ? 0 : 1; }
+    static u32 Outbound(bool onSideA) { return onSideA ? 1 : 0; }
+
+    static u64 NowNanos()
+    {
+      timespec now;
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      return ((u64) now.tv_sec) * 1000000000 + now.tv_nsec;
+    }
+
+    /**
+       Charge bytes to the line in direction dir, and return when they
+       will have arrived.  Call with m_access held.
+     */
+    u64 Transmit(u32 dir, u32 bytes)
+    {
+      if (m_bytesPerSecond == 0)
+      {
+        return 0;
+      }
+      const u64 now = NowNanos();
+      const u64 start = MAX(now, m_lineFreeAt[dir]);
+      m_lineFreeAt[dir] = start + ((u64) bytes) * 1000000000 / m_bytesPerSecond;
+      return m_lineFreeAt[dir];
+    }
+
+    /**
+       True if something due to arrive at arrivesAt has.  Call with
+       m_access held.
+     */
+    bool HasArrived(u64 arrivesAt) const
+    {
+      return m_bytesPerSecond == 0 || NowNanos() >= arrivesAt;
+    }
+
+    SharedCacheChannel(const SharedCacheChannel &) ; // Declare away
+    SharedCacheChannel & operator=(const SharedCacheChannel &) ; // Declare away
+
+  public:
+
+    SharedCacheChannel()
+      : m_bytesPerSecond(0)
+    {
+      for (u32 i = 0; i < 2; ++i)
+      {
+        m_updates[i].m_count = 0;
+        m_updateFull[i] = false;
+        m_replies[i] = 0;
+        m_replyFull[i] = false;
+        m_updatesPosted[i] = 0;
+        m_sitesPosted[i] = 0;
+        m_lineFreeAt[i] = 0;
+        m_updateArrivesAt[i] = 0;
+        m_replyArrivesAt[i] = 0;
+      }
+    }
+
+    /**
+       Model a data rate of bytesPerSecond in each direction, or none,
+       if it is 0.
+     */
+    void SetDataRate(u32 bytesPerSecond)
+    {
+      Mutex::ScopeLock lock(m_access);
+      m_bytesPerSecond = bytesPerSecond;
+    }
+
+    u32 GetDataRate() const
+    {
+      return m_bytesPerSecond;
+    }
+
+    /**
+       Get the buffer for an update going out from the given side, or
+       null if the peer has not yet taken the previous one.  The
+       caller fills it in and then hands it over with PostUpdate.
+     */
+    SharedUpdate * GetOutboundUpdate(bool onSideA)
+    {
+      Mutex::ScopeLock lock(m_access);
+      const u32 out = Outbound(onSideA);
+      return m_updateFull[out] ? 0 : &m_updates[out];
+    }
+
+    /**
+       Hand the update filled in via GetOutboundUpdate to the peer.
+     */
+    void PostUpdate(bool onSideA)
+    {
+      Mutex::ScopeLock lock(m_access);
+      const u32 out = Outbound(onSideA);
+      MFM_API_ASSERT_STATE(!m_updateFull[out]);
+      MFM_API_ASSERT_STATE(m_updates[out].m_count <= SITE_COUNT);
+      m_updateFull[out] = true;
+      ++m_updatesPosted[out];
+      m_sitesPosted[out] += m_updates[out].m_count;
+      m_updateArrivesAt[out] =
+        Transmit(out, UPDATE_BEGIN_BYTES + m_updates[out].m_count * SITE_BYTES + UPDATE_END_BYTES);
+    }
+
+    /**
+       Get the update waiting for the given side, or null if there is
+       none, or it has not yet arrived at the modeled data rate.  The
+       update stays put until ReleaseUpdate.
+     */
+    const SharedUpdate * GetInboundUpdate(bool onSideA)
+    {
+      Mutex::ScopeLock lock(m_access);
+      const u32 in = Inbound(onSideA);
+      return m_updateFull[in] && HasArrived(m_updateArrivesAt[in]) ? &m_updates[in] : 0;
+    }
+
+    /**
+       Return the buffer of the update obtained via GetInboundUpdate
+       to the peer for reuse.
+     */
+    void ReleaseUpdate(bool onSideA)
+    {
+      Mutex::ScopeLock lock(m_access);
+      const u32 in = Inbound(onSideA);
+      MFM_API_ASSERT_STATE(m_updateFull[in]);
+      m_updateFull[in] = false;
+    }
+
+    /**
+       Send the reply to the update just received, carrying the count
+       of consistent atoms found in it.
+     */
+    void PostReply(bool onSideA, u32 consistentCount)
+    {
+      Mutex::ScopeLock lock(m_access);
+      const u32 out = Outbound(onSideA);
+      MFM_API_ASSERT_STATE(!m_replyFull[out]);
+      m_replies[out] = consistentCount;
+      m_replyFull[out] = true;
+      m_replyArrivesAt[out] = Transmit(out, REPLY_BYTES);
+    }
+
+    /**
+       Take the reply waiting for the given side, if any.  Returns
+       false, leaving consistentCount untouched, if there is none, or
+       it has not yet arrived.
+     */
+    bool TakeReply(bool onSideA, u32 & consistentCount)
+    {
+      Mutex::ScopeLock lock(m_access);
+      const u32 in = Inbound(onSideA);
+      if (!m_replyFull[in] || !HasArrived(m_replyArrivesAt[in]))
+      {
+        return false;
+      }
+      consistentCount = m_replies[in];
+      m_replyFull[in] = false;
+      return true;
+    }
+
+    /**
+       The number of updates, and of sites within them, sent so far
+       from the given side.
+     */
+    u64 GetUpdatesPosted(bool onSideA) const { return m_updatesPosted[Outbound(onSideA)]; }
+
+    u64 GetSitesPosted(bool onSideA) const { return m_sitesPosted[Outbound(onSideA)]; }
+
+  };
+} /* namespace MFM */
+
+#endif /*SHAREDCACHECHANNEL_H*/
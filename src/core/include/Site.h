@@ -27,6 +27,7 @@
 #ifndef SITE_H
 #define SITE_H
 
+#include <string.h>  /* For memset */
 #include "itype.h"
 #include "AtomConfig.h"
 #include "Base.h"
@@ -35,13 +36,105 @@
 namespace MFM
 {
 
+  /**
+     The per-site event statistics: how many events a site has had,
+     the site event count when it last changed, and the tile event
+     number of its most recent event.  SiteStats<false> has the same
+     interface but no storage, and its stores do nothing, for runs
+     that never look at these numbers.
+   */
+  template <bool ENABLED>
+  struct SiteStats
+  {
+    u64 m_eventCount;
+    u64 m_lastChangedEventCount;  // in units of Site event count
+    u64 m_lastEventNumber;        // in units of total tile events
+
+    SiteStats()
+      : m_eventCount(0)
+      , m_lastChangedEventCount(0)
+      , m_lastEventNumber(0)
+    { }
+
+    void RecordEvent(u64 eventNumber)
+    {
+      ++m_eventCount;
+      m_lastEventNumber = eventNumber;
+    }
+
+    void Set(u64 eventCount, u64 lastChangedEventCount, u64 lastEventNumber)
+    {
+      m_eventCount = eventCount;
+      m_lastChangedEventCount = lastChangedEventCount;
+      m_lastEventNumber = lastEventNumber;
+    }
+
+    void Clear()
+    {
+      m_eventCount = 0;
+      m_lastChangedEventCount = 0;
+    }
+
+    void MarkChanged() { m_lastChangedEventCount = m_eventCount; }
+
+    u64 GetEventCount() const { return m_eventCount; }
+
+    u64 GetLastChangedEventCount() const { return m_lastChangedEventCount; }
+
+    u64 GetLastEventNumber() const { return m_lastEventNumber; }
+  };
+
+  template <>
+  struct SiteStats<false>
+  {
+    void RecordEvent(u64 eventNumber) { }
+
+    void Set(u64 eventCount, u64 lastChangedEventCount, u64 lastEventNumber) { }
+
+    void Clear() { }
+
+    void MarkChanged() { }
+
+    u64 GetEventCount() const { return 0; }
+
+    u64 GetLastChangedEventCount() const { return 0; }
+
+    u64 GetLastEventNumber() const { return 0; }
+  };
+
+  /**
+     Everything the text configuration of a Site records, in a fixed
+     binary layout, for binary grid snapshots.  Atom types are those
+     of the process that made the image.
+   */
+  template <class AC>
+  struct SiteImage
+  {
+    typedef typename AC::ATOM_TYPE T;
+
+    u64 m_eventCount;
+    u64 m_lastChangedEventCount;
+    u64 m_lastEventNumber;
+    u64 m_lastTouchEventCount;
+    T m_atom;
+    T m_baseAtom;
+    u32 m_paint;
+    u32 m_touchType;
+    u32 m_isLiveSite;
+  };
+
   /**
      A Site holds a Base and an Atom, and all information associated
      with that Atom, such as access times, ages, and so forth.  It is
-     a template depending only on an AtomConfig (AC).
+     a template depending on an AtomConfig (AC), and on whether the
+     per-site event statistics are kept at all (STATS).
+
+     With STATS false the statistics take no space and cost no
+     stores: event counts and ages read as zero, touches are not
+     sensed, and save files carry zeros in the statistics fields.
    */
-  template <class AC>
-  class Site
+  template <class AC, bool STATS = true>
+  class Site : private SiteStats<STATS>
   {
   public:
     /**
@@ -49,51 +142,89 @@ namespace MFM
      */
     typedef AC ATOM_CONFIG;
 
+    /**
+       Present whether per-site event statistics are kept
+     */
+    enum { SITE_STATS = STATS };
+
     // Extract short names for parameter types
     typedef typename ATOM_CONFIG::ATOM_TYPE T;
 
+    /**
+       A tile's Sites are simply an array of them, indexed by site
+       number, and handed out by reference.
+     */
+    typedef Site * PLANES;
+    typedef Site & REF;
+    typedef const Site & CONST_REF;
+
+    static REF GetSiteIn(PLANES sites, u32 siteNumber)
+    {
+      return sites[siteNumber];
+    }
+
+    static T & GetAtomIn(PLANES sites, u32 siteNumber)
+    {
+      return sites[siteNumber].m_atom;
+    }
+
+    static Base<AC> & GetBaseIn(PLANES sites, u32 siteNumber)
+    {
+      return sites[siteNumber].m_base;
+    }
+
   private:
+    typedef SiteStats<STATS> Stats;
+
     T m_atom;
     Base<AC> m_base;
-    u64 m_eventCount;
-    u64 m_lastChangedEventCount;  // in units of Site event count
-    u64 m_lastEventNumber;        // in units of total tile events
     bool m_isLiveSite;
 
   public:
     Site()
-      : m_eventCount(0)
-      , m_lastChangedEventCount(0)
-      , m_lastEventNumber(0)
-      , m_isLiveSite(true)
+      : m_isLiveSite(true)
     { }
 
     void RecordEventAtSite(u64 eventNumber)
     {
-      ++m_eventCount;
-      m_lastEventNumber = eventNumber;
+      Stats::RecordEvent(eventNumber);
     }
 
-    void SaveConfig(ByteSink& bs, AtomTypeFormatter<AC> & atf) const
+    /**
+       Write the text configuration of a site with the given fields.
+       Shared by every site storage layout so they all save alike.
+     */
+    static void SaveSiteConfig(ByteSink& bs, AtomTypeFormatter<AC> & atf,
+                               bool isLiveSite, u64 eventCount,
+                               u64 lastChangedEventCount, u64 lastEventNumber,
+                               const T & atom, const Base<AC> & base)
     {
-      bs.Printf(",%D", m_isLiveSite);
+      bs.Printf(",%D", isLiveSite);
+
       // 64 bit stuff not yet exposed via Printf..
-      bs.Print(m_eventCount, Format::LXX64);
-      bs.Print(m_lastChangedEventCount, Format::LXX64);
-      bs.Print(m_lastEventNumber, Format::LXX64);
+      bs.Print(eventCount, Format::LXX64);
+      bs.Print(lastChangedEventCount, Format::LXX64);
+      bs.Print(lastEventNumber, Format::LXX64);
 
       {
-        T tmp = m_atom;
+        T tmp = atom;
         bs.Printf(",");
         atf.PrintAtomType(tmp, bs);
         AtomSerializer<AC> as(tmp);
         bs.Printf(",%@", &as);
       }
 
-      m_base.SaveConfig(bs, atf);
+      base.SaveConfig(bs, atf);
     }
 
-    bool LoadConfig(LineCountingByteSource& bs, AtomTypeFormatter<AC> & atf)
+    /**
+       Read the text configuration of a site into the given fields,
+       which are only changed if the whole site parses.
+     */
+    static bool LoadSiteConfig(LineCountingByteSource& bs, AtomTypeFormatter<AC> & atf,
+                               bool & isLiveSite, u64 & eventCount,
+                               u64 & lastChangedEventCount, u64 & lastEventNumber,
+                               T & atom, Base<AC> & base)
     {
       u32 tmp_m_isLiveSite;
       if (2 != bs.Scanf(",%D", &tmp_m_isLiveSite)) return false;
@@ -126,22 +257,93 @@ namespace MFM
         }
       }
 
-      if (!m_base.LoadConfig(bs, atf))
+      if (!base.LoadConfig(bs, atf))
         return false;
 
-      m_atom = defaultAtom;
+      atom = defaultAtom;
+      isLiveSite = tmp_m_isLiveSite;
+      eventCount = tmp_m_eventCount;
+      lastChangedEventCount = tmp_m_lastChangedEventCount;
+      lastEventNumber = tmp_m_lastEventNumber;
+      return true;
+    }
+
+    /**
+       Fill image from the given site fields.  Like SaveSiteConfig,
+       shared by every site storage layout.
+     */
+    static void SaveSiteImage(SiteImage<AC> & image, bool isLiveSite, u64 eventCount,
+                              u64 lastChangedEventCount, u64 lastEventNumber,
+                              const T & atom, const Base<AC> & base)
+    {
+      memset((void *) &image, 0, sizeof(image));  // No junk in the padding
+      image.m_eventCount = eventCount;
+      image.m_lastChangedEventCount = lastChangedEventCount;
+      image.m_lastEventNumber = lastEventNumber;
+      image.m_lastTouchEventCount = base.GetSensory().m_touchSensor.m_lastTouchEventCount;
+      image.m_atom = atom;
+      image.m_baseAtom = base.GetBaseAtom();
+      image.m_paint = base.GetPaint();
+      image.m_touchType = base.GetSensory().m_touchSensor.m_touchType;
+      image.m_isLiveSite = isLiveSite;
+    }
+
+    /**
+       Set the given site fields from image, whose atom types must
+       already be those of this process.
+     */
+    static void LoadSiteImage(const SiteImage<AC> & image, bool & isLiveSite, u64 & eventCount,
+                              u64 & lastChangedEventCount, u64 & lastEventNumber,
+                              T & atom, Base<AC> & base)
+    {
+      isLiveSite = image.m_isLiveSite != 0;
+      eventCount = image.m_eventCount;
+      lastChangedEventCount = image.m_lastChangedEventCount;
+      lastEventNumber = image.m_lastEventNumber;
+      atom = image.m_atom;
+      base.PutBaseAtom(image.m_baseAtom);
+      base.SetPaint(image.m_paint);
+      base.GetSensory().m_touchSensor.Touch((SiteTouchType) image.m_touchType,
+                                            image.m_lastTouchEventCount);
+    }
+
+    void SaveImage(SiteImage<AC> & image) const
+    {
+      SaveSiteImage(image, m_isLiveSite, Stats::GetEventCount(),
+                    Stats::GetLastChangedEventCount(), Stats::GetLastEventNumber(),
+                    m_atom, m_base);
+    }
 
-      m_isLiveSite = tmp_m_isLiveSite;
-      m_eventCount = tmp_m_eventCount;
-      m_lastChangedEventCount = tmp_m_lastChangedEventCount;
-      m_lastEventNumber = tmp_m_lastEventNumber;
+    void LoadImage(const SiteImage<AC> & image)
+    {
+      u64 eventCount, lastChangedEventCount, lastEventNumber;
+      LoadSiteImage(image, m_isLiveSite, eventCount, lastChangedEventCount,
+                    lastEventNumber, m_atom, m_base);
+      Stats::Set(eventCount, lastChangedEventCount, lastEventNumber);
+    }
 
+    void SaveConfig(ByteSink& bs, AtomTypeFormatter<AC> & atf) const
+    {
+      SaveSiteConfig(bs, atf, m_isLiveSite, Stats::GetEventCount(),
+                     Stats::GetLastChangedEventCount(), Stats::GetLastEventNumber(),
+                     m_atom, m_base);
+    }
+
+    bool LoadConfig(LineCountingByteSource& bs, AtomTypeFormatter<AC> & atf)
+    {
+      u64 eventCount, lastChangedEventCount, lastEventNumber;
+      if (!LoadSiteConfig(bs, atf, m_isLiveSite, eventCount,
+                          lastChangedEventCount, lastEventNumber,
+                          m_atom, m_base))
+        return false;
+      Stats::Set(eventCount, lastChangedEventCount, lastEventNumber);
       return true;
     }
 
     void Sense(SiteTouchType stt)
     {
-      m_base.GetSensory().Touch(stt, m_eventCount);
+      if (!STATS) return;  // Touches age by site events
+      m_base.GetSensory().Touch(stt, Stats::GetEventCount());
     }
 
     bool InRecentProximity() const
@@ -151,7 +353,8 @@ namespace MFM
 
     u32 RecentTouch() const
     {
-      return m_base.GetSensory().RecentTouch(m_eventCount);
+      if (!STATS) return TOUCH_TYPE_NONE;
+      return m_base.GetSensory().RecentTouch(Stats::GetEventCount());
     }
 
     bool HasRecentLightTouch()
@@ -176,29 +379,28 @@ namespace MFM
 
     void Clear() {
       m_atom.SetEmpty();
-      m_eventCount = 0;
-      m_lastChangedEventCount = 0;
+      Stats::Clear();
       m_base.GetSensory().Clear();
     }
 
     u64 GetEventCount() const {
-      return m_eventCount;
+      return Stats::GetEventCount();
     }
 
     u64 GetLastChangedEventCount() const {
-      return m_lastChangedEventCount;
+      return Stats::GetLastChangedEventCount();
     }
 
     void MarkChanged() {
-      m_lastChangedEventCount = m_eventCount;
+      Stats::MarkChanged();
     }
 
     u64 GetWriteAge() const {
-      return m_eventCount - m_lastChangedEventCount;
+      return Stats::GetEventCount() - Stats::GetLastChangedEventCount();
     }
 
     u64 GetEventAge(u64 currentEventNumber) const {
-      return m_lastEventNumber - currentEventNumber;
+      return Stats::GetLastEventNumber() - currentEventNumber;
     }
 
   };
@@ -0,0 +1,199 @@
+/*                                              -*- mode:C++ -*-
+  SiteClaimMap.h Per-site owners keeping concurrent event windows apart
+  Copyright (C) 2015 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file SiteClaimMap.h Per-site owners keeping concurrent event windows apart
+  \author David H. Ackley.
+  \date (C) 2015 All rights reserved.
+  \lgpl
+ */
+#ifndef SITECLAIMMAP_H
+#define SITECLAIMMAP_H
+
+#include "itype.h"
+#include "Fail.h"
+#include "Point.h"
+#include "MDist.h"
+
+namespace MFM
+{
+  /**
+     The owner, if any, of each site of a tile, for a tile running
+     several event windows at once.  Before an event a window claims
+     the sites it will touch, and the claim succeeds only if none of
+     them is owned by another window, so two events in progress
+     never share a site.  The claim is all-or-nothing: a window that
+     finds any site taken gets none of them, and should just try
+     somewhere else.
+
+     Each site is claimed by its own compare-and-swap, so windows
+     claiming far-apart sites never contend.  A claim that hits a
+     taken site gives back the sites it took on the way.  Until it
+     does, another claim can see them taken and fail, spuriously but
+     harmlessly, since it just tries elsewhere.  The claim and
+     conflict counts are not synchronized, and may be slightly off.
+     Storage is allocated only by Allocate, which must not race with
+     claims, so an unused SiteClaimMap costs nothing but its header.
+   */
+  template <u32 R>
+  class SiteClaimMap
+  {
+  public:
+    enum { SITE_COUNT = EVENT_WINDOW_SITES(R) };
+    enum { UNOWNED = 0 };
+
+  private:
+    volatile u8 * m_owners;  // m_owners[y * m_width + x] is the owner of (x,y)
+    u32 m_width;
+    u32 m_height;
+    s32 m_offsets[SITE_COUNT];  // From a window center, in m_owners
+
+    u64 m_claims;      // Successful claims
+    u64 m_conflicts;   // Claims refused because a site was taken
+
+    SiteClaimMap(const SiteClaimMap &) ; // Declare away
+    SiteClaimMap & operator=(const SiteClaimMap &) ; // Declare away
+
+  public:
+    SiteClaimMap()
+      : m_owners(0)
+      , m_width(0)
+      , m_height(0)
+      , m_claims(0)
+      , m_conflicts(0)
+    { }
+
+    ~SiteClaimMap()
+    {
+      delete [] m_owners;
+    }
+
+    bool IsAllocated() const
+    {
+      return m_owners != 0;
+    }
+
+    /**
+       Allocate (or reallocate) storage for a width by height tile,
+       with every site unowned.
+     */
+    void Allocate(u32 width, u32 height)
+    {
+      MFM_API_ASSERT_ARG(width > 2 * R && height > 2 * R);
+      delete [] m_owners;
+      m_width = width;
+      m_height = height;
+      m_owners = new u8[m_width * m_height];
+      for (u32 i = 0; i < m_width * m_height; m_owners[i++] = UNOWNED);
+
+      const MDist<R> & md = MDist<R>::get();
+      for (u32 i = 0; i < SITE_COUNT; ++i)
+      {
+        const SPoint & pt = md.GetPoint(i);
+        m_offsets[i] = pt.GetY() * (s32) m_width + pt.GetX();
+      }
+      m_claims = m_conflicts = 0;
+    }
+
+    /**
+       Try to claim, for owner, the first siteCount sites of the event
+       window centered at center -- so 1 claims just the center, and
+       SITE_COUNT the whole window.  Sites owner already holds count
+       as free, so a window can claim its center first and the rest
+       later.  Returns false, claiming nothing more, if any of the
+       sites belongs to some other owner.  The whole window must lie
+       within the tile.
+     */
+    bool TryClaim(const SPoint & center, u8 owner, u32 siteCount)
+    {
+      MFM_API_ASSERT_ARG(owner != UNOWNED && siteCount <= SITE_COUNT);
+      MFM_API_ASSERT_ARG(center.GetX() >= (s32) R && center.GetX() < (s32) (m_width - R) &&
+                         center.GetY() >= (s32) R && center.GetY() < (s32) (m_height - R));
+      MFM_API_ASSERT_STATE(IsAllocated());
+
+      volatile u8 * const centerOwner = &m_owners[center.GetY() * m_width + center.GetX()];
+
+      bool took[SITE_COUNT];
+      for (u32 i = 0; i < siteCount; ++i)
+      {
+        volatile u8 & site = centerOwner[m_offsets[i]];
+        took[i] = site != owner;
+        if (took[i] && !__sync_bool_compare_and_swap(&site, (u8) UNOWNED, owner))
+        {
+          while (i-- > 0)
+          {
+            if (took[i])
+            {
+              centerOwner[m_offsets[i]] = UNOWNED;
+            }
+          }
+          ++m_conflicts;
+          return false;
+        }
+      }
+      ++m_claims;
+      return true;
+    }
+
+    /**
+       Release every site of the window centered at center that owner
+       holds.
+     */
+    void Release(const SPoint & center, u8 owner)
+    {
+      MFM_API_ASSERT_STATE(IsAllocated());
+      volatile u8 * const centerOwner = &m_owners[center.GetY() * m_width + center.GetX()];
+
+      __sync_synchronize();  // The event's writes before the sites go
+      for (u32 i = 0; i < SITE_COUNT; ++i)
+      {
+        volatile u8 & was = centerOwner[m_offsets[i]];
+        if (was == owner)
+        {
+          was = UNOWNED;
+        }
+      }
+    }
+
+    /**
+       Get the owner of the site at pt, or UNOWNED.  Only a snapshot,
+       unless the caller is that owner.
+     */
+    u8 GetOwner(const SPoint & pt)
+    {
+      MFM_API_ASSERT_STATE(IsAllocated());
+      MFM_API_ASSERT_ARG(pt.GetX() >= 0 && pt.GetX() < (s32) m_width &&
+                         pt.GetY() >= 0 && pt.GetY() < (s32) m_height);
+      return m_owners[pt.GetY() * m_width + pt.GetX()];
+    }
+
+    u64 GetClaims() const
+    {
+      return m_claims;
+    }
+
+    u64 GetConflicts() const
+    {
+      return m_conflicts;
+    }
+  };
+} /* namespace MFM */
+
+#endif /*SITECLAIMMAP_H*/
@@ -0,0 +1,152 @@
+/*                                              -*- mode:C++ -*-
+  SiteIndexSet.h A set of site numbers with constant-time update and sampling
+  Copyright (C) 2015 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file SiteIndexSet.h A set of site numbers with constant-time update and sampling
+  \author David H. Ackley.
+  \date (C) 2015 All rights reserved.
+  \lgpl
+ */
+#ifndef SITEINDEXSET_H
+#define SITEINDEXSET_H
+
+#include "itype.h"
+#include "Fail.h"
+
+namespace MFM
+{
+  /**
+     A set of site numbers in 0..capacity-1, kept as a dense array of
+     members plus the slot of each member within it, so that
+     insertion, removal, membership and picking the i'th member are
+     all constant time.  Storage is allocated only by Allocate, so an
+     unused SiteIndexSet costs nothing but its header.
+   */
+  class SiteIndexSet
+  {
+    enum { NOT_A_MEMBER = U32_MAX };
+
+    u32 * m_members;  // m_members[0..m_count-1] are the set
+    u32 * m_slots;    // m_slots[site] is its index in m_members, or NOT_A_MEMBER
+    u32 m_capacity;
+    u32 m_count;
+
+    SiteIndexSet(const SiteIndexSet &) ; // Declare away
+    SiteIndexSet & operator=(const SiteIndexSet &) ; // Declare away
+
+  public:
+    SiteIndexSet()
+      : m_members(0)
+      , m_slots(0)
+      , m_capacity(0)
+      , m_count(0)
+    { }
+
+    ~SiteIndexSet()
+    {
+      delete [] m_members;
+      delete [] m_slots;
+    }
+
+    /**
+       Make room for site numbers 0..capacity-1, and empty the set.
+     */
+    void Allocate(u32 capacity)
+    {
+      if (capacity != m_capacity)
+      {
+        delete [] m_members;
+        delete [] m_slots;
+        m_members = new u32[capacity];
+        m_slots = new u32[capacity];
+        m_capacity = capacity;
+      }
+      for (u32 i = 0; i < m_capacity; ++i)
+      {
+        m_slots[i] = NOT_A_MEMBER;
+      }
+      m_count = 0;
+    }
+
+    bool IsAllocated() const
+    {
+      return m_capacity > 0;
+    }
+
+    void Clear()
+    {
+      while (m_count > 0)
+      {
+        m_slots[m_members[--m_count]] = NOT_A_MEMBER;
+      }
+    }
+
+    u32 GetCount() const
+    {
+      return m_count;
+    }
+
+    u32 Get(u32 index) const
+    {
+      MFM_API_ASSERT_ARG(index < m_count);
+      return m_members[index];
+    }
+
+    bool Contains(u32 site) const
+    {
+      MFM_API_ASSERT_ARG(site < m_capacity);
+      return m_slots[site] != NOT_A_MEMBER;
+    }
+
+    /**
+       Add site to the set.  Returns false if it was already there.
+     */
+    bool Insert(u32 site)
+    {
+      if (Contains(site))
+      {
+        return false;
+      }
+      m_slots[site] = m_count;
+      m_members[m_count++] = site;
+      return true;
+    }
+
+    /**
+       Remove site from the set, by moving the last member into its
+       slot.  Returns false if it wasn't there.
+     */
+    bool Remove(u32 site)
+    {
+      if (!Contains(site))
+      {
+        return false;
+      }
+      const u32 slot = m_slots[site];
+      const u32 last = m_members[--m_count];
+      m_members[slot] = last;
+      m_slots[last] = slot;
+      m_slots[site] = NOT_A_MEMBER;
+      return true;
+    }
+  };
+} /* namespace MFM */
+
+#endif /*SITEINDEXSET_H*/
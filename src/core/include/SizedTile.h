@@ -30,6 +30,7 @@
 #define SIZEDTILE_H
 
 #include "MFMSTile.h"
+#include "SoASite.h"
 
 namespace MFM
 {
@@ -38,10 +39,19 @@ namespace MFM
      A SizedTile provides a completed Tile, possessing a size and site
      storage, and offering a default constructor so that arrays of
      SizedTiles can be formed.
+
+     The site storage is a base class, rather than a member, so that
+     it is constructed before the Tile that initializes the sites.
+     Its layout is determined by the SITE type of the EventConfig
+     (see SiteStorage).
    */
   template <class EC, u32 WIDTH, u32 HEIGHT, u32 EVENTHISTORYSIZE>
-  class SizedTile : public MFMSTile<EC>
+  class SizedTile
+    : private SiteStorage<typename EC::SITE, WIDTH * HEIGHT>
+    , public MFMSTile<EC>
   {
+    typedef SiteStorage<typename EC::SITE, WIDTH * HEIGHT> Storage;
+
   public:
     typedef typename EC::SITE SITE;
 
@@ -55,11 +65,10 @@ namespace MFM
 
     static bool IsGridLayoutPatternStaggered() { return (m_ctorLayoutPattern == GRID_LAYOUT_STAGGERED); }
 
-    SizedTile(): MFMSTile<EC>(TILE_WIDTH, TILE_HEIGHT, m_ctorLayoutPattern, m_sites, EVENTHISTORYSIZE, m_items) { }
+    SizedTile(): MFMSTile<EC>(TILE_WIDTH, TILE_HEIGHT, m_ctorLayoutPattern, Storage::GetSitePlanes(), EVENTHISTORYSIZE, m_items) { }
 
 
   private:
-    SITE m_sites[TILE_SITES];
     EventHistoryItem m_items[EVENTHISTORYSIZE];
     static GridLayoutPattern m_ctorLayoutPattern;
 
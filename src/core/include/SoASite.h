@@ -0,0 +1,281 @@
+/*                                              -*- mode:C++ -*-
+  SoASite.h A Site whose fields live in per-tile parallel arrays
+  Copyright (C) 2015 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file SoASite.h A Site whose fields live in per-tile parallel arrays
+  \author David H. Ackley.
+  \date (C) 2015 All rights reserved.
+  \lgpl
+ */
+#ifndef SOASITE_H
+#define SOASITE_H
+
+#include "itype.h"
+#include "Site.h"
+
+namespace MFM
+{
+  /**
+     An SoASite offers the same interface as a Site, but its atom,
+     base, statistics and liveness live in parallel arrays -- the
+     PLANES -- belonging to its tile.  Using SoASite as the SITE of an
+     EventConfig makes a SizedTile store its sites in a
+     structure-of-arrays layout, so that loading an event window only
+     touches the contiguous atoms.
+
+     SoASites are handles, not values: a Tile makes one on demand from
+     its planes and a site number, and hands it out by value (see
+     REF).  Nothing of them is stored.  As with Site, STATS false
+     compiles the per-site event statistics out.
+   */
+  template <class AC, bool STATS = true>
+  class SoASite
+  {
+  public:
+    /**
+       Present the AtomConfig in use
+     */
+    typedef AC ATOM_CONFIG;
+
+    /**
+       Present whether per-site event statistics are kept
+     */
+    enum { SITE_STATS = STATS };
+
+    // Extract short names for parameter types
+    typedef typename ATOM_CONFIG::ATOM_TYPE T;
+
+  private:
+    typedef SiteStats<STATS> Stats;
+
+  public:
+    /**
+       The parallel arrays of a tile's site fields, indexed by site
+       number.  Without statistics, m_stats holds a single empty
+       SiteStats standing in for all sites.
+     */
+    struct PLANES
+    {
+      T * m_atoms;
+      Base<AC> * m_bases;
+      Stats * m_stats;
+      bool * m_isLiveSite;
+    };
+
+    /**
+       A Tile hands out SoASites by value
+     */
+    typedef SoASite REF;
+    typedef const SoASite CONST_REF;
+
+    static REF GetSiteIn(const PLANES & planes, u32 siteNumber)
+    {
+      return SoASite(planes, siteNumber);
+    }
+
+    static T & GetAtomIn(const PLANES & planes, u32 siteNumber)
+    {
+      return planes.m_atoms[siteNumber];
+    }
+
+    static Base<AC> & GetBaseIn(const PLANES & planes, u32 siteNumber)
+    {
+      return planes.m_bases[siteNumber];
+    }
+
+  private:
+    const PLANES & m_planes;
+    const u32 m_index;
+
+    SoASite(const PLANES & planes, u32 index)
+      : m_planes(planes)
+      , m_index(index)
+    { }
+
+    SoASite & operator=(const SoASite &) ; // Declare away
+
+    Stats & GetStats() const { return m_planes.m_stats[STATS ? m_index : 0]; }
+
+    bool & IsLiveSite() const { return m_planes.m_isLiveSite[m_index]; }
+
+  public:
+
+    void RecordEventAtSite(u64 eventNumber)
+    {
+      GetStats().RecordEvent(eventNumber);
+    }
+
+    void SaveConfig(ByteSink& bs, AtomTypeFormatter<AC> & atf) const
+    {
+      const Stats & stats = GetStats();
+      Site<AC>::SaveSiteConfig(bs, atf, IsLiveSite(),
+                               stats.GetEventCount(), stats.GetLastChangedEventCount(),
+                               stats.GetLastEventNumber(), GetAtom(), GetBase());
+    }
+
+    bool LoadConfig(LineCountingByteSource& bs, AtomTypeFormatter<AC> & atf)
+    {
+      u64 eventCount, lastChangedEventCount, lastEventNumber;
+      if (!Site<AC>::LoadSiteConfig(bs, atf, IsLiveSite(),
+                                    eventCount, lastChangedEventCount,
+                                    lastEventNumber, GetAtom(), GetBase()))
+        return false;
+      GetStats().Set(eventCount, lastChangedEventCount, lastEventNumber);
+      return true;
+    }
+
+    void SaveImage(SiteImage<AC> & image) const
+    {
+      const Stats & stats = GetStats();
+      Site<AC>::SaveSiteImage(image, IsLiveSite(),
+                              stats.GetEventCount(), stats.GetLastChangedEventCount(),
+                              stats.GetLastEventNumber(), GetAtom(), GetBase());
+    }
+
+    void LoadImage(const SiteImage<AC> & image)
+    {
+      u64 eventCount, lastChangedEventCount, lastEventNumber;
+      Site<AC>::LoadSiteImage(image, IsLiveSite(),
+                              eventCount, lastChangedEventCount, lastEventNumber,
+                              GetAtom(), GetBase());
+      GetStats().Set(eventCount, lastChangedEventCount, lastEventNumber);
+    }
+
+    void Sense(SiteTouchType stt)
+    {
+      if (!STATS) return;  // Touches age by site events
+      GetBase().GetSensory().Touch(stt, GetStats().GetEventCount());
+    }
+
+    bool InRecentProximity() const
+    {
+      return TOUCH_TYPE_PROXIMITY == RecentTouch();
+    }
+
+    u32 RecentTouch() const
+    {
+      if (!STATS) return TOUCH_TYPE_NONE;
+      return GetBase().GetSensory().RecentTouch(GetStats().GetEventCount());
+    }
+
+    bool HasRecentLightTouch()
+    {
+      return TOUCH_TYPE_LIGHT == RecentTouch();
+    }
+
+    void PutAtom(const T & newAtom) { GetAtom() = newAtom; }
+
+    T & GetAtom() { return m_planes.m_atoms[m_index]; }
+
+    const T & GetAtom() const { return m_planes.m_atoms[m_index]; }
+
+    Base<AC> & GetBase() { return m_planes.m_bases[m_index]; }
+
+    const Base<AC> & GetBase() const { return m_planes.m_bases[m_index]; }
+
+    u32 GetPaint() const {
+      return GetBase().GetPaint();
+    }
+
+    void SetPaint(u32 paint) {
+      GetBase().SetPaint(paint);
+    }
+
+    void Clear() {
+      GetAtom().SetEmpty();
+      GetStats().Clear();
+      GetBase().GetSensory().Clear();
+    }
+
+    u64 GetEventCount() const {
+      return GetStats().GetEventCount();
+    }
+
+    u64 GetLastChangedEventCount() const {
+      return GetStats().GetLastChangedEventCount();
+    }
+
+    void MarkChanged() {
+      GetStats().MarkChanged();
+    }
+
+    u64 GetWriteAge() const {
+      const Stats & stats = GetStats();
+      return stats.GetEventCount() - stats.GetLastChangedEventCount();
+    }
+
+    u64 GetEventAge(u64 currentEventNumber) const {
+      return GetStats().GetLastEventNumber() - currentEventNumber;
+    }
+
+  };
+
+  /**
+     Storage for the SITES sites of a SizedTile.  By default, simply
+     an array of SITE.
+   */
+  template <class SITE, u32 SITES>
+  class SiteStorage
+  {
+    SITE m_sites[SITES];
+
+  public:
+    typename SITE::PLANES GetSitePlanes() { return m_sites; }
+  };
+
+  /**
+     Structure-of-arrays storage for a tile of SoASites: the atoms,
+     bases, statistics and liveness flags each get their own array,
+     handed to the tile as its SoASite::PLANES.  Without statistics,
+     a single empty SiteStats stands in for all sites.
+   */
+  template <class AC, bool STATS, u32 SITES>
+  class SiteStorage<SoASite<AC,STATS>, SITES>
+  {
+    typedef typename AC::ATOM_TYPE T;
+
+    T m_atoms[SITES];
+    Base<AC> m_bases[SITES];
+    SiteStats<STATS> m_stats[STATS ? SITES : 1];
+    bool m_isLiveSite[SITES];
+
+    SiteStorage(const SiteStorage &) ; // Declare away
+    SiteStorage & operator=(const SiteStorage &) ; // Declare away
+
+  public:
+    SiteStorage()
+    {
+      for (u32 i = 0; i < SITES; m_isLiveSite[i++] = true);
+    }
+
+    typename SoASite<AC,STATS>::PLANES GetSitePlanes()
+    {
+      typename SoASite<AC,STATS>::PLANES planes;
+      planes.m_atoms = m_atoms;
+      planes.m_bases = m_bases;
+      planes.m_stats = m_stats;
+      planes.m_isLiveSite = m_isLiveSite;
+      return planes;
+    }
+  };
+
+} /* namespace MFM */
+
+#endif /*SOASITE_H*/
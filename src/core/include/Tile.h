@@ -44,6 +44,9 @@
 #include "CacheProcessor.h"
 #include "UlamClassRegistry.h"
 #include "LonglivedLock.h"
+#include "PhaseBarrier.h"
+#include "SiteIndexSet.h"
+#include "SiteClaimMap.h"
 #include "OverflowableCharBufferByteSink.h"  /* for OString16 */
 #include "LineCountingByteSource.h"
 
@@ -89,6 +92,9 @@ namespace MFM
     typedef typename EC::ATOM_CONFIG AC;
     typedef typename AC::ATOM_TYPE T;
     typedef typename EC::SITE S;
+    typedef typename S::PLANES SITE_PLANES;
+    typedef typename S::REF SITE_REF;
+    typedef typename S::CONST_REF CONST_SITE_REF;
 
     // Promote some parameter names
     enum { EVENT_WINDOW_RADIUS = EC::EVENT_WINDOW_RADIUS };
@@ -137,7 +143,7 @@ namespace MFM
       REGION_COUNT
     };
 
-    Tile(const u32 tileWidth, const u32 tileHeight, const GridLayoutPattern gridlayout, S * sites, const u32 eventbuffersize, EventHistoryItem * items) ;
+    Tile(const u32 tileWidth, const u32 tileHeight, const GridLayoutPattern gridlayout, const SITE_PLANES & sites, const u32 eventbuffersize, EventHistoryItem * items) ;
 
     virtual ~Tile() ;
 
@@ -187,9 +193,9 @@ namespace MFM
        tile, \e including the caches, so index ranges from
        0..TILE_WIDTH-1 in x, and 0..TILE_HEIGHT-1 in y
      */
-    const S & GetSite(const SPoint index) const
+    CONST_SITE_REF GetSite(const SPoint index) const
     {
-      return m_sites[GetSiteInTileNumber(index)];
+      return S::GetSiteIn(m_sitePlanes, GetSiteInTileNumber(index));
     }
 
     /**
@@ -197,9 +203,9 @@ namespace MFM
        tile, \e including the caches, so index ranges from
        0..TILE_WIDTH-1 in x, and 0..TILE_HEIGHT-1 in y
      */
-    S & GetSite(const SPoint index)
+    SITE_REF GetSite(const SPoint index)
     {
-      return const_cast<S &>(static_cast<const Tile<EC>*>(this)->GetSite(index));
+      return S::GetSiteIn(m_sitePlanes, GetSiteInTileNumber(index));
     }
 
     /**
@@ -207,7 +213,7 @@ namespace MFM
        tile, \e excluding the caches, so index ranges from
        0..OWNED_WIDTH-1 in x, and 0..OWNED_HEIGHT-1 in y
      */
-    const S & GetUncachedSite(const SPoint index) const
+    CONST_SITE_REF GetUncachedSite(const SPoint index) const
     {
       return GetSite(index + SPoint(EVENT_WINDOW_RADIUS,EVENT_WINDOW_RADIUS));
     }
@@ -217,11 +223,31 @@ namespace MFM
        tile, \e excluding the caches, so index ranges from
        0..OWNED_WIDTH-1 in x, and 0..OWNED_HEIGHT-1 in y
      */
-    S & GetUncachedSite(const SPoint index)
+    SITE_REF GetUncachedSite(const SPoint index)
     {
       return GetSite(index + SPoint(EVENT_WINDOW_RADIUS,EVENT_WINDOW_RADIUS));
     }
 
+    /**
+       Get the Atom at site number \c siteNumber (see
+       GetSiteInTileNumber) straight from the tile's site planes,
+       \e including the caches.  With SoASites this is just an index
+       into the tile's array of atoms.
+     */
+    const T & GetPlaneAtom(const u32 siteNumber) const
+    {
+      return S::GetAtomIn(m_sitePlanes, siteNumber);
+    }
+
+    /**
+       Get the Base at site number \c siteNumber straight from the
+       tile's site planes, as GetPlaneAtom.
+     */
+    Base<AC> & GetPlaneBase(const u32 siteNumber)
+    {
+      return S::GetBaseIn(m_sitePlanes, siteNumber);
+    }
+
     /**
        Get the coordinate of a randomly selected 'owned' site in this
        tile.  An owned site is one that can be at the center of an
@@ -232,11 +258,183 @@ namespace MFM
       return OwnedCoordToTile(SPoint(GetRandom(), OWNED_WIDTH, OWNED_HEIGHT));
     }
 
+    /**
+       Get the coordinate of the next event center for this tile.
+       Normally this is just GetRandomOwnedCoord(), but with active
+       site selection enabled, it is usually a random non-empty owned
+       site instead.
+
+       \sa SetActiveSiteSelection
+     */
+    SPoint GetEventCenterCoord() ;
+
+    /**
+       Enable or disable active site selection.  When enabled, the
+       tile keeps the set of its non-empty owned sites, and picks
+       event centers uniformly from that set, except that \c
+       uniformPercent percent of the time (and whenever the set is
+       empty) it picks uniformly from all owned sites as usual.
+       Since empty sites have no behavior, this changes only how
+       often events land on empty sites, not the relative rates of
+       events among occupied ones.
+     */
+    void SetActiveSiteSelection(bool enabled, u32 uniformPercent) ;
+
+    bool IsActiveSiteSelection() const
+    {
+      return m_activeSiteSelection;
+    }
+
+    u32 GetUniformSelectionPercent() const
+    {
+      return m_uniformSelectionPercent;
+    }
+
+    /**
+       Get the number of non-empty owned sites known to active site
+       selection, rebuilding the set first if needed.  Zero if active
+       site selection is disabled.
+     */
+    u32 GetActiveSiteCount() ;
+
+    /**
+     * The most event windows a tile may run at once, and the number
+     * of events each helper window runs per AdvanceComputation.
+     */
+    enum { MAX_CONCURRENT_WINDOWS = 8, HELPER_BATCH_EVENTS = 16 };
+
+    /**
+       Run count event windows at once in this tile: the usual one,
+       driven by the tile's own thread, plus count-1 helper windows,
+       each on a thread of its own.  A SiteClaimMap keeps the windows
+       from overlapping.  Helpers only take event centers in the
+       hidden region, so they never touch a CacheProcessor or a site
+       a neighbor can update, and they only run while the tile's
+       thread is inside AdvanceComputation, so whenever the tile is
+       not advancing, it is quiescent as usual.  A count of 1 stops
+       any helpers.  Requires a non-empty hidden region when count
+       exceeds 1, and must not be called while the tile is advancing.
+     */
+    void SetConcurrentWindows(u32 count) ;
+
+    u32 GetConcurrentWindows() const
+    {
+      return m_concurrentWindows;
+    }
+
+    /**
+       Get the map through which concurrent event windows claim their
+       sites, or null if this tile runs only one window at a time.
+     */
+    SiteClaimMap<EVENT_WINDOW_RADIUS> * GetSiteClaims()
+    {
+      return m_concurrentWindows > 1 ? &m_siteClaims : 0;
+    }
+
+    /**
+       Get the number of event attempts abandoned because another
+       window held some of their sites.
+     */
+    u64 GetSiteClaimConflicts() const
+    {
+      return m_siteClaims.GetConflicts();
+    }
+
+    /**
+       Enable or disable deterministic mode.  A deterministic tile
+       initiates events only during phases begun by
+       StartDeterministicPhase, iterates its CacheProcessors in a fixed
+       order, and lets each event that needs intertile locks wait for
+       its CacheProcessors to go idle, rather than draw another event
+       center, so that the events it runs depend only on its state and
+       the phase seed, not on thread timing.  Requires a single event
+       window.  Must not be called while the tile is advancing.
+     */
+    void SetDeterministic(bool deterministic) ;
+
+    bool IsDeterministic() const
+    {
+      return m_deterministic;
+    }
+
+    /**
+       Begin a deterministic phase, in which the tile reseeds its PRNG
+       with seed and then attempts events events.  When they are done
+       and its CacheProcessors are idle again, the tile's thread
+       calls barrier.Finish().  Called from a thread other than the
+       tile's, after the previous phase has been reported done.
+     */
+    void StartDeterministicPhase(u32 seed, u32 events, PhaseBarrier & barrier) ;
+
+    /**
+       Enable or disable sequential mode, in which the Grid runs this
+       tile's events itself, on its own thread, through
+       RunSequentialEvents.  neighbors[d] is the tile, if any, that
+       the CacheProcessor in direction d connects to.  A sequential
+       tile's events take no intertile locks and involve no
+       CacheProcessor: instead each atom an event writes into the
+       shared or cache region is written straight through to every
+       neighbor holding a copy of that site.  That is only safe if no
+       two neighboring tiles ever run events at once.  Requires a
+       single event window and must not be called while the tile is
+       advancing.  Pass null to leave sequential mode.
+     */
+    void SetSequential(Tile<EC> * const * neighbors) ;
+
+    bool IsSequential() const
+    {
+      return m_sequential;
+    }
+
+    /**
+       Copy the atom at pt, if it is in the shared or cache region,
+       to each neighbor tile that also holds that site.  Sequential
+       mode only.
+     */
+    void WriteThrough(const SPoint & pt) ;
+
+    /**
+       In sequential mode, act on any requested state change, and
+       then, if the tile is active and enabled, attempt up to \c
+       attempts events on the calling thread.  Returns the number of
+       events executed.
+     */
+    u32 RunSequentialEvents(u32 attempts) ;
+
+    /**
+       Get the coordinate of a site in the hidden region, drawn
+       uniformly using random.  The hidden region must not be empty.
+     */
+    SPoint GetRandomHiddenCoord(Random & random) const
+    {
+      const u32 margin = 3 * EVENT_WINDOW_RADIUS;
+      return SPoint(random, TILE_WIDTH - 2 * margin, TILE_HEIGHT - 2 * margin) +
+        SPoint(margin, margin);
+    }
+
+    /**
+       The number of atoms of atomType in this tile's owned sites.
+       While the tile runs events on threads of its own, they do any
+       recount a bulk change (a load, an X-ray, ..) calls for, so a
+       count may briefly lag such a change.
+     */
     u32 GetAtomCount(ElementType atomType) const
     {
+      RecountAtomsIfIdle();
       return m_cdata.GetAtomCount(atomType);
     }
 
+    /**
+       Recount the atoms in this tile from scratch, and return how
+       many element types (counting illegal atoms as one) the
+       incrementally maintained counts had wrong, logging each.  The
+       tile must not be running.
+     */
+    u32 AuditAtomCounts() const
+    {
+      return m_cdata.AuditAtomCounts();
+    }
+
     /**
      * The maximum number of tile parameters
      */
@@ -292,7 +490,7 @@ namespace MFM
 
   private:
 
-    S * const m_sites;
+    const SITE_PLANES m_sitePlanes;
 
     /**
      * A brief name or label for this Tile, for reporting and debugging
@@ -368,7 +566,7 @@ namespace MFM
     /**
      * A minimal iterator over the Sites of a tile.  Access via Tile::begin().
      */
-    template <class SITETYPE, class TILETYPE>
+    template <class SITEREF, class TILETYPE>
     class TileIterator
     {
       TILETYPE & t;
@@ -410,16 +608,11 @@ namespace MFM
       }
       */
 
-      SITETYPE & operator*() const
+      SITEREF operator*() const
       {
         return t.GetSite(AtSite());
       }
 
-      SITETYPE * operator->() const
-      {
-        return &t.GetSite(AtSite());
-      }
-
       /* AtSite() etc methods are always absolute full Tile coords */
       SPoint AtSite() const { return SPoint(GetXSite(),GetYSite()); }
       u32 GetXSite() const { return (u32) i; }
@@ -432,8 +625,8 @@ namespace MFM
 
     };
 
-    typedef TileIterator< S, Tile<EC> > iterator_type;
-    typedef TileIterator< const S, const Tile<EC> > const_iterator_type;
+    typedef TileIterator< SITE_REF, Tile<EC> > iterator_type;
+    typedef TileIterator< CONST_SITE_REF, const Tile<EC> > const_iterator_type;
 
     iterator_type beginAll() {
       return iterator_type(*this, 0, 0, 0);
@@ -501,23 +694,53 @@ namespace MFM
 
       u32 m_illegalAtomCount;
 
-      /** false when the m_atomCount counts are known valid.*/
-      bool m_needRecount;
+      /** false when the m_atomCount counts are known valid.  Set
+          by any thread; cleared only by RecountIfNeeded.*/
+      volatile bool m_needRecount;
 
       void RecountAtoms() ;
 
+      /**
+         Count one owned site's atom as oldType no more and newType
+         instead, keeping the counts current without a recount.
+       */
+      void CountTypeChange(u32 oldType, u32 newType)
+      {
+        if (m_needRecount || oldType == newType)
+        {
+          return;  // A recount will take care of it, or nothing to do
+        }
+        CountType(oldType, -1);
+        CountType(newType, +1);
+      }
+
+      void CountType(u32 type, s32 delta)
+      {
+        s32 idx = m_tile.m_elementTable.GetIndex(type);
+        if (idx < 0) m_illegalAtomCount += delta;
+        else m_atomCount[idx] += delta;
+      }
+
+      u32 AuditAtomCounts() ;
+
+      /**
+         Recount, if flagged.  Nothing may change the tile's atoms
+         meanwhile, so only the thread running the tile's events may
+         call this while they run.  The flag is cleared before the
+         scan, so a recount flagged during it is not lost.
+       */
       void RecountIfNeeded()
       {
         if (m_needRecount)
         {
+          m_needRecount = false;
+          __sync_synchronize();  // Clear before scanning
           RecountAtoms();
         }
-        m_needRecount = false;
       }
 
       u32 GetIllegalAtomCount()
       {
-        RecountIfNeeded();
         return m_illegalAtomCount;
       }
 
@@ -601,11 +824,144 @@ namespace MFM
      */
     u32 m_warpFactor;
 
+    /**
+       true if event centers are drawn mostly from m_activeSites
+     */
+    bool m_activeSiteSelection;
+
+    /**
+       Percent of event centers still drawn uniformly from all owned
+       sites when m_activeSiteSelection is true
+     */
+    u32 m_uniformSelectionPercent;
+
+    /**
+       The owned site numbers (y * OWNED_WIDTH + x, in owned
+       coordinates) of the non-empty owned sites, maintained by
+       PlaceAtomInSite while m_activeSiteSelection is true.
+     */
+    SiteIndexSet m_activeSites;
+
+    /**
+       true when atoms may have changed behind PlaceAtomInSite's back
+       (as flagged by NeedAtomRecount), so m_activeSites must be
+       rebuilt before it is used
+     */
+    mutable bool m_activeSitesStale;
+
+    void RebuildActiveSites() ;
+
+    void UpdateActiveSite(const SPoint & pt, bool isEmpty) ;
+
     /**
        Record of recent past events for debugging and such
      */
     EventHistoryBuffer<EC> m_eventHistoryBuffer;
 
+    /**
+       An extra event window, with its own PRNG and thread, run when
+       m_concurrentWindows exceeds 1.  The thread sleeps until
+       AdvanceComputation requests a batch of events, runs them, and
+       goes back to sleep.
+     */
+    struct HelperWindow
+    {
+      Tile & m_tile;
+      Random m_random;
+      EventWindow<EC> m_window;
+      MFMErrorEnvironmentPointer_t m_errorEnvironmentStackTop;
+      pthread_t m_threadId;
+
+      Mutex m_lock;
+      bool m_batchRequested;  // Guarded by m_lock
+      bool m_exitRequested;   // Guarded by m_lock
+
+      struct RequestPredicate : public Mutex::Predicate
+      {
+        HelperWindow & m_hw;
+        RequestPredicate(HelperWindow & hw)
+          : Mutex::Predicate(hw.m_lock)
+          , m_hw(hw)
+        { }
+        virtual bool EvaluatePrecondition() { return true; }
+        virtual bool EvaluatePredicate() { return m_hw.m_batchRequested || m_hw.m_exitRequested; }
+      };
+      RequestPredicate m_request;
+
+      HelperWindow(Tile & tile, u8 claimOwner, u32 seed)
+        : m_tile(tile)
+        , m_random(seed)
+        , m_window(tile)
+        , m_errorEnvironmentStackTop(0)
+        , m_batchRequested(false)
+        , m_exitRequested(false)
+        , m_request(*this)
+      {
+        m_window.SetConcurrentIdentity(claimOwner, m_random);
+      }
+    };
+
+    static void * HelperWindowRunner(void * arg) ;
+
+    /**
+       Request a batch from each helper, then keep running events in
+       m_window, and communicating, until the last helper finishes.
+     */
+    bool AdvanceConcurrentComputation() ;
+
+    void StopHelperWindows() ;
+
+    u32 m_concurrentWindows;
+    HelperWindow * m_helperWindows[MAX_CONCURRENT_WINDOWS - 1];
+
+    /**
+       Helpers still running the batch requested of them
+     */
+    volatile u32 m_helpersBusy;
+
+    SiteClaimMap<EVENT_WINDOW_RADIUS> m_siteClaims;
+
+    bool m_deterministic;
+
+    volatile u32 m_phaseRequested;     // Bumped by StartDeterministicPhase
+    u32 m_phaseStarted;                // Last phase this tile's thread began
+    u32 m_phaseSeed;                   // Set before m_phaseRequested is bumped
+    u32 m_phaseEvents;                 // Set before m_phaseRequested is bumped
+    PhaseBarrier * m_phaseBarrier;     // Set before m_phaseRequested is bumped
+    u32 m_phaseEventsLeft;
+    bool m_phaseReported;
+
+    SPoint m_waitingCenter;            // Chosen but waiting for idle CacheProcessors
+    bool m_isWaitingCenter;
+
+    bool m_sequential;
+    Tile<EC> * m_sequentialNeighbors[Dirs::DIR_COUNT];  // Indexed by CacheProcessor Dir
+
+    /**
+       Guards state touched by every event window, but not covered by
+       site claims -- m_activeSites, m_eventHistoryBuffer, and m_random
+       when drawn for radiation -- while m_concurrentWindows exceeds 1.
+     */
+    Mutex m_windowSharedAccess;
+
+    /**
+       Holds m_windowSharedAccess for its lifetime, if the tile is
+       running concurrent windows.
+     */
+    struct WindowSharedScope
+    {
+      Mutex * m_mutex;
+      WindowSharedScope(Tile & tile)
+        : m_mutex(tile.m_concurrentWindows > 1 ? &tile.m_windowSharedAccess : 0)
+      {
+        if (m_mutex) m_mutex->Lock();
+      }
+      ~WindowSharedScope()
+      {
+        if (m_mutex) m_mutex->Unlock();
+      }
+    };
+
     /**
      * Compute the coordinates of \c atomLoc in a neighboring tile.
      * (There may or may not actually be a Tile in the given \c
@@ -646,6 +1002,18 @@ namespace MFM
 
     bool AdvanceComputation() ;
 
+    /**
+       AdvanceComputation for deterministic mode: attempt the next
+       event of the current phase, if any, or report the phase done.
+     */
+    bool AdvanceDeterministicComputation() ;
+
+    /**
+       true if every connected CacheProcessor is idle, so any event
+       could get the locks it needs.
+     */
+    bool AreCacheProcessorsIdle() const ;
+
     /**
        Advance the passive packet processing state machine in the
        Tile.  Return true if any possibly valuable work was done.
@@ -657,6 +1025,11 @@ namespace MFM
 
     void SetForegroundRadiationEnabled(bool value);
 
+    bool IsForegroundRadiationEnabled() const
+    {
+      return m_foregroundRadiationEnabled;
+    }
+
     void SingleXRay(const SPoint & at, u32 bitOdds) ;
 
     void XRay(u32 siteOdds, u32 bitOdds) ;
@@ -672,6 +1045,35 @@ namespace MFM
       }
     }
 
+    /**
+     * Offer (or stop offering) delta-encoded cache updates on every
+     * cache processor of this Tile.
+     *
+     * \sa CacheProcessor::SetDeltaEncoding
+     */
+    void SetCacheDeltaEncoding(bool offered)
+    {
+      for (u32 d = 0; d < Dirs::DIR_COUNT; ++d)
+      {
+        m_cacheProcessors[d].SetDeltaEncoding(offered);
+      }
+    }
+
+    /**
+     * Get the total bytes and number of cache updates this Tile has
+     * shipped, either as full atoms or as deltas.
+     */
+    void GetCacheTraffic(bool asDeltas, u64 & bytes, u64 & updates) const
+    {
+      bytes = updates = 0;
+      for (u32 d = 0; d < Dirs::DIR_COUNT; ++d)
+      {
+        const CacheProcessor<EC> & cp = m_cacheProcessors[d];
+        bytes += cp.GetShippedBytes(asDeltas);
+        updates += cp.GetShippedUpdates(asDeltas);
+      }
+    }
+
     double GetAverageCacheRedundancy() const
     {
       u32 count = 0;
@@ -698,9 +1100,24 @@ namespace MFM
      */
     void NeedAtomRecount() const
     {
+      m_activeSitesStale = true;
       m_cdata.NeedAtomRecount();
     }
 
+    /**
+     * Do any needed recount on this thread, unless the tile is running
+     * events on threads of its own; Advance recounts there.  Holding
+     * m_stateAccess keeps the tile from starting to meanwhile.
+     */
+    void RecountAtomsIfIdle() const
+    {
+      Mutex::ScopeLock lock(m_stateAccess);
+      if (m_state != ACTIVE || m_sequential)
+      {
+        m_cdata.RecountIfNeeded();
+      }
+    }
+
     CacheProcessor<EC> & GetCacheProcessor(Dir toCache) ;
 
     const CacheProcessor<EC> & GetCacheProcessor(Dir toCache) const ;
@@ -767,12 +1184,32 @@ namespace MFM
      */
     u64 GetEventsExecuted() const
     {
-      return m_window.GetEventWindowsExecuted();
+      u64 total = m_window.GetEventWindowsExecuted();
+      for (u32 i = 0; i + 1 < m_concurrentWindows; ++i)
+      {
+        total += m_helperWindows[i]->m_window.GetEventWindowsExecuted();
+      }
+      return total;
     }
 
     u64 GetSitesAccessed() const
     {
-      return m_window.GetSitesAccessed();
+      u64 total = m_window.GetSitesAccessed();
+      for (u32 i = 0; i + 1 < m_concurrentWindows; ++i)
+      {
+        total += m_helperWindows[i]->m_window.GetSitesAccessed();
+      }
+      return total;
+    }
+
+    u64 GetEmptyCenterEvents() const
+    {
+      u64 total = m_window.GetEmptyCenterEvents();
+      for (u32 i = 0; i + 1 < m_concurrentWindows; ++i)
+      {
+        total += m_helperWindows[i]->m_window.GetEmptyCenterEvents();
+      }
+      return total;
     }
 
     EventWindow<EC> & GetEventWindow()
@@ -812,6 +1249,8 @@ namespace MFM
     {
       CopyTileParameters(heroTile);
       SetWarpFactor(heroTile.GetWarpFactor());
+      SetActiveSiteSelection(heroTile.IsActiveSiteSelection(),
+                             heroTile.GetUniformSelectionPercent());
       m_ucr = heroTile.m_ucr;
 
       const UlamClass<EC> * uempty = m_ucr.GetUlamElementEmpty();
@@ -841,6 +1280,16 @@ namespace MFM
      */
     void Connect(AbstractChannel& channel, LonglivedLock & lock, Dir toCache) ;
 
+    /**
+     * Connects a side of this Tile to an in-process neighbor, via a
+     * SharedCacheChannel rather than a packet-carrying channel.
+     *
+     * @param channel The SharedCacheChannel to connect to.
+     *
+     * @param toCache The cache to share with other.
+     */
+    void Connect(SharedCacheChannel<EC>& channel, LonglivedLock & lock, Dir toCache) ;
+
     /**
      * Gets the number of sites in this Tile in sites, excluding caches.
      */
@@ -1226,7 +1675,7 @@ namespace MFM
      */
     T* GetWritableAtom(const SPoint & pt)
     {
-      S & site = GetSite(pt);
+      SITE_REF site = GetSite(pt);
       return &site.GetAtom();
     }
 
@@ -10,14 +10,14 @@
 namespace MFM
 {
   template <class EC>
-  Tile<EC>::Tile(const u32 tileWidth, const u32 tileHeight, const GridLayoutPattern gridlayout, S * sites, const u32 eventbuffersize, EventHistoryItem * items)
+  Tile<EC>::Tile(const u32 tileWidth, const u32 tileHeight, const GridLayoutPattern gridlayout, const SITE_PLANES & sites, const u32 eventbuffersize, EventHistoryItem * items)
     : TILE_WIDTH(tileWidth)
     , TILE_HEIGHT(tileHeight)
     , OWNED_WIDTH(TILE_WIDTH - 2 * EVENT_WINDOW_RADIUS)  // This OWNED_SIDE computation is duplicated in Grid.h!
     , OWNED_HEIGHT(TILE_HEIGHT - 2 * EVENT_WINDOW_RADIUS)  // This OWNED_SIDE computation is duplicated in Grid.h!
     , GRID_LAYOUT(gridlayout)
     , DUMMY_TILE(false)
-    , m_sites(sites)
+    , m_sitePlanes(sites)
     , m_cdata(*this)
     , m_lockAttempts(0)
     , m_lockAttemptsSucceeded(0)
@@ -29,11 +29,30 @@ namespace MFM
     , m_foregroundRadiationEnabled(false)
     , m_requestedState(OFF)
     , m_warpFactor(3)
+    , m_activeSiteSelection(false)
+    , m_uniformSelectionPercent(100)
+    , m_activeSitesStale(true)
     , m_eventHistoryBuffer(*this, eventbuffersize, items)
+    , m_concurrentWindows(1)
+    , m_helpersBusy(0)
+    , m_deterministic(false)
+    , m_phaseRequested(0)
+    , m_phaseStarted(0)
+    , m_phaseSeed(0)
+    , m_phaseEvents(0)
+    , m_phaseBarrier(0)
+    , m_phaseEventsLeft(0)
+    , m_phaseReported(true)
+    , m_waitingCenter(0,0)
+    , m_isWaitingCenter(false)
+    , m_sequential(false)
   {
-    // TILE sides can't be too small, and we must apparently have sites, but not necessarily hidden ones.
+    for (u32 i = 0; i < MAX_CONCURRENT_WINDOWS - 1; m_helperWindows[i++] = 0);
+    for (u32 i = 0; i < Dirs::DIR_COUNT; m_sequentialNeighbors[i++] = 0);
+
+    // TILE sides can't be too small, but we needn't have hidden sites.
     // Effort to avoid simultaneous locks in opposite directions (e.g. East and West);
-    MFM_API_ASSERT_ARG(TILE_WIDTH >= 6*EVENT_WINDOW_RADIUS && TILE_HEIGHT >= 6*EVENT_WINDOW_RADIUS && m_sites != 0);
+    MFM_API_ASSERT_ARG(TILE_WIDTH >= 6*EVENT_WINDOW_RADIUS && TILE_HEIGHT >= 6*EVENT_WINDOW_RADIUS);
 
     // Require even TILE side dimensions.
     MFM_API_ASSERT_ARG(2 * TILE_WIDTH / 2 == TILE_WIDTH);
@@ -61,7 +80,10 @@ namespace MFM
   }
 
   template <class EC>
-  Tile<EC>::~Tile() {/* defined to avoid inline error */}
+  Tile<EC>::~Tile()
+  {
+    StopHelperWindows();
+  }
 
   template <class EC>
   void Tile<EC>::SaveTile(ByteSink & to) const
@@ -69,8 +91,13 @@ namespace MFM
     to.Printf(",");
     to.Print(m_lockAttempts,Format::LXX64);
     to.Print(m_lockAttemptsSucceeded,Format::LXX64);
-    to.Print(m_window.GetEventWindowsExecuted(),Format::LXX64);
-    to.Print(m_window.GetEventWindowsAttempted(),Format::LXX64);
+    u64 attempted = m_window.GetEventWindowsAttempted();
+    for (u32 i = 0; i + 1 < m_concurrentWindows; ++i)
+    {
+      attempted += m_helperWindows[i]->m_window.GetEventWindowsAttempted();
+    }
+    to.Print(GetEventsExecuted(),Format::LXX64);
+    to.Print(attempted,Format::LXX64);
     to.Printf(",%D%D%D",
               m_enabled,
               m_backgroundRadiationEnabled,
@@ -103,6 +130,11 @@ namespace MFM
     m_lockAttemptsSucceeded = tmp_m_lockAttemptsSucceeded;
     m_window.SetEventWindowsExecuted(tmp_EventWindowsExecuted);
     m_window.SetEventWindowsAttempted(tmp_EventWindowsAttempted);
+    for (u32 i = 0; i + 1 < m_concurrentWindows; ++i)
+    {
+      m_helperWindows[i]->m_window.SetEventWindowsExecuted(0);
+      m_helperWindows[i]->m_window.SetEventWindowsAttempted(0);
+    }
     m_enabled = tmp_m_enabled;
     m_backgroundRadiationEnabled = tmp_m_backgroundRadiationEnabled;
     m_warpFactor = tmp_m_warpFactor;
@@ -144,6 +176,7 @@ namespace MFM
   {
     Random & random = GetRandom();
     GetWritableAtom(at)->XRay(random, bitOdds);
+    NeedAtomRecount();
   }
 
   template <class EC>
@@ -152,8 +185,9 @@ namespace MFM
     Random & random = GetRandom();
     for(iterator_type i = beginAll(); i != endAll(); ++i) { // hitting caches too
       if (random.OneIn(siteOdds))
-        i->GetAtom().XRay(random, bitOdds);
+        (*i).GetAtom().XRay(random, bitOdds);
     }
+    NeedAtomRecount();
   }
 
   template <class EC>
@@ -162,15 +196,16 @@ namespace MFM
     Random & random = GetRandom();
     for(iterator_type i = beginOwned(); i != endOwned(); ++i) {
       if (random.OneIn(siteOdds))
-        i->Clear();
+        (*i).Clear();
     }
+    NeedAtomRecount();
   }
 
   template <class EC>
   void Tile<EC>::ClearAtoms()
   {
     for(iterator_type i = beginAll(); i != endAll(); ++i) {
-      i->Clear();
+      (*i).Clear();
     }
     NeedAtomRecount();
   }
@@ -185,6 +220,16 @@ namespace MFM
     cxn.ClaimCacheProcessor(*this, channel, lock, toCache);
   }
 
+  template <class EC>
+  void Tile<EC>::Connect(SharedCacheChannel<EC>& channel, LonglivedLock & lock, Dir toCache)
+  {
+    CacheProcessor<EC> & cxn = GetCacheProcessor(toCache);
+
+    MFM_API_ASSERT_STATE(!cxn.IsConnected());
+
+    cxn.ClaimCacheProcessor(*this, channel, lock, toCache);
+  }
+
   template <class EC>
   CacheProcessor<EC> & Tile<EC>::GetCacheProcessor(Dir toCache)
   {
@@ -211,8 +256,6 @@ namespace MFM
     if (idx < 0)
       return -1;
 
-    RecountIfNeeded();
-
     return m_atomCount[idx];
   }
 
@@ -225,7 +268,7 @@ namespace MFM
 
     for(const_iterator_type i = m_tile.beginOwned(); i != m_tile.endOwned(); ++i) {
 
-      u32 atype = i->GetAtom().GetType();
+      u32 atype = (*i).GetAtom().GetType();
       s32 idx = m_tile.m_elementTable.GetIndex(atype);
 
       if (idx < 0) ++m_illegalAtomCount;
@@ -233,6 +276,41 @@ namespace MFM
     }
   }
 
+  template <class EC>
+  u32 Tile<EC>::CountData::AuditAtomCounts()
+  {
+    if (m_needRecount)
+    {
+      RecountIfNeeded();
+      return 0;  // Nothing incremental to check
+    }
+
+    u32 * counts = new u32[ELEMENT_TABLE_SIZE];
+    for (u32 i = 0; i < ELEMENT_TABLE_SIZE; i++) counts[i] = m_atomCount[i];
+    const u32 illegal = m_illegalAtomCount;
+
+    RecountAtoms();
+
+    u32 wrong = 0;
+    for (u32 i = 0; i < ELEMENT_TABLE_SIZE; i++)
+    {
+      if (counts[i] != m_atomCount[i])
+      {
+        LOG.Warning("Tile %s: Count for type slot %d was %d, not %d",
+                    m_tile.GetLabel(), i, counts[i], m_atomCount[i]);
+        ++wrong;
+      }
+    }
+    if (illegal != m_illegalAtomCount)
+    {
+      LOG.Warning("Tile %s: Illegal atom count was %d, not %d",
+                  m_tile.GetLabel(), illegal, m_illegalAtomCount);
+      ++wrong;
+    }
+    delete [] counts;
+    return wrong;
+  }
+
   template <class EC>
   u32 Tile<EC>::GetUncachedWriteAge32(const SPoint site) const
   {
@@ -504,7 +582,7 @@ namespace MFM
       return;
     }
 
-    Site<AC> & site = GetSite(pt);
+    SITE_REF site = GetSite(pt);
     T & oldAtom = placeInBase ? site.GetBase().GetBaseAtom() : site.GetAtom();
     T newAtom = atom;
     unwind_protect(
@@ -516,11 +594,14 @@ namespace MFM
 		  pt.GetX(), pt.GetY());
     },
     {
-      if(m_backgroundRadiationEnabled &&
-         m_random.OneIn(BACKGROUND_RADIATION_SITE_ODDS))
+      if(m_backgroundRadiationEnabled)
       {
-        // Write fault!
-        newAtom.XRay(m_random, BACKGROUND_RADIATION_BIT_ODDS);
+        WindowSharedScope shared(*this);
+        if (m_random.OneIn(BACKGROUND_RADIATION_SITE_ODDS))
+        {
+          // Write fault!
+          newAtom.XRay(m_random, BACKGROUND_RADIATION_BIT_ODDS);
+        }
       }
 
       bool owned = IsOwnedSite(pt);
@@ -540,10 +621,18 @@ namespace MFM
 	    }
 	  else
 	    {
-	      NeedAtomRecount();
+	      if (owned && !placeInBase)
+	      {
+		WindowSharedScope shared(*this);
+		m_cdata.CountTypeChange(oldAtom.GetType(), newAtom.GetType());
+	      }
 	      if (owned)
 		site.MarkChanged();
 
+	      if (owned && !placeInBase && m_activeSiteSelection &&
+                  oldAtom.GetType() != newAtom.GetType())
+		UpdateActiveSite(pt, newAtom.GetType() == T::ATOM_EMPTY_TYPE);
+
 	      oldAtom = newAtom;
 	    }
 	}
@@ -634,6 +723,10 @@ namespace MFM
 
     bool didWork = false;
     State curState = GetCurrentState();
+    if (curState == ACTIVE)
+    {
+      m_cdata.RecountIfNeeded();  // Here, before any events change counts
+    }
     if (!m_enabled)
     {
       curState = PASSIVE;
@@ -748,6 +841,11 @@ namespace MFM
       return false;
     }
 
+    if (m_deterministic)
+    {
+      return AdvanceDeterministicComputation();  // Even if disabled
+    }
+
     if (!IsEnabled())
     {
       SleepMsec(2);
@@ -755,18 +853,408 @@ namespace MFM
     }
 
     //INITIATE_EVENT,
-    SPoint pt = GetRandomOwnedCoord(); //adjusted to range (0..Tile_Width, 0...Tile_Height)
+    if (m_concurrentWindows > 1)
+    {
+      return AdvanceConcurrentComputation();
+    }
+
+    SPoint pt = GetEventCenterCoord(); //adjusted to range (0..Tile_Width, 0...Tile_Height)
     if (RegionIn(pt) == REGION_CACHE)
       FAIL(ILLEGAL_STATE);
 
     return m_window.TryEventAt(pt);
   }
 
+  template <class EC>
+  void Tile<EC>::SetDeterministic(bool deterministic)
+  {
+    MFM_API_ASSERT_STATE(!deterministic || m_concurrentWindows == 1);
+    m_deterministic = deterministic;
+    m_isWaitingCenter = false;
+  }
+
+  template <class EC>
+  void Tile<EC>::SetSequential(Tile<EC> * const * neighbors)
+  {
+    MFM_API_ASSERT_STATE(!neighbors || m_concurrentWindows == 1);
+    m_sequential = neighbors != 0;
+    for (u32 d = 0; d < Dirs::DIR_COUNT; ++d)
+    {
+      m_sequentialNeighbors[d] = neighbors ? neighbors[d] : 0;
+    }
+  }
+
+  template <class EC>
+  void Tile<EC>::WriteThrough(const SPoint & pt)
+  {
+    MFM_API_ASSERT_STATE(m_sequential);
+    if (IsInHidden(pt))
+    {
+      return;
+    }
+
+    const T & atom = GetSite(pt).GetAtom();
+    for (u32 d = 0; d < Dirs::DIR_COUNT; ++d)
+    {
+      Tile<EC> * other = m_sequentialNeighbors[d];
+      if (!other)
+      {
+        continue;
+      }
+
+      const SPoint remote = m_cacheProcessors[d].LocalToRemote(pt);
+      if (!other->IsInTile(remote))
+      {
+        continue;
+      }
+
+      // As PlaceAtom, but without a second chance at radiation
+      SITE_REF site = other->GetSite(remote);
+      T & oldAtom = site.GetAtom();
+      if (oldAtom == atom)
+      {
+        continue;
+      }
+      if (other->IsOwnedSite(remote))
+      {
+        other->m_cdata.CountTypeChange(oldAtom.GetType(), atom.GetType());
+        site.MarkChanged();
+        if (other->m_activeSiteSelection && oldAtom.GetType() != atom.GetType())
+        {
+          other->UpdateActiveSite(remote, atom.GetType() == T::ATOM_EMPTY_TYPE);
+        }
+      }
+      oldAtom = atom;
+    }
+  }
+
+  template <class EC>
+  u32 Tile<EC>::RunSequentialEvents(u32 attempts)
+  {
+    MFM_API_ASSERT_STATE(m_sequential);
+    ConsiderStateChange();
+    if (!IsActive() || !IsEnabled())
+    {
+      return 0;
+    }
+
+    u32 executed = 0;
+    for (u32 i = 0; i < attempts; ++i)
+    {
+      if (m_window.TryEventAt(GetEventCenterCoord()))
+      {
+        ++executed;
+      }
+    }
+    return executed;
+  }
+
+  template <class EC>
+  void Tile<EC>::StartDeterministicPhase(u32 seed, u32 events, PhaseBarrier & barrier)
+  {
+    MFM_API_ASSERT_STATE(m_deterministic);
+    MFM_API_ASSERT_STATE(m_phaseRequested == m_phaseStarted && m_phaseReported);
+    m_phaseSeed = seed;
+    m_phaseEvents = events;
+    m_phaseBarrier = &barrier;
+    __sync_add_and_fetch(&m_phaseRequested, 1);  // Full barrier too
+  }
+
+  template <class EC>
+  bool Tile<EC>::AreCacheProcessorsIdle() const
+  {
+    for (u32 i = 0; i < Dirs::DIR_COUNT; ++i)
+    {
+      const CacheProcessor<EC> & cp = m_cacheProcessors[i];
+      if (!cp.IsIdle() && !cp.IsUnclaimed())
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  template <class EC>
+  bool Tile<EC>::AdvanceDeterministicComputation()
+  {
+    if (m_phaseStarted != m_phaseRequested)
+    {
+      __sync_synchronize();  // See StartDeterministicPhase's writes
+      m_phaseStarted = m_phaseRequested;
+      m_random.SetSeed(m_phaseSeed);
+      m_phaseEventsLeft = IsEnabled() ? m_phaseEvents : 0;
+      m_phaseReported = false;
+
+      // Incoming cache updates reorder the set; rebuild it canonically
+      m_activeSitesStale = true;
+    }
+
+    if (m_phaseEventsLeft == 0)
+    {
+      if (m_phaseReported || !AreCacheProcessorsIdle())
+      {
+        return false;
+      }
+      m_phaseReported = true;
+      m_phaseBarrier->Finish();
+      return true;
+    }
+
+    // Draw each center once, however long it must wait for locks
+    if (!m_isWaitingCenter)
+    {
+      m_waitingCenter = GetEventCenterCoord();
+      if (RegionIn(m_waitingCenter) == REGION_CACHE)
+        FAIL(ILLEGAL_STATE);
+      m_isWaitingCenter = true;
+    }
+
+    if (!IsInHidden(m_waitingCenter) && !AreCacheProcessorsIdle())
+    {
+      return false;
+    }
+
+    m_isWaitingCenter = false;
+    --m_phaseEventsLeft;
+    m_window.TryEventAt(m_waitingCenter);
+    return true;
+  }
+
+  template <class EC>
+  bool Tile<EC>::AdvanceConcurrentComputation()
+  {
+    const u32 helpers = m_concurrentWindows - 1;
+    m_helpersBusy = helpers;
+    __sync_synchronize();
+    for (u32 i = 0; i < helpers; ++i)
+    {
+      HelperWindow & hw = *m_helperWindows[i];
+      Mutex::ScopeLock lock(hw.m_lock);
+      hw.m_batchRequested = true;
+      hw.m_request.SignalCondition();
+    }
+
+    // Stay useful while the helpers work: the primary window takes
+    // the events near the edges, which the helpers can't, and the
+    // cache traffic they cause
+    do
+    {
+      SPoint pt = GetEventCenterCoord();
+      if (RegionIn(pt) == REGION_CACHE)
+        FAIL(ILLEGAL_STATE);
+
+      m_window.TryEventAt(pt);
+      AdvanceCommunication();
+    } while (__sync_add_and_fetch(&m_helpersBusy, 0) > 0);
+
+    return true;
+  }
+
+  template <class EC>
+  void * Tile<EC>::HelperWindowRunner(void * arg)
+  {
+    HelperWindow & hw = *(HelperWindow *) arg;
+    Tile & tile = hw.m_tile;
+
+    // Init error stack pointer (for this thread only)
+    MFMPtrToErrEnvStackPtr = &hw.m_errorEnvironmentStackTop;
+
+    while (true)
+    {
+      {
+        Mutex::ScopeLock lock(hw.m_lock);
+        hw.m_request.WaitForCondition();
+        if (hw.m_exitRequested)
+        {
+          break;
+        }
+      }
+
+      for (u32 i = 0; i < HELPER_BATCH_EVENTS; ++i)
+      {
+        hw.m_window.TryEventAt(tile.GetRandomHiddenCoord(hw.m_random));
+      }
+
+      {
+        Mutex::ScopeLock lock(hw.m_lock);
+        hw.m_batchRequested = false;
+      }
+      __sync_sub_and_fetch(&tile.m_helpersBusy, 1);
+    }
+    return 0;
+  }
+
+  template <class EC>
+  void Tile<EC>::SetConcurrentWindows(u32 count)
+  {
+    MFM_API_ASSERT_ARG(count >= 1 && count <= MAX_CONCURRENT_WINDOWS);
+    MFM_API_ASSERT_STATE(count == 1 || (!m_deterministic && !m_sequential));
+    MFM_API_ASSERT_ARG(count == 1 ||
+                       (TILE_WIDTH > 6 * EVENT_WINDOW_RADIUS &&
+                        TILE_HEIGHT > 6 * EVENT_WINDOW_RADIUS));
+    MFM_API_ASSERT_STATE(!IsDummyTile());
+
+    StopHelperWindows();
+    if (count == 1)
+    {
+      return;
+    }
+
+    m_siteClaims.Allocate(TILE_WIDTH, TILE_HEIGHT);
+    if (m_activeSiteSelection)
+    {
+      m_activeSitesStale = true;
+    }
+
+    // Claim owner 1 is the primary window; helpers follow
+    for (u32 i = 0; i < count - 1; ++i)
+    {
+      HelperWindow * hw = new HelperWindow(*this, (u8) (i + 2), m_random.Create());
+      m_helperWindows[i] = hw;
+      if (pthread_create(&hw->m_threadId, NULL, HelperWindowRunner, hw))
+      {
+        FAIL(ILLEGAL_STATE);
+      }
+    }
+    m_concurrentWindows = count;
+  }
+
+  template <class EC>
+  void Tile<EC>::StopHelperWindows()
+  {
+    const u32 helpers = m_concurrentWindows - 1;
+    m_concurrentWindows = 1;
+    for (u32 i = 0; i < helpers; ++i)
+    {
+      HelperWindow * hw = m_helperWindows[i];
+      {
+        Mutex::ScopeLock lock(hw->m_lock);
+        hw->m_exitRequested = true;
+        hw->m_request.SignalCondition();
+      }
+      pthread_join(hw->m_threadId, NULL);
+
+      // Keep the events the helper ran on the books
+      m_window.SetEventWindowsExecuted(m_window.GetEventWindowsExecuted() +
+                                       hw->m_window.GetEventWindowsExecuted());
+      m_window.SetEventWindowsAttempted(m_window.GetEventWindowsAttempted() +
+                                        hw->m_window.GetEventWindowsAttempted());
+      delete hw;
+      m_helperWindows[i] = 0;
+    }
+  }
+
+  template <class EC>
+  SPoint Tile<EC>::GetEventCenterCoord()
+  {
+    if (!m_activeSiteSelection)
+    {
+      return GetRandomOwnedCoord();
+    }
+
+    WindowSharedScope shared(*this);
+    if (m_activeSitesStale)
+    {
+      RebuildActiveSites();
+    }
+
+    const u32 count = m_activeSites.GetCount();
+    if (count == 0 || m_random.OddsOf(m_uniformSelectionPercent, 100))
+    {
+      return GetRandomOwnedCoord();
+    }
+
+    const u32 site = m_activeSites.Get(m_random.Create(count));
+    return OwnedCoordToTile(SPoint(site % OWNED_WIDTH, site / OWNED_WIDTH));
+  }
+
+  template <class EC>
+  void Tile<EC>::SetActiveSiteSelection(bool enabled, u32 uniformPercent)
+  {
+    MFM_API_ASSERT_ARG(uniformPercent <= 100);
+    m_uniformSelectionPercent = uniformPercent;
+    if (enabled && !m_activeSiteSelection)
+    {
+      m_activeSitesStale = true;
+    }
+    m_activeSiteSelection = enabled;
+  }
+
+  template <class EC>
+  u32 Tile<EC>::GetActiveSiteCount()
+  {
+    if (!m_activeSiteSelection)
+    {
+      return 0;
+    }
+    WindowSharedScope shared(*this);
+    if (m_activeSitesStale)
+    {
+      RebuildActiveSites();
+    }
+    return m_activeSites.GetCount();
+  }
+
+  template <class EC>
+  void Tile<EC>::RebuildActiveSites()
+  {
+    if (!m_activeSites.IsAllocated())
+    {
+      m_activeSites.Allocate(OWNED_WIDTH * OWNED_HEIGHT);
+    }
+    else
+    {
+      m_activeSites.Clear();
+    }
+
+    for (u32 y = 0; y < OWNED_HEIGHT; ++y)
+    {
+      for (u32 x = 0; x < OWNED_WIDTH; ++x)
+      {
+        const T & atom = GetSite(OwnedCoordToTile(SPoint(x, y))).GetAtom();
+        if (atom.GetType() != T::ATOM_EMPTY_TYPE)
+        {
+          m_activeSites.Insert(y * OWNED_WIDTH + x);
+        }
+      }
+    }
+    m_activeSitesStale = false;
+  }
+
+  template <class EC>
+  void Tile<EC>::UpdateActiveSite(const SPoint & pt, bool isEmpty)
+  {
+    WindowSharedScope shared(*this);
+    if (m_activeSitesStale)
+    {
+      return;  // Will be rebuilt before it's next used anyway
+    }
+
+    const SPoint owned = TileCoordToOwned(pt);
+    const u32 site = owned.GetY() * OWNED_WIDTH + owned.GetX();
+    if (isEmpty)
+    {
+      m_activeSites.Remove(site);
+    }
+    else
+    {
+      m_activeSites.Insert(site);
+    }
+  }
+
   template <class EC>
   bool Tile<EC>::AdvanceCommunication()
   {
     bool didWork = false;
-    for (m_dirIterator.ShuffleOrReset(m_random); m_dirIterator.HasNext(); )
+    if (m_deterministic)
+    {
+      m_dirIterator.Reset();  // Leave m_random to the events
+    }
+    else
+    {
+      m_dirIterator.ShuffleOrReset(m_random);
+    }
+    while (m_dirIterator.HasNext())
     {
       u32 i = m_dirIterator.Next();
       MFM_API_ASSERT_STATE(Dirs::IsValidDir(i, IsTileGridLayoutStaggered()));
@@ -794,6 +1282,14 @@ namespace MFM
 
     LOG.Log(level,"  ==Tile %s Events==", m_label.GetZString());
     LOG.Log(level,"   Events: %dM (total)", (u32) (GetEventsExecuted() / 1000000));
+    LOG.Log(level,"   Empty-center events: %dM", (u32) (GetEmptyCenterEvents() / 1000000));
+    if (m_concurrentWindows > 1)
+    {
+      LOG.Log(level,"   Concurrent windows: %d (%dK claims, %dK conflicts)",
+              m_concurrentWindows,
+              (u32) (m_siteClaims.GetClaims() / 1000),
+              (u32) (m_siteClaims.GetConflicts() / 1000));
+    }
 
     for (u32 d = Dirs::NORTH; d <= Dirs::NORTHWEST; ++d)
     {
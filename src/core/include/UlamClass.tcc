@@ -43,7 +43,7 @@ namespace MFM {
   {
     if( atype == EC::ATOM_CONFIG::ATOM_TYPE::ATOM_UNDEFINED_TYPE )
       FAIL(ILLEGAL_STATE);  // needs 'quark type' vtable support
-    const UlamElement<EC> * ueltptr = (UlamElement<EC> *) uc.LookupElementTypeFromContext(atype);
+    const UlamClass<EC> * ueltptr = uc.LookupUlamElementTypeFromContext(atype); //direct, by type
     if (!ueltptr) return NULL;
     return ueltptr->getVTableEntry(idx);
   } //GetVTableEntry (static)
@@ -32,6 +32,7 @@
 #define ULAMCLASSREGISTRY_H
 
 #include "itype.h"
+#include "UlamVTableCache.h"
 
 namespace MFM {
 
@@ -40,7 +41,8 @@ namespace MFM {
   template <class EC>
   struct UlamClassRegistry {
     enum {
-      TABLE_SIZE = 1000
+      TABLE_SIZE = 1000,
+      NAME_INDEX_SIZE = 2048  // A power of two, over twice TABLE_SIZE
     };
 
     UlamClassRegistry()
@@ -48,6 +50,7 @@ namespace MFM {
       , m_ulamElementEmpty(0)
     {
       for(u32 i = 0; i < TABLE_SIZE; i++) m_registeredUlamClasses[i] = 0;
+      for(u32 i = 0; i < NAME_INDEX_SIZE; i++) m_nameIndex[i] = 0;
     }
 
     bool RegisterUlamClass(UlamClass<EC>& uc) ;
@@ -71,10 +74,45 @@ namespace MFM {
 
     const UlamClass<EC> * GetUlamElementEmpty() const { return m_ulamElementEmpty; }
 
+    /**
+       @returns the class whose function is at index vownedfuncidx,
+       among those declared by class origclassregnum, in the vtable
+       of class vtclassid, setting vfunc to that function.  Asks the
+       vtable itself only on a vtable cache miss.  FAILs if there is
+       no class vtclassid.
+     */
+    const UlamClass<EC> * ResolveVTableSlot(u32 vtclassid, u32 origclassregnum,
+                                            u32 vownedfuncidx, VfuncPtr & vfunc) const ;
+
+    /**
+       The resolved virtual calls of the classes registered here.
+       Registering a class clears it.
+     */
+    UlamVTableCache<EC> & GetVTableCache() const { return m_vtableCache; }
+
     UlamClass<EC> * m_registeredUlamClasses[TABLE_SIZE];
     u32 m_registeredUlamClassCount;
 
     UlamClass<EC> * m_ulamElementEmpty;
+
+    /**
+       An open-addressed hash of the registered classes by mangled
+       name, built as they register: each entry is 1 + the
+       registration number of a class, or 0 if the entry is free.
+     */
+    u16 m_nameIndex[NAME_INDEX_SIZE];
+
+    static u32 HashMangledName(const char * mangledName) ;
+
+    /**
+       @returns the registration number of the class named
+       mangledName exactly, or -1 if there is none
+     */
+    s32 FindMangledName(const char * mangledName) const;
+
+    void IndexMangledName(u32 regnum) ;
+
+    mutable UlamVTableCache<EC> m_vtableCache;
   };
 
 } //MFM
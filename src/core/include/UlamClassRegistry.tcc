@@ -4,11 +4,62 @@
 
 namespace MFM {
 
+  template <class EC>
+  u32 UlamClassRegistry<EC>::HashMangledName(const char * mangledName)
+  {
+    // FNV-1a
+    u32 hash = 2166136261u;
+    for (const char * p = mangledName; *p; ++p)
+    {
+      hash = (hash ^ (u8) *p) * 16777619u;
+    }
+    return hash;
+  }
+
+  template <class EC>
+  s32 UlamClassRegistry<EC>::FindMangledName(const char * mangledName) const
+  {
+    for (u32 slot = HashMangledName(mangledName); ; ++slot)
+    {
+      const u32 entry = m_nameIndex[slot & (NAME_INDEX_SIZE - 1)];
+      if (entry == 0)
+        return -1;
+      if (!strcmp(m_registeredUlamClasses[entry - 1]->GetMangledClassName(), mangledName))
+        return (s32) (entry - 1);
+    }
+  }
+
+  template <class EC>
+  void UlamClassRegistry<EC>::IndexMangledName(u32 regnum)
+  {
+    const char * mangledName = m_registeredUlamClasses[regnum]->GetMangledClassName();
+    for (u32 slot = HashMangledName(mangledName); ; ++slot)
+    {
+      u16 & entry = m_nameIndex[slot & (NAME_INDEX_SIZE - 1)];
+      if (entry == 0)
+      {
+        entry = (u16) (regnum + 1);
+        return;
+      }
+      if (!strcmp(m_registeredUlamClasses[entry - 1]->GetMangledClassName(), mangledName))
+      {
+        // Same name twice?  The lowest registration number answers
+        if (regnum < (u32) (entry - 1))
+          entry = (u16) (regnum + 1);
+        return;
+      }
+    }
+  }
+
   template <class EC>
   s32 UlamClassRegistry<EC>::GetUlamClassIndex(const char *mangledName) const
   {
     if (!mangledName) FAIL(NULL_POINTER);
 
+    s32 idx = FindMangledName(mangledName);
+    if (idx >= 0)
+      return idx;
+
     // HACK: If mangledName is an array type, we need to get the
     // mangled name representing the underlying scalar type, for
     // lookup purposes.
@@ -21,18 +72,9 @@ namespace MFM {
 
       uti.MakeScalar();                // Stomp out the array length
       uti.PrintMangled(scalarName);    // Convert back to mangled name
-      mangledName = scalarName.GetZString(); // Update pointer
+      return FindMangledName(scalarName.GetZString());
     }
 
-    for (u32 i = 0; i < m_registeredUlamClassCount; ++i)
-    {
-      UlamClass<EC> * uc = m_registeredUlamClasses[i];
-      if (!uc) continue; //contiguous after all classes register
-
-      const char * mang = uc->GetMangledClassName();
-      if (!strcmp(mang, mangledName))
-        return (s32) i;
-    }
     return -1;
   }
 
@@ -59,6 +101,9 @@ namespace MFM {
     if(myregnum >= m_registeredUlamClassCount)
       m_registeredUlamClassCount = myregnum + 1; //max + 1
 
+    IndexMangledName(myregnum);
+    m_vtableCache.Clear();
+
     return true;
   }
 
@@ -70,11 +115,37 @@ namespace MFM {
     if (!m_ulamElementEmpty)
     {
       m_ulamElementEmpty = &ue;
+      m_vtableCache.Clear();
       return 1;
     }
     return -1;
   }
 
+  template <class EC>
+  const UlamClass<EC> * UlamClassRegistry<EC>::ResolveVTableSlot(u32 vtclassid, u32 origclassregnum,
+                                                                 u32 vownedfuncidx, VfuncPtr & vfunc) const
+  {
+    typedef UlamVTableCache<EC> Cache;
+    typename Cache::Resolution res;
+    if (!m_vtableCache.Find(Cache::NO_SELF, vtclassid, origclassregnum, vownedfuncidx, res))
+    {
+      const UlamClass<EC> * vtableclassptr = GetUlamClassOrNullByIndex(vtclassid);
+      MFM_API_ASSERT_NONNULL(vtableclassptr);
+
+      //3 VTable accesses for: originating class' start, vfunc entry, and its override class
+      const u32 origclassvtstart = vtableclassptr->GetVTStartOffsetForClassByRegNum(origclassregnum);
+      res.m_vfunc = vtableclassptr->getVTableEntry(vownedfuncidx + origclassvtstart);
+      res.m_ovclass = vtableclassptr->getVTableEntryUlamClassPtr(vownedfuncidx + origclassvtstart);
+      MFM_API_ASSERT_NONNULL(res.m_ovclass);
+      res.m_ovclassrelpos = 0;
+      res.m_ovclasslen = 0;
+      res.m_ovclassIsElement = false;
+      m_vtableCache.Insert(Cache::NO_SELF, vtclassid, origclassregnum, vownedfuncidx, res);
+    }
+    vfunc = res.m_vfunc;
+    return res.m_ovclass;
+  }
+
   template <class EC>
   bool UlamClassRegistry<EC>::IsRegisteredUlamClass(const char *mangledName) const
   {
@@ -38,7 +38,7 @@
 namespace MFM
 {
   template <class AC> class Base; // FORWARD
-  template <class AC> class Site; // FORWARD
+  template <class AC, bool STATS> class Site; // FORWARD
   template <class EC> class EventWindow; // FORWARD
   template <class EC> class UlamClass; //FORWARD
   template <class EC> class UlamClassRegistry; //FORWARD
@@ -24,10 +24,7 @@ namespace MFM {
   template <class EC>
   const UlamClass<EC> * UlamContext<EC>::LookupUlamElementTypeFromContext(u32 etype) const
   {
-    const Element<EC> * eltptr = this->LookupElementTypeFromContext(etype);
-    if (!eltptr) return NULL;
-    const UlamElement<EC> * ueltptr =  eltptr->AsUlamElement();
-    return ueltptr; //might be NULL
+    return m_elementTable.LookupUlamElement(etype); //might be NULL
   } //LookupUlamElementTypeFromContext
 
 } //MFM
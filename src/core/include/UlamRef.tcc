@@ -331,31 +331,47 @@ namespace MFM {
   {
     MFM_API_ASSERT_NONNULL(vtclassptr); //could be same as effSelf
 
-    //check VTable class is/related to origclass
-    if(!vtclassptr->internalCMethodImplementingIs(origclassregnum))
-      FAIL(BAD_VIRTUAL_CALL);
-
     const UlamClass<EC> * effSelf = ur.GetEffectiveSelf();
     MFM_API_ASSERT_NONNULL(effSelf);
 
-    //check effSelf is/related to VTable class
-    if(!effSelf->internalCMethodImplementingIs(vtclassptr))
-      FAIL(BAD_VIRTUAL_CALL);
+    //same classes, same call, same resolution: check the cache first
+    UlamVTableCache<EC> * cache =
+      m_uc.HasUlamClassRegistry() ? &m_uc.GetUlamClassRegistry().GetVTableCache() : NULL;
+    const u32 effselfid = effSelf->GetRegistrationNumber();
+    const u32 vtclassid = vtclassptr->GetRegistrationNumber();
+    typename UlamVTableCache<EC>::Resolution res;
+    if(!cache || !cache->Find(effselfid, vtclassid, origclassregnum, vownedfuncidx, res))
+      {
+	//check VTable class is/related to origclass
+	if(!vtclassptr->internalCMethodImplementingIs(origclassregnum))
+	  FAIL(BAD_VIRTUAL_CALL);
+
+	//check effSelf is/related to VTable class
+	if(!effSelf->internalCMethodImplementingIs(vtclassptr))
+	  FAIL(BAD_VIRTUAL_CALL);
 
-    //3 VTable accesses for: originating class' start, vfunc entry, and its override class
-    const u32 origclassvtstart = vtclassptr->GetVTStartOffsetForClassByRegNum(origclassregnum);
-    vfuncref = vtclassptr->getVTableEntry(vownedfuncidx + origclassvtstart); //return ref to virtual function ptr
-    const UlamClass<EC> * ovclassptr = vtclassptr->getVTableEntryUlamClassPtr(vownedfuncidx + origclassvtstart);
-    MFM_API_ASSERT_NONNULL(ovclassptr);
+	//3 VTable accesses for: originating class' start, vfunc entry, and its override class
+	const u32 origclassvtstart = vtclassptr->GetVTStartOffsetForClassByRegNum(origclassregnum);
+	res.m_vfunc = vtclassptr->getVTableEntry(vownedfuncidx + origclassvtstart);
+	const UlamClass<EC> * ovclassptr = vtclassptr->getVTableEntryUlamClassPtr(vownedfuncidx + origclassvtstart);
+	MFM_API_ASSERT_NONNULL(ovclassptr);
+	res.m_ovclass = ovclassptr;
 
-    //relative to effSelf
-    const s32 ovclassrelpos = effSelf->internalCMethodImplementingGetRelativePositionOfBaseClass(ovclassptr);
-    MFM_API_ASSERT(ovclassrelpos >= 0, PURE_VIRTUAL_CALLED);
+	//relative to effSelf
+	res.m_ovclassrelpos = effSelf->internalCMethodImplementingGetRelativePositionOfBaseClass(ovclassptr);
+	MFM_API_ASSERT(res.m_ovclassrelpos >= 0, PURE_VIRTUAL_CALLED);
 
-    const u32 ovclasslen = (ovclassptr == effSelf) ? ovclassptr->GetClassLength() : ovclassptr->GetClassDataMembersSize(); //use baseclass size when incomplete obj, not element.
-    ApplyDelta(ur.GetEffectiveSelfPos(), ovclassrelpos, ovclasslen);
+	res.m_ovclasslen = (ovclassptr == effSelf) ? ovclassptr->GetClassLength() : ovclassptr->GetClassDataMembersSize(); //use baseclass size when incomplete obj, not element.
+	res.m_ovclassIsElement = ovclassptr->AsUlamElement() != NULL;
 
-    m_usage = ovclassptr->AsUlamElement() ? ELEMENTAL : CLASSIC;
+	if(cache)
+	  cache->Insert(effselfid, vtclassid, origclassregnum, vownedfuncidx, res);
+      }
+
+    vfuncref = res.m_vfunc; //return ref to virtual function ptr
+    ApplyDelta(ur.GetEffectiveSelfPos(), res.m_ovclassrelpos, res.m_ovclasslen);
+
+    m_usage = res.m_ovclassIsElement ? ELEMENTAL : CLASSIC;
   } //InitUlamRefForVirtualFuncCall
 
   template <class EC>
@@ -383,13 +399,10 @@ namespace MFM {
     if(!gotit)
       {
 	const UlamClassRegistry<EC> & ucr = m_uc.GetUlamClassRegistry();
-	const UlamClass<EC> * vtableclassptr = ucr.GetUlamClassOrNullByIndex(m_vtableclassid);
-	MFM_API_ASSERT_NONNULL(vtableclassptr); //first one checked is effSelf
 
-	//3 VTable accesses for: originating class' start, vfunc entry, and its override class
-	const u32 origclassvtstart = vtableclassptr->GetVTStartOffsetForClassByRegNum(origclassregnum);
-	const UlamClass<EC> * ovclassptr = vtableclassptr->getVTableEntryUlamClassPtr(vownedfuncidx + origclassvtstart);
-	MFM_API_ASSERT_NONNULL(ovclassptr);
+	//the override class in the vtable of m_vtableclassid (first one checked is effSelf)
+	VfuncPtr vfunc;
+	const UlamClass<EC> * ovclassptr = ucr.ResolveVTableSlot(m_vtableclassid, origclassregnum, vownedfuncidx, vfunc);
 
 	if(candidateid < 0)
 	  candidateid = ovclassptr->GetRegistrationNumber();
@@ -445,7 +458,13 @@ namespace MFM {
   const UlamClass<EC>* UlamRef<EC>::LookupUlamElementTypeFromAtom() const
   {
     MFM_API_ASSERT_STATE(m_usage == ATOMIC || m_usage == ELEMENTAL);
-    T a = ReadAtom();
+
+    // Only the header bits, ahead of the atom's first state bit, say
+    // its type, so read just them rather than the whole atom
+    const u32 atomPos =
+      (m_usage == ATOMIC) ? m_pos : GetEffectiveSelfPos() - T::ATOM_FIRST_STATE_BIT;
+    T a;
+    a.GetBits().template Write<0, T::ATOM_FIRST_STATE_BIT>(m_stg.Read(atomPos, T::ATOM_FIRST_STATE_BIT));
     MFM_API_ASSERT(a.IsSane(),INCONSISTENT_ATOM);
     u32 etype = a.GetType();
     const UlamClass<EC> * eltptr = m_uc.LookupUlamElementTypeFromContext(etype);
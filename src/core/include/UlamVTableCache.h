@@ -0,0 +1,194 @@
+/*                                              -*- mode:C++ -*-
+  UlamVTableCache.h Remembers how ulam virtual calls resolved
+  Copyright (C) 2015 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file UlamVTableCache.h Remembers how ulam virtual calls resolved
+  \author David H. Ackley.
+  \date (C) 2015 All rights reserved.
+  \lgpl
+ */
+#ifndef ULAMVTABLECACHE_H
+#define ULAMVTABLECACHE_H
+
+#include "itype.h"
+#include "UlamVTableEntry.h"
+
+namespace MFM
+{
+  template <class EC> class UlamClass; //FORWARD
+
+  /**
+     A direct-mapped cache of resolved ulam virtual calls, so a call
+     made again from the same classes skips the vtable walk and the
+     subclass checks.  A call is keyed by the registration numbers
+     of its effective self (or NO_SELF, for just the vtable slot), of
+     the class whose vtable is used, and of the class that declared
+     the function, plus the function's index in that class.  None of
+     that changes unless ulam classes (re)register, which clears the
+     cache.
+
+     Each UlamClassRegistry has one.  Its usual user is the thread
+     running its tile's events, but a renderer may call in too, so
+     each entry is guarded by a sequence count: writers claim it (or
+     skip it) with a compare-and-swap, and readers discard what they
+     read if the count moved.  The hit and miss counts are not so
+     guarded, and may be slightly off.
+   */
+  template <class EC>
+  class UlamVTableCache
+  {
+  public:
+    enum {
+      SIZE_BITS = 8,
+      SIZE = 1 << SIZE_BITS,
+      NO_SELF = 0xffff,   // For entries that resolve just a vtable slot
+      MAX_KEY = 0xfffe    // Larger keys are never cached
+    };
+
+    /**
+       What a virtual call resolves to.  For NO_SELF entries, only
+       m_vfunc and m_ovclass mean anything.
+     */
+    struct Resolution
+    {
+      VfuncPtr m_vfunc;
+      const UlamClass<EC> * m_ovclass;  // The class whose function m_vfunc is
+      s32 m_ovclassrelpos;              // Where it is relative to the effective self
+      u32 m_ovclasslen;
+      bool m_ovclassIsElement;
+    };
+
+    UlamVTableCache()
+      : m_hits(0)
+      , m_misses(0)
+    {
+      Clear();
+    }
+
+    /**
+       Forget every resolution.  For use while registering classes,
+       before any events run.
+     */
+    void Clear()
+    {
+      for (u32 i = 0; i < SIZE; ++i)
+      {
+        m_entries[i].m_seq = 0;
+        m_entries[i].m_classes = 0;
+        m_entries[i].m_call = 0;
+        m_entries[i].m_res.m_ovclass = 0;
+      }
+    }
+
+    /**
+       Look up a call.  Returns true, having set found, on a hit.
+     */
+    bool Find(u32 selfid, u32 vtclassid, u32 origclassid, u32 funcidx, Resolution & found)
+    {
+      u32 classes, call;
+      if (MakeKey(selfid, vtclassid, origclassid, funcidx, classes, call))
+      {
+        const Entry & e = m_entries[Slot(classes, call)];
+        const u32 seq = __atomic_load_n(&e.m_seq, __ATOMIC_ACQUIRE);
+        if ((seq & 1) == 0 && e.m_classes == classes && e.m_call == call)
+        {
+          found = e.m_res;
+          __atomic_thread_fence(__ATOMIC_ACQUIRE);
+          if (found.m_ovclass && __atomic_load_n(&e.m_seq, __ATOMIC_RELAXED) == seq)
+          {
+            ++m_hits;
+            return true;
+          }
+        }
+      }
+      ++m_misses;
+      return false;
+    }
+
+    /**
+       Remember how a call resolved, unless the entry it goes in is
+       busy.
+     */
+    void Insert(u32 selfid, u32 vtclassid, u32 origclassid, u32 funcidx, const Resolution & res)
+    {
+      u32 classes, call;
+      if (!res.m_ovclass || !MakeKey(selfid, vtclassid, origclassid, funcidx, classes, call))
+      {
+        return;
+      }
+      Entry & e = m_entries[Slot(classes, call)];
+      const u32 seq = e.m_seq;
+      if ((seq & 1) != 0 || !__sync_bool_compare_and_swap(&e.m_seq, seq, seq + 1))
+      {
+        return;  // Someone else is writing it
+      }
+      __sync_synchronize();  // Claim before changes
+      e.m_classes = classes;
+      e.m_call = call;
+      e.m_res = res;
+      __sync_synchronize();  // Changes before release
+      e.m_seq = seq + 2;
+    }
+
+    u64 GetHits() const { return m_hits; }
+
+    u64 GetMisses() const { return m_misses; }
+
+    void ResetCounts()
+    {
+      m_hits = 0;
+      m_misses = 0;
+    }
+
+  private:
+    struct Entry
+    {
+      volatile u32 m_seq;   // Odd while being written
+      u32 m_classes;        // (1 + self, or 0 for NO_SELF) << 16 | vtable class
+      u32 m_call;           // Declaring class << 16 | function index
+      Resolution m_res;     // Null m_ovclass if unused
+    };
+
+    Entry m_entries[SIZE];
+    u64 m_hits;
+    u64 m_misses;
+
+    static bool MakeKey(u32 selfid, u32 vtclassid, u32 origclassid, u32 funcidx,
+                        u32 & classes, u32 & call)
+    {
+      if ((selfid > MAX_KEY && selfid != NO_SELF) ||
+          vtclassid > MAX_KEY || origclassid > MAX_KEY || funcidx > MAX_KEY)
+      {
+        return false;
+      }
+      const u32 self = (selfid == NO_SELF) ? 0 : selfid + 1;
+      classes = (self << 16) | vtclassid;
+      call = (origclassid << 16) | funcidx;
+      return true;
+    }
+
+    static u32 Slot(u32 classes, u32 call)
+    {
+      return ((classes ^ (call * 0x9E3779B1u)) * 0x85EBCA6Bu) >> (32 - SIZE_BITS);
+    }
+  };
+} /* namespace MFM */
+
+#endif /*ULAMVTABLECACHE_H*/
@@ -547,6 +547,23 @@ namespace MFM
 
    private:
 
+    typedef typename EventWindow<EC>::SiteMask SiteMask;
+
+    static bool IsSet(const SiteMask & mask, const u32 index)
+    {
+      return (mask[index / 32] >> (index % 32)) & 1;
+    }
+
+    /**
+     * Set matches for every live site in the window holding an atom
+     * of the given type.  The queries that map coordinates one by
+     * one then need only test bits.
+     */
+    u32 MatchInWindow(const u32 type, SiteMask & matches) const
+    {
+      return m_win.MatchTypeDirect(type, 0, m_win.GetBoundedSiteCount() - 1, matches);
+    }
+
     void FindRandomAtoms(const u32 radius, const u32 count, va_list& list) const;
 
   };
@@ -58,38 +58,19 @@ namespace MFM
 
     MFM_API_ASSERT_ARG(radius != 0 && radius <= R);
 
-    for(u32 i = md.GetFirstIndex(1); i <= md.GetLastIndex(radius); i++)
-    {
-      if(m_win.IsLiveSiteDirect(md.GetPoint(i)))
-      {
-        if(m_win.GetRelativeAtomDirect(md.GetPoint(i)).GetType() == type)
-        {
-          return true;
-        }
-      }
-    }
-    return false;
+    SiteMask matches;
+    return m_win.MatchTypeDirect(type, md.GetFirstIndex(1), md.GetLastIndex(radius), matches) > 0;
   }
 
   template <class EC>
   u32 WindowScanner<EC>::CountAtomsOfType(const u32 type, const u32 radius) const
   {
     const MDist<R>& md = MDist<R>::get();
-    u32 atomCount = 0;
 
     MFM_API_ASSERT_ARG(radius != 0 && radius <= R);
 
-    for(u32 i = md.GetFirstIndex(1); i <= md.GetLastIndex(radius); i++)
-    {
-      if(m_win.IsLiveSiteDirect(md.GetPoint(i)))
-      {
-        if(m_win.GetRelativeAtomDirect(md.GetPoint(i)).GetType() == type)
-        {
-          atomCount++;
-        }
-      }
-    }
-    return atomCount;
+    SiteMask matches;
+    return m_win.MatchTypeDirect(type, md.GetFirstIndex(1), md.GetLastIndex(radius), matches);
   }
 
   template <class EC>
@@ -103,18 +84,18 @@ namespace MFM
                                                   const Dir* neighborhood,
                                                   const u32 dirCount) const
   {
+    SiteMask matches;
+    MatchInWindow(type, matches);
+
     SPoint searchPt;
     for(u32 i = 0; i < dirCount; i++)
     {
       Dirs::FillDir(searchPt, neighborhood[i], false);
       searchPt /= 2; // Need undoubled coords for scanning
 
-      if(m_win.IsLiveSiteDirect(searchPt))
+      if(IsSet(matches, m_win.MapToIndexDirectValid(searchPt)))
       {
-        if(m_win.GetRelativeAtomDirect(searchPt).GetType() == type)
-        {
-          return true;
-        }
+        return true;
       }
     }
     return false;
@@ -141,6 +122,9 @@ namespace MFM
                                            const Dir* neighborhood,
                                            const u32 dirCount) const
   {
+    SiteMask matches;
+    MatchInWindow(type, matches);
+
     SPoint searchPt;
     u32 atomCount = 0;
     for(u32 i = 0; i < dirCount; i++)
@@ -148,12 +132,9 @@ namespace MFM
       Dirs::FillDir(searchPt, neighborhood[i], false);
       searchPt /= 2; // Need undoubled coords for scanning
 
-      if(m_win.IsLiveSiteDirect(searchPt))
+      if(IsSet(matches, m_win.MapToIndexDirectValid(searchPt)))
       {
-        if(m_win.GetRelativeAtomDirect(searchPt).GetType() == type)
-        {
-          atomCount++;
-        }
+        atomCount++;
       }
     }
     return atomCount;
@@ -187,43 +168,37 @@ namespace MFM
                                                   SPoint& outPoint) const
   {
     const MDist<R>& md = MDist<R>::get();
-    u32 foundPts = 0;
 
     MFM_API_ASSERT_ARG(radius != 0 && radius <= R);
 
-    for(u32 i = md.GetFirstIndex(1); i <= md.GetLastIndex(radius); i++)
+    // Count them all at once, then pick one uniformly
+    SiteMask matches;
+    const u32 foundPts =
+      m_win.MatchTypeDirect(type, md.GetFirstIndex(1), md.GetLastIndex(radius), matches);
+    if(foundPts > 0)
     {
-      if(m_win.IsLiveSiteDirect(md.GetPoint(i)))
-      {
-        if(m_win.GetRelativeAtomDirect(md.GetPoint(i)).GetType() == type)
-        {
-          foundPts++;
-          if(m_rand.OneIn(foundPts))
-          {
-            outPoint.Set(md.GetPoint(i));
-          }
-        }
-      }
+      const u32 pick = EventWindow<EC>::SelectSiteDirect(matches, m_rand.Create(foundPts));
+      outPoint.Set(md.GetPoint(pick));
     }
-  return foundPts;
+    return foundPts;
   }
 
   template <class EC>
   u32 WindowScanner<EC>::FindRandomInSubWindow(const u32 type, const SPoint* subWindow,
                                                const u32 subCount, SPoint& outPoint) const
   {
+    SiteMask matches;
+    MatchInWindow(type, matches);
+
     u32 atomCount = 0;
     for(u32 i = 0; i < subCount; i++)
     {
-      if(m_win.IsLiveSiteSym(subWindow[i]))
+      if(IsSet(matches, m_win.MapToIndexSymValid(subWindow[i])))
       {
-        if(m_win.GetRelativeAtomSym(subWindow[i]).GetType() == type)
+        atomCount++;
+        if(m_rand.OneIn(atomCount))
         {
-          atomCount++;
-          if(m_rand.OneIn(atomCount))
-          {
-            outPoint.Set(subWindow[i].GetX(), subWindow[i].GetY());
-          }
+          outPoint.Set(subWindow[i].GetX(), subWindow[i].GetY());
         }
       }
     }
@@ -243,6 +218,9 @@ namespace MFM
                                                   const u32 dirCount,
                                                   SPoint& outPoint) const
   {
+    SiteMask matches;
+    MatchInWindow(type, matches);
+
     SPoint searchPt;
     u32 ptsFound = 0;
 
@@ -251,16 +229,13 @@ namespace MFM
       Dirs::FillDir(searchPt, dirs[i], false);
       searchPt /= 2; // Need undoubled coords for scanning
 
-      if(m_win.IsLiveSiteSym(searchPt))
+      if(IsSet(matches, m_win.MapToIndexSymValid(searchPt)))
       {
-        if(m_win.GetRelativeAtomSym(searchPt).GetType() == type)
+        ptsFound++;
+        if(m_rand.OneIn(ptsFound))
         {
-          ptsFound++;
-          if(m_rand.OneIn(ptsFound))
-          {
-            Dirs::FillDir(outPoint, dirs[i], false);
-            outPoint /= 2; // Need undoubled coords for scanning
-          }
+          Dirs::FillDir(outPoint, dirs[i], false);
+          outPoint /= 2; // Need undoubled coords for scanning
         }
       }
     }
@@ -368,32 +343,31 @@ namespace MFM
     const MDist<R>& md = MDist<R>::get();
     Random& rand = m_win.GetRandom();
     SPoint* outPts[SITES];
-    u32 types[SITES];
+    SiteMask matches[SITES];
     u32* outCounts[SITES];
 
     for(u32 i = 0; i < count; i++)
     {
       outPts[i] = (SPoint*)va_arg(list, SPoint*);
-      types[i] = (u32)va_arg(list, u32);
+      const u32 type = (u32)va_arg(list, u32);
       outCounts[i] = (u32*)va_arg(list, u32*);
 
       *outCounts[i] = 0;
+      MatchInWindow(type, matches[i]);
     }
 
     for(u32 i = md.GetFirstIndex(1); i <= md.GetLastIndex(radius); i++)
     {
       SPoint pt = md.GetPoint(i);
-      if(m_win.IsLiveSiteSym(pt))
+      const u32 idx = m_win.MapToIndexSymValid(pt);
+      for(u32 j = 0; j < count; j++)
       {
-        for(u32 j = 0; j < count; j++)
+        if(IsSet(matches[j], idx))
         {
-          if(m_win.GetRelativeAtomSym(pt).GetType() == types[j])
+          (*(outCounts[j]))++;
+          if(rand.OneIn(*(outCounts[j])))
           {
-            (*(outCounts[j]))++;
-            if(rand.OneIn(*(outCounts[j])))
-            {
-              outPts[j]->Set(pt.GetX(), pt.GetY());
-            }
+            outPts[j]->Set(pt.GetX(), pt.GetY());
           }
         }
       }
@@ -0,0 +1,149 @@
+/*                                              -*- mode:C++ -*-
+  Xoshiro128.h A small, fast PRNG with jump-ahead
+  Copyright (C) 2015 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file Xoshiro128.h A small, fast PRNG with jump-ahead
+  \author David H. Ackley.
+  \date (C) 2015 All rights reserved.
+  \lgpl
+ */
+#ifndef XOSHIRO128_H
+#define XOSHIRO128_H
+
+#include "itype.h"
+#include "Util.h"  /* For HexU64 */
+
+namespace MFM
+{
+  /**
+     The xoshiro128** generator of Blackman and Vigna: 128 bits of
+     state, 32 bits per draw, period 2**128-1, and a Jump that
+     advances 2**64 draws at once, so generators seeded alike and
+     jumped different numbers of times give non-overlapping streams.
+
+     It has the same Next, Seed, Jump, and Split as RandMT, so Random
+     can use either.
+   */
+  class Xoshiro128
+  {
+    u32 m_state[4];
+
+    static inline u32 Rotl(const u32 x, u32 k)
+    {
+      return (x << k) | (x >> (32 - k));
+    }
+
+    /**
+       One step of splitmix64, to spread a seed over the state.
+     */
+    static inline u64 SplitMix(u64 & x)
+    {
+      u64 z = (x += HexU64(0x9E3779B9, 0x7F4A7C15));
+      z = (z ^ (z >> 30)) * HexU64(0xBF58476D, 0x1CE4E5B9);
+      z = (z ^ (z >> 27)) * HexU64(0x94D049BB, 0x133111EB);
+      return z ^ (z >> 31);
+    }
+
+  public:
+
+    Xoshiro128()
+    {
+      Seed(1);
+    }
+
+    Xoshiro128(u32 seed)
+    {
+      Seed(seed);
+    }
+
+    inline u32 Next()
+    {
+      const u32 result = Rotl(m_state[1] * 5, 7) * 9;
+      const u32 t = m_state[1] << 9;
+
+      m_state[2] ^= m_state[0];
+      m_state[3] ^= m_state[1];
+      m_state[1] ^= m_state[2];
+      m_state[0] ^= m_state[3];
+      m_state[2] ^= t;
+      m_state[3] = Rotl(m_state[3], 11);
+
+      return result;
+    }
+
+    /**
+       Set the state from seed.  Any seed, including 0, and sequential
+       seeds, give well-mixed, different states.
+     */
+    void Seed(u32 seed)
+    {
+      u64 x = seed;
+      const u64 a = SplitMix(x);
+      const u64 b = SplitMix(x);
+      m_state[0] = (u32) a;
+      m_state[1] = (u32) (a >> 32);
+      m_state[2] = (u32) b;
+      m_state[3] = (u32) (b >> 32);
+      if ((m_state[0] | m_state[1] | m_state[2] | m_state[3]) == 0)
+      {
+        m_state[0] = 1;  // The one state that never leaves itself
+      }
+    }
+
+    /**
+       Advance the generator as if by 2**64 calls to Next.
+     */
+    void Jump()
+    {
+      static const u32 JUMP[4] = { 0x8764000b, 0xf542d2d3, 0x6fa035c3, 0x77f2db5b };
+
+      u32 s[4] = { 0, 0, 0, 0 };
+      for (u32 i = 0; i < 4; ++i)
+      {
+        for (u32 b = 0; b < 32; ++b)
+        {
+          if (JUMP[i] & (1u << b))
+          {
+            for (u32 j = 0; j < 4; ++j)
+            {
+              s[j] ^= m_state[j];
+            }
+          }
+          Next();
+        }
+      }
+      for (u32 j = 0; j < 4; ++j)
+      {
+        m_state[j] = s[j];
+      }
+    }
+
+    /**
+       Give into the stream starting here, and Jump past it.
+     */
+    void Split(Xoshiro128 & into)
+    {
+      into = *this;
+      Jump();
+    }
+  };
+} /* namespace MFM */
+
+#endif /*XOSHIRO128_H*/
@@ -1,6 +1,281 @@
 #include "Logger.h"
+#include "OverflowableCharBufferByteSink.h"
+#include <unistd.h>   /* for usleep */
 
 namespace MFM {
 
   Logger LOG(DevNullByteSink, Logger::ERROR);
+
+  struct Logger::AsyncRecord
+  {
+    Level m_level;
+    StampCapture m_stamp;
+    OverflowableCharBufferByteSink<ASYNC_RECORD_BYTES> m_text;
+  };
+
+  /**
+     A single-producer, single-consumer ring of AsyncRecords.  Only
+     its thread advances m_head, and only the holder of m_ringsMutex
+     advances m_tail; each publishes its record with a barrier before
+     the store.
+   */
+  struct Logger::AsyncRing
+  {
+    AsyncRing * m_next;
+    volatile u32 m_head;        // Records put, ever
+    volatile u32 m_tail;        // Records taken, ever
+    volatile bool m_released;   // Its thread has exited
+    AsyncRecord m_records[ASYNC_RING_RECORDS];
+
+    AsyncRing() : m_next(0), m_head(0), m_tail(0), m_released(false) { }
+  };
+
+  /**
+     Bumped in each child process that fork creates, which has no
+     drainer thread.
+   */
+  static volatile u32 s_forkGeneration = 0;
+  static pthread_once_t s_atForkOnce = PTHREAD_ONCE_INIT;
+
+  static void AtForkChild()
+  {
+    ++s_forkGeneration;
+  }
+
+  static void RegisterAtFork()
+  {
+    pthread_atfork(0, 0, &AtForkChild);
+  }
+
+  Logger::~Logger()
+  {
+    if (IsForkedChild())
+    {
+      return;  // The rings' records are the parent's to write
+    }
+    StopAsync();
+    DrainRings();
+    while (m_rings)
+    {
+      AsyncRing * ring = m_rings;
+      m_rings = ring->m_next;
+      delete ring;
+    }
+    if (m_ringKeyMade)
+    {
+      pthread_key_delete(m_ringKey);
+    }
+  }
+
+  bool Logger::IsForkedChild() const
+  {
+    return m_forkGeneration != s_forkGeneration;
+  }
+
+  bool Logger::StartAsync()
+  {
+    if (m_async)
+    {
+      return true;
+    }
+    pthread_once(&s_atForkOnce, &RegisterAtFork);
+    if (!m_ringKeyMade)
+    {
+      if (pthread_key_create(&m_ringKey, &ReleaseRing))
+      {
+        return false;
+      }
+      m_ringKeyMade = true;
+    }
+    m_forkGeneration = s_forkGeneration;
+    DrainRings();  // Stragglers from a previous StopAsync
+
+    m_stopDrainer = false;
+    if (pthread_create(&m_drainer, NULL, DrainRunner, this))
+    {
+      return false;
+    }
+    m_drainerRunning = true;
+    __sync_synchronize();
+    m_async = true;
+    return true;
+  }
+
+  void Logger::StopAsync()
+  {
+    m_async = false;
+    if (IsForkedChild())
+    {
+      return;
+    }
+    if (m_drainerRunning)
+    {
+      m_stopDrainer = true;
+      pthread_join(m_drainer, NULL);
+      m_drainerRunning = false;
+    }
+  }
+
+  void Logger::FlushAsync()
+  {
+    if (m_async && !IsForkedChild())
+    {
+      DrainRings();
+    }
+  }
+
+  void Logger::ReleaseRing(void * ring)
+  {
+    ((AsyncRing *) ring)->m_released = true;
+  }
+
+  Logger::AsyncRing * Logger::GetAsyncRing()
+  {
+    AsyncRing * ring = (AsyncRing *) pthread_getspecific(m_ringKey);
+    if (!ring)
+    {
+      ring = new AsyncRing();
+      if (pthread_setspecific(m_ringKey, ring))
+      {
+        delete ring;
+        return 0;
+      }
+      Mutex::ScopeLock lock(m_ringsMutex);
+      ring->m_next = m_rings;
+      m_rings = ring;
+    }
+    return ring;
+  }
+
+  bool Logger::AsyncReport(Level level, const char * format, va_list * ap, ByteSource * bs)
+  {
+    if (IsForkedChild())
+    {
+      m_async = false;
+      return false;
+    }
+    AsyncRing * ring = GetAsyncRing();
+    if (!ring)
+    {
+      return false;
+    }
+
+    const u32 head = ring->m_head;
+    __sync_synchronize();  // See the consumer's latest m_tail
+    if (head - ring->m_tail >= ASYNC_RING_RECORDS)
+    {
+      __sync_fetch_and_add(&m_droppedRecords, 1);
+      return true;
+    }
+
+    AsyncRecord & record = ring->m_records[head % ASYNC_RING_RECORDS];
+    record.m_level = level;
+    record.m_text.Reset();
+    if (m_includeFlags & INCLUDE_TIMESTAMP)
+    {
+      CaptureStamp(record.m_stamp);
+    }
+    unwind_protect(
+    {
+      abort(); // Logger is not prepared to handle failures during printing!
+    },
+    {
+      if (m_includeFlags & INCLUDE_TEXT)
+      {
+        if (bs) record.m_text.Printf("%<", bs);
+        else record.m_text.Vprintf(format, *ap);
+      }
+    });
+    __sync_synchronize();  // Record before head
+    ring->m_head = head + 1;
+    return true;
+  }
+
+  void Logger::CaptureStamp(StampCapture & stamp)
+  {
+    stamp.m_sequence = __atomic_add_fetch(&m_stampSequence, 1, __ATOMIC_RELAXED);
+    clock_gettime(CLOCK_REALTIME, &stamp.m_time);
+    stamp.m_thread = pthread_self();
+  }
+
+  void Logger::WriteRecord(const AsyncRecord & record)
+  {
+    unwind_protect(
+    {
+      abort(); // Logger is not prepared to handle failures during printing!
+    },
+    {
+      if (m_includeFlags & INCLUDE_TIMESTAMP)
+      {
+        m_stampCapture = record.m_stamp;
+        m_sink->Printf("%@", m_timeStamper);
+      }
+      if (m_includeFlags & INCLUDE_LEVEL) m_sink->Printf("%s", StrLevel(record.m_level));
+      if (m_includeFlags & INCLUDE_SEPARATOR) m_sink->Printf(": ");
+      if (m_includeFlags & INCLUDE_TEXT) m_sink->Print(record.m_text.GetZString());
+      if (m_includeFlags & INCLUDE_NEWLINE) m_sink->Println();
+    });
+  }
+
+  u32 Logger::DrainRings()
+  {
+    Mutex::ScopeLock ringsLock(m_ringsMutex);
+    u32 written = 0;
+    for (AsyncRing ** link = &m_rings; *link; )
+    {
+      AsyncRing * ring = *link;
+      __sync_synchronize();  // See the producer's records up to m_head
+      const u32 head = ring->m_head;
+      const bool released = ring->m_released;
+      if (ring->m_tail != head)
+      {
+        Mutex::ScopeLock lock(m_mutex);
+        for (u32 tail = ring->m_tail; tail != head; ++tail)
+        {
+          WriteRecord(ring->m_records[tail % ASYNC_RING_RECORDS]);
+          ++written;
+        }
+      }
+      __sync_synchronize();  // Done with the records before freeing them
+      ring->m_tail = head;
+
+      if (released && ring->m_head == head)
+      {
+        *link = ring->m_next;
+        delete ring;
+      }
+      else
+      {
+        link = &ring->m_next;
+      }
+    }
+
+    const u64 dropped = m_droppedRecords;
+    if (dropped != m_reportedDrops)
+    {
+      Mutex::ScopeLock lock(m_mutex);
+      AsyncRecord note;
+      note.m_level = WARNING;
+      CaptureStamp(note.m_stamp);
+      note.m_text.Printf("Logger dropped %d records (%d in all)",
+                         (u32) (dropped - m_reportedDrops), (u32) dropped);
+      WriteRecord(note);
+      m_reportedDrops = dropped;
+    }
+    return written;
+  }
+
+  void * Logger::DrainRunner(void * arg)
+  {
+    Logger & logger = *(Logger *) arg;
+    while (!logger.m_stopDrainer)
+    {
+      if (logger.DrainRings() == 0)
+      {
+        usleep(1000);
+      }
+    }
+    logger.DrainRings();
+    return NULL;
+  }
 }
@@ -0,0 +1,6 @@
+#ifndef MAIN_H
+#define MAIN_H
+
+#include "Tests.h"
+
+#endif  /* MAIN_H */
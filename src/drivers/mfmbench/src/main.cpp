@@ -0,0 +1,32 @@
+#include "main.h"
+
+using namespace MFM;
+
+/*
+ * Wall-clock benchmarks, kept out of mfmtest so the tests stay quick
+ * and their outcomes don't depend on the machine's speed or load.
+ * Results go to the log; give any argument to see all of it.
+ */
+
+#define BENCHMARK(className)                                    \
+  do {                                                          \
+    MFM::LOG.Message("Starting " # className " benchmarks");    \
+    className::Test_RunBenchmarks();                            \
+    MFM::LOG.Message("Done     " # className " benchmarks");    \
+  } while (0)
+
+int main(int argc, char** argv)
+{
+  MFM::LOG.SetByteSink(MFM::STDERR);
+  MFM::LOG.SetLevel(argc > 1 ? MFM::LOG.ALL : MFM::LOG.MESSAGE);
+
+  BENCHMARK(BitVector_Test);
+  BENCHMARK(Random_Test);
+  BENCHMARK(EventWindow_Test);
+  BENCHMARK(UlamClassRegistry_Test);
+  BENCHMARK(Grid_Test);
+  BENCHMARK(SiteLayout_Test);
+  BENCHMARK(GridSnapshot_Test);
+
+  return 0;
+}
@@ -192,7 +192,7 @@ namespace MFM
         Super::PrintTo(byteSink, argument);
         byteSink.Printf("%dAEPS [%x]",
                         (u32) driver.GetAEPS(),
-                        (u32) (((u64) pthread_self())>>8));
+                        (u32) (((u64) LOG.GetStampCapture().m_thread)>>8));
         return SUCCESS;
       }
     };
@@ -22,6 +22,7 @@ int main(int argc, char** argv)
   TEST(BitRef_Test);
   TEST(UlamRef_Test);
   TEST(UlamElement_Test);
+  TEST(UlamClassRegistry_Test);
 
   TEST(GridTransceiver_Test);
   TEST(ElementRegistry_Test);
@@ -40,6 +41,7 @@ int main(int argc, char** argv)
   TEST(ColorMap_Test);
   TEST(Random_Test);
   TEST(BitVector_Test);
+  TEST(LonglivedLock_Test);
 
   Point_Test::Test_pointAdd();
   Point_Test::Test_pointMultiply();
@@ -58,6 +60,23 @@ int main(int argc, char** argv)
   TEST(Tile_Test);
 
   Grid_Test::Test_gridPlaceAtom();
+  Grid_Test::Test_gridPauseUnpause();
+  Grid_Test::Test_gridPauseWhilePaused();
+  Grid_Test::Test_gridWorkerPool();
+  Grid_Test::Test_gridWorkerSteal();
+  Grid_Test::Test_gridActiveSiteSelection();
+  Grid_Test::Test_gridSharedCacheChannels();
+  Grid_Test::Test_gridCacheDeltaEncoding();
+  Grid_Test::Test_gridCacheSpotChecks();
+  Grid_Test::Test_gridCacheDeltaRepair();
+  Grid_Test::Test_gridConcurrentWindows();
+  Grid_Test::Test_gridDeterministic();
+  Grid_Test::Test_gridSequential();
+  Grid_Test::Test_gridIncrementalAtomCounts();
+  TEST(SiteLayout_Test);
+  TEST(CpuTopology_Test);
+  TEST(SweepPlan_Test);
+  TEST(GridSnapshot_Test);
 
   TEST(ExternalConfig_Test);
 
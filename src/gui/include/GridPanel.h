@@ -69,7 +69,7 @@ namespace MFM
 
     typedef Grid<GC> OurGrid;
     typedef Tile<EC> OurTile;
-    typedef Site<AC> OurSite;
+    typedef typename EC::SITE OurSite;
     typedef TileRenderer<EC> OurTileRenderer;
     typedef GridTool<GC> OurGridTool;
     typedef AtomViewPanel<GC> OurAtomViewPanel;
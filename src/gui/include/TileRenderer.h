@@ -46,7 +46,7 @@ namespace MFM
     typedef typename AC::ATOM_TYPE T;
     typedef typename EC::SITE S;
     typedef Tile<EC> OurTile;
-    typedef Site<AC> OurSite;
+    typedef typename EC::SITE OurSite;
 
     enum { EWR = EC::EVENT_WINDOW_RADIUS };
 
@@ -164,7 +164,7 @@ namespace MFM
       SPoint siteInVisibleCoord = i.At();  // (0,0) is least visible pos (cache if m_drawCacheSites, else owned)
       SPoint siteOriginDit = tileDitOrigin + siteInVisibleCoord * m_atomSizeDit + SPoint(m_atomSizeDit/2,m_atomSizeDit/2); // Center of site
 
-      AtomBitStorage<EC> abs(i->GetAtom());
+      AtomBitStorage<EC> abs((*i).GetAtom());
       const T& atom = abs.GetAtom();
       if (!atom.IsSane()) continue;
 
@@ -281,7 +281,7 @@ namespace MFM
                                         const DrawSiteType drawType,
                                         const DrawSiteShape shape,
                                         const SPoint ditOrigin,
-                                        const Site<AC> & site,
+                                        const OurSite & site,
                                         const Tile<EC> & inTile)
   {
     u32 selector = 0;
@@ -301,6 +301,7 @@ namespace MFM
 
     case DRAW_SITE_CHANGE_AGE:
       {
+        if (!EC::SITE_STATS) return;  // No write ages were kept
         const u32 writeAge = site.GetWriteAge();
         const u32 MAX_IDX = 10000;       // Potential (interpolated) colors
         const u32 AGE_PER_AEPS = 1; // Counting site events directly.., was: tile.GetSites();
@@ -34,6 +34,9 @@
 #include <sys/time.h>  /* for gettimeofday */
 #include <sys/types.h> /* for mkdir */
 #include <errno.h>     /* for errno */
+#include <fcntl.h>     /* for open */
+#include <unistd.h>    /* for fork, write, sysconf */
+#include <sys/wait.h>  /* for waitpid */
 #include "Util.h"
 #include "Utils.h"     /* for GetDateTimeNow, Sleep */
 #include "ExternalConfig.h"
@@ -51,6 +54,10 @@
 #include "ElementRegistry.h"
 #include "Version.h"
 #include "DebugTools.h"
+#include "SweepPlan.h"
+#include "GridSnapshot.h"
+#include "SnapshotWriter.h"
+#include "CharBufferByteSource.h"
 
 
 #define MAX_PATH_LENGTH 1000
@@ -61,6 +68,8 @@
 
 #define INITIAL_AEPS_PER_FRAME 1
 
+#define SWEEP_ATTEMPTS_PER_TILE 100
+
 namespace MFM
 {
   /** 
@@ -263,7 +272,14 @@ namespace MFM
       else
         m_msSpentOverhead = 0;
 
-      SleepUsec(m_microsSleepPerFrame);
+      if (grid.IsSequential())
+      {
+        grid.RunSequentialFor(m_microsSleepPerFrame);  // Nobody else will
+      }
+      else
+      {
+        SleepUsec(m_microsSleepPerFrame);
+      }
 
       m_ticksLastStopped = GetTicks(); // and before pausing
 
@@ -315,6 +331,17 @@ namespace MFM
         thisAERsample = 1000.0 * newEvents / totalSites / thisPeriodMS;
       }
 
+      {
+        // Events whose center wasn't empty, for comparing site
+        // selection modes
+        u64 usefulEvents = grid.GetTotalUsefulEvents();
+        u64 newUseful =
+          usefulEvents >= m_lastUsefulEvents ? usefulEvents - m_lastUsefulEvents : 0;
+        m_lastUsefulEvents = usefulEvents;
+        m_recentUsefulEventsPerSecond =
+          0.9 * m_recentUsefulEventsPerSecond + 0.1 * (1000.0 * newUseful / thisPeriodMS);
+      }
+
       const double BACKWARDS_AVERAGE_RATE = 0.99;
       m_recentAER = BACKWARDS_AVERAGE_RATE * m_recentAER +
                     (1 - BACKWARDS_AVERAGE_RATE) * thisAERsample;
@@ -435,6 +462,10 @@ namespace MFM
      */
     virtual void OnceOnly(VArguments& args)
     {
+      if (m_sweepPath && m_haltAfterAEPS == 0)
+      {
+        args.Die("--sweep needs --haltafteraeps to say how long each run is");
+      }
       if(!args.Appeared("-d"))
       {
         SetDataDirFromArgs(NULL, this);
@@ -512,6 +543,225 @@ namespace MFM
 
     }
 
+    /**
+     * Run each line of the --sweep file as a separate run, starting
+     * from the world as loaded and initialized, for --haltafteraeps
+     * AEPS, appending one line of results per run to sweep.csv in the
+     * simulation directory.  Each run is a fork()ed child, so the
+     * element libraries, .mfs loading and grid setup all happen once,
+     * and the children share the parent's memory copy-on-write until
+     * they write to it.  Up to m_sweepJobs children run at a time.
+     */
+    void RunSweep()
+    {
+      VArguments & args = m_varguments;
+      SweepPlan plan;
+      if (!plan.ReadFile(m_sweepPath))
+      {
+        args.Die("Can't run sweep file '%s'", m_sweepPath);
+      }
+
+      // Check the settings up front, rather than in every child
+      for (u32 r = 0; r < plan.GetRunCount(); ++r)
+      {
+        const SweepRun & run = plan.GetRun(r);
+        for (u32 i = 0; i < run.m_settingCount; ++i)
+        {
+          const SweepSetting & s = run.m_settings[i];
+          if (s.m_isTileParameter)
+          {
+            if (s.m_key >= Tile<EC>::MAX_TILE_PARAMETERS)
+            {
+              args.Die("Sweep run %d: No tile parameter key %d", r, s.m_key);
+            }
+            continue;
+          }
+          Element<EC> * elem = m_grid.LookupElementFromSymbol((const u8 *) s.m_symbol);
+          if (!elem)
+          {
+            args.Die("Sweep run %d: '%s' is not a known element symbol", r, s.m_symbol);
+          }
+          if (elem->GetElementParameters().GetParameterNumberFromTag(s.m_tag) < 0)
+          {
+            args.Die("Sweep run %d: '%s' is not a parameter tag of %s",
+                     r, s.m_tag, elem->GetName());
+          }
+        }
+      }
+
+      u32 jobs = m_sweepJobs;
+      if (jobs == 0)
+      {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        jobs = cores > 0 ? (u32) cores : 1;
+      }
+
+      OString512 csvPath;
+      csvPath.Printf("%s", GetSimDirPathTemporary("sweep.csv"));
+      int fd = open(csvPath.GetZString(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+      if (fd < 0)
+      {
+        args.Die("Can't open '%s': %s", csvPath.GetZString(), strerror(errno));
+      }
+
+      OverflowableCharBufferByteSink<4096> header;
+      header.Printf("run,seed,settings,aeps,events,msec");
+      for (u32 i = 0; i < m_neededElementCount; ++i)
+      {
+        header.WriteByte(',');
+        for (const char * p = m_neededElements[i]->GetName(); *p; ++p)
+        {
+          header.WriteByte((isspace(*p) || *p == ',' || *p == '"') ? '_' : *p);
+        }
+      }
+      header.Println();
+      if (header.HasOverflowed() ||
+          write(fd, header.GetZString(), header.GetLength()) != (ssize_t) header.GetLength())
+      {
+        args.Die("Can't write '%s'", csvPath.GetZString());
+      }
+
+      LOG.Message("Sweeping %d runs of %d AEPS, %d at a time, into '%s'",
+                  plan.GetRunCount(), m_haltAfterAEPS, jobs, csvPath.GetZString());
+
+      const u64 startMS = GetTicksSinceEpoch();
+      pid_t * pids = new pid_t[jobs];
+      u32 * runOf = new u32[jobs];
+      u32 running = 0, next = 0, failures = 0;
+      while (next < plan.GetRunCount() || running > 0)
+      {
+        if (next < plan.GetRunCount() && running < jobs)
+        {
+          fflush(NULL);  // Don't let the child inherit unwritten output
+          pid_t pid = fork();
+          if (pid == 0)
+          {
+            int status = RunSweepChild(plan.GetRun(next), next, fd);
+            m_snapshotWriter.Finish();
+            fflush(NULL);
+            _exit(status);
+          }
+          if (pid < 0)
+          {
+            LOG.Error("Sweep run %d: fork failed: %s", next, strerror(errno));
+            ++failures;
+          }
+          else
+          {
+            pids[running] = pid;
+            runOf[running] = next;
+            ++running;
+          }
+          ++next;
+          continue;
+        }
+
+        int status;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid < 0)
+        {
+          if (errno == EINTR)
+          {
+            continue;
+          }
+          FAIL(ILLEGAL_STATE);  // We have children, so where are they?
+        }
+        for (u32 i = 0; i < running; ++i)
+        {
+          if (pids[i] != pid)
+          {
+            continue;
+          }
+          if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+          {
+            const SweepRun & run = plan.GetRun(runOf[i]);
+            LOG.Error("Sweep run %d (seed %d '%s') failed", runOf[i], run.m_seed, run.m_label);
+            ++failures;
+          }
+          --running;
+          pids[i] = pids[running];
+          runOf[i] = runOf[running];
+          break;
+        }
+      }
+      delete [] pids;
+      delete [] runOf;
+      close(fd);
+
+      LOG.Message("Sweep of %d runs done in %d ms, %d failed",
+                  plan.GetRunCount(), (u32) (GetTicksSinceEpoch() - startMS), failures);
+    }
+
+    /**
+     * Apply run to the grid and run it, appending its results to the
+     * CSV file open on fd.  Runs in a child process forked by
+     * RunSweep, and returns its exit status.
+     */
+    int RunSweepChild(const SweepRun & run, u32 index, int fd)
+    {
+      m_grid.Reseed(run.m_seed);
+      for (u32 i = 0; i < run.m_settingCount; ++i)
+      {
+        const SweepSetting & s = run.m_settings[i];
+        if (s.m_isTileParameter)
+        {
+          m_grid.SetTileParameter(s.m_key, s.m_value);
+          continue;
+        }
+        Element<EC> * elem = m_grid.LookupElementFromSymbol((const u8 *) s.m_symbol);
+        MFM_API_ASSERT_NONNULL(elem);  // RunSweep checked
+        ElementParameters<EC> & parms = elem->GetElementParameters();
+        ElementParameter<EC> * p =
+          parms.GetParameter((u32) parms.GetParameterNumberFromTag(s.m_tag));
+        MFM_API_ASSERT_NONNULL(p);
+        CharBufferByteSource in(s.m_text, strlen(s.m_text));
+        if (!p->ReadValue(in))
+        {
+          LOG.Error("Sweep run %d: Bad value '%s' for %s.%s",
+                    index, s.m_text, s.m_symbol, s.m_tag);
+          return 2;
+        }
+      }
+
+      const u64 sites = m_grid.GetTotalSites();
+      const u64 startEvents = m_grid.GetTotalEventsExecuted();
+      const u64 goalEvents = startEvents + (u64) m_haltAfterAEPS * sites;
+      const u64 startMS = GetTicksSinceEpoch();
+
+      m_grid.Unpause();
+      while (m_grid.GetTotalEventsExecuted() < goalEvents)
+      {
+        if (m_grid.RunSequentialEvents(SWEEP_ATTEMPTS_PER_TILE) == 0)
+        {
+          break;  // No tile is running
+        }
+      }
+      m_grid.Pause();
+      m_grid.RecountAtoms();
+
+      const u64 events = m_grid.GetTotalEventsExecuted() - startEvents;
+      OverflowableCharBufferByteSink<4096> row;
+      row.Printf("%d,%d,\"%s\",%f,", index, run.m_seed, run.m_label,
+                 ((double) events) / sites);
+      row.Print(events);
+      row.WriteByte(',');
+      row.Print(GetTicksSinceEpoch() - startMS);
+      for (u32 i = 0; i < m_neededElementCount; ++i)
+      {
+        row.Printf(",%d", m_grid.GetAtomCount(m_neededElements[i]->GetType()));
+      }
+      row.Println();
+
+      // One write, so rows from concurrent runs don't interleave
+      if (row.HasOverflowed() ||
+          write(fd, row.GetZString(), row.GetLength()) != (ssize_t) row.GetLength())
+      {
+        LOG.Error("Sweep run %d: Writing results failed", index);
+        return 1;
+      }
+      return 0;
+    }
+
     virtual bool RunHelperExiter() {
       double full = m_grid.GetFullSitePercentage();
       if((m_haltAfterAEPS > 0 && m_AEPS > m_haltAfterAEPS)
@@ -524,7 +774,8 @@ namespace MFM
         // Free final save if halting on --halt*.  Hope for good-looking corpse.
         {
           const char* filename =
-            GetSimDirPathTemporary("save/final-%D-%D.mfs", m_epochCount, (u32) m_AEPS);
+            GetSimDirPathTemporary("save/final-%D-%D.%s", m_epochCount, (u32) m_AEPS,
+                                   GetSaveExtension());
           SaveGrid(filename);
         }
         WriteTimeBasedData();
@@ -690,6 +941,13 @@ namespace MFM
       LOG.SetLevel((Logger::Level) val);
     }
 
+    static void SetAsyncLogging(const char* not_needed, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+      if (!LOG.StartAsync())
+        driver.m_varguments.Die("Can't start the logging thread");
+    }
+
     static const char * GetNumberFromString(const char* str, s32 & output, s32 min, s32 max)
     {
       MFM_API_ASSERT_NONNULL(str);
@@ -756,6 +1014,21 @@ namespace MFM
       driver.m_autosavePerEpochs = (u32) out;
     }
 
+    static void SetAuditCountsPerEpochsFromArgs(const char* arg, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+      VArguments& args = driver.m_varguments;
+
+      s32 out;
+      const char * errmsg = AbstractDriver<GC>::GetNumberFromString(arg, out, 0, S32_MAX);
+      if (errmsg)
+      {
+        args.Die("Bad audit counts per epochs '%s': %s", arg, errmsg);
+      }
+
+      driver.m_auditCountsPerEpochs = (u32) out;
+    }
+
     static void SetPicturesPerRateFromArgs(const char* aeps, void* driverptr)
     {
       AbstractDriver& driver = *(AbstractDriver*)driverptr;
@@ -851,6 +1124,36 @@ namespace MFM
       ((AbstractDriver*)driver)->m_tileImages = 1;
     }
 
+    static void SetBinarySaves(const char* not_needed, void* driver)
+    {
+      ((AbstractDriver*)driver)->m_binarySaves = true;
+    }
+
+    static void SetAsyncSaves(const char* not_needed, void* driver)
+    {
+      ((AbstractDriver*)driver)->m_asyncSaves = true;
+    }
+
+    static void SetDeltaSavesFromArgs(const char* arg, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+      VArguments& args = driver.m_varguments;
+
+      s32 out;
+      const char * errmsg = AbstractDriver<GC>::GetNumberFromString(arg, out, 1, S32_MAX);
+      if (errmsg)
+      {
+        args.Die("Bad autosaves per keyframe '%s': %s", arg, errmsg);
+      }
+
+      driver.m_keyframePerAutosaves = (u32) out;
+    }
+
+    static void SetConvertToFromArgs(const char* path, void* driver)
+    {
+      ((AbstractDriver*)driver)->m_convertPath = path;
+    }
+
     static void SetDataDirFromArgs(const char* dirPath, void* driverPtr)
     {
       AbstractDriver& driver = *((AbstractDriver*)driverPtr);
@@ -977,6 +1280,128 @@ namespace MFM
       driver.m_grid.SetWarpFactor(out);
     }
 
+    static void SetWorkerThreadsFromArgs(const char* threads, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+      VArguments& args = driver.m_varguments;
+
+      s32 out;
+      const char * errmsg = AbstractDriver<GC>::GetNumberFromString(threads, out, 0, OurGrid::MAX_TILES_SUPPORTED);
+      if (errmsg)
+      {
+        args.Die("Worker thread count '%s' not in 0..%d: %s",
+                 threads, OurGrid::MAX_TILES_SUPPORTED, errmsg);
+      }
+
+      driver.m_grid.SetWorkerThreads((u32) out);
+    }
+
+    static void SetConcurrentWindowsFromArgs(const char* count, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+      VArguments& args = driver.m_varguments;
+
+      s32 out;
+      const char * errmsg =
+        AbstractDriver<GC>::GetNumberFromString(count, out, 1, Tile<EC>::MAX_CONCURRENT_WINDOWS);
+      if (errmsg)
+      {
+        args.Die("Concurrent window count '%s' not in 1..%d: %s",
+                 count, Tile<EC>::MAX_CONCURRENT_WINDOWS, errmsg);
+      }
+
+      driver.m_grid.SetConcurrentWindows((u32) out);
+    }
+
+    static void SetDeterministicFromArgs(const char* events, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+      VArguments& args = driver.m_varguments;
+
+      s32 out;
+      const char * errmsg = AbstractDriver<GC>::GetNumberFromString(events, out, 1, 1000000000);
+      if (errmsg)
+      {
+        args.Die("Deterministic events per round '%s' not in 1..%d: %s",
+                 events, 1000000000, errmsg);
+      }
+
+      driver.m_grid.SetDeterministic((u32) out);
+    }
+
+    static void SetThreadAffinityFromArgs(const char* policy, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+      VArguments& args = driver.m_varguments;
+
+      ThreadAffinity affinity;
+      if (!CpuTopology::ParseAffinity(policy, affinity))
+      {
+        args.Die("Thread affinity '%s' is not none, compact, or spread", policy);
+      }
+
+      driver.m_grid.SetThreadAffinity(affinity);
+    }
+
+    static void SetActiveSitesFromArgs(const char* pct, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+      VArguments& args = driver.m_varguments;
+
+      s32 out;
+      const char * errmsg = AbstractDriver<GC>::GetNumberFromString(pct, out, 0, 100);
+      if (errmsg)
+      {
+        args.Die("Uniform selection percent '%s' not in 0..100: %s", pct, errmsg);
+      }
+
+      driver.m_grid.SetActiveSiteSelection(true, (u32) out);
+    }
+
+    static void SetSharedCachesFromArgs(const char* not_needed, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+
+      driver.m_grid.SetSharedCacheChannels(true);
+    }
+
+    static void SetSequentialFromArgs(const char* not_needed, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+
+      driver.m_grid.SetSequential(true);
+    }
+
+    static void SetSweepFromArgs(const char* path, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+
+      driver.m_sweepPath = path;
+      driver.m_grid.SetSequential(true);  // No threads to lose in fork()
+    }
+
+    static void SetSweepJobsFromArgs(const char* jobs, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+      VArguments& args = driver.m_varguments;
+
+      s32 out;
+      const char * errmsg = AbstractDriver<GC>::GetNumberFromString(jobs, out, 0, 10000);
+      if (errmsg)
+      {
+        args.Die("Bad sweep job count '%s': %s", jobs, errmsg);
+      }
+
+      driver.m_sweepJobs = (u32) out;
+    }
+
+    static void SetNoCacheDeltasFromArgs(const char* not_needed, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+
+      driver.m_grid.SetCacheDeltaEncoding(false);
+    }
+
     static void LoadFromConfigFile(const char* path, void* driverptr)
     {
       AbstractDriver& driver = *((AbstractDriver*)driverptr);
@@ -1156,18 +1581,148 @@ namespace MFM
 
     void AutosaveGrid(u32 epochs)
     {
+      if (m_asyncSaves || m_keyframePerAutosaves > 0)
+      {
+        AutosaveGridCaptured(epochs);
+        return;
+      }
       const char* filename =
-        GetSimDirPathTemporary("autosave/%D-%D.mfs", epochs, (u32) m_AEPS);
+        GetSimDirPathTemporary("autosave/%D-%D.%s", epochs, (u32) m_AEPS,
+                               GetSaveExtension());
       SaveGrid(filename);
     }
 
+    /**
+     * Autosave from a GridSnapshot::Capture of the paused grid: as a
+     * full .mfb snapshot or, under --deltasaves between keyframes, as
+     * a .mfd delta against the previous autosave's capture.  Under
+     * --asyncsaves, m_snapshotWriter makes any delta and writes the
+     * file while the grid runs on; any earlier autosave still being
+     * written finishes first, and that wait counts against the pause.
+     */
+    void AutosaveGridCaptured(u32 epochs)
+    {
+      const u64 startMS = GetTicksSinceEpoch();
+      m_snapshotWriter.Finish();
+      free(m_retiredCapture);  // No background diff reads it now
+      m_retiredCapture = 0;
+      const u64 waitedMS = GetTicksSinceEpoch();
+
+      GridSnapshot<GC> snapshot(m_externalConfig, m_externalConfigSectionGrid);
+      u64 length;
+      u8 * bytes = snapshot.Capture(length);
+      if (!bytes)
+      {
+        LOG.Error("Autosave at epoch %d failed", epochs);
+        return;
+      }
+
+      const bool keyframe = !m_lastCapture ||
+        m_deltasSinceKeyframe + 1 >= m_keyframePerAutosaves;
+      OString32 name;
+      name.Printf("%D-%D.%s", epochs, (u32) m_AEPS, keyframe ? "mfb" : "mfd");
+      const char* filename = GetSimDirPathTemporary("autosave/%s", name.GetZString());
+
+      // Under --asyncsaves a delta is diffed on the writer's thread,
+      // after the grid is running again
+      const bool diffLater = !keyframe && m_asyncSaves;
+      u8 * out = bytes;
+      u64 outLength = length;
+      if (!keyframe && !diffLater)
+      {
+        out = GridSnapshot<GC>::Diff(m_lastCapture, bytes, m_lastCaptureName.GetZString(), outLength);
+      }
+      else if (keyframe && m_keyframePerAutosaves > 0 && m_asyncSaves)
+      {
+        out = (u8 *) malloc(length);  // The writer frees its copy
+        if (out)
+        {
+          memcpy(out, bytes, length);
+        }
+      }
+      if (!out)
+      {
+        LOG.Error("Autosave at epoch %d failed", epochs);
+        free(bytes);
+        return;
+      }
+
+      OString32 previousName;
+      previousName.Printf("%s", m_lastCaptureName.GetZString());
+      if (m_keyframePerAutosaves > 0)
+      {
+        // Keep this capture to diff the next autosave against, and
+        // the one before until any diff against it is done
+        if (diffLater)
+        {
+          m_retiredCapture = m_lastCapture;
+        }
+        else
+        {
+          free(m_lastCapture);
+        }
+        m_lastCapture = bytes;
+        m_lastCaptureName.Reset();
+        m_lastCaptureName.Printf("%s", name.GetZString());
+        m_deltasSinceKeyframe = keyframe ? 0 : m_deltasSinceKeyframe + 1;
+      }
+      const u64 endMS = GetTicksSinceEpoch();
+
+      if (diffLater)
+      {
+        LOG.Message("Autosaving delta to: %s (diffing in background; paused %d ms: %d waiting, %d copying)",
+                    filename, (u32) (endMS - startMS),
+                    (u32) (waitedMS - startMS), (u32) (endMS - waitedMS));
+        m_snapshotWriter.WriteDiff(&GridSnapshot<GC>::Diff, m_retiredCapture, m_lastCapture,
+                                   previousName.GetZString(), filename);
+        return;
+      }
+
+      LOG.Message("Autosaving %s to: %s (%d KB; paused %d ms: %d waiting, %d copying)",
+                  keyframe ? "keyframe" : "delta", filename, (u32) (outLength / 1024),
+                  (u32) (endMS - startMS),
+                  (u32) (waitedMS - startMS), (u32) (endMS - waitedMS));
+      if (m_asyncSaves)
+      {
+        m_snapshotWriter.Write(out, outLength, filename);
+      }
+      else
+      {
+        GridSnapshot<GC>::WriteFile(out, outLength, filename);
+        if (out != m_lastCapture)
+        {
+          free(out);
+        }
+      }
+    }
+
     ExternalConfig<GC> & GetExternalConfig()
     {
       return m_externalConfig;
     }
 
+    /**
+     * The file extension of autosaves and final saves: "mfb" for
+     * binary snapshots under --binarysaves, else "mfs"
+     */
+    const char * GetSaveExtension() const
+    {
+      return m_binarySaves ? "mfb" : "mfs";
+    }
+
+    /**
+     * Save the configuration to filename, as a binary GridSnapshot if
+     * filename ends in ".mfb", or as .mfs text otherwise.
+     */
     void SaveGrid(const char* filename)
     {
+      const u32 len = strlen(filename);
+      if (len > 4 && !strcmp(filename + len - 4, ".mfb"))
+      {
+        GridSnapshot<GC> snapshot(m_externalConfig, m_externalConfigSectionGrid);
+        snapshot.Save(filename);
+        return;
+      }
 
       LOG.Message("Saving to: %s", filename);
       FILE* fp = fopen(filename, "w");
@@ -1212,6 +1767,12 @@ namespace MFM
       }
       /* else buf filled with resource path */
 
+      if (GridSnapshot<GC>::IsSnapshotFile(buf.GetZString()))
+      {
+        GridSnapshot<GC> snapshot(m_externalConfig, m_externalConfigSectionGrid);
+        return snapshot.Load(buf.GetZString());
+      }
+
       LOG.Message("Loading configuration '%s'", buf.GetZString());
 
       FileByteSource fs(buf.GetZString());
@@ -1237,7 +1798,8 @@ namespace MFM
      */
     virtual void DoEpochEvents(OurGrid& grid, u32 epochs, u32 epochAEPS)
     {
-      LOG.Debug("Epoch %d: %d AEPS", epochs, epochAEPS);
+      LOG.Debug("Epoch %d: %d AEPS, %d useful events/sec",
+                epochs, epochAEPS, (u32) m_recentUsefulEventsPerSecond);
 
       WriteTimeBasedData();
 
@@ -1264,6 +1826,15 @@ namespace MFM
         this->AutosaveGrid(epochs);
       }
 
+      if (m_auditCountsPerEpochs > 0 && (epochs % m_auditCountsPerEpochs) == 0)
+      {
+        u32 wrong = grid.AuditAtomCounts();
+        if (wrong > 0)
+        {
+          LOG.Warning("Epoch %d: Atom counts were wrong in %d tiles", epochs, wrong);
+        }
+      }
+
       if (m_accelerateAfterEpochs > 0 && (epochs % m_accelerateAfterEpochs) == 0)
       {
         this->SetAEPSPerEpoch(MAX(1u, this->GetAEPSPerEpoch() + m_acceleration));
@@ -1302,18 +1873,30 @@ namespace MFM
       , m_aepsPerFrame(INITIAL_AEPS_PER_FRAME)
       , m_AEPSPerEpoch(100)
       , m_autosavePerEpochs(10)
+      , m_auditCountsPerEpochs(0)
       , m_accelerateAfterEpochs(0)
       , m_acceleration(1)
       , m_surgeAfterEpochs(0)
       , m_maxEpochLength(0)
       , m_gridImages(false)
       , m_tileImages(false)
+      , m_binarySaves(false)
+      , m_asyncSaves(false)
+      , m_keyframePerAutosaves(0)
+      , m_deltasSinceKeyframe(0)
+      , m_lastCapture(0)
+      , m_retiredCapture(0)
+      , m_convertPath(0)
       , m_AEPS(0.0)
       , m_AER(0.0)
       , m_recentAER(0)
       , m_lastTotalEvents(0)
+      , m_lastUsefulEvents(0)
+      , m_recentUsefulEventsPerSecond(0)
       , m_nextEpochAEPS(0)
       , m_epochCount(0)
+      , m_sweepPath(0)
+      , m_sweepJobs(0)
       , m_configurationPathCount(0)
       , m_currentConfigurationPath(U32_MAX)
       , m_simDirBasePathLength(0)
@@ -1324,7 +1907,12 @@ namespace MFM
       InitTicks(0); // Overwritten later on -cp load
     }
 
-    virtual ~AbstractDriver() {} //avoid inline error
+    virtual ~AbstractDriver()
+    {
+      m_snapshotWriter.Finish();  // It may be diffing against the captures
+      free(m_lastCapture);
+      free(m_retiredCapture);
+    }
 
     virtual void RegisterExternalConfigSections()
     {
@@ -1420,6 +2008,9 @@ namespace MFM
       RegisterArgument("Amount of logging output is ARG (0 -> none, 8 -> max)",
                        "-l|--log", &SetLoggingLevel, NULL, true);
 
+      RegisterArgument("Log from a background thread, so logging tiles don't wait on each other",
+                       "--asynclog", &SetAsyncLogging, this, false);
+
       RegisterArgument("Print the brief version number, then exit.",
                        "-v|--version", &PrintVersion, NULL, false);
 
@@ -1435,6 +2026,9 @@ namespace MFM
       RegisterArgument("Autosave grid every ARG epochs (default 10; 0 for never)",
                        "-a|--autosave", &SetAutosavePerEpochsFromArgs, this, true);
 
+      RegisterArgument("Every ARG epochs, check the incrementally kept atom counts against a recount (default 0 for never)",
+                       "--auditcounts", &SetAuditCountsPerEpochsFromArgs, this, true);
+
       RegisterArgument("Increase the epoch length every ARG epochs",
                              "--accelerate",
                              &SetPicturesPerRateFromArgs, this, true);
@@ -1453,6 +2047,18 @@ namespace MFM
       RegisterArgument("Each epoch, write tile AEPS image to per-sim teps/ directory",
                        "--tileImages", &SetTileImages, this, false);
 
+      RegisterArgument("Autosave and final save as binary .mfb snapshots, not .mfs text",
+                       "--binarysaves", &SetBinarySaves, this, false);
+
+      RegisterArgument("Autosave as .mfb snapshots written in the background, pausing only to copy the grid",
+                       "--asyncsaves", &SetAsyncSaves, this, false);
+
+      RegisterArgument("Autosave just the sites changed since the last autosave, as .mfd deltas, with a full .mfb keyframe every ARG autosaves",
+                       "--deltasaves", &SetDeltaSavesFromArgs, this, true);
+
+      RegisterArgument("Save the loaded configuration to ARG (.mfb: snapshot; else .mfs) and exit",
+                       "--convertto", &SetConvertToFromArgs, this, true);
+
       RegisterArgument("Place one atom of element ARG in the grid.",
                        "--edenseed", &SetEdenSeedFromArgs, this, true);
 
@@ -1489,6 +2095,36 @@ namespace MFM
       RegisterArgument("Set warp factor 0..10 (0: flattest space; 10: highest AER)",
                        "-wf|--warpfactor", &SetWarpFactorFromArgs, this, true);
 
+      RegisterArgument("Advance tiles with a pool of ARG worker threads (0: one per core)",
+                       "-wt|--workerthreads", &SetWorkerThreadsFromArgs, this, true);
+
+      RegisterArgument("Run ARG event windows at once in each tile, on ARG threads per tile",
+                       "-cw|--concurrentwindows", &SetConcurrentWindowsFromArgs, this, true);
+
+      RegisterArgument("Run reproducibly, in rounds of ARG events per tile",
+                       "-dr|--deterministic", &SetDeterministicFromArgs, this, true);
+
+      RegisterArgument("Pin tile threads to CPUs: ARG is none, compact, or spread",
+                       "-ta|--affinity", &SetThreadAffinityFromArgs, this, true);
+
+      RegisterArgument("Pick event centers mostly from non-empty sites, but ARG percent uniformly",
+                       "-as|--activesites", &SetActiveSitesFromArgs, this, true);
+
+      RegisterArgument("Exchange intertile cache updates in-process, without packet encoding",
+                       "-sc|--sharedcaches", &SetSharedCachesFromArgs, this, false);
+
+      RegisterArgument("Run all tiles on one thread, with no cache protocol",
+                       "-sq|--sequential", &SetSequentialFromArgs, this, false);
+
+      RegisterArgument("Run each line of file ARG as a separate run, collecting results in sweep.csv",
+                       "--sweep", &SetSweepFromArgs, this, true);
+
+      RegisterArgument("Run up to ARG sweep runs at once (0: one per core)",
+                       "--sweepjobs", &SetSweepJobsFromArgs, this, true);
+
+      RegisterArgument("Send intertile cache updates as full atoms, never as deltas",
+                       "--no-cache-deltas", &SetNoCacheDeltasFromArgs, this, false);
+
       RegisterArgument("Add a key=value pair to simulation parameters (string)",
                        "-kv|--keyvalue", &RegisterKeyValue, this, true);
 
@@ -1553,6 +2189,11 @@ namespace MFM
       return m_recentAER;
     }
 
+    double GetRecentUsefulEventsPerSecond()
+    {
+      return m_recentUsefulEventsPerSecond;
+    }
+
     void SetRecentAER(double aer)
     {
       m_recentAER = aer;
@@ -1629,13 +2270,38 @@ namespace MFM
         abort();
        },
        {
-         RunHelper();
+         if (m_convertPath)
+         {
+           SaveGrid(m_convertPath);
+         }
+         else if (m_sweepPath)
+         {
+           RunSweep();
+         }
+         else
+         {
+           RunHelper();
+         }
+         m_snapshotWriter.Finish();
+         LogVTableCacheCounts();
          LOG.Message("Simulation driver exiting");
        });
     }
 
   protected:
 
+    void LogVTableCacheCounts()
+    {
+      u64 hits, misses;
+      m_grid.GetVTableCacheCounts(hits, misses);
+      const u64 calls = hits + misses;
+      if (calls > 0)
+      {
+        LOG.Message("Ulam virtual call cache: %d%% hits of %dK lookups",
+                    (u32) (100 * hits / calls), (u32) (calls / 1000));
+      }
+    }
+
     OurElementRegistry m_elementRegistry;
 
     Element<EC>* m_neededElements[MAX_NEEDED_ELEMENTS];
@@ -1669,6 +2335,7 @@ namespace MFM
 
     s32 m_AEPSPerEpoch;
     u32 m_autosavePerEpochs;
+    u32 m_auditCountsPerEpochs;
     u32 m_accelerateAfterEpochs;
     u32 m_acceleration;
     u32 m_surgeAfterEpochs;
@@ -1676,6 +2343,34 @@ namespace MFM
 
     bool m_gridImages;
     bool m_tileImages;
+    bool m_binarySaves;
+    bool m_asyncSaves;
+
+    /**
+     * Writes --asyncsaves autosaves while the grid runs on
+     */
+    SnapshotWriter m_snapshotWriter;
+
+    /**
+     * Under --deltasaves, a full keyframe every this many autosaves,
+     * the autosaves since the last one, and the capture and file name
+     * of the last autosave, which the next delta is against
+     */
+    u32 m_keyframePerAutosaves;
+    u32 m_deltasSinceKeyframe;
+    u8 * m_lastCapture;
+    OString32 m_lastCaptureName;
+
+    /**
+     * The capture before m_lastCapture, kept while m_snapshotWriter
+     * may still be diffing against it
+     */
+    u8 * m_retiredCapture;
+
+    /**
+     * If non-null, just save the loaded configuration here and exit
+     */
+    const char * m_convertPath;
 
     double m_AEPS;
 
@@ -1695,9 +2390,27 @@ namespace MFM
      */
     u64 m_lastTotalEvents;
 
+    /**
+     * The previous value of Grid::GetTotalUsefulEvents, for computing
+     * m_recentUsefulEventsPerSecond
+     */
+    u64 m_lastUsefulEvents;
+
+    /**
+     * The recent rate of events on non-empty sites, per second of
+     * running, computed by backwards averaging
+     */
+    double m_recentUsefulEventsPerSecond;
+
     u32 m_nextEpochAEPS;
     u32 m_epochCount;
 
+    /**
+     * The --sweep file, if any, and how many of its runs to do at once
+     */
+    const char * m_sweepPath;
+    u32 m_sweepJobs;
+
     VArguments m_varguments;
     OString1024 m_commandLineArguments;
 
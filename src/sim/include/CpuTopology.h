@@ -0,0 +1,155 @@
+/*                                              -*- mode:C++ -*-
+  CpuTopology.h Map threads onto the machine's cores, caches and NUMA nodes
+  Copyright (C) 2015 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file CpuTopology.h Map threads onto the machine's cores, caches and NUMA nodes
+  \author David H. Ackley.
+  \date (C) 2015 All rights reserved.
+  \lgpl
+ */
+#ifndef CPUTOPOLOGY_H
+#define CPUTOPOLOGY_H
+
+#include <pthread.h>
+#include "itype.h"
+
+namespace MFM
+{
+  /**
+     How Grid threads are pinned to CPUs.
+   */
+  enum ThreadAffinity
+  {
+    AFFINITY_NONE,     // Let the kernel place (and migrate) threads
+    AFFINITY_COMPACT,  // Pack threads onto as few cores and nodes as possible
+    AFFINITY_SPREAD,   // Spread threads over all nodes, one per core before SMT
+    AFFINITY_COUNT
+  };
+
+  /**
+     The CPUs this process may run on, with the NUMA node, package
+     (socket) and core each belongs to, as read from /sys.  Once
+     Arranged for a ThreadAffinity, it maps the k'th of a sequence
+     of threads to a CPU, such that consecutive threads -- which the
+     Grid makes neighboring tiles -- share a node, and under
+     AFFINITY_COMPACT, share cores and caches as well.
+   */
+  class CpuTopology
+  {
+  public:
+    enum { MAX_CPUS = 512, MAX_NODES = 64 };
+
+    struct Cpu
+    {
+      u32 m_cpu;       // As numbered by the kernel
+      u32 m_node;      // NUMA node, as numbered by the kernel
+      u32 m_package;   // physical_package_id
+      u32 m_core;      // core_id, unique within the package
+      u32 m_smtRank;   // 0 for the first hardware thread of a core, etc
+      u32 m_coreRank;  // Ordinal of this core within its package
+      u32 m_nodeRank;  // Ordinal of this node among our nodes
+    };
+
+  private:
+    Cpu m_cpus[MAX_CPUS];
+    u32 m_cpuCount;
+
+    ThreadAffinity m_arrangedFor;
+    u32 m_nodeCount;
+    u32 m_nodeStart[MAX_NODES];  // First index in m_cpus of each node rank
+    u32 m_nodeSize[MAX_NODES];   // Number of CPUs in each node rank
+
+    static bool CompactBefore(const Cpu & a, const Cpu & b) ;
+    static bool SpreadBefore(const Cpu & a, const Cpu & b) ;
+    void ComputeRanks() ;
+
+  public:
+
+    CpuTopology()
+      : m_cpuCount(0)
+      , m_arrangedFor(AFFINITY_NONE)
+      , m_nodeCount(0)
+    { }
+
+    static const char * GetAffinityName(ThreadAffinity affinity) ;
+
+    /**
+       Set out to the ThreadAffinity named name ("none", "compact" or
+       "spread").  Returns false, leaving out untouched, if there is
+       no such ThreadAffinity.
+     */
+    static bool ParseAffinity(const char * name, ThreadAffinity & out) ;
+
+    /**
+       Replace any content with the CPUs this process is allowed to
+       run on.  Topology information missing from /sys is defaulted,
+       so this always finds at least one CPU.
+     */
+    void ReadFromSystem() ;
+
+    /**
+       Add a CPU with the given location to the topology.  Mostly for
+       testing.
+     */
+    void AddCpu(u32 cpu, u32 node, u32 package, u32 core) ;
+
+    u32 GetCpuCount() const
+    {
+      return m_cpuCount;
+    }
+
+    /**
+       Get the number of distinct nodes among our CPUs.  Valid after
+       Arrange.
+     */
+    u32 GetNodeCount() const
+    {
+      return m_nodeCount;
+    }
+
+    /**
+       Sort the CPUs into the order affinity places threads in.
+       affinity must not be AFFINITY_NONE.
+     */
+    void Arrange(ThreadAffinity affinity) ;
+
+    /**
+       Get the CPU that thread k of count threads should be pinned to,
+       under the ThreadAffinity last passed to Arrange.
+     */
+    const Cpu & GetCpuForThread(u32 k, u32 count) const ;
+
+    /**
+       Restrict thread to run only on cpu.  Returns false if that
+       failed.
+     */
+    static bool Pin(pthread_t thread, const Cpu & cpu) ;
+
+    /**
+       Move the memory pages lying entirely within length bytes at
+       start to NUMA node, which is where they would have been put if
+       first touched by a thread running there.  Returns false if
+       that failed or is unsupported.
+     */
+    static bool MoveToNode(void * start, u32 length, u32 node) ;
+  };
+} /* namespace MFM */
+
+#endif /*CPUTOPOLOGY_H*/
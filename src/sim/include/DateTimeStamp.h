@@ -31,26 +31,30 @@
 #include "ByteSerializable.h"
 #include "itype.h"
 #include "Utils.h"
+#include "Logger.h"
 
 namespace MFM
 {
+  /**
+     A time stamper for LOG, printing the date and time each record
+     was logged and its sequence number.
+   */
   class DateTimeStamp : public ByteSerializable {
     u64 m_lastDateTime;
-    u32 m_sequence;
   public:
-    DateTimeStamp() : m_lastDateTime(0), m_sequence(0) { }
+    DateTimeStamp() : m_lastDateTime(0) { }
     void Reset() { m_lastDateTime = 0; }
     virtual Result PrintTo(ByteSink & byteSink, s32 argument = 0)
     {
-      m_lastDateTime = Utils::GetDateTimeNow();
+      const Logger::StampCapture & stamp = LOG.GetStampCapture();
+      m_lastDateTime = Utils::GetDateTime(stamp.m_time.tv_sec);
       byteSink.Print(m_lastDateTime);
       if (argument == 0)
       {
         byteSink.Print("-");
-        byteSink.Print(m_sequence, Format::LEX32);
+        byteSink.Print((u32) stamp.m_sequence, Format::LEX32);
         byteSink.Print(": ");
       }
-      ++m_sequence;
       return SUCCESS;
     }
 
@@ -171,6 +171,22 @@ namespace MFM
       return m_grid;
     }
 
+    /**
+     * Set whether the sites travel in the section text: whether
+     * WriteSection includes the Site(..) of every site, and
+     * ReadFinalize refreshes the grid's caches.  Binary snapshots
+     * save the rest of the section as text, and the sites separately.
+     */
+    void SetSitesInText(bool value)
+    {
+      m_sitesInText = value;
+    }
+
+    bool IsSitesInText() const
+    {
+      return m_sitesInText;
+    }
+
   private:
 
     /**
@@ -180,6 +196,7 @@ namespace MFM
 
     static const u32 MAX_REGISTERED_ELEMENTS = 100;
     ByteSink * m_errorsTo;
+    bool m_sitesInText;
 
     struct RegElt {
       UUID m_uuid;
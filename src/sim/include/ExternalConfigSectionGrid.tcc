@@ -272,6 +272,7 @@ namespace MFM
     : ExternalConfigSection<GC>(ec)
     , m_grid(grid)
     , m_errorsTo(0)
+    , m_sitesInText(true)
     , m_registeredElementCount(0)
     , m_elementRegistry(grid.GetElementRegistry())
     , m_fcDefineGridSize(*this)
@@ -298,6 +299,10 @@ namespace MFM
   template<class GC>
   bool ExternalConfigSectionGrid<GC>::ReadFinalize()
   {
+    if (!m_sitesInText)
+    {
+      return true;  // Whoever loads the sites finishes up
+    }
     m_grid.RefreshAllCaches();
     m_grid.RecountAtoms();
     return true;
@@ -366,7 +371,7 @@ namespace MFM
     const u32 gridHeight = m_grid.GetHeightSites();
     const bool isStaggeredGrid = m_grid.IsGridLayoutStaggered();
 
-    for(u32 y = 0; y < gridHeight; y++)
+    for(u32 y = 0; m_sitesInText && y < gridHeight; y++)
       {
 	for(u32 x = 0; x < gridWidth; x++)
 	  {
@@ -37,6 +37,7 @@
 #include "Sense.h"
 #include "GridConfig.h"
 #include "GridTransceiver.h"
+#include "CpuTopology.h"
 #include "ElementRegistry.h"
 #include "Logger.h"
 #include "LineCountingByteSource.h"
@@ -65,6 +66,7 @@ namespace MFM {
     enum { OWNED_WIDTH = TILE_WIDTH - 2 * R }; // Duplicating the OWNED_SIDE computation in Tile.tcc!
     enum { OWNED_HEIGHT = TILE_HEIGHT - 2 * R }; // Duplicating the OWNED_SIDE computation in Tile.tcc!
     enum { MAX_LOCKS_OWNED_PER_TILE = 3}; //checkboard: E,SE,S  staggered: NE,E,SE
+    enum { CACHE_BYTES_PER_SECOND = 100000000 }; // Modeled intertile data rate
 
     typedef SizedTile<EC,TILE_WIDTH,TILE_HEIGHT,EVENT_HISTORY_SIZE> GridTile;
 
@@ -113,11 +115,34 @@ namespace MFM {
       SPoint m_loc;
       Grid* m_gridPtr;
       pthread_t m_threadId;
+      u32 m_ackedGeneration;  // Last control generation this tile acknowledged
+      s32 m_cpu;              // CPU this tile's thread is pinned to, or -1
       GridTransceiver m_channels[4]; // 4: NE, E, SE, S == dir-Dirs::NORTHEAST
+      SharedCacheChannel<EC> m_sharedChannels[4]; // Used instead if m_sharedCacheChannels
+
+      /**
+       * Lets a per-tile thread sleep while PAUSED until SetState
+       * wakes it, instead of polling.
+       */
+      struct UnpausedPredicate : public Mutex::Predicate
+      {
+        TileDriver & m_td;
+        UnpausedPredicate(TileDriver & td)
+          : Mutex::Predicate(td.m_stateLock)
+          , m_td(td)
+        { }
+        virtual bool EvaluatePrecondition() { return true; }
+        virtual bool EvaluatePredicate() { return m_td.m_state != PAUSED; }
+      };
+      UnpausedPredicate m_unpaused;
+
       TileDriver()
         : m_state(PAUSED)
         , m_loc(-1,-1)
         , m_gridPtr(0)
+        , m_ackedGeneration(0)
+        , m_cpu(-1)
+        , m_unpaused(*this)
       { }
 
       ~TileDriver() {} //avoid inline error
@@ -132,6 +157,17 @@ namespace MFM {
       {
         Mutex::ScopeLock lock(m_stateLock);
         m_state = newState;
+        m_unpaused.SignalCondition();
+      }
+
+      /**
+       * Block while this driver is PAUSED, returning the new state
+       */
+      State WaitWhilePaused()
+      {
+        Mutex::ScopeLock lock(m_stateLock);
+        m_unpaused.WaitForCondition();
+        return m_state;
       }
 
       Tile<EC> & GetTile()
@@ -149,13 +185,352 @@ namespace MFM {
     bool m_threadsInitted;
     static void * TileDriverRunner(void *) ;
 
+    /**
+     * One thread of the optional worker pool.  Each TileWorker owns a
+     * deque of TileDriver indices, advances the tile at the front and
+     * returns it to the back, so it round-robins over its own tiles.
+     * Workers that find themselves short of tiles steal from the
+     * front of the most heavily loaded peer.
+     */
+    struct TileWorker {
+      Mutex m_dequeLock;
+      u32 * m_deque;     // Ring buffer of TileDriver indices
+      u32 m_capacity;
+      u32 m_head;
+      u32 m_count;
+
+      u32 m_index;
+      Grid* m_gridPtr;
+      pthread_t m_threadId;
+      Random m_random;     // For backoff jitter
+
+      /**
+       * Lets an idle worker back off until either its timeout expires
+       * or the grid changes state under it.
+       */
+      struct WakePredicate : public Mutex::Predicate
+      {
+        bool m_wakeRequested;
+        WakePredicate(Mutex & lock)
+          : Mutex::Predicate(lock)
+          , m_wakeRequested(false)
+        { }
+        virtual bool EvaluatePrecondition() { return true; }
+        virtual bool EvaluatePredicate() { return m_wakeRequested; }
+      };
+      Mutex m_wakeLock;
+      WakePredicate m_wake;
+
+      /*
+        The statistics are written only by the worker itself, with
+        Count, and may be read by any thread, with Read.
+       */
+      u64 m_busyAdvances;  // Tile::Advance calls that accomplished something
+      u64 m_idleAdvances;  // Tile::Advance calls that did nothing
+      u64 m_pausedVisits;  // Tiles taken while not advancing
+      u64 m_steals;        // Tiles taken from another worker
+      u64 m_busyNanos;     // Time spent inside productive Advance calls
+      u64 m_sleepNanos;    // Time spent backing off with nothing to do
+      timespec m_started;
+
+      static void Count(u64 & stat, u64 amount)
+      {
+        __atomic_store_n(&stat, stat + amount, __ATOMIC_RELAXED);
+      }
+
+      static u64 Read(const u64 & stat)
+      {
+        return __atomic_load_n(&stat, __ATOMIC_RELAXED);
+      }
+
+      TileWorker()
+        : m_deque(0)
+        , m_capacity(0)
+        , m_head(0)
+        , m_count(0)
+        , m_index(0)
+        , m_gridPtr(0)
+        , m_wake(m_wakeLock)
+        , m_busyAdvances(0)
+        , m_idleAdvances(0)
+        , m_pausedVisits(0)
+        , m_steals(0)
+        , m_busyNanos(0)
+        , m_sleepNanos(0)
+      { }
+
+      ~TileWorker()
+      {
+        delete [] m_deque;
+      }
+
+      void Init(Grid & grid, u32 index, u32 capacity)
+      {
+        MFM_API_ASSERT_STATE(!m_deque);
+        m_gridPtr = &grid;
+        m_index = index;
+        m_capacity = capacity;
+        m_deque = new u32[m_capacity];
+      }
+
+      u32 GetCount()
+      {
+        Mutex::ScopeLock lock(m_dequeLock);
+        return m_count;
+      }
+
+      bool PopFront(u32 & idx)
+      {
+        Mutex::ScopeLock lock(m_dequeLock);
+        if (m_count == 0) return false;
+        idx = m_deque[m_head];
+        m_head = (m_head + 1) % m_capacity;
+        --m_count;
+        return true;
+      }
+
+      void PushBack(u32 idx)
+      {
+        Mutex::ScopeLock lock(m_dequeLock);
+        MFM_API_ASSERT_STATE(m_count < m_capacity);
+        m_deque[(m_head + m_count) % m_capacity] = idx;
+        ++m_count;
+      }
+
+      /**
+         Steal the front tile of this deque, but only if doing so
+         leaves it with at least as many tiles as the thief, who
+         currently has \c thiefCount.
+       */
+      bool StealFront(u32 & idx, u32 thiefCount)
+      {
+        Mutex::ScopeLock lock(m_dequeLock);
+        if (m_count < thiefCount + 2) return false;
+        idx = m_deque[m_head];
+        m_head = (m_head + 1) % m_capacity;
+        --m_count;
+        return true;
+      }
+
+      /**
+         Sleep for up to \c usec, or until Wake() is called
+       */
+      void Nap(u32 usec)
+      {
+        Mutex::ScopeLock lock(m_wakeLock);
+        m_wake.WaitForConditionFor(usec);
+        m_wake.m_wakeRequested = false;
+      }
+
+      void Wake()
+      {
+        Mutex::ScopeLock lock(m_wakeLock);
+        m_wake.m_wakeRequested = true;
+        m_wake.SignalCondition();
+      }
+
+      /**
+         Percent of wall-clock time since the worker started that it
+         spent in productive Tile::Advance calls.
+       */
+      double GetUtilization() const
+      {
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        u64 elapsed = ElapsedNanos(m_started, now);
+        if (elapsed == 0) return 0;
+        return 100.0 * Read(m_busyNanos) / elapsed;
+      }
+    };
+
+    static u64 ElapsedNanos(const timespec & from, const timespec & to)
+    {
+      const u64 BILLION = 1000000000;
+      return ((u64) to.tv_sec * BILLION + to.tv_nsec) - ((u64) from.tv_sec * BILLION + from.tv_nsec);
+    }
+
+    u32 m_workerThreads;       // 0 -> one thread per tile
+    TileWorker * m_tileWorkers;
+    volatile u32 m_workerLiveTiles; // Tiles not yet retired by EXIT_REQUEST
+
+    static void * TileWorkerRunner(void *) ;
+    bool StealTileFor(TileWorker & thief, u32 & idx) ;
+    void InitWorkerThreads() ;
+
     bool m_backgroundRadiationEnabled; // shadows value pushed to tiles
     bool m_foregroundRadiationEnabled; // shadows value pushed to tiles
 
+    bool m_sharedCacheChannels; // Connect tiles in-process, not via GridTransceivers
+
+    bool m_sequential;          // Run every tile on the calling thread
+
+    /**
+       Events each tile attempts per turn in sequential mode.  Big
+       enough to keep a tile's sites in cache for a while, small
+       enough that no tile runs far ahead of the others.
+     */
+    enum { SEQUENTIAL_BATCH_EVENTS = 32 };
+
+    /**
+       Give each non-dummy tile one turn of up to batch event
+       attempts, in shuffled order, and return the events executed.
+     */
+    u64 RunSequentialPass(u32 batch) ;
+
+    ThreadAffinity m_threadAffinity;
+
+    u32 m_concurrentWindows; // Event windows run at once in each tile
+
+    /**
+       Deterministic mode state.  Each round runs DETERMINISTIC_COLORS
+       phases; in phase c, just the tiles of color c attempt events,
+       so no two neighboring tiles are ever active at once, and every
+       intertile lock an active tile wants is free once its own
+       CacheProcessors are idle.
+     */
+    enum { DETERMINISTIC_COLORS = 4 };
+    u32 m_deterministicEvents;    // Per tile per round; 0 if not deterministic
+    volatile u64 m_roundsCompleted;
+    PhaseBarrier m_phaseBarrier;  // Tiles yet to finish the current phase
+
+    Mutex m_roundLock;
+    u64 m_roundLimit;             // Run rounds until this many are done
+    bool m_roundsHeld;            // True while the grid is paused
+    bool m_roundInProgress;
+    bool m_roundExitRequested;
+    pthread_t m_roundThreadId;
+    bool m_roundThreadStarted;
+
+    struct RoundWanted : public Mutex::Predicate
+    {
+      Grid & m_grid;
+      RoundWanted(Grid & grid)
+        : Mutex::Predicate(grid.m_roundLock)
+        , m_grid(grid)
+      { }
+      virtual bool EvaluatePrecondition() { return true; }
+      virtual bool EvaluatePredicate()
+      {
+        return m_grid.m_roundExitRequested ||
+          (!m_grid.m_roundsHeld && m_grid.m_roundsCompleted < m_grid.m_roundLimit);
+      }
+    };
+    RoundWanted m_roundWanted;
+
+    struct RoundsIdle : public Mutex::Predicate
+    {
+      Grid & m_grid;
+      u64 m_awaited;  // Also wait for this many rounds to be done
+      RoundsIdle(Grid & grid)
+        : Mutex::Predicate(grid.m_roundLock)
+        , m_grid(grid)
+        , m_awaited(0)
+      { }
+      virtual bool EvaluatePrecondition() { return true; }
+      virtual bool EvaluatePredicate()
+      {
+        return !m_grid.m_roundInProgress && m_grid.m_roundsCompleted >= m_awaited;
+      }
+    };
+    RoundsIdle m_roundsIdle;
+
+    static void * RoundRunner(void * arg) ;
+
+    /**
+       Run one deterministic round, phase by phase.
+     */
+    void RunDeterministicRound() ;
+
+    /**
+       Derive the PRNG seed for the tile at (x,y) in the given phase
+       of the given round from the grid seed alone.
+     */
+    u32 GetDeterministicSeed(u64 round, u32 color, u32 x, u32 y) const ;
+
+    /**
+       Stop starting deterministic rounds, and wait for any in progress
+       to finish.
+     */
+    void HoldDeterministicRounds() ;
+
+    void ReleaseDeterministicRounds() ;
+
+    /**
+       Pin the tile threads (or pool workers) according to
+       m_threadAffinity, walking the tiles so that consecutive
+       threads are neighboring tiles, and move each tile to the
+       memory of its thread's node.
+     */
+    void ApplyThreadAffinity() ;
+
+    /**
+       Return true if (x,y) is a real tile, with a thread to drive it.
+     */
+    bool IsDrivenTile(u32 x, u32 y)
+    {
+      const SPoint pt(x, y);
+      return IsLegalTileIndex(pt) && !GetTile(pt).IsDummyTile();
+    }
+    bool m_tilesConnected;
+
     ElementRegistry<EC> m_er;
 
     s32 m_xraySiteOdds;
 
+    /**
+     * A log2-bucketed histogram of control latencies, in microseconds
+     */
+    struct LatencyHistogram
+    {
+      enum { BUCKETS = 24 };  // Bucket i holds latencies < 2^i usec; last is open
+      u32 m_buckets[BUCKETS];
+      u32 m_count;
+      u64 m_totalUsec;
+      u32 m_maxUsec;
+
+      LatencyHistogram()
+      {
+        Reset();
+      }
+
+      void Reset()
+      {
+        for (u32 i = 0; i < BUCKETS; ++i) m_buckets[i] = 0;
+        m_count = 0;
+        m_totalUsec = 0;
+        m_maxUsec = 0;
+      }
+
+      void Record(u32 usec)
+      {
+        u32 bucket = 0;
+        while (bucket < BUCKETS - 1 && usec >= (1u << bucket)) ++bucket;
+        ++m_buckets[bucket];
+        ++m_count;
+        m_totalUsec += usec;
+        if (usec > m_maxUsec) m_maxUsec = usec;
+      }
+
+      void Report(Logger::Level level, const char * label) const
+      {
+        if (m_count == 0)
+        {
+          LOG.Log(level," %s latency: no samples", label);
+          return;
+        }
+        LOG.Log(level," %s latency: %d samples, mean %d usec, max %d usec",
+                label, m_count, (u32) (m_totalUsec / m_count), m_maxUsec);
+        for (u32 i = 0; i < BUCKETS; ++i)
+        {
+          if (m_buckets[i] == 0) continue;
+          LOG.Log(level,"  < %8d usec: %d", 1u << i, m_buckets[i]);
+        }
+      }
+    };
+
+    LatencyHistogram m_pauseLatency;
+    LatencyHistogram m_unpauseLatency;
+
     /**
      * A synchronized command sequence to the grid
      */
@@ -177,8 +552,48 @@ namespace MFM {
          Called once per op at the end
        */
       virtual void PostGridControl(Grid&) = 0;
+
+      /**
+         Where to record how long tiles took to become ready
+       */
+      virtual LatencyHistogram & GetLatencyHistogram(Grid&) = 0;
+    };
+
+    /**
+     * Generation-counted barrier for TileDriverControl.  Each control
+     * bumps m_generation and sets m_pending to the tile count; each
+     * tile's driving thread acknowledges at most once per generation,
+     * when CheckIfReady first holds for it, and the last one wakes
+     * the waiting control thread.
+     */
+    struct ControlBarrier : public Mutex::Predicate
+    {
+      TileDriverControl * m_control;
+      volatile u32 m_generation;
+      u32 m_pending;
+
+      ControlBarrier(Mutex & lock)
+        : Mutex::Predicate(lock)
+        , m_control(0)
+        , m_generation(0)
+        , m_pending(0)
+      { }
+
+      virtual bool EvaluatePrecondition() { return m_control != 0; }
+      virtual bool EvaluatePredicate() { return m_pending == 0; }
     };
 
+    Mutex m_controlLock;
+    ControlBarrier m_controlBarrier;
+
+    /**
+     * Called by a tile's driving thread after advancing it, to
+     * acknowledge any control in progress once the tile is ready.
+     * Also called by the control thread itself for tiles whose
+     * drivers are paused.
+     */
+    void MaybeAcknowledgeControl(TileDriver & td) ;
+
     /**
      * Operations for synchronized grid pausing
      */
@@ -220,6 +635,11 @@ namespace MFM {
         grid.SetGridRunning(false);
       }
 
+      virtual LatencyHistogram & GetLatencyHistogram(Grid& grid)
+      {
+        return grid.m_pauseLatency;
+      }
+
     };
 
     /**
@@ -242,7 +662,6 @@ namespace MFM {
       virtual void MakeRequest(TileDriver & td)
       {
         Tile<EC> & tile = td.GetTile();
-        tile.NeedAtomRecount();
         tile.RequestStateActive();
       }
       virtual bool CheckIfReady(TileDriver & td)
@@ -264,6 +683,11 @@ namespace MFM {
       {
       }
 
+      virtual LatencyHistogram & GetLatencyHistogram(Grid& grid)
+      {
+        return grid.m_unpauseLatency;
+      }
+
     };
 
     /**
@@ -298,6 +722,21 @@ namespace MFM {
       return m_heroTile.GetUlamClassRegistry();
     }
 
+    /**
+       Sum the ulam virtual call cache hits and misses of all the
+       tiles.
+     */
+    void GetVTableCacheCounts(u64 & hits, u64 & misses) const
+    {
+      hits = misses = 0;
+      for (const_iterator_type i = begin(); i != end(); ++i)
+      {
+        const UlamVTableCache<EC> & cache = i->GetUlamClassRegistry().GetVTableCache();
+        hits += cache.GetHits();
+        misses += cache.GetMisses();
+      }
+    }
+
     s32 GetWarpFactor() const
     {
       return m_heroTile.GetWarpFactor();
@@ -313,17 +752,61 @@ namespace MFM {
       m_heroTile.SetWarpFactor(wf);
     }
 
+    bool IsActiveSiteSelection() const
+    {
+      return m_heroTile.IsActiveSiteSelection();
+    }
+
+    u32 GetUniformSelectionPercent() const
+    {
+      return m_heroTile.GetUniformSelectionPercent();
+    }
+
+    /**
+     * Enable or disable active site selection in every tile.  Call
+     * only while the grid is paused.
+     *
+     * \sa Tile::SetActiveSiteSelection
+     */
+    void SetActiveSiteSelection(bool enabled, u32 uniformPercent) ;
+
     double GetAverageCacheRedundancy() const;
     void SetCacheRedundancy(u32 redundancyOddsType) ;
 
+    /**
+     * Offer (or stop offering) delta-encoded cache updates between
+     * all tiles.  Call only while the grid is paused.
+     *
+     * \sa CacheProcessor::SetDeltaEncoding
+     */
+    void SetCacheDeltaEncoding(bool offered) ;
+
+    /**
+     * Get the average bytes shipped per cache update, over all tiles,
+     * for updates sent either as full atoms or as deltas.  Returns 0
+     * if there have been no such updates.
+     */
+    u32 GetCacheBytesPerUpdate(bool asDeltas) const ;
+
     void ReportGridStatus(Logger::Level level) ;
 
     Random& GetRandom() { return m_random; }
 
     friend class GridRenderer;
+    friend class Grid_Test;
 
     void SetSeed(u32 seed);
 
+    /**
+     * Restart the grid's and all tiles' random number generators from
+     * seed, as if it had been the seed when the grid was initialized.
+     */
+    void Reseed(u32 seed)
+    {
+      SetSeed(seed);
+      InitSeed();
+    }
+
     Grid(ElementRegistry<EC>& elts, u32 width, u32 height, GridLayoutPattern layout)
       : m_random()
       , m_seed(0)
@@ -334,10 +817,28 @@ namespace MFM {
       , m_intertileLocks(new LonglivedLock[m_width * m_height * MAX_LOCKS_OWNED_PER_TILE])
       , m_tileDrivers(new TileDriver[m_width * m_height * MAX_LOCKS_OWNED_PER_TILE])
       , m_threadsInitted(false)
+      , m_workerThreads(0)
+      , m_tileWorkers(0)
+      , m_workerLiveTiles(0)
       , m_backgroundRadiationEnabled(false)
       , m_foregroundRadiationEnabled(false)
+      , m_sharedCacheChannels(false)
+      , m_sequential(false)
+      , m_threadAffinity(AFFINITY_NONE)
+      , m_concurrentWindows(1)
+      , m_deterministicEvents(0)
+      , m_roundsCompleted(0)
+      , m_roundLimit(U64_MAX)
+      , m_roundsHeld(true)
+      , m_roundInProgress(false)
+      , m_roundExitRequested(false)
+      , m_roundThreadStarted(false)
+      , m_roundWanted(*this)
+      , m_roundsIdle(*this)
+      , m_tilesConnected(false)
       , m_er(elts)
       , m_xraySiteOdds(100)
+      , m_controlBarrier(m_controlLock)
       , m_rgi(m_width * m_height)
     {
       //dummy tiles not set for iterator use!!! avoid illegal tile coord.
@@ -360,6 +861,186 @@ namespace MFM {
      */
     void InitThreads();
 
+    /**
+       Advance the tiles with a fixed pool of \c threads worker
+       threads, rather than one thread per tile.  A \c threads of 0
+       means one worker per online core.  Must be called before
+       InitThreads().
+     */
+    void SetWorkerThreads(u32 threads) ;
+
+    /**
+       Get the size of the worker pool, or 0 if each tile is driven by
+       its own thread.
+     */
+    u32 GetWorkerThreads() const
+    {
+      return m_workerThreads;
+    }
+
+    /**
+       A consistent-enough copy of one pool worker's statistics.  Each
+       field is read atomically, but the fields are not read at one
+       instant, so they may disagree slightly while the grid runs.
+     */
+    struct WorkerStats
+    {
+      u32 m_tiles;
+      u32 m_utilization;  // Percent of time in productive Advance calls
+      u64 m_busyAdvances;
+      u64 m_idleAdvances;
+      u64 m_pausedVisits;
+      u64 m_steals;
+      u64 m_sleepNanos;
+    };
+
+    /**
+       Copy the statistics of pool worker \c w into \c stats.
+       Returns false, leaving stats alone, if there is no such worker.
+     */
+    bool GetWorkerStats(u32 w, WorkerStats & stats) ;
+
+    /**
+       Have neighboring tiles exchange cache updates by copying them
+       through in-process SharedCacheChannels, rather than encoding
+       them as packets over GridTransceivers.  The channels model the
+       same data rate, charging each update what its full packet
+       encoding would take, so only the encoding time is saved.  Must
+       be called before Init().
+     */
+    void SetSharedCacheChannels(bool shared) ;
+
+    /**
+       Return true if tiles exchange cache updates in-process.
+     */
+    bool IsSharedCacheChannels() const
+    {
+      return m_sharedCacheChannels;
+    }
+
+    /**
+       Pin tile threads (or pool workers, if any) to CPUs by the given
+       policy.  Must be called before InitThreads().
+     */
+    void SetThreadAffinity(ThreadAffinity affinity) ;
+
+    ThreadAffinity GetThreadAffinity() const
+    {
+      return m_threadAffinity;
+    }
+
+    /**
+       Get the CPU the thread driving the tile at (x,y) was pinned to,
+       or -1 if it wasn't.
+     */
+    s32 GetTileCpu(u32 x, u32 y)
+    {
+      return _getTileDriver(x, y).m_cpu;
+    }
+
+    /**
+       Run \c count event windows at once in each tile, on \c count
+       threads per tile.  Must be called before InitThreads().
+
+       \sa Tile::SetConcurrentWindows
+     */
+    void SetConcurrentWindows(u32 count) ;
+
+    u32 GetConcurrentWindows() const
+    {
+      return m_concurrentWindows;
+    }
+
+    /**
+       Get the number of event attempts, over all tiles, abandoned
+       because a concurrent window held some of their sites.
+     */
+    u64 GetTotalSiteClaimConflicts() const ;
+
+    /**
+       Run the grid deterministically, in rounds in which each tile
+       attempts \c eventsPerRound events, from a PRNG stream derived
+       from the grid seed, the tile's position, and the round.  Then
+       the world state after any given number of rounds depends only
+       on the seed and the initial state -- not on the number of
+       threads, or how they happen to interleave.  A grid that is
+       running advances round after round; Pause() waits for the
+       round in progress to finish.  An \c eventsPerRound of 0 means
+       the usual free-running mode.  Must be called before
+       InitThreads(), with a checkerboard layout and a single event
+       window per tile.  Background radiation, if enabled, is not
+       reproducible.
+     */
+    void SetDeterministic(u32 eventsPerRound) ;
+
+    bool IsDeterministic() const
+    {
+      return m_deterministicEvents > 0;
+    }
+
+    u32 GetDeterministicEventsPerRound() const
+    {
+      return m_deterministicEvents;
+    }
+
+    /**
+       Get the number of deterministic rounds completed.
+     */
+    u64 GetRoundsCompleted() const
+    {
+      return m_roundsCompleted;
+    }
+
+    /**
+       Run exactly \c rounds more deterministic rounds and leave the
+       grid paused.  The grid must be deterministic, have its threads
+       initted, and be paused.
+     */
+    void RunRounds(u32 rounds) ;
+
+    /**
+       Run the whole grid on the calling thread, with no tile threads,
+       intertile locks, CacheProcessor traffic, or GridTransceivers:
+       tiles take turns running short batches of events, and each
+       atom an event writes near a tile edge is copied directly into
+       the neighboring tiles' caches.  Since only one tile runs at a
+       time, the caches are always exact, and a given seed and
+       initial state always give the same run.  Instead of running
+       by itself once unpaused, a sequential grid advances only
+       within RunSequentialEvents or RunSequentialFor.  Must be
+       called before Init(), and is incompatible with worker
+       threads, concurrent windows, and deterministic mode.
+     */
+    void SetSequential(bool sequential) ;
+
+    bool IsSequential() const
+    {
+      return m_sequential;
+    }
+
+    /**
+       In sequential mode, have each unpaused tile attempt \c
+       attemptsPerTile events, and return the number executed.
+     */
+    u64 RunSequentialEvents(u32 attemptsPerTile) ;
+
+    /**
+       In sequential mode, run unpaused tiles for about \c usec
+       microseconds, and return the number of events executed.
+     */
+    u64 RunSequentialFor(u32 usec) ;
+
+    /**
+       Log the tile count, steals, and utilization of each pool worker.
+     */
+    void ReportWorkerStatus(Logger::Level level) ;
+
+    /**
+       Log the attempt, failure, and hold time counts of each
+       intertile lock that has seen any use.
+     */
+    void ReportIntertileLockStatus(Logger::Level level) ;
+
     /**
        Enable or disable the tiles and the transceivers.
      */
@@ -406,6 +1087,10 @@ namespace MFM {
     void SetTileParameter(u32 key, s32 value)
     {
       m_heroTile.SetTileParameter(key, value);
+      for (iterator_type i = begin(); i != end(); ++i)
+      {
+        i->SetTileParameter(key, value);  // In case we're already initted
+      }
       LOG.Message("Tile parameter key %d set to value %d", key, value);
     }
 
@@ -495,6 +1180,7 @@ namespace MFM {
       delete [] m_tiles;
       delete [] m_intertileLocks;
       delete [] m_tileDrivers;
+      delete [] m_tileWorkers;
     }
 
     /**
@@ -669,13 +1355,49 @@ namespace MFM {
      */
     void ShutdownTileThreads()
     {
+      if (m_roundThreadStarted)
+      {
+        {
+          Mutex::ScopeLock lock(m_roundLock);
+          m_roundExitRequested = true;
+          m_roundWanted.SignalCondition();
+        }
+        pthread_join(m_roundThreadId, NULL);
+        m_roundThreadStarted = false;
+      }
+
       LOG.Message("Sending exit requests to the tiles");
       for (iterator_type i = begin(); i != end(); ++i)
       {
         TileDriver & td = _getTileDriver(i.GetX(),i.GetY());
         td.SetState(TileDriver::EXIT_REQUEST);
       }
-      SleepMsec(500);
+
+      if (!m_threadsInitted || m_sequential)
+      {
+        return;
+      }
+
+      if (m_tileWorkers)
+      {
+        for (u32 w = 0; w < m_workerThreads; ++w)
+        {
+          m_tileWorkers[w].Wake();
+          pthread_join(m_tileWorkers[w].m_threadId, NULL);
+        }
+        LOG.Message("Joined %d worker threads", m_workerThreads);
+        return;
+      }
+
+      u32 joined = 0;
+      for (iterator_type i = begin(); i != end(); ++i)
+      {
+        TileDriver & td = _getTileDriver(i.GetX(),i.GetY());
+        if (!td.m_gridPtr) continue; // No thread was started for it
+        pthread_join(td.m_threadId, NULL);
+        ++joined;
+      }
+      LOG.Message("Joined %d tile threads", joined);
     }
 
     /**
@@ -683,6 +1405,7 @@ namespace MFM {
      */
     void Pause()
     {
+      HoldDeterministicRounds();
       PauseControl pc;
       DoTileDriverControl(pc);
     }
@@ -694,6 +1417,7 @@ namespace MFM {
     {
       RunControl rc;
       DoTileDriverControl(rc);
+      ReleaseDeterministicRounds();
     }
 
     /**
@@ -702,6 +1426,13 @@ namespace MFM {
      */
     void RecountAtoms();
 
+    /**
+     * Check every tile's incrementally maintained atom counts against
+     * a recount, as Tile::AuditAtomCounts, and return how many tiles
+     * had any wrong.  The grid must be paused.
+     */
+    u32 AuditAtomCounts();
+
     void CheckAtom(const T& atom, const SPoint& location);
 
     void PlaceAtom(const T& atom, const SPoint& location);
@@ -802,6 +1533,21 @@ namespace MFM {
 
     u64 GetTotalEventsExecuted() const;
 
+    /**
+     * Gets the number of executed events, over all tiles, that took
+     * the empty-center fast path.
+     */
+    u64 GetTotalEmptyCenterEvents() const;
+
+    /**
+     * Gets the number of executed events, over all tiles, whose
+     * center was not empty, so that some behavior actually ran.
+     */
+    u64 GetTotalUsefulEvents() const
+    {
+      return GetTotalEventsExecuted() - GetTotalEmptyCenterEvents();
+    }
+
     u64 GetTotalSitesAccessed() const;
 
     void WriteEPSImage(ByteSink & outstrm) const;
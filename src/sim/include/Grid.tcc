@@ -3,6 +3,7 @@
 #include "Grid.h"
 #include "Utils.h"   /* For Sleep */
 #include "FileByteSink.h"
+#include <unistd.h>  /* For sysconf */
 
 #define XRAY_BIT_ODDS 100
 
@@ -162,14 +163,25 @@ namespace MFM {
 
 	    LonglivedLock & otl = isStaggered ? ctl : GetIntertileLock(npt.GetX(),npt.GetY(),odir, false); //simpler for staggered, refs not changed
 
+	    if (m_sharedCacheChannels || m_sequential)
+	      {
+		SharedCacheChannel<EC> & sc = td.m_sharedChannels[d - Dirs::NORTHEAST];
+		ctile.Connect(sc, ctl, d);
+		otile.Connect(sc, otl, odir);
+		// Sequential mode runs off no clock, so models no data rate
+		sc.SetDataRate(m_sequential ? 0 : CACHE_BYTES_PER_SECOND);
+		continue; // gt stays disabled, so is never advanced
+	      }
+
 	    ctile.Connect(gt, ctl, d);
 	    otile.Connect(gt, otl, odir);
 
 	    gt.SetEnabled(true);
-	    gt.SetDataRate(100000000);
+	    gt.SetDataRate(CACHE_BYTES_PER_SECOND);
 	    gt.SetMaxInFlight(0);
 	  } //direction loop
       } //tile loop
+    m_tilesConnected = true;
   } //Init
 
   template <class GC>
@@ -181,7 +193,7 @@ namespace MFM {
     {
       for(u32 y = 0; y < m_height; y++)
       {
-	if(!IsLegalTileIndex(x,y))
+	if(!IsLegalTileIndex(SPoint(x,y)))
 	  continue;
 
         const Tile<EC> & tile = GetTile(x,y);
@@ -211,10 +223,10 @@ namespace MFM {
     {
       for(u32 y = 0; y < m_height; y++)
       {
-	if(!IsLegalTileIndex(x,y))
+	if(!IsLegalTileIndex(SPoint(x,y)))
 	  continue;
 
-        const Tile<EC> & tile = GetTile(x,y);
+        Tile<EC> & tile = GetTile(x,y);
 
 	if(tile.IsDummyTile())
 	  continue;
@@ -224,6 +236,264 @@ namespace MFM {
     }
   }
 
+  template <class GC>
+  void Grid<GC>::SetWorkerThreads(u32 threads)
+  {
+    if (m_threadsInitted)
+    {
+      FAIL(ILLEGAL_STATE);
+    }
+
+    if (threads == 0)
+    {
+      long cores = sysconf(_SC_NPROCESSORS_ONLN);
+      threads = cores > 0 ? (u32) cores : 1;
+    }
+    m_workerThreads = threads;
+  }
+
+  template <class GC>
+  void Grid<GC>::SetCacheDeltaEncoding(bool offered)
+  {
+    for (iterator_type i = begin(); i != end(); ++i)
+    {
+      i->SetCacheDeltaEncoding(offered);
+    }
+  }
+
+  template <class GC>
+  u32 Grid<GC>::GetCacheBytesPerUpdate(bool asDeltas) const
+  {
+    u64 totalBytes = 0, totalUpdates = 0;
+    for (const_iterator_type i = begin(); i != end(); ++i)
+    {
+      u64 bytes, updates;
+      i->GetCacheTraffic(asDeltas, bytes, updates);
+      totalBytes += bytes;
+      totalUpdates += updates;
+    }
+    return totalUpdates ? (u32) (totalBytes / totalUpdates) : 0;
+  }
+
+  template <class GC>
+  void Grid<GC>::SetSharedCacheChannels(bool shared)
+  {
+    if (m_tilesConnected)
+    {
+      FAIL(ILLEGAL_STATE);
+    }
+    m_sharedCacheChannels = shared;
+  }
+
+  template <class GC>
+  void Grid<GC>::SetSequential(bool sequential)
+  {
+    if (m_tilesConnected)
+    {
+      FAIL(ILLEGAL_STATE);
+    }
+    m_sequential = sequential;
+  }
+
+  template <class GC>
+  u64 Grid<GC>::RunSequentialPass(u32 batch)
+  {
+    u64 executed = 0;
+    for (m_rgi.ShuffleOrReset(m_random); m_rgi.HasNext(); )
+    {
+      SPoint tpt = IteratorIndexToCoord(m_rgi.Next());
+      executed += GetTile(tpt).RunSequentialEvents(batch);
+    }
+    return executed;
+  }
+
+  template <class GC>
+  u64 Grid<GC>::RunSequentialEvents(u32 attemptsPerTile)
+  {
+    MFM_API_ASSERT_STATE(m_sequential && m_threadsInitted);
+    u64 executed = 0;
+    while (attemptsPerTile > 0)
+    {
+      const u32 batch = MIN(attemptsPerTile, (u32) SEQUENTIAL_BATCH_EVENTS);
+      executed += RunSequentialPass(batch);
+      attemptsPerTile -= batch;
+    }
+    return executed;
+  }
+
+  template <class GC>
+  u64 Grid<GC>::RunSequentialFor(u32 usec)
+  {
+    MFM_API_ASSERT_STATE(m_sequential && m_threadsInitted);
+    timespec start, now;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    u64 executed = 0;
+    do
+    {
+      executed += RunSequentialPass(SEQUENTIAL_BATCH_EVENTS);
+      clock_gettime(CLOCK_MONOTONIC, &now);
+    } while (ElapsedNanos(start, now) < 1000 * (u64) usec);
+    return executed;
+  }
+
+  template <class GC>
+  void Grid<GC>::SetConcurrentWindows(u32 count)
+  {
+    if (m_threadsInitted)
+    {
+      FAIL(ILLEGAL_STATE);
+    }
+    if (count < 1 || count > Tile<EC>::MAX_CONCURRENT_WINDOWS)
+    {
+      FAIL(ILLEGAL_ARGUMENT);
+    }
+    m_concurrentWindows = count;
+  }
+
+  template <class GC>
+  u64 Grid<GC>::GetTotalSiteClaimConflicts() const
+  {
+    u64 total = 0;
+    for (const_iterator_type i = begin(); i != end(); ++i)
+    {
+      total += i->GetSiteClaimConflicts();
+    }
+    return total;
+  }
+
+  template <class GC>
+  void Grid<GC>::SetDeterministic(u32 eventsPerRound)
+  {
+    if (m_threadsInitted)
+    {
+      FAIL(ILLEGAL_STATE);
+    }
+    m_deterministicEvents = eventsPerRound;
+  }
+
+  template <class GC>
+  u32 Grid<GC>::GetDeterministicSeed(u64 round, u32 color, u32 x, u32 y) const
+  {
+    // Mix each input into the grid seed in turn (murmur3's finalizer)
+    u32 h = m_seed;
+    const u32 inputs[] = { (u32) round, (u32) (round >> 32), color, x, y };
+    for (u32 i = 0; i < sizeof(inputs) / sizeof(inputs[0]); ++i)
+    {
+      h ^= inputs[i] + 0x9e3779b9 + (h << 6) + (h >> 2);
+      h ^= h >> 16;
+      h *= 0x85ebca6b;
+      h ^= h >> 13;
+      h *= 0xc2b2ae35;
+      h ^= h >> 16;
+    }
+    return h ? h : 1;  // Random wants a non-zero seed
+  }
+
+  template <class GC>
+  void Grid<GC>::RunDeterministicRound()
+  {
+    const u64 round = m_roundsCompleted;
+    for (u32 color = 0; color < DETERMINISTIC_COLORS; ++color)
+    {
+      u32 tiles = 0;
+      for (iterator_type i = begin(); i != end(); ++i)
+      {
+        if ((i.GetX() % 2) + 2 * (i.GetY() % 2) == color) ++tiles;
+      }
+      if (tiles == 0)
+      {
+        continue;
+      }
+
+      m_phaseBarrier.Begin(tiles);  // Before any tile can finish
+      for (iterator_type i = begin(); i != end(); ++i)
+      {
+        if ((i.GetX() % 2) + 2 * (i.GetY() % 2) != color) continue;
+        i->StartDeterministicPhase(GetDeterministicSeed(round, color, i.GetX(), i.GetY()),
+                                   m_deterministicEvents, m_phaseBarrier);
+      }
+
+      /* Don't make idle workers wait out their backoff */
+      for (u32 w = 0; m_tileWorkers && w < m_workerThreads; ++w)
+      {
+        m_tileWorkers[w].Wake();
+      }
+
+      m_phaseBarrier.Await();
+    }
+    m_roundsCompleted = round + 1;
+  }
+
+  template <class GC>
+  void * Grid<GC>::RoundRunner(void * arg)
+  {
+    Grid & grid = *(Grid *) arg;
+    Mutex::ScopeLock lock(grid.m_roundLock);
+    while (true)
+    {
+      grid.m_roundWanted.WaitForCondition();
+      if (grid.m_roundExitRequested)
+      {
+        break;
+      }
+
+      grid.m_roundInProgress = true;
+      grid.m_roundLock.Unlock();
+      grid.RunDeterministicRound();
+      grid.m_roundLock.Lock();
+      grid.m_roundInProgress = false;
+      grid.m_roundsIdle.SignalCondition();
+    }
+    grid.m_roundInProgress = false;
+    grid.m_roundsIdle.SignalCondition();
+    return 0;
+  }
+
+  template <class GC>
+  void Grid<GC>::HoldDeterministicRounds()
+  {
+    if (!m_roundThreadStarted)
+    {
+      return;
+    }
+    Mutex::ScopeLock lock(m_roundLock);
+    m_roundsHeld = true;
+    m_roundsIdle.m_awaited = 0;
+    m_roundsIdle.WaitForCondition();
+  }
+
+  template <class GC>
+  void Grid<GC>::ReleaseDeterministicRounds()
+  {
+    if (!m_roundThreadStarted)
+    {
+      return;
+    }
+    Mutex::ScopeLock lock(m_roundLock);
+    m_roundsHeld = false;
+    m_roundWanted.SignalCondition();
+  }
+
+  template <class GC>
+  void Grid<GC>::RunRounds(u32 rounds)
+  {
+    MFM_API_ASSERT_STATE(m_roundThreadStarted);
+    {
+      Mutex::ScopeLock lock(m_roundLock);
+      MFM_API_ASSERT_STATE(m_roundsHeld);
+      m_roundLimit = m_roundsCompleted + rounds;
+    }
+
+    Unpause();
+    {
+      Mutex::ScopeLock lock(m_roundLock);
+      m_roundsIdle.m_awaited = m_roundLimit;
+      m_roundsIdle.WaitForCondition();
+      m_roundLimit = U64_MAX;
+    }
+    Pause();
+  }
+
   template <class GC>
   void Grid<GC>::InitThreads()
   {
@@ -232,6 +502,87 @@ namespace MFM {
       FAIL(ILLEGAL_STATE);
     }
 
+    if (m_sequential)
+    {
+      if (m_workerThreads > 0 || m_concurrentWindows > 1 || m_deterministicEvents > 0)
+      {
+        FAIL(ILLEGAL_STATE);
+      }
+
+      const bool isStaggered = IsGridLayoutStaggered();
+      for (iterator_type i = begin(); i != end(); ++i)
+      {
+        SPoint tpt = i.At();
+        Tile<EC> * neighbors[Dirs::DIR_COUNT];
+        for (Dir d = 0; d < Dirs::DIR_COUNT; ++d)
+        {
+          neighbors[d] = 0;
+          if (!Dirs::IsValidDir(d, isStaggered))
+          {
+            continue;
+          }
+          SPoint gridoffset;
+          Dirs::ToNeighborTileInGrid(gridoffset, d, isStaggered, tpt);
+          SPoint npt = tpt + gridoffset;
+          if (IsLegalTileIndex(npt) && !GetTile(npt).IsDummyTile())
+          {
+            neighbors[d] = &GetTile(npt);
+          }
+        }
+
+        // Drivers with no threads, so controls can find their tiles
+        TileDriver & td = _getTileDriver(tpt.GetX(),tpt.GetY());
+        td.m_loc = tpt;
+        td.m_gridPtr = this;
+
+        i->SetSequential(neighbors);
+        i->RequestStatePassive();
+        i->RunSequentialEvents(0);  // Just take the state change
+      }
+      m_threadsInitted = true;
+      LOG.Message("Running all tiles sequentially on one thread");
+      return;
+    }
+
+    if (m_deterministicEvents > 0)
+    {
+      if (IsGridLayoutStaggered() || m_concurrentWindows > 1)
+      {
+        FAIL(ILLEGAL_STATE);
+      }
+      for (iterator_type i = begin(); i != end(); ++i)
+      {
+        i->SetDeterministic(true);
+      }
+      if (pthread_create(&m_roundThreadId, NULL, RoundRunner, this))
+      {
+        FAIL(ILLEGAL_STATE);
+      }
+      m_roundThreadStarted = true;
+      LOG.Message("Running deterministically, %d events per tile per round",
+                  m_deterministicEvents);
+    }
+
+    if (m_concurrentWindows > 1)
+    {
+      for (iterator_type i = begin(); i != end(); ++i)
+      {
+        if (!i->IsDummyTile())
+        {
+          i->SetConcurrentWindows(m_concurrentWindows);
+        }
+      }
+      LOG.Message("Running %d event windows at once per tile", m_concurrentWindows);
+    }
+
+    if (m_workerThreads > 0)
+    {
+      InitWorkerThreads();
+      ApplyThreadAffinity();
+      m_threadsInitted = true;
+      return;
+    }
+
     /* Init the tile thread drivers */
     for (m_rgi.ShuffleOrReset(m_random); m_rgi.HasNext(); )
     {
@@ -244,15 +595,121 @@ namespace MFM {
       td.SetState(TileDriver::PAUSED);
       MFM_API_ASSERT_STATE(!td.GetTile().IsDummyTile());
 
+      // Before the thread starts, so it can't undo an early Unpause
+      td.GetTile().RequestStatePassive();
+
       if (pthread_create(&td.m_threadId, NULL, TileDriverRunner, &td))
       {
         FAIL(ILLEGAL_STATE);
       }
     }
 
+    ApplyThreadAffinity();
     m_threadsInitted = true;
   }
 
+  template <class GC>
+  void Grid<GC>::SetThreadAffinity(ThreadAffinity affinity)
+  {
+    if (m_threadsInitted)
+    {
+      FAIL(ILLEGAL_STATE);
+    }
+    MFM_API_ASSERT_ARG(affinity >= 0 && affinity < AFFINITY_COUNT);
+    m_threadAffinity = affinity;
+  }
+
+  template <class GC>
+  void Grid<GC>::ApplyThreadAffinity()
+  {
+    if (m_threadAffinity == AFFINITY_NONE)
+    {
+      return;
+    }
+
+    CpuTopology * topology = new CpuTopology();  // Too big for the stack
+    topology->ReadFromSystem();
+    topology->Arrange(m_threadAffinity);
+
+    const char * policy = CpuTopology::GetAffinityName(m_threadAffinity);
+    LOG.Message("Thread affinity %s: %d CPUs on %d nodes",
+                policy, topology->GetCpuCount(), topology->GetNodeCount());
+
+    if (m_workerThreads > 0)
+    {
+      // Workers steal tiles from each other, so only the workers
+      // themselves have a home
+      for (u32 w = 0; w < m_workerThreads; ++w)
+      {
+        const CpuTopology::Cpu & cpu = topology->GetCpuForThread(w, m_workerThreads);
+        if (!CpuTopology::Pin(m_tileWorkers[w].m_threadId, cpu))
+        {
+          LOG.Warning("Couldn't pin worker %d to CPU %d", w, cpu.m_cpu);
+          continue;
+        }
+        LOG.Message(" Worker %d -> CPU %d (node %d, core %d)",
+                    w, cpu.m_cpu, cpu.m_node, cpu.m_core);
+      }
+      delete topology;
+      return;
+    }
+
+    u32 tileCount = 0;
+    for (u32 x = 0; x < m_width; ++x)
+    {
+      for (u32 y = 0; y < m_height; ++y)
+      {
+        if (IsDrivenTile(x, y)) ++tileCount;
+      }
+    }
+
+    // Walk the rows boustrophedonically, so each thread's successor
+    // is a neighboring tile
+    const bool moveMemory = topology->GetNodeCount() > 1;
+    u32 k = 0;
+    for (u32 y = 0; y < m_height; ++y)
+    {
+      for (u32 i = 0; i < m_width; ++i)
+      {
+        const u32 x = (y & 1) ? m_width - 1 - i : i;
+        if (!IsDrivenTile(x, y))
+        {
+          continue;
+        }
+        TileDriver & td = _getTileDriver(x, y);
+        const CpuTopology::Cpu & cpu = topology->GetCpuForThread(k++, tileCount);
+        if (!CpuTopology::Pin(td.m_threadId, cpu))
+        {
+          LOG.Warning("Couldn't pin tile (%d,%d) to CPU %d", x, y, cpu.m_cpu);
+          continue;
+        }
+        td.m_cpu = (s32) cpu.m_cpu;
+
+        if (moveMemory)
+        {
+          Tile<EC> & tile = GetTile(x, y);
+          if (!CpuTopology::MoveToNode(&tile, sizeof(GridTile), cpu.m_node))
+          {
+            LOG.Debug("Couldn't move tile (%d,%d) to node %d", x, y, cpu.m_node);
+          }
+        }
+      }
+    }
+
+    // Log the mapping as a map of the grid
+    for (u32 y = 0; y < m_height; ++y)
+    {
+      OString256 row;
+      for (u32 x = 0; x < m_width; ++x)
+      {
+        row.Printf(" %3d", IsDrivenTile(x, y) ? _getTileDriver(x, y).m_cpu : -1);
+      }
+      LOG.Message(" Tile row %2d CPUs:%s", y, row.GetZString());
+    }
+
+    delete topology;
+  }
+
   template <class GC>
   void Grid<GC>::SetGridRunning(bool running)
   {
@@ -267,6 +724,12 @@ namespace MFM {
 
       td.SetState(running? TileDriver::ADVANCING : TileDriver::PAUSED);
     }
+
+    /* Don't make idle workers wait out their backoff */
+    for (u32 w = 0; m_tileWorkers && w < m_workerThreads; ++w)
+    {
+      m_tileWorkers[w].Wake();
+    }
   }
 
   template <class GC>
@@ -288,10 +751,7 @@ namespace MFM {
 		  td->m_loc.GetY(),
 		  ctile.GetLabel()));
 
-    ctile.RequestStatePassive();
-
     bool running = true;
-    u32 pauseUsec = 0;
     while (running)
     {
       switch (td->GetState())
@@ -317,15 +777,13 @@ namespace MFM {
           // We accomplished nothing.  Let somebody else try
           sched_yield();
         }
-        pauseUsec = 0;
+        td->m_gridPtr->MaybeAcknowledgeControl(*td);
         break;
       }
 
       case TileDriver::PAUSED:
-        // Sleep a little
-        if (pauseUsec < 100000)
-          pauseUsec += ctile.GetRandom().Between(10,100);
-        SleepUsec(pauseUsec);
+        // Sleep until somebody changes our state
+        td->WaitWhilePaused();
         break;
 
       default:
@@ -336,6 +794,228 @@ namespace MFM {
     return NULL;
   }
 
+  template <class GC>
+  void Grid<GC>::InitWorkerThreads()
+  {
+    const u32 tileCount = m_rgi.GetLimit();
+    if (m_workerThreads > tileCount)
+    {
+      LOG.Message("Reducing %d worker threads to %d, one per tile",
+                  m_workerThreads, tileCount);
+      m_workerThreads = tileCount;
+    }
+
+    m_tileWorkers = new TileWorker[m_workerThreads];
+    for (u32 w = 0; w < m_workerThreads; ++w)
+    {
+      m_tileWorkers[w].Init(*this, w, tileCount);
+      m_random.Split(m_tileWorkers[w].m_random);
+    }
+
+    /* Deal the tiles out to the workers */
+    u32 dealt = 0;
+    for (m_rgi.ShuffleOrReset(m_random); m_rgi.HasNext(); )
+    {
+      SPoint tpt = IteratorIndexToCoord(m_rgi.Next());
+      MFM_API_ASSERT_STATE(IsLegalTileIndex(tpt));
+
+      TileDriver & td = _getTileDriver(tpt.GetX(),tpt.GetY());
+      td.m_loc = tpt; //init m_loc before a GetTile call
+      td.m_gridPtr = this;
+      td.SetState(TileDriver::PAUSED);
+
+      Tile<EC> & ctile = td.GetTile();
+      MFM_API_ASSERT_STATE(!ctile.IsDummyTile());
+      ctile.RequestStatePassive();
+
+      m_tileWorkers[dealt % m_workerThreads].PushBack(&td - m_tileDrivers);
+      ++dealt;
+    }
+    m_workerLiveTiles = dealt;
+
+    for (u32 w = 0; w < m_workerThreads; ++w)
+    {
+      TileWorker & tw = m_tileWorkers[w];
+      clock_gettime(CLOCK_MONOTONIC, &tw.m_started);
+      if (pthread_create(&tw.m_threadId, NULL, TileWorkerRunner, &tw))
+      {
+        FAIL(ILLEGAL_STATE);
+      }
+    }
+
+    LOG.Message("Started %d worker threads for %d tiles", m_workerThreads, dealt);
+  }
+
+  template <class GC>
+  bool Grid<GC>::StealTileFor(TileWorker & thief, u32 & idx)
+  {
+    const u32 thiefCount = thief.GetCount();
+
+    // Pick the most heavily loaded peer as the victim
+    TileWorker * victim = 0;
+    u32 victimCount = thiefCount + 1;
+    for (u32 w = 0; w < m_workerThreads; ++w)
+    {
+      TileWorker & tw = m_tileWorkers[w];
+      if (&tw == &thief) continue;
+      u32 count = tw.GetCount();
+      if (count > victimCount)
+      {
+        victim = &tw;
+        victimCount = count;
+      }
+    }
+
+    if (!victim || !victim->StealFront(idx, thiefCount))
+    {
+      return false;
+    }
+
+    TileWorker::Count(thief.m_steals, 1);
+    return true;
+  }
+
+  template <class GC>
+  void* Grid<GC>::TileWorkerRunner(void * arg)
+  {
+    TileWorker * tw = (TileWorker*) arg;
+    Grid & grid = *tw->m_gridPtr;
+
+    MFM_LOG_DBG4(("TileWorker %d init: %d tiles", tw->m_index, tw->GetCount()));
+
+    u32 pauseUsec = 0;
+    u32 visitsSinceBusy = 0;
+    while (grid.m_workerLiveTiles > 0)
+    {
+      u32 idx;
+      bool haveTile = tw->PopFront(idx) || grid.StealTileFor(*tw, idx);
+
+      if (haveTile)
+      {
+        TileDriver & td = grid.m_tileDrivers[idx];
+        Tile<EC> & ctile = td.GetTile();
+
+        switch (td.GetState())
+        {
+        case TileDriver::EXIT_REQUEST:
+          // Retire the tile by not returning it to the deque
+          MFM_LOG_DBG4(("Tile %s retired by worker %d", ctile.GetLabel(), tw->m_index));
+          __sync_sub_and_fetch(&grid.m_workerLiveTiles, 1);
+          continue;
+
+        case TileDriver::ADVANCING:
+        {
+          // Point the error stack at this tile for the duration
+          MFMPtrToErrEnvStackPtr = ctile.GetErrorEnvironmentStackTop();
+
+          // Drive this tile's transceivers
+          timespec now;
+          clock_gettime(CLOCK_MONOTONIC, &now);
+          for (u32 c = 0; c < 4; ++c)
+          {
+            if(td.m_channels[c].IsEnabled())
+              td.m_channels[c].AdvanceToTime(now);
+          }
+
+          // Drive the tile itself
+          if (ctile.Advance())
+          {
+            timespec then;
+            clock_gettime(CLOCK_MONOTONIC, &then);
+            TileWorker::Count(tw->m_busyNanos, ElapsedNanos(now, then));
+            TileWorker::Count(tw->m_busyAdvances, 1);
+            visitsSinceBusy = 0;
+            pauseUsec = 0;
+          }
+          else
+          {
+            TileWorker::Count(tw->m_idleAdvances, 1);
+            ++visitsSinceBusy;
+          }
+          grid.MaybeAcknowledgeControl(td);
+          break;
+        }
+
+        case TileDriver::PAUSED:
+          TileWorker::Count(tw->m_pausedVisits, 1);
+          ++visitsSinceBusy;
+          break;
+
+        default:
+          FAIL(ILLEGAL_STATE);
+        }
+
+        tw->PushBack(idx);
+
+        // Keep going until a full pass over our tiles got nowhere
+        if (visitsSinceBusy <= tw->GetCount())
+        {
+          continue;
+        }
+      }
+
+      // Nothing to do: back off instead of spinning
+      visitsSinceBusy = 0;
+      if (pauseUsec < 100000)
+        pauseUsec += tw->m_random.Between(10,100);
+      tw->Nap(pauseUsec);
+      TileWorker::Count(tw->m_sleepNanos, (u64) pauseUsec * 1000);
+    }
+
+    MFM_LOG_DBG4(("TileWorker %d thread exiting", tw->m_index));
+    return NULL;
+  }
+
+  template <class GC>
+  void Grid<GC>::ReportWorkerStatus(Logger::Level level)
+  {
+    if (!m_tileWorkers)
+    {
+      LOG.Log(level," Tile threads: one per tile");
+      return;
+    }
+
+    LOG.Log(level," Worker threads: %d for %d live tiles", m_workerThreads, m_workerLiveTiles);
+    WorkerStats ws;
+    for (u32 w = 0; GetWorkerStats(w, ws); ++w)
+    {
+      // The counts are u64, and %d would wrap them on long runs
+      const u64 advances = ws.m_busyAdvances + ws.m_idleAdvances;
+      OString256 line;
+      line.Printf("  Worker %2d: %2d tiles, %3d%% busy, ", w, ws.m_tiles, ws.m_utilization);
+      line.Print(ws.m_busyAdvances);
+      line.Print("/");
+      line.Print(advances);
+      line.Print(" productive advances, ");
+      line.Print(ws.m_pausedVisits);
+      line.Print(" paused visits, ");
+      line.Print(ws.m_steals);
+      line.Print(" steals, ");
+      line.Print(ws.m_sleepNanos / 1000000);
+      line.Print(" ms asleep");
+      LOG.Log(level, "%s", line.GetZString());
+    }
+  }
+
+  template <class GC>
+  bool Grid<GC>::GetWorkerStats(u32 w, WorkerStats & stats)
+  {
+    if (!m_tileWorkers || w >= m_workerThreads)
+    {
+      return false;
+    }
+
+    TileWorker & tw = m_tileWorkers[w];
+    stats.m_tiles = tw.GetCount();
+    stats.m_utilization = (u32) tw.GetUtilization();
+    stats.m_busyAdvances = TileWorker::Read(tw.m_busyAdvances);
+    stats.m_idleAdvances = TileWorker::Read(tw.m_idleAdvances);
+    stats.m_pausedVisits = TileWorker::Read(tw.m_pausedVisits);
+    stats.m_steals = TileWorker::Read(tw.m_steals);
+    stats.m_sleepNanos = TileWorker::Read(tw.m_sleepNanos);
+    return true;
+  }
+
   template <class GC>
   void Grid<GC>::SetSeed(u32 seed)
   {
@@ -352,7 +1032,7 @@ namespace MFM {
 
     m_random.SetSeed(m_seed);
     for (iterator_type i = begin(); i != end(); ++i)
-      i->GetRandom().SetSeed(m_random.Create());
+      m_random.Split(i->GetRandom());
   }
 
 
@@ -505,7 +1185,7 @@ namespace MFM {
     }
 
     Tile<EC> & owner = GetTile(tileInGrid);
-    Site<AC> & site = owner.GetSite(siteInTile);
+    typename Tile<EC>::SITE_REF site = owner.GetSite(siteInTile);
 
     //////// NOTE WE ARE RACING AGAINST THE TILE THREADS HERE!
     //
@@ -606,6 +1286,20 @@ namespace MFM {
       i->NeedAtomRecount();
   }
 
+  template <class GC>
+  u32 Grid<GC>::AuditAtomCounts()
+  {
+    u32 wrong = 0;
+    for (iterator_type i = begin(); i != end(); ++i)
+    {
+      if (i->AuditAtomCounts() > 0)
+      {
+        ++wrong;
+      }
+    }
+    return wrong;
+  }
+
   template <class GC>
   void Grid<GC>:: CheckAtom(const T& atom, const SPoint& siteInGrid)
   {
@@ -705,6 +1399,39 @@ namespace MFM {
     LOG.Log(level," Last event tile: (%d, %d)", m_lastEventTile.GetX(), m_lastEventTile.GetY());
     LOG.Log(level," Background radiation: %s", m_backgroundRadiationEnabled?"true":"false");
     LOG.Log(level," Xray odds: %d", m_xraySiteOdds);
+    LOG.Log(level," Cache channels: %s",
+            m_sequential ? "none (sequential)" : m_sharedCacheChannels ? "shared" : "packet");
+    if (!m_sharedCacheChannels && !m_sequential)
+    {
+      LOG.Log(level," Cache bytes/update: %d full, %d delta",
+              GetCacheBytesPerUpdate(false), GetCacheBytesPerUpdate(true));
+    }
+    {
+      const u64 events = GetTotalEventsExecuted();
+      const u64 empties = GetTotalEmptyCenterEvents();
+      LOG.Log(level," Empty-center events: %dK of %dK (%d%%)",
+              (u32) (empties / 1000), (u32) (events / 1000),
+              events ? (u32) (100 * empties / events) : 0);
+      if (IsActiveSiteSelection())
+      {
+        LOG.Log(level," Active site selection: %d%% uniform",
+                GetUniformSelectionPercent());
+      }
+      if (IsDeterministic())
+      {
+        LOG.Log(level," Deterministic: %d rounds of %d events per tile",
+                (u32) m_roundsCompleted, m_deterministicEvents);
+      }
+      if (m_concurrentWindows > 1)
+      {
+        LOG.Log(level," Concurrent windows per tile: %d (%dK claim conflicts)",
+                m_concurrentWindows, (u32) (GetTotalSiteClaimConflicts() / 1000));
+      }
+    }
+    m_pauseLatency.Report(level, "Pause");
+    m_unpauseLatency.Report(level, "Unpause");
+    ReportWorkerStatus(level);
+    ReportIntertileLockStatus(level);
 
     for (iterator_type i = begin(); i != end(); ++i)
     {
@@ -715,12 +1442,101 @@ namespace MFM {
     }
   }
 
+  template <class GC>
+  void Grid<GC>::ReportIntertileLockStatus(Logger::Level level)
+  {
+    const bool isStaggered = IsGridLayoutStaggered();
+    const Dir firstDir = isStaggered ? Dirs::NORTHEAST : Dirs::EAST;
+
+    u32 totalAttempts = 0;
+    u32 totalFailures = 0;
+    LOG.Log(level," Intertile locks (attempts/failures, acquisitions, sampled mean hold):");
+    for (u32 x = 0; x < m_width; ++x)
+    {
+      for (u32 y = 0; y < m_height; ++y)
+      {
+        for (u32 i = 0; i < MAX_LOCKS_OWNED_PER_TILE; ++i)
+        {
+          LonglivedLock & lock = _getIntertileLock(x, y, i);
+          const u32 attempts = lock.GetAttempts();
+          if (attempts == 0) continue;  // Unused slot or idle edge
+
+          const u32 failures = lock.GetFailures();
+          const u32 acquisitions = lock.GetAcquisitions();
+          const u32 holdSamples = lock.GetHoldSamples();
+          totalAttempts += attempts;
+          totalFailures += failures;
+          LOG.Log(level,"  (%d,%d) %2s: %d/%d (%d%%), %d, %d ns",
+                  x, y, Dirs::GetCode(firstDir + i),
+                  attempts, failures, (u32) ((u64) 100 * failures / attempts),
+                  acquisitions,
+                  holdSamples ? (u32) (lock.GetHoldNanos() / holdSamples) : 0);
+        }
+      }
+    }
+    LOG.Log(level," Intertile lock totals: %d attempts, %d failures",
+            totalAttempts, totalFailures);
+  }
+
+  template <class GC>
+  void Grid<GC>::MaybeAcknowledgeControl(TileDriver & td)
+  {
+    // Fast path: nothing new since we last acknowledged
+    if (td.m_ackedGeneration == m_controlBarrier.m_generation)
+    {
+      return;
+    }
+
+    Mutex::ScopeLock lock(m_controlLock);
+    TileDriverControl * tc = m_controlBarrier.m_control;
+    if (!tc)
+    {
+      // Control finished (or not yet begun); just catch up
+      td.m_ackedGeneration = m_controlBarrier.m_generation;
+      return;
+    }
+
+    if (!tc->CheckIfReady(td))
+    {
+      return;
+    }
+
+    td.m_ackedGeneration = m_controlBarrier.m_generation;
+    MFM_API_ASSERT_STATE(m_controlBarrier.m_pending > 0);
+    if (--m_controlBarrier.m_pending == 0)
+    {
+      m_controlBarrier.SignalCondition();
+    }
+  }
+
   template <class GC>
   void Grid<GC>::DoTileDriverControl(TileDriverControl & tc)
   {
     // Initial grid changes
     tc.PreGridControl(*this);
 
+    if (m_sequential)
+    {
+      // No threads to wait for: each tile takes the request at once
+      for (m_rgi.ShuffleOrReset(m_random); m_rgi.HasNext(); )
+      {
+        SPoint i = IteratorIndexToCoord(m_rgi.Next());
+        TileDriver & td = _getTileDriver(i.GetX(),i.GetY());
+        if (!tc.CheckPrecondition(td))
+        {
+          LOG.Error("%s control precondition failed at (%d,%d)=Tile %s (%p)--",
+                    tc.GetName(), i.GetX(), i.GetY(), td.GetTile().GetLabel(), (void *) &td);
+          FAIL(ILLEGAL_STATE);
+        }
+        tc.MakeRequest(td);
+        td.GetTile().RunSequentialEvents(0);
+        MFM_API_ASSERT_STATE(tc.CheckIfReady(td));
+        tc.Execute(td);
+      }
+      tc.PostGridControl(*this);
+      return;
+    }
+
     // Ensure everybody is ready for the request
     for (m_rgi.ShuffleOrReset(m_random); m_rgi.HasNext(); )
     {
@@ -741,6 +1557,16 @@ namespace MFM {
       }
     }
 
+    // Open a new barrier generation before anybody can become ready
+    timespec started;
+    clock_gettime(CLOCK_MONOTONIC, &started);
+    {
+      Mutex::ScopeLock lock(m_controlLock);
+      m_controlBarrier.m_control = &tc;
+      m_controlBarrier.m_pending = m_rgi.GetLimit();
+      ++m_controlBarrier.m_generation;
+    }
+
     // Issue request to all
     for (m_rgi.ShuffleOrReset(m_random); m_rgi.HasNext(); )
     {
@@ -754,60 +1580,39 @@ namespace MFM {
       tc.MakeRequest(td);
     }
 
-    // Wait until all acknowledge
-    u32 loops = 0;
-    u32 notReady = 0;
-    s32 sleepTimer = 100000000; // XXX m_random.Between(1000,10000);
-    do
+    // A paused driver does not advance its tile, so it never
+    // acknowledges anything itself.  Do that for it, if its tile is
+    // already ready -- as when pausing a grid that is paused.
+    for (m_rgi.ShuffleOrReset(m_random); m_rgi.HasNext(); )
     {
-      if (++loops >= 1000000)
-      {
-        LOG.Error("%s control looped %d times, but %d still not ready, killing",
-                  tc.GetName(), loops, notReady);
-        ReportGridStatus(Logger::ERROR);
-        LOG.Error("%s control: Sleeping", tc.GetName());
-        SleepUsec(60*1000000);  // 1 minute
-        LOG.Error("%s control: Resetting", tc.GetName());
-        loops = 0;
-      }
-
-      if (--sleepTimer < 0)
-      {
-        SleepUsec(m_random.Between(10,1000));  // 0.01ms..1ms
-        sleepTimer = m_random.Create(10000);
-      }
-      else
+      SPoint i = IteratorIndexToCoord(m_rgi.Next());
+      TileDriver & td = _getTileDriver(i.GetX(),i.GetY());
+      if (td.GetState() == TileDriver::PAUSED)
       {
-        sched_yield();
+        MaybeAcknowledgeControl(td);
       }
+    }
 
-      notReady = 0;
-
-      for (m_rgi.ShuffleOrReset(m_random); m_rgi.HasNext(); )
+    // Sleep until the last tile acknowledges
+    {
+      const u32 PATIENCE_USEC = 60*1000000;  // 1 minute
+      Mutex::ScopeLock lock(m_controlLock);
+      while (!m_controlBarrier.WaitForConditionFor(PATIENCE_USEC))
       {
-        SPoint i = IteratorIndexToCoord(m_rgi.Next());
-	MFM_API_ASSERT_STATE(IsLegalTileIndex(i));
-
-        u32 x = i.GetX();
-        u32 y = i.GetY();
-        TileDriver & td = _getTileDriver(x,y);
-	MFM_API_ASSERT_STATE(!td.GetTile().IsDummyTile());
-
-        if (!tc.CheckIfReady(td))
-        {
-          ++notReady;
-          sched_yield();
-        }
+        LOG.Error("%s control waited %d seconds, but %d still not ready",
+                  tc.GetName(), PATIENCE_USEC / 1000000, m_controlBarrier.m_pending);
+        m_controlLock.Unlock();
+        ReportGridStatus(Logger::ERROR);
+        m_controlLock.Lock();
       }
-
-    } while (notReady > 0);
-
-    if (loops > 5000)
-    {
-      LOG.Debug("%s control looped %d times",
-                tc.GetName(), loops);
+      m_controlBarrier.m_control = 0;
     }
 
+    timespec ready;
+    clock_gettime(CLOCK_MONOTONIC, &ready);
+    const u64 usec = ElapsedNanos(started, ready) / 1000;
+    tc.GetLatencyHistogram(*this).Record(usec > U32_MAX ? U32_MAX : (u32) usec);
+
     // Release the hounds
     for (m_rgi.ShuffleOrReset(m_random); m_rgi.HasNext(); )
     {
@@ -842,6 +1647,16 @@ namespace MFM {
     return total;
   }
 
+  template <class GC>
+  u64 Grid<GC>::GetTotalEmptyCenterEvents() const
+  {
+    u64 total = 0;
+    for (const_iterator_type i = begin(); i != end(); ++i)
+      total += i->GetEmptyCenterEvents();
+
+    return total;
+  }
+
   template <class GC>
   u64 Grid<GC>::GetTotalSitesAccessed() const
   {
@@ -1025,6 +1840,19 @@ namespace MFM {
     m_backgroundRadiationEnabled = value;
   }
 
+  template <class GC>
+  void Grid<GC>::SetActiveSiteSelection(bool enabled, u32 uniformPercent)
+  {
+    if (uniformPercent > 100)
+    {
+      FAIL(ILLEGAL_ARGUMENT);
+    }
+
+    m_heroTile.SetActiveSiteSelection(enabled, uniformPercent);
+    for (iterator_type i = begin(); i != end(); ++i)
+      i->SetActiveSiteSelection(enabled, uniformPercent);
+  }
+
   template <class GC>
   void Grid<GC>::SetForegroundRadiationEnabled(bool value)
   {
@@ -0,0 +1,256 @@
+/*                                              -*- mode:C++ -*-
+  GridSnapshot.h Binary, memory-mappable saved grids
+  Copyright (C) 2015 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file GridSnapshot.h Binary, memory-mappable saved grids
+  \author David H. Ackley.
+  \date (C) 2015 All rights reserved.
+  \lgpl
+ */
+#ifndef GRIDSNAPSHOT_H
+#define GRIDSNAPSHOT_H
+
+#include "itype.h"
+#include "Site.h"
+#include "ExternalConfig.h"
+#include "ExternalConfigSectionGrid.h"
+
+namespace MFM
+{
+  /**
+     Saves and loads a whole configuration -- everything an .mfs file
+     holds -- as a binary snapshot.  A snapshot file is
+
+       - a fixed-size SnapshotHeader,
+
+       - the MFS/3 text of the configuration, minus all the Site(..)
+         lines, so the driver settings, element registrations and
+         parameters, and tile settings load exactly as from an .mfs,
+
+       - the type map: the atom type of each element at save time,
+         which the text registers by UUID under the name T%04x,
+
+       - the tile table: the grid coordinates of each saved tile,
+
+       - and, starting on a page boundary, a SiteImage for each owned
+         site of each tile, row by row, tile after tile.
+
+     Loading maps the file read-only and converts the site images of
+     several tiles at once, each on its own thread.  Atoms whose
+     element has the same type here as at save time are copied as
+     they are; others are rebuilt from the element's default atom
+     and their saved state bits, just as when loading an .mfs.
+
+     A snapshot records raw in-memory atoms, so it can only be loaded
+     by a build with the same atom layout and byte order; Load checks
+     that.  Convert to .mfs for anything else.
+
+     A delta (.mfd) is laid out the same way, behind a DeltaHeader,
+     except that in place of the site images of every tile it holds
+     SiteChanges for just the sites whose contents -- atom, base
+     atom, paint, liveness -- differ from the checkpoint before it,
+     which it names.  Every event bumps its site's statistics, so
+     those alone are not a change: they travel with a changed site,
+     and otherwise stay as of an earlier checkpoint.  Loading a delta loads its keyframe,
+     the full snapshot at the start of its chain, applies each
+     delta's changes in turn, and takes everything else from the
+     newest text.
+   */
+  template <class GC>
+  class GridSnapshot
+  {
+    typedef typename GC::EVENT_CONFIG EC;
+    typedef typename EC::ATOM_CONFIG AC;
+    typedef typename AC::ATOM_TYPE T;
+
+  public:
+
+    enum { SNAPSHOT_VERSION = 1 };
+
+    enum { BYTE_ORDER_MARK = 0x01020304 };
+
+    enum { SITES_ALIGNMENT = 4096 };  // Of the first SiteImage in the file
+
+    enum { MAX_DELTA_CHAIN = 1000 };  // Files, including the keyframe
+
+    struct SnapshotHeader
+    {
+      char m_magic[8];          // "MFMSNAP\n"
+      u32 m_version;            // SNAPSHOT_VERSION
+      u32 m_byteOrder;          // BYTE_ORDER_MARK, as stored by the saver
+      u32 m_bitsPerAtom;
+      u32 m_siteImageBytes;     // sizeof(SiteImage<AC>) when saved
+      u32 m_gridWidth;          // In tiles
+      u32 m_gridHeight;
+      u32 m_ownedWidth;         // In sites, per tile, excluding caches
+      u32 m_ownedHeight;
+      u32 m_layout;             // GridLayoutPattern
+      u32 m_tileCount;          // Tiles saved, excluding dummy tiles
+      u32 m_typeCount;          // u32 entries in the type map
+      u32 m_unused;
+      u64 m_textOffset;         // The MFS/3 text
+      u64 m_textLength;
+      u64 m_typeMapOffset;
+      u64 m_tileTableOffset;    // s32 x, y of each tile, in save order
+      u64 m_sitesOffset;        // Page aligned
+      u64 m_tileBytes;          // Bytes of SiteImages per tile
+    };
+
+    struct DeltaHeader
+    {
+      SnapshotHeader m_base;    // Magic "MFMDELTA"; m_sitesOffset is of the SiteChanges
+      u64 m_previousOffset;     // The previous checkpoint's file name, NUL-terminated,
+      u64 m_previousLength;     //   relative to this file's directory
+      u64 m_changeCount;
+    };
+
+    struct SiteChange
+    {
+      u32 m_tile;               // In tile table order
+      u32 m_site;               // y * OWNED_WIDTH + x
+      SiteImage<AC> m_image;
+    };
+
+    /**
+       A snapshotter for the configuration read and written by config,
+       whose grid is the one in gridSection.
+     */
+    GridSnapshot(ExternalConfig<GC> & config, ExternalConfigSectionGrid<GC> & gridSection) ;
+
+    /**
+       Set how many threads Load uses to convert site images.  0, the
+       default, means one per online core (but never more than there
+       are tiles).
+     */
+    void SetLoadThreads(u32 threads)
+    {
+      m_loadThreads = threads;
+    }
+
+    /**
+       Return true if the file at path starts like a snapshot or a
+       delta.
+     */
+    static bool IsSnapshotFile(const char * path) ;
+
+    /**
+       Write the grid's whole configuration to path.  Returns false,
+       having logged why, if that failed.
+     */
+    bool Save(const char * path) ;
+
+    /**
+       Copy the grid's whole configuration into memory, laid out just
+       as Save writes it, and return those length bytes, from malloc,
+       for WriteFile or a SnapshotWriter to write later.  The grid
+       must be paused, but only for the copy.  Returns null, having
+       logged why, if that failed.
+     */
+    u8 * Capture(u64 & length) ;
+
+    /**
+       Write the length bytes of a Capture to path.  Returns false,
+       having logged why, if that failed.
+     */
+    static bool WriteFile(const u8 * bytes, u64 length, const char * path) ;
+
+    /**
+       Given two Captures of this grid, before and after, return, from
+       malloc, the length bytes of a delta holding after's text and
+       the sites whose contents changed since before, which was (or will be)
+       saved under previousName.  Returns null, having logged why, if
+       that failed.
+     */
+    static u8 * Diff(const u8 * before, const u8 * after, const char * previousName, u64 & length) ;
+
+    /**
+       Replace the grid's whole configuration with the snapshot or
+       delta at path.  Returns false, having logged why, if a file
+       involved is missing, is not one this build can load, or is
+       damaged; the grid may then be partly loaded.
+     */
+    bool Load(const char * path) ;
+
+  private:
+    ExternalConfig<GC> & m_config;
+    ExternalConfigSectionGrid<GC> & m_gridSection;
+    u32 m_loadThreads;
+
+    struct MappedFile
+    {
+      void * m_map;
+      u64 m_length;
+
+      MappedFile() : m_map(0), m_length(0) { }
+
+      const u8 * GetBytes() const
+      {
+        return (const u8 *) m_map;
+      }
+
+      const SnapshotHeader & GetHeader() const
+      {
+        return *(const SnapshotHeader *) m_map;
+      }
+    };
+
+    struct LoadJob
+    {
+      const u8 * m_sites;               // First tile's SiteImages
+      u64 m_tileBytes;
+      Tile<EC> * const * m_tiles;       // Where to load each saved tile
+      u32 m_tileCount;
+      u32 m_first;                      // Tiles m_first, m_first + m_stride, ..
+      u32 m_stride;
+      const Element<EC> * const * m_typeMap;  // Element of each saved type, or null
+      u32 m_unknownAtoms;               // Atoms of an unmapped type
+    };
+
+    static void * LoadRunner(void * arg) ;
+
+    static bool RemapAtom(T & atom, const Element<EC> * const * typeMap) ;
+
+    /**
+       True if a and b differ in more than their event statistics.
+     */
+    static bool ContentsDiffer(const SiteImage<AC> & a, const SiteImage<AC> & b) ;
+
+    static bool MapFile(const char * path, MappedFile & file) ;
+
+    bool CheckTiles(const MappedFile & file, const char * path) const ;
+
+    bool BuildTypeMap(const MappedFile & file, const Element<EC> ** typeMap, const char * path) const ;
+
+    bool LoadSites(const MappedFile & file, Tile<EC> * const * tiles, u32 tileCount,
+                   const Element<EC> * const * typeMap, const char * path) ;
+
+    static bool ApplyChanges(const MappedFile & file, Tile<EC> * const * tiles, u32 tileCount,
+                             const Element<EC> * const * typeMap, const char * path) ;
+
+    void FillHeader(SnapshotHeader & header) const ;
+
+    bool CheckHeader(const SnapshotHeader & header, u64 fileLength, const char * path,
+                     u64 sitesBytes) const ;
+  };
+} /* namespace MFM */
+
+#include "GridSnapshot.tcc"
+
+#endif /*GRIDSNAPSHOT_H*/
@@ -0,0 +1,637 @@
+/* -*- C++ -*- */
+#include "FileByteSink.h"
+#include "CharBufferByteSource.h"
+#include <errno.h>     /* for errno */
+#include <fcntl.h>     /* for open */
+#include <pthread.h>   /* for pthread_create */
+#include <stdio.h>     /* for fopen, open_memstream */
+#include <stdlib.h>    /* for calloc, free */
+#include <string.h>    /* for memcmp, strerror */
+#include <sys/mman.h>  /* for mmap */
+#include <sys/stat.h>  /* for fstat */
+#include <unistd.h>    /* for close, sysconf */
+
+namespace MFM
+{
+  static const char SNAPSHOT_MAGIC[8] = { 'M', 'F', 'M', 'S', 'N', 'A', 'P', '\n' };
+  static const char DELTA_MAGIC[8] = { 'M', 'F', 'M', 'D', 'E', 'L', 'T', 'A' };
+
+  template <class GC>
+  GridSnapshot<GC>::GridSnapshot(ExternalConfig<GC> & config,
+                                 ExternalConfigSectionGrid<GC> & gridSection)
+    : m_config(config)
+    , m_gridSection(gridSection)
+    , m_loadThreads(0)
+  { }
+
+  template <class GC>
+  bool GridSnapshot<GC>::IsSnapshotFile(const char * path)
+  {
+    FILE * file = fopen(path, "r");
+    if (!file)
+    {
+      return false;
+    }
+    char magic[sizeof(SNAPSHOT_MAGIC)];
+    bool is = fread(magic, sizeof(magic), 1, file) == 1 &&
+      (!memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) || !memcmp(magic, DELTA_MAGIC, sizeof(magic)));
+    fclose(file);
+    return is;
+  }
+
+  template <class GC>
+  void GridSnapshot<GC>::FillHeader(SnapshotHeader & header) const
+  {
+    Grid<GC> & grid = m_gridSection.GetGrid();
+    memset(&header, 0, sizeof(header));
+    memcpy(header.m_magic, SNAPSHOT_MAGIC, sizeof(header.m_magic));
+    header.m_version = SNAPSHOT_VERSION;
+    header.m_byteOrder = BYTE_ORDER_MARK;
+    header.m_bitsPerAtom = AC::BITS_PER_ATOM;
+    header.m_siteImageBytes = sizeof(SiteImage<AC>);
+    header.m_gridWidth = grid.GetWidth();
+    header.m_gridHeight = grid.GetHeight();
+    header.m_ownedWidth = Grid<GC>::OWNED_WIDTH;
+    header.m_ownedHeight = Grid<GC>::OWNED_HEIGHT;
+    header.m_layout = grid.IsGridLayoutStaggered() ? GRID_LAYOUT_STAGGERED : GRID_LAYOUT_CHECKERBOARD;
+    header.m_tileBytes = (u64) Grid<GC>::OWNED_WIDTH * Grid<GC>::OWNED_HEIGHT * sizeof(SiteImage<AC>);
+  }
+
+  template <class GC>
+  bool GridSnapshot<GC>::CheckHeader(const SnapshotHeader & header, u64 fileLength,
+                                     const char * path, u64 sitesBytes) const
+  {
+    SnapshotHeader ours;
+    FillHeader(ours);
+
+    if (header.m_version != SNAPSHOT_VERSION)
+    {
+      LOG.Error("'%s' is snapshot version %d, not %d", path, header.m_version, SNAPSHOT_VERSION);
+      return false;
+    }
+    if (header.m_byteOrder != ours.m_byteOrder ||
+        header.m_bitsPerAtom != ours.m_bitsPerAtom ||
+        header.m_siteImageBytes != ours.m_siteImageBytes)
+    {
+      LOG.Error("'%s' was saved with a different atom layout; convert it via .mfs", path);
+      return false;
+    }
+    if (header.m_gridWidth != ours.m_gridWidth ||
+        header.m_gridHeight != ours.m_gridHeight ||
+        header.m_ownedWidth != ours.m_ownedWidth ||
+        header.m_ownedHeight != ours.m_ownedHeight ||
+        header.m_layout != ours.m_layout ||
+        header.m_tileBytes != ours.m_tileBytes)
+    {
+      LOG.Error("'%s' holds a %dx%d grid of %dx%d tiles, not %dx%d of %dx%d",
+                path,
+                header.m_gridWidth, header.m_gridHeight,
+                header.m_ownedWidth, header.m_ownedHeight,
+                ours.m_gridWidth, ours.m_gridHeight,
+                ours.m_ownedWidth, ours.m_ownedHeight);
+      return false;
+    }
+    if (header.m_textOffset + header.m_textLength > fileLength ||
+        header.m_textLength > U32_MAX ||
+        header.m_typeMapOffset + 4 * (u64) header.m_typeCount > fileLength ||
+        header.m_tileTableOffset + 8 * (u64) header.m_tileCount > fileLength ||
+        header.m_sitesOffset + sitesBytes > fileLength ||
+        header.m_typeMapOffset % 4 || header.m_tileTableOffset % 4 || header.m_sitesOffset % 8)
+    {
+      LOG.Error("Snapshot '%s' is truncated or damaged", path);
+      return false;
+    }
+    return true;
+  }
+
+  template <class GC>
+  u8 * GridSnapshot<GC>::Capture(u64 & length)
+  {
+    Grid<GC> & grid = m_gridSection.GetGrid();
+
+    // The text goes first, so lay out the rest once we know its length
+    char * text = 0;
+    size_t textLength = 0;
+    FILE * textFile = open_memstream(&text, &textLength);
+    if (!textFile)
+    {
+      LOG.Error("Can't capture snapshot text: %s", strerror(errno));
+      return 0;
+    }
+    {
+      FileByteSink fs(textFile);
+      const bool sitesInText = m_gridSection.IsSitesInText();
+      m_gridSection.SetSitesInText(false);
+      m_config.Write(fs);
+      m_gridSection.SetSitesInText(sitesInText);
+      fs.Close();
+    }
+
+    SnapshotHeader header;
+    FillHeader(header);
+    ElementRegistry<EC> & registry = grid.GetElementRegistry();
+    for (u32 i = 0; i < registry.GetEntryCount(); ++i)
+    {
+      if (registry.GetRegisteredElement(i))
+      {
+        ++header.m_typeCount;
+      }
+    }
+    for (typename Grid<GC>::iterator_type i = grid.begin(); i != grid.end(); ++i)
+    {
+      ++header.m_tileCount;
+    }
+
+    header.m_textOffset = sizeof(header);
+    header.m_textLength = textLength;
+    header.m_typeMapOffset = (header.m_textOffset + header.m_textLength + 3) / 4 * 4;
+    header.m_tileTableOffset = header.m_typeMapOffset + 4 * (u64) header.m_typeCount;
+    header.m_sitesOffset = header.m_tileTableOffset + 8 * (u64) header.m_tileCount;
+    header.m_sitesOffset =
+      (header.m_sitesOffset + SITES_ALIGNMENT - 1) / SITES_ALIGNMENT * SITES_ALIGNMENT;
+    length = header.m_sitesOffset + header.m_tileCount * header.m_tileBytes;
+
+    u8 * bytes = (u8 *) calloc(length, 1);  // Zeroing the padding
+    if (!bytes)
+    {
+      LOG.Error("Can't allocate %d KB to capture snapshot", (u32) (length / 1024));
+      free(text);
+      return 0;
+    }
+
+    memcpy(bytes, &header, sizeof(header));
+    memcpy(bytes + header.m_textOffset, text, textLength);
+    free(text);
+
+    u32 * types = (u32 *) (bytes + header.m_typeMapOffset);
+    for (u32 i = 0; i < registry.GetEntryCount(); ++i)
+    {
+      Element<EC> * elt = registry.GetRegisteredElement(i);
+      if (elt)
+      {
+        *types++ = elt->GetType();
+      }
+    }
+
+    s32 * tileTable = (s32 *) (bytes + header.m_tileTableOffset);
+    SiteImage<AC> * images = (SiteImage<AC> *) (bytes + header.m_sitesOffset);
+    for (typename Grid<GC>::iterator_type i = grid.begin(); i != grid.end(); ++i)
+    {
+      *tileTable++ = i.At().GetX();
+      *tileTable++ = i.At().GetY();
+
+      const Tile<EC> & tile = *i;
+      for (u32 y = 0; y < Grid<GC>::OWNED_HEIGHT; ++y)
+      {
+        for (u32 x = 0; x < Grid<GC>::OWNED_WIDTH; ++x)
+        {
+          tile.GetUncachedSite(SPoint(x, y)).SaveImage(*images++);
+        }
+      }
+    }
+    return bytes;
+  }
+
+  template <class GC>
+  bool GridSnapshot<GC>::WriteFile(const u8 * bytes, u64 length, const char * path)
+  {
+    FILE * file = fopen(path, "w");
+    bool ok = file && fwrite(bytes, 1, length, file) == length;
+    ok = file && (fclose(file) == 0) && ok;
+    if (!ok)
+    {
+      LOG.Error("Writing snapshot '%s' failed: %s", path, strerror(errno));
+    }
+    return ok;
+  }
+
+  template <class GC>
+  bool GridSnapshot<GC>::Save(const char * path)
+  {
+    LOG.Message("Saving snapshot to: %s", path);
+    u64 length;
+    u8 * bytes = Capture(length);
+    if (!bytes)
+    {
+      return false;
+    }
+    bool ok = WriteFile(bytes, length, path);
+    free(bytes);
+    return ok;
+  }
+
+  template <class GC>
+  bool GridSnapshot<GC>::RemapAtom(T & atom, const Element<EC> * const * typeMap)
+  {
+    const Element<EC> * elt = typeMap[atom.GetType()];
+    if (!elt)
+    {
+      return false;
+    }
+    if (elt->GetType() != atom.GetType())
+    {
+      T fresh = elt->GetDefaultAtom();
+      for (u32 i = T::ATOM_FIRST_STATE_BIT; i < T::BPA; ++i)
+      {
+        fresh.GetBits().StoreBit(i, atom.GetBits().ReadBit(i));
+      }
+      atom = fresh;
+    }
+    return true;
+  }
+
+  template <class GC>
+  void * GridSnapshot<GC>::LoadRunner(void * arg)
+  {
+    LoadJob & job = *(LoadJob *) arg;
+    for (u32 t = job.m_first; t < job.m_tileCount; t += job.m_stride)
+    {
+      Tile<EC> & tile = *job.m_tiles[t];
+      const SiteImage<AC> * images = (const SiteImage<AC> *) (job.m_sites + t * job.m_tileBytes);
+      for (u32 y = 0; y < Grid<GC>::OWNED_HEIGHT; ++y)
+      {
+        for (u32 x = 0; x < Grid<GC>::OWNED_WIDTH; ++x)
+        {
+          SiteImage<AC> image = images[y * Grid<GC>::OWNED_WIDTH + x];
+          if (!RemapAtom(image.m_atom, job.m_typeMap) ||
+              !RemapAtom(image.m_baseAtom, job.m_typeMap))
+          {
+            ++job.m_unknownAtoms;
+            continue;
+          }
+          tile.GetUncachedSite(SPoint(x, y)).LoadImage(image);
+        }
+      }
+    }
+    return 0;
+  }
+
+  template <class GC>
+  bool GridSnapshot<GC>::MapFile(const char * path, MappedFile & file)
+  {
+    file.m_map = 0;
+    file.m_length = 0;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+      LOG.Error("Can't read snapshot '%s': %s", path, strerror(errno));
+      return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) || (u64) st.st_size < sizeof(SnapshotHeader))
+    {
+      LOG.Error("Snapshot '%s' is truncated or unreadable", path);
+      close(fd);
+      return false;
+    }
+    void * map = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+      LOG.Error("Can't map snapshot '%s': %s", path, strerror(errno));
+      return false;
+    }
+    file.m_map = map;
+    file.m_length = st.st_size;
+    return true;
+  }
+
+  template <class GC>
+  bool GridSnapshot<GC>::CheckTiles(const MappedFile & file, const char * path) const
+  {
+    const SnapshotHeader & header = file.GetHeader();
+    const s32 * tileTable = (const s32 *) (file.GetBytes() + header.m_tileTableOffset);
+    Grid<GC> & grid = m_gridSection.GetGrid();
+    u32 t = 0;
+    bool ok = true;
+    for (typename Grid<GC>::iterator_type i = grid.begin(); ok && i != grid.end(); ++i, ++t)
+    {
+      ok = t < header.m_tileCount &&
+        tileTable[2 * t] == i.At().GetX() &&
+        tileTable[2 * t + 1] == i.At().GetY();
+    }
+    if (!ok || t != header.m_tileCount)
+    {
+      LOG.Error("Snapshot '%s' tiles do not match the grid", path);
+      return false;
+    }
+    return true;
+  }
+
+  template <class GC>
+  bool GridSnapshot<GC>::BuildTypeMap(const MappedFile & file, const Element<EC> ** typeMap,
+                                      const char * path) const
+  {
+    const u32 TYPES = Tile<EC>::ELEMENT_TABLE_SIZE;
+    for (u32 t = 0; t < TYPES; ++t)
+    {
+      typeMap[t] = 0;
+    }
+    const SnapshotHeader & header = file.GetHeader();
+    const u32 * savedTypes = (const u32 *) (file.GetBytes() + header.m_typeMapOffset);
+    for (u32 i = 0; i < header.m_typeCount; ++i)
+    {
+      const u32 type = savedTypes[i];
+      if (type >= TYPES)
+      {
+        LOG.Error("Snapshot '%s' has bad atom type 0x%x", path, type);
+        return false;
+      }
+      OString16 nick;
+      nick.Printf("T%04x", type);
+      typeMap[type] = m_gridSection.LookupElement(nick);  // Unknown elements stay null
+    }
+    return true;
+  }
+
+  template <class GC>
+  bool GridSnapshot<GC>::LoadSites(const MappedFile & file, Tile<EC> * const * tiles,
+                                   u32 tileCount, const Element<EC> * const * typeMap,
+                                   const char * path)
+  {
+    const SnapshotHeader & header = file.GetHeader();
+
+    u32 threads = m_loadThreads;
+    if (threads == 0)
+    {
+      long cores = sysconf(_SC_NPROCESSORS_ONLN);
+      threads = cores > 0 ? (u32) cores : 1;
+    }
+    threads = MAX(1u, MIN(threads, tileCount));
+
+    LoadJob * jobs = new LoadJob[threads];
+    pthread_t * ids = new pthread_t[threads];
+    bool * started = new bool[threads];
+    for (u32 k = 0; k < threads; ++k)
+    {
+      LoadJob & job = jobs[k];
+      job.m_sites = file.GetBytes() + header.m_sitesOffset;
+      job.m_tileBytes = header.m_tileBytes;
+      job.m_tiles = tiles;
+      job.m_tileCount = tileCount;
+      job.m_first = k;
+      job.m_stride = threads;
+      job.m_typeMap = typeMap;
+      job.m_unknownAtoms = 0;
+      started[k] = k > 0 && pthread_create(&ids[k], NULL, LoadRunner, &job) == 0;
+    }
+    for (u32 k = 0; k < threads; ++k)
+    {
+      if (!started[k])
+      {
+        LoadRunner(&jobs[k]);  // On this thread, then
+      }
+    }
+    u32 unknownAtoms = 0;
+    for (u32 k = 0; k < threads; ++k)
+    {
+      if (started[k])
+      {
+        pthread_join(ids[k], NULL);
+      }
+      unknownAtoms += jobs[k].m_unknownAtoms;
+    }
+    delete [] started;
+    delete [] ids;
+    delete [] jobs;
+
+    if (unknownAtoms > 0)
+    {
+      LOG.Error("Snapshot '%s': %d sites hold atoms of unregistered elements",
+                path, unknownAtoms);
+      return false;
+    }
+    return true;
+  }
+
+  template <class GC>
+  bool GridSnapshot<GC>::ApplyChanges(const MappedFile & file, Tile<EC> * const * tiles,
+                                      u32 tileCount, const Element<EC> * const * typeMap,
+                                      const char * path)
+  {
+    const DeltaHeader & delta = *(const DeltaHeader *) file.GetBytes();
+    const SiteChange * changes =
+      (const SiteChange *) (file.GetBytes() + delta.m_base.m_sitesOffset);
+    const u32 sitesPerTile = Grid<GC>::OWNED_WIDTH * Grid<GC>::OWNED_HEIGHT;
+    for (u64 i = 0; i < delta.m_changeCount; ++i)
+    {
+      SiteChange change = changes[i];
+      if (change.m_tile >= tileCount || change.m_site >= sitesPerTile)
+      {
+        LOG.Error("Delta '%s' is damaged at change %d", path, (u32) i);
+        return false;
+      }
+      if (!RemapAtom(change.m_image.m_atom, typeMap) ||
+          !RemapAtom(change.m_image.m_baseAtom, typeMap))
+      {
+        LOG.Error("Delta '%s' holds atoms of unregistered elements", path);
+        return false;
+      }
+      const SPoint site(change.m_site % Grid<GC>::OWNED_WIDTH,
+                        change.m_site / Grid<GC>::OWNED_WIDTH);
+      tiles[change.m_tile]->GetUncachedSite(site).LoadImage(change.m_image);
+    }
+    return true;
+  }
+
+  template <class GC>
+  bool GridSnapshot<GC>::Load(const char * path)
+  {
+    Grid<GC> & grid = m_gridSection.GetGrid();
+
+    // Map path and, if it is a delta, each checkpoint before it back
+    // to their keyframe.  chain[0] is path; chain[count - 1] the keyframe.
+    MappedFile * chain = new MappedFile[MAX_DELTA_CHAIN];
+    u32 count = 0;
+    OString512 at;
+    at.Printf("%s", path);
+    bool ok = true;
+    while (ok)
+    {
+      if (count >= MAX_DELTA_CHAIN)
+      {
+        LOG.Error("'%s' is more than %d deltas past a keyframe", path, MAX_DELTA_CHAIN - 1);
+        ok = false;
+        break;
+      }
+      MappedFile & file = chain[count];
+      if (!MapFile(at.GetZString(), file))
+      {
+        ok = false;
+        break;
+      }
+      ++count;
+
+      const SnapshotHeader & header = file.GetHeader();
+      if (!memcmp(header.m_magic, SNAPSHOT_MAGIC, sizeof(header.m_magic)))
+      {
+        ok = CheckHeader(header, file.m_length, at.GetZString(),
+                         header.m_tileCount * header.m_tileBytes);
+        break;
+      }
+      if (memcmp(header.m_magic, DELTA_MAGIC, sizeof(header.m_magic)) ||
+          file.m_length < sizeof(DeltaHeader))
+      {
+        LOG.Error("'%s' is not a grid snapshot", at.GetZString());
+        ok = false;
+        break;
+      }
+
+      const DeltaHeader & delta = *(const DeltaHeader *) file.GetBytes();
+      ok = CheckHeader(header, file.m_length, at.GetZString(),
+                       delta.m_changeCount * sizeof(SiteChange));
+      if (ok && (delta.m_previousLength < 2 ||
+                 delta.m_previousOffset + delta.m_previousLength > file.m_length))
+      {
+        LOG.Error("Delta '%s' is truncated or damaged", at.GetZString());
+        ok = false;
+      }
+      if (ok)
+      {
+        // The previous checkpoint is named relative to this one's directory
+        const char * previous = (const char *) file.GetBytes() + delta.m_previousOffset;
+        const char * slash = strrchr(at.GetZString(), '/');
+        OString512 next;
+        if (previous[0] != '/' && slash)
+        {
+          next.WriteBytes((const u8 *) at.GetZString(), slash + 1 - at.GetZString());
+        }
+        next.WriteBytes((const u8 *) previous, (u32) delta.m_previousLength - 1);
+        at.Reset();
+        at.Printf("%s", next.GetZString());
+      }
+    }
+
+    if (ok)
+    {
+      LOG.Message("Loading snapshot '%s'%s", path, count > 1 ? ", with deltas" : "");
+
+      // The newest text clears the grid and registers the elements by UUID
+      const SnapshotHeader & newest = chain[0].GetHeader();
+      CharBufferByteSource text((const char *) chain[0].GetBytes() + newest.m_textOffset,
+                                (u32) newest.m_textLength);
+      m_config.SetByteSource(text, path);
+      const bool sitesInText = m_gridSection.IsSitesInText();
+      m_gridSection.SetSitesInText(false);
+      ok = m_config.Read();
+      m_gridSection.SetSitesInText(sitesInText);
+    }
+
+    u32 tileCount = 0;
+    for (typename Grid<GC>::iterator_type i = grid.begin(); i != grid.end(); ++i)
+    {
+      ++tileCount;
+    }
+    Tile<EC> ** tiles = new Tile<EC> * [tileCount];
+    tileCount = 0;
+    for (typename Grid<GC>::iterator_type i = grid.begin(); i != grid.end(); ++i)
+    {
+      tiles[tileCount++] = &*i;
+    }
+
+    const Element<EC> ** typeMap = new const Element<EC> * [Tile<EC>::ELEMENT_TABLE_SIZE];
+    for (s32 k = (s32) count - 1; ok && k >= 0; --k)
+    {
+      ok = CheckTiles(chain[k], path) &&
+        BuildTypeMap(chain[k], typeMap, path);
+      if (ok)
+      {
+        ok = k == (s32) count - 1 ?
+          LoadSites(chain[k], tiles, tileCount, typeMap, path) :
+          ApplyChanges(chain[k], tiles, tileCount, typeMap, path);
+      }
+    }
+    delete [] typeMap;
+    delete [] tiles;
+
+    for (u32 k = 0; k < count; ++k)
+    {
+      munmap(chain[k].m_map, chain[k].m_length);
+    }
+    delete [] chain;
+
+    grid.RefreshAllCaches();
+    grid.RecountAtoms();
+
+    if (ok)
+    {
+      LOG.Message("Loaded snapshot '%s'", path);
+    }
+    return ok;
+  }
+
+  template <class GC>
+  bool GridSnapshot<GC>::ContentsDiffer(const SiteImage<AC> & a, const SiteImage<AC> & b)
+  {
+    return
+      memcmp(&a.m_atom, &b.m_atom, sizeof(a.m_atom)) ||
+      memcmp(&a.m_baseAtom, &b.m_baseAtom, sizeof(a.m_baseAtom)) ||
+      a.m_paint != b.m_paint ||
+      a.m_isLiveSite != b.m_isLiveSite;
+  }
+
+  template <class GC>
+  u8 * GridSnapshot<GC>::Diff(const u8 * before, const u8 * after,
+                              const char * previousName, u64 & length)
+  {
+    MFM_API_ASSERT_NONNULL(before);
+    MFM_API_ASSERT_NONNULL(after);
+    MFM_API_ASSERT_NONNULL(previousName);
+
+    const SnapshotHeader & b = *(const SnapshotHeader *) before;
+    const SnapshotHeader & a = *(const SnapshotHeader *) after;
+    MFM_API_ASSERT_ARG(b.m_tileCount == a.m_tileCount && b.m_tileBytes == a.m_tileBytes);
+
+    const u64 sites = (u64) a.m_tileCount * Grid<GC>::OWNED_WIDTH * Grid<GC>::OWNED_HEIGHT;
+    const SiteImage<AC> * was = (const SiteImage<AC> *) (before + b.m_sitesOffset);
+    const SiteImage<AC> * is = (const SiteImage<AC> *) (after + a.m_sitesOffset);
+    u64 changeCount = 0;
+    for (u64 i = 0; i < sites; ++i)
+    {
+      if (ContentsDiffer(was[i], is[i]))
+      {
+        ++changeCount;
+      }
+    }
+
+    DeltaHeader delta;
+    memset(&delta, 0, sizeof(delta));
+    delta.m_base = a;
+    memcpy(delta.m_base.m_magic, DELTA_MAGIC, sizeof(delta.m_base.m_magic));
+    delta.m_base.m_textOffset = sizeof(delta);
+    delta.m_base.m_typeMapOffset = (delta.m_base.m_textOffset + a.m_textLength + 3) / 4 * 4;
+    delta.m_base.m_tileTableOffset = delta.m_base.m_typeMapOffset + 4 * (u64) a.m_typeCount;
+    delta.m_previousOffset = delta.m_base.m_tileTableOffset + 8 * (u64) a.m_tileCount;
+    delta.m_previousLength = strlen(previousName) + 1;
+    delta.m_base.m_sitesOffset = (delta.m_previousOffset + delta.m_previousLength + 7) / 8 * 8;
+    delta.m_changeCount = changeCount;
+    length = delta.m_base.m_sitesOffset + changeCount * sizeof(SiteChange);
+
+    u8 * bytes = (u8 *) calloc(length, 1);
+    if (!bytes)
+    {
+      LOG.Error("Can't allocate %d KB for snapshot delta", (u32) (length / 1024));
+      return 0;
+    }
+    memcpy(bytes, &delta, sizeof(delta));
+    memcpy(bytes + delta.m_base.m_textOffset, after + a.m_textOffset, a.m_textLength);
+    memcpy(bytes + delta.m_base.m_typeMapOffset, after + a.m_typeMapOffset, 4 * (u64) a.m_typeCount);
+    memcpy(bytes + delta.m_base.m_tileTableOffset, after + a.m_tileTableOffset, 8 * (u64) a.m_tileCount);
+    memcpy(bytes + delta.m_previousOffset, previousName, delta.m_previousLength);
+
+    const u32 sitesPerTile = Grid<GC>::OWNED_WIDTH * Grid<GC>::OWNED_HEIGHT;
+    SiteChange * changes = (SiteChange *) (bytes + delta.m_base.m_sitesOffset);
+    for (u64 i = 0; i < sites; ++i)
+    {
+      if (ContentsDiffer(was[i], is[i]))
+      {
+        changes->m_tile = (u32) (i / sitesPerTile);
+        changes->m_site = (u32) (i % sitesPerTile);
+        memcpy((void *) &changes->m_image, &is[i], sizeof(SiteImage<AC>));
+        ++changes;
+      }
+    }
+    return bytes;
+  }
+} /* namespace MFM */
@@ -0,0 +1,129 @@
+/*                                              -*- mode:C++ -*-
+  SnapshotWriter.h Writes captured grid snapshots on a background thread
+  Copyright (C) 2015 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file SnapshotWriter.h Writes captured grid snapshots on a background thread
+  \author David H. Ackley.
+  \date (C) 2015 All rights reserved.
+  \lgpl
+ */
+#ifndef SNAPSHOTWRITER_H
+#define SNAPSHOTWRITER_H
+
+#include "itype.h"
+#include <pthread.h>
+
+namespace MFM
+{
+  /**
+     Writes the bytes of snapshots captured by GridSnapshot::Capture
+     to disk, each on its own thread, so the grid can keep running
+     while they're written.  At most one write is in progress at a
+     time: starting another first waits for the one before.
+   */
+  class SnapshotWriter
+  {
+  public:
+    /**
+       How WriteDiff makes the bytes to write: GridSnapshot::Diff
+     */
+    typedef u8 * (*DiffFunction)(const u8 * before, const u8 * after,
+                                 const char * previousName, u64 & length);
+
+  private:
+    enum { MAX_PATH = 512 };
+
+    u8 * m_bytes;             // malloc'd; freed once written
+    u64 m_length;
+    char m_path[MAX_PATH];
+
+    DiffFunction m_diff;      // If non-null, makes m_bytes first
+    const u8 * m_before;      // The caller's, for m_diff
+    const u8 * m_after;
+    char m_previousName[MAX_PATH];
+    pthread_t m_thread;
+    bool m_running;           // m_thread needs joining
+    bool m_ok;                // How the last finished write went
+    u32 m_writeMsec;          // How long it took
+
+    SnapshotWriter(const SnapshotWriter &) ; // Declare away
+    SnapshotWriter & operator=(const SnapshotWriter &) ; // Declare away
+
+    static void * Runner(void * arg) ;
+
+    void WriteNow() ;
+
+    void Start() ;
+
+  public:
+
+    SnapshotWriter()
+      : m_bytes(0)
+      , m_length(0)
+      , m_diff(0)
+      , m_before(0)
+      , m_after(0)
+      , m_running(false)
+      , m_ok(true)
+      , m_writeMsec(0)
+    {
+      m_path[0] = '\0';
+      m_previousName[0] = '\0';
+    }
+
+    ~SnapshotWriter()
+    {
+      Finish();
+    }
+
+    /**
+       Write the length bytes at bytes, which must come from malloc,
+       to path, in the background, and free them.  Waits first for
+       any earlier write to finish.  Writes on the calling thread if
+       no background thread can be started.
+     */
+    void Write(u8 * bytes, u64 length, const char * path) ;
+
+    /**
+       Like Write, but the bytes to write are diff(before, after,
+       previousName), made in the background too.  before and after
+       remain the caller's, and must not change or be freed until
+       this write is finished.
+     */
+    void WriteDiff(DiffFunction diff, const u8 * before, const u8 * after,
+                   const char * previousName, const char * path) ;
+
+    /**
+       Wait for the write in progress, if any, to finish.  Returns
+       false if the last write failed.
+     */
+    bool Finish() ;
+
+    /**
+       Milliseconds the last finished write took.
+     */
+    u32 GetLastWriteMsec() const
+    {
+      return m_writeMsec;
+    }
+  };
+} /* namespace MFM */
+
+#endif /*SNAPSHOTWRITER_H*/
@@ -0,0 +1,126 @@
+/*                                              -*- mode:C++ -*-
+  SweepPlan.h The seeds and parameter settings of a batch of runs
+  Copyright (C) 2015 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file SweepPlan.h The seeds and parameter settings of a batch of runs
+  \author David H. Ackley.
+  \date (C) 2015 All rights reserved.
+  \lgpl
+ */
+#ifndef SWEEPPLAN_H
+#define SWEEPPLAN_H
+
+#include "itype.h"
+
+namespace MFM
+{
+  /**
+     One parameter change made before a sweep run starts.  Either a
+     tile parameter, as set by --keyvalue, or an element parameter, as
+     it would be set in an .mfs file.
+   */
+  struct SweepSetting
+  {
+    enum { MAX_SYMBOL = 3, MAX_TAG = 32, MAX_TEXT = 64 };
+
+    bool m_isTileParameter;
+    u32 m_key;                // Tile parameter key
+    s32 m_value;              // Tile parameter value
+    char m_symbol[MAX_SYMBOL];  // Element symbol, NUL-terminated
+    char m_tag[MAX_TAG];      // Element parameter tag
+    char m_text[MAX_TEXT];    // Element parameter value, as .mfs text
+  };
+
+  /**
+     One run of a sweep: a seed and the settings to apply to the
+     loaded world before running it.
+   */
+  struct SweepRun
+  {
+    enum { MAX_SETTINGS = 16, MAX_LABEL = 256 };
+
+    u32 m_seed;
+    u32 m_settingCount;
+    SweepSetting m_settings[MAX_SETTINGS];
+    char m_label[MAX_LABEL];  // The settings as written, for reports
+  };
+
+  /**
+     A list of SweepRuns, read from a text file with one run per
+     line.  Each line is a nonzero seed followed by zero or more
+     whitespace-separated settings, each either KEY:VALUE for a tile
+     parameter, or SYMBOL.TAG=VALUE for an element parameter, as in
+
+       # seed  settings
+       1       Dm.pDIFFUSION=0.5
+       2       Dm.pDIFFUSION=0.5 0:3
+
+     Blank lines and lines starting with '#' are ignored.
+   */
+  class SweepPlan
+  {
+    enum { MAX_LINE = 1024 };
+
+    SweepRun * m_runs;
+    u32 m_runCount;
+    u32 m_runCapacity;
+
+    SweepPlan(const SweepPlan &) ; // Declare away
+    SweepPlan & operator=(const SweepPlan &) ; // Declare away
+
+  public:
+
+    SweepPlan()
+      : m_runs(0)
+      , m_runCount(0)
+      , m_runCapacity(0)
+    { }
+
+    ~SweepPlan()
+    {
+      delete [] m_runs;
+    }
+
+    /**
+       Parse one non-comment line of a sweep file into run.  Returns
+       false, with error set to a description of the problem, if line
+       is not a valid run.
+     */
+    static bool ParseRun(const char * line, SweepRun & run, const char * & error) ;
+
+    /**
+       Append the runs in the file at path to this plan.  Returns
+       false, having logged the offending line, if path cannot be read
+       or contains an invalid line.
+     */
+    bool ReadFile(const char * path) ;
+
+    void AddRun(const SweepRun & run) ;
+
+    u32 GetRunCount() const
+    {
+      return m_runCount;
+    }
+
+    const SweepRun & GetRun(u32 index) const ;
+  };
+} /* namespace MFM */
+
+#endif /*SWEEPPLAN_H*/
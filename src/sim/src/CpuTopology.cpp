@@ -0,0 +1,308 @@
+#include "CpuTopology.h"
+#include "Fail.h"
+#include <sched.h>   /* for sched_getaffinity */
+#include <stdio.h>   /* for fopen, fscanf */
+#include <string.h>  /* for strcmp */
+#include <unistd.h>  /* for sysconf, syscall */
+#include <sys/syscall.h> /* for SYS_move_pages */
+
+namespace MFM
+{
+  static const char * AFFINITY_NAMES[AFFINITY_COUNT] = { "none", "compact", "spread" };
+
+  const char * CpuTopology::GetAffinityName(ThreadAffinity affinity)
+  {
+    MFM_API_ASSERT_ARG(affinity >= 0 && affinity < AFFINITY_COUNT);
+    return AFFINITY_NAMES[affinity];
+  }
+
+  bool CpuTopology::ParseAffinity(const char * name, ThreadAffinity & out)
+  {
+    for (u32 i = 0; i < AFFINITY_COUNT; ++i)
+    {
+      if (!strcmp(name, AFFINITY_NAMES[i]))
+      {
+        out = (ThreadAffinity) i;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+     Read a single unsigned number from path, or return false.
+   */
+  static bool ReadSysNumber(const char * path, u32 & out)
+  {
+    FILE * file = fopen(path, "r");
+    if (!file)
+    {
+      return false;
+    }
+    unsigned value;
+    bool ok = fscanf(file, "%u", &value) == 1;
+    fclose(file);
+    if (ok)
+    {
+      out = value;
+    }
+    return ok;
+  }
+
+  void CpuTopology::ReadFromSystem()
+  {
+    m_cpuCount = 0;
+
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed))
+    {
+      // Assume we can run on everything online
+      long cores = sysconf(_SC_NPROCESSORS_ONLN);
+      for (long c = 0; c < cores && c < CPU_SETSIZE; ++c)
+      {
+        CPU_SET(c, &allowed);
+      }
+    }
+
+    // NUMA node of each CPU, from the nodes' cpulists
+    u32 nodeOf[CPU_SETSIZE];
+    for (u32 c = 0; c < CPU_SETSIZE; ++c)
+    {
+      nodeOf[c] = 0;
+    }
+    for (u32 n = 0; n < MAX_NODES; ++n)
+    {
+      char path[100];
+      snprintf(path, sizeof(path), "/sys/devices/system/node/node%u/cpulist", n);
+      FILE * file = fopen(path, "r");
+      if (!file)
+      {
+        continue;  // Node numbers needn't be dense
+      }
+      unsigned lo, hi;
+      while (fscanf(file, "%u", &lo) == 1)
+      {
+        hi = lo;
+        int ch = fgetc(file);
+        if (ch == '-')
+        {
+          if (fscanf(file, "%u", &hi) != 1)
+          {
+            break;
+          }
+          ch = fgetc(file);
+        }
+        for (u32 c = lo; c <= hi && c < CPU_SETSIZE; ++c)
+        {
+          nodeOf[c] = n;
+        }
+        if (ch != ',')
+        {
+          break;
+        }
+      }
+      fclose(file);
+    }
+
+    for (u32 c = 0; c < CPU_SETSIZE && m_cpuCount < MAX_CPUS; ++c)
+    {
+      if (!CPU_ISSET(c, &allowed))
+      {
+        continue;
+      }
+      char path[100];
+      u32 package = 0, core = c;
+      snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/physical_package_id", c);
+      ReadSysNumber(path, package);
+      snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/core_id", c);
+      ReadSysNumber(path, core);
+      AddCpu(c, nodeOf[c], package, core);
+    }
+
+    if (m_cpuCount == 0)
+    {
+      AddCpu(0, 0, 0, 0);
+    }
+  }
+
+  void CpuTopology::AddCpu(u32 cpu, u32 node, u32 package, u32 core)
+  {
+    MFM_API_ASSERT_STATE(m_cpuCount < MAX_CPUS);
+    Cpu & c = m_cpus[m_cpuCount++];
+    c.m_cpu = cpu;
+    c.m_node = node;
+    c.m_package = package;
+    c.m_core = core;
+    c.m_smtRank = 0;
+    c.m_coreRank = 0;
+    c.m_nodeRank = 0;
+    m_nodeCount = 0;  // Need to Arrange again
+  }
+
+  void CpuTopology::ComputeRanks()
+  {
+    for (u32 i = 0; i < m_cpuCount; ++i)
+    {
+      Cpu & c = m_cpus[i];
+      c.m_smtRank = c.m_coreRank = c.m_nodeRank = 0;
+
+      // Lower-numbered nodes, and cores in our package, each count
+      // once, by their lowest-numbered CPU
+      for (u32 j = 0; j < m_cpuCount; ++j)
+      {
+        const Cpu & o = m_cpus[j];
+        bool first = true;
+        for (u32 k = 0; k < m_cpuCount; ++k)
+        {
+          const Cpu & p = m_cpus[k];
+          if (p.m_cpu < o.m_cpu && p.m_package == o.m_package && p.m_core == o.m_core)
+          {
+            first = false;
+            break;
+          }
+        }
+
+        if (o.m_package == c.m_package && o.m_core == c.m_core && o.m_cpu < c.m_cpu)
+        {
+          ++c.m_smtRank;
+        }
+        if (first && o.m_package == c.m_package && o.m_core < c.m_core)
+        {
+          ++c.m_coreRank;
+        }
+      }
+
+      for (u32 n = 0; n < c.m_node; ++n)
+      {
+        for (u32 j = 0; j < m_cpuCount; ++j)
+        {
+          if (m_cpus[j].m_node == n)
+          {
+            ++c.m_nodeRank;
+            break;
+          }
+        }
+      }
+    }
+  }
+
+  bool CpuTopology::CompactBefore(const Cpu & a, const Cpu & b)
+  {
+    if (a.m_nodeRank != b.m_nodeRank) return a.m_nodeRank < b.m_nodeRank;
+    if (a.m_package != b.m_package) return a.m_package < b.m_package;
+    if (a.m_coreRank != b.m_coreRank) return a.m_coreRank < b.m_coreRank;
+    return a.m_cpu < b.m_cpu;
+  }
+
+  bool CpuTopology::SpreadBefore(const Cpu & a, const Cpu & b)
+  {
+    if (a.m_nodeRank != b.m_nodeRank) return a.m_nodeRank < b.m_nodeRank;
+    if (a.m_smtRank != b.m_smtRank) return a.m_smtRank < b.m_smtRank;
+    if (a.m_coreRank != b.m_coreRank) return a.m_coreRank < b.m_coreRank;
+    if (a.m_package != b.m_package) return a.m_package < b.m_package;
+    return a.m_cpu < b.m_cpu;
+  }
+
+  void CpuTopology::Arrange(ThreadAffinity affinity)
+  {
+    MFM_API_ASSERT_ARG(affinity == AFFINITY_COMPACT || affinity == AFFINITY_SPREAD);
+    MFM_API_ASSERT_STATE(m_cpuCount > 0);
+
+    ComputeRanks();
+
+    // Insertion sort: there aren't many CPUs
+    for (u32 i = 1; i < m_cpuCount; ++i)
+    {
+      Cpu c = m_cpus[i];
+      u32 j = i;
+      while (j > 0 &&
+             (affinity == AFFINITY_COMPACT ?
+              CompactBefore(c, m_cpus[j - 1]) :
+              SpreadBefore(c, m_cpus[j - 1])))
+      {
+        m_cpus[j] = m_cpus[j - 1];
+        --j;
+      }
+      m_cpus[j] = c;
+    }
+
+    m_nodeCount = 0;
+    for (u32 i = 0; i < m_cpuCount; ++i)
+    {
+      const u32 rank = m_cpus[i].m_nodeRank;
+      MFM_API_ASSERT_STATE(rank < MAX_NODES);
+      if (rank >= m_nodeCount)
+      {
+        m_nodeCount = rank + 1;
+        m_nodeStart[rank] = i;
+        m_nodeSize[rank] = 0;
+      }
+      ++m_nodeSize[rank];
+    }
+    m_arrangedFor = affinity;
+  }
+
+  const CpuTopology::Cpu & CpuTopology::GetCpuForThread(u32 k, u32 count) const
+  {
+    MFM_API_ASSERT_STATE(m_nodeCount > 0);
+    MFM_API_ASSERT_ARG(k < count);
+
+    if (m_arrangedFor == AFFINITY_COMPACT)
+    {
+      // Fill CPUs in order, or share them out in runs if too few
+      const u32 idx = count > m_cpuCount ? (u32) ((u64) k * m_cpuCount / count) : k;
+      return m_cpus[idx];
+    }
+
+    // Spread: runs of consecutive threads per node, then round-robin
+    // over the node's cores, SMT siblings last
+    const u32 node = (u32) ((u64) k * m_nodeCount / count);
+    const u32 firstOnNode = (u32) (((u64) node * count + m_nodeCount - 1) / m_nodeCount);
+    const u32 j = k - firstOnNode;
+    return m_cpus[m_nodeStart[node] + j % m_nodeSize[node]];
+  }
+
+  bool CpuTopology::Pin(pthread_t thread, const Cpu & cpu)
+  {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu.m_cpu, &set);
+    return pthread_setaffinity_np(thread, sizeof(set), &set) == 0;
+  }
+
+  bool CpuTopology::MoveToNode(void * start, u32 length, u32 node)
+  {
+#ifdef SYS_move_pages
+    const long pageSize = sysconf(_SC_PAGESIZE);
+    if (pageSize <= 0)
+    {
+      return false;
+    }
+    const uptr first = ((uptr) start + pageSize - 1) / pageSize * pageSize;
+    const uptr last = ((uptr) start + length) / pageSize * pageSize;
+    if (last <= first)
+    {
+      return true;  // No whole pages to move
+    }
+    const u32 count = (u32) ((last - first) / pageSize);
+    void ** pages = new void * [count];
+    int * nodes = new int[count];
+    int * status = new int[count];
+    for (u32 i = 0; i < count; ++i)
+    {
+      pages[i] = (void *) (first + i * pageSize);
+      nodes[i] = (int) node;
+    }
+    const int MOVE_PAGES_MF_MOVE = 1 << 1;  // MPOL_MF_MOVE, from numaif.h
+    long ret = syscall(SYS_move_pages, 0, (unsigned long) count, pages, nodes, status,
+                       MOVE_PAGES_MF_MOVE);
+    delete [] pages;
+    delete [] nodes;
+    delete [] status;
+    return ret == 0;
+#else
+    return false;
+#endif
+  }
+} /* namespace MFM */
@@ -0,0 +1,114 @@
+#include "SnapshotWriter.h"
+#include "Fail.h"
+#include "Logger.h"
+#include <errno.h>   /* for errno */
+#include <stdio.h>   /* for fopen, fwrite */
+#include <stdlib.h>  /* for free */
+#include <string.h>  /* for strerror, strlen */
+#include <time.h>    /* for clock_gettime */
+
+namespace MFM
+{
+  void * SnapshotWriter::Runner(void * arg)
+  {
+    ((SnapshotWriter *) arg)->WriteNow();
+    return 0;
+  }
+
+  void SnapshotWriter::WriteNow()
+  {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    if (m_diff)
+    {
+      m_bytes = m_diff(m_before, m_after, m_previousName, m_length);
+      m_diff = 0;
+      m_before = m_after = 0;
+      if (!m_bytes)
+      {
+        m_ok = false;
+        LOG.Error("Making snapshot delta '%s' failed", m_path);
+        return;
+      }
+    }
+
+    FILE * file = fopen(m_path, "w");
+    bool ok = file && fwrite(m_bytes, 1, m_length, file) == m_length;
+    ok = file && (fclose(file) == 0) && ok;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    m_writeMsec = (u32) ((end.tv_sec - start.tv_sec) * 1000 +
+                         (end.tv_nsec - start.tv_nsec) / 1000000);
+    m_ok = ok;
+
+    if (ok)
+    {
+      LOG.Message("Wrote snapshot '%s' (%d KB) in %d ms",
+                  m_path, (u32) (m_length / 1024), m_writeMsec);
+    }
+    else
+    {
+      LOG.Error("Writing snapshot '%s' failed: %s", m_path, strerror(errno));
+    }
+
+    free(m_bytes);
+    m_bytes = 0;
+  }
+
+  void SnapshotWriter::Write(u8 * bytes, u64 length, const char * path)
+  {
+    MFM_API_ASSERT_NONNULL(bytes);
+    MFM_API_ASSERT_NONNULL(path);
+    MFM_API_ASSERT_ARG(strlen(path) < MAX_PATH);
+
+    Finish();
+
+    m_bytes = bytes;
+    m_length = length;
+    strcpy(m_path, path);
+    Start();
+  }
+
+  void SnapshotWriter::WriteDiff(DiffFunction diff, const u8 * before, const u8 * after,
+                                 const char * previousName, const char * path)
+  {
+    MFM_API_ASSERT_NONNULL(diff);
+    MFM_API_ASSERT_NONNULL(before);
+    MFM_API_ASSERT_NONNULL(after);
+    MFM_API_ASSERT_NONNULL(previousName);
+    MFM_API_ASSERT_NONNULL(path);
+    MFM_API_ASSERT_ARG(strlen(path) < MAX_PATH && strlen(previousName) < MAX_PATH);
+
+    Finish();
+
+    m_diff = diff;
+    m_before = before;
+    m_after = after;
+    strcpy(m_previousName, previousName);
+    m_bytes = 0;
+    m_length = 0;
+    strcpy(m_path, path);
+    Start();
+  }
+
+  void SnapshotWriter::Start()
+  {
+    m_running = pthread_create(&m_thread, NULL, Runner, this) == 0;
+    if (!m_running)
+    {
+      LOG.Warning("No background thread for snapshot '%s'; writing it now", m_path);
+      WriteNow();
+    }
+  }
+
+  bool SnapshotWriter::Finish()
+  {
+    if (m_running)
+    {
+      pthread_join(m_thread, NULL);
+      m_running = false;
+    }
+    return m_ok;
+  }
+} /* namespace MFM */
@@ -0,0 +1,227 @@
+#include "SweepPlan.h"
+#include "Fail.h"
+#include "Logger.h"
+#include <ctype.h>   /* for isspace */
+#include <errno.h>   /* for errno */
+#include <stdio.h>   /* for fopen, fgets */
+#include <stdlib.h>  /* for strtoul, strtol */
+#include <string.h>  /* for strchr, strlen */
+
+namespace MFM
+{
+  /**
+     Copy the length characters at from into to, NUL-terminated, if
+     they fit in size bytes and there is at least one of them.
+   */
+  static bool CopyField(char * to, u32 size, const char * from, u32 length)
+  {
+    if (length == 0 || length >= size)
+    {
+      return false;
+    }
+    memcpy(to, from, length);
+    to[length] = '\0';
+    return true;
+  }
+
+  static bool ParseSetting(const char * token, u32 length, SweepSetting & s, const char * & error)
+  {
+    char buf[SweepRun::MAX_LABEL];
+    if (!CopyField(buf, sizeof(buf), token, length))
+    {
+      error = "Setting too long";
+      return false;
+    }
+
+    const char * eq = strchr(buf, '=');
+    const char * dot = strchr(buf, '.');
+    if (eq)
+    {
+      if (!dot || dot > eq)
+      {
+        error = "Expected SYMBOL.TAG=VALUE";
+        return false;
+      }
+      s.m_isTileParameter = false;
+      s.m_key = 0;
+      s.m_value = 0;
+      if (!CopyField(s.m_symbol, sizeof(s.m_symbol), buf, dot - buf))
+      {
+        error = "Bad element symbol";
+        return false;
+      }
+      if (!CopyField(s.m_tag, sizeof(s.m_tag), dot + 1, eq - dot - 1))
+      {
+        error = "Bad parameter tag";
+        return false;
+      }
+      if (!CopyField(s.m_text, sizeof(s.m_text), eq + 1, strlen(eq + 1)))
+      {
+        error = "Bad parameter value";
+        return false;
+      }
+      return true;
+    }
+
+    const char * colon = strchr(buf, ':');
+    if (!colon)
+    {
+      error = "Expected KEY:VALUE or SYMBOL.TAG=VALUE";
+      return false;
+    }
+    char * end;
+    errno = 0;
+    unsigned long key = strtoul(buf, &end, 10);
+    if (end != colon || end == buf || errno || key > U32_MAX)
+    {
+      error = "Bad tile parameter key";
+      return false;
+    }
+    long value = strtol(colon + 1, &end, 10);
+    if (*end != '\0' || end == colon + 1 || errno || value < S32_MIN || value > S32_MAX)
+    {
+      error = "Bad tile parameter value";
+      return false;
+    }
+    s.m_isTileParameter = true;
+    s.m_key = (u32) key;
+    s.m_value = (s32) value;
+    s.m_symbol[0] = s.m_tag[0] = s.m_text[0] = '\0';
+    return true;
+  }
+
+  bool SweepPlan::ParseRun(const char * line, SweepRun & run, const char * & error)
+  {
+    MFM_API_ASSERT_NONNULL(line);
+
+    run.m_seed = 0;
+    run.m_settingCount = 0;
+    run.m_label[0] = '\0';
+
+    if (strchr(line, '"') || strchr(line, ','))
+    {
+      error = "Quotes and commas are not allowed";
+      return false;
+    }
+
+    const char * p = line;
+    while (isspace(*p)) ++p;
+
+    char * end;
+    errno = 0;
+    unsigned long seed = strtoul(p, &end, 10);
+    if (end == p || errno || seed == 0 || seed > U32_MAX || (*end && !isspace(*end)))
+    {
+      error = "Expected a nonzero seed";
+      return false;
+    }
+    run.m_seed = (u32) seed;
+    p = end;
+
+    u32 labelLength = 0;
+    while (true)
+    {
+      while (isspace(*p)) ++p;
+      if (!*p)
+      {
+        break;
+      }
+      const char * token = p;
+      while (*p && !isspace(*p)) ++p;
+      const u32 length = p - token;
+
+      if (run.m_settingCount >= SweepRun::MAX_SETTINGS)
+      {
+        error = "Too many settings";
+        return false;
+      }
+      if (!ParseSetting(token, length, run.m_settings[run.m_settingCount], error))
+      {
+        return false;
+      }
+      ++run.m_settingCount;
+
+      if (labelLength + length + 1 >= SweepRun::MAX_LABEL)
+      {
+        error = "Settings too long";
+        return false;
+      }
+      if (labelLength > 0)
+      {
+        run.m_label[labelLength++] = ' ';
+      }
+      memcpy(&run.m_label[labelLength], token, length);
+      labelLength += length;
+      run.m_label[labelLength] = '\0';
+    }
+    return true;
+  }
+
+  bool SweepPlan::ReadFile(const char * path)
+  {
+    MFM_API_ASSERT_NONNULL(path);
+    FILE * file = fopen(path, "r");
+    if (!file)
+    {
+      LOG.Error("Can't read sweep file '%s': %s", path, strerror(errno));
+      return false;
+    }
+
+    char line[MAX_LINE];
+    u32 lineNumber = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), file))
+    {
+      ++lineNumber;
+      u32 len = strlen(line);
+      if (len == sizeof(line) - 1 && line[len - 1] != '\n')
+      {
+        LOG.Error("%s:%d: Line too long", path, lineNumber);
+        ok = false;
+        break;
+      }
+
+      const char * p = line;
+      while (isspace(*p)) ++p;
+      if (!*p || *p == '#')
+      {
+        continue;
+      }
+
+      SweepRun run;
+      const char * error = "";
+      if (!ParseRun(p, run, error))
+      {
+        LOG.Error("%s:%d: %s", path, lineNumber, error);
+        ok = false;
+        break;
+      }
+      AddRun(run);
+    }
+    fclose(file);
+    return ok;
+  }
+
+  void SweepPlan::AddRun(const SweepRun & run)
+  {
+    if (m_runCount >= m_runCapacity)
+    {
+      const u32 capacity = m_runCapacity ? 2 * m_runCapacity : 16;
+      SweepRun * runs = new SweepRun[capacity];
+      for (u32 i = 0; i < m_runCount; ++i)
+      {
+        runs[i] = m_runs[i];
+      }
+      delete [] m_runs;
+      m_runs = runs;
+      m_runCapacity = capacity;
+    }
+    m_runs[m_runCount++] = run;
+  }
+
+  const SweepRun & SweepPlan::GetRun(u32 index) const
+  {
+    MFM_API_ASSERT_ARG(index < m_runCount);
+    return m_runs[index];
+  }
+} /* namespace MFM */
@@ -35,6 +35,14 @@ namespace MFM {
 
     static void Test_bitVectorPopulationCount();
 
+    static void Test_bitVectorFixedFields();
+
+    /**
+     * Wall-clock timings, for mfmbench rather than mfmtest: reading
+     * the 16 type bits of a block of atom-sized vectors through the
+     * runtime Read and through Read<POS,LEN>
+     */
+    static void Test_RunBenchmarks();
   };
 } /* namespace MFM */
 #endif /*BITVECTOR_TEST_H*/
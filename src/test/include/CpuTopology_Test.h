@@ -0,0 +1,23 @@
+#ifndef CPUTOPOLOGY_TEST_H      /* -*- C++ -*- */
+#define CPUTOPOLOGY_TEST_H
+
+#include "Test_Common.h"
+
+namespace MFM {
+
+  /**
+   * Tests for mapping tile threads onto CPUs by topology
+   */
+  class CpuTopology_Test
+  {
+  private:
+    static void Test_cpuTopologyParse();
+    static void Test_cpuTopologyCompact();
+    static void Test_cpuTopologySpread();
+    static void Test_cpuTopologyGridPinning();
+
+  public:
+    static void Test_RunTests();
+  };
+} /* namespace MFM */
+#endif /*CPUTOPOLOGY_TEST_H*/
@@ -16,7 +16,18 @@ public:
 
   static void Test_EventWindowWrite();
 
+  static void Test_EventWindowDirtySites();
+
+  static void Test_EventWindowEmptyFastPath();
+
+  static void Test_EventWindowTypeMatches();
+
   static void Test_RunTests();
+
+  /**
+   * Wall-clock timings, for mfmbench rather than mfmtest
+   */
+  static void Test_RunBenchmarks();
 };
 } /* namespace MFM */
 #endif /*EVENTWINDOW_TEST_H*/
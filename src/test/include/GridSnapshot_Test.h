@@ -0,0 +1,29 @@
+#ifndef GRIDSNAPSHOT_TEST_H      /* -*- C++ -*- */
+#define GRIDSNAPSHOT_TEST_H
+
+#include "Test_Common.h"
+
+namespace MFM {
+
+  /**
+   * Tests for binary grid snapshots and their round trip to .mfs
+   */
+  class GridSnapshot_Test
+  {
+  private:
+    static void Test_gridSnapshotRoundTrip();
+    static void Test_gridSnapshotRejects();
+    static void Test_gridSnapshotBackgroundWrite();
+    static void Test_gridSnapshotDeltas();
+    static void Test_gridSnapshotSparseDeltas();
+
+  public:
+    static void Test_RunTests();
+
+    /**
+     * Wall-clock timings, for mfmbench rather than mfmtest
+     */
+    static void Test_RunBenchmarks();
+  };
+} /* namespace MFM */
+#endif /*GRIDSNAPSHOT_TEST_H*/
@@ -9,12 +9,30 @@
 namespace MFM {
 
   /**
-   * Tests for the Grid class
+   * Tests and benchmarks for the Grid class
    */
   class Grid_Test
   {
   public:
     static void Test_gridPlaceAtom();
+    static void Test_gridPauseUnpause();
+    static void Test_gridPauseWhilePaused();
+    static void Test_gridWorkerPool();
+    static void Test_gridWorkerSteal();
+    static void Test_gridActiveSiteSelection();
+    static void Test_gridSharedCacheChannels();
+    static void Test_gridCacheDeltaEncoding();
+    static void Test_gridCacheSpotChecks();
+    static void Test_gridCacheDeltaRepair();
+    static void Test_gridConcurrentWindows();
+    static void Test_gridDeterministic();
+    static void Test_gridSequential();
+    static void Test_gridIncrementalAtomCounts();
+
+    /**
+     * Wall-clock timings, for mfmbench rather than mfmtest
+     */
+    static void Test_RunBenchmarks();
   };
 } /* namespace MFM */
 #endif /*GRID_TEST_H*/
@@ -0,0 +1,19 @@
+#ifndef LONGLIVEDLOCK_TEST_H      /* -*- C++ -*- */
+#define LONGLIVEDLOCK_TEST_H
+
+#include "LonglivedLock.h"
+
+namespace MFM {
+
+  class LonglivedLock_Test
+  {
+  private:
+    static void Test_longlivedLockOwnership();
+    static void Test_longlivedLockCounters();
+    static void Test_longlivedLockContention();
+
+  public:
+    static void Test_RunTests();
+  };
+} /* namespace MFM */
+#endif /*LONGLIVEDLOCK_TEST_H*/
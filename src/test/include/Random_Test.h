@@ -10,9 +10,16 @@ namespace MFM {
     static Random & setup();
     static void Test_randomSetSeed();
     static void Test_randomDeterministics();
+    static void Test_randomFill();
+    static void Test_randomSplit();
 
   public:
     static void Test_RunTests();
+
+    /**
+     * Wall-clock timings, for mfmbench rather than mfmtest
+     */
+    static void Test_RunBenchmarks();
   };
 }
 #endif /*RANDOM_TEST_H*/
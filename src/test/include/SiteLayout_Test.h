@@ -0,0 +1,29 @@
+#ifndef SITELAYOUT_TEST_H      /* -*- C++ -*- */
+#define SITELAYOUT_TEST_H
+
+#include "Test_Common.h"
+
+namespace MFM {
+
+  /**
+   * Tests for the array-of-structures (Site) and
+   * structure-of-arrays (SoASite) tile storage layouts, with and
+   * without per-site event statistics
+   */
+  class SiteLayout_Test
+  {
+  private:
+    static void Test_siteLayoutSoAAccess();
+    static void Test_siteLayoutSaveLoad();
+    static void Test_siteLayoutNoStats();
+
+  public:
+    static void Test_RunTests();
+
+    /**
+     * Wall-clock timings, for mfmbench rather than mfmtest
+     */
+    static void Test_RunBenchmarks();
+  };
+} /* namespace MFM */
+#endif /*SITELAYOUT_TEST_H*/
@@ -0,0 +1,22 @@
+#ifndef SWEEPPLAN_TEST_H      /* -*- C++ -*- */
+#define SWEEPPLAN_TEST_H
+
+#include "Test_Common.h"
+
+namespace MFM {
+
+  /**
+   * Tests for reading the runs of a parameter sweep
+   */
+  class SweepPlan_Test
+  {
+  private:
+    static void Test_sweepPlanParseRun();
+    static void Test_sweepPlanParseErrors();
+    static void Test_sweepPlanReadFile();
+
+  public:
+    static void Test_RunTests();
+  };
+} /* namespace MFM */
+#endif /*SWEEPPLAN_TEST_H*/
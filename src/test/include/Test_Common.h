@@ -7,6 +7,8 @@
 #include "ElementTable.h"
 #include "EventWindow.h"
 #include "SizedTile.h"
+#include "SoASite.h"
+#include <time.h>     /* For timespec */
 
 namespace MFM {
 
@@ -23,9 +25,28 @@ namespace MFM {
   typedef Grid<TestGridConfig> TestGrid;
   typedef TestGrid::GridTile TestTile;
 
+  /* The same, but with structure-of-arrays site storage */
+  typedef SoASite<P3AtomConfig> SoATestSite;
+  typedef EventConfig<SoATestSite, 4> SoATestEventConfig;
+  typedef GridConfig<SoATestEventConfig,40,40,1000> SoATestGridConfig;
+  typedef Grid<SoATestGridConfig> SoATestGrid;
+
+  /* The same, but without per-site event statistics */
+  typedef Site<P3AtomConfig,false> NoStatsTestSite;
+  typedef EventConfig<NoStatsTestSite, 4> NoStatsTestEventConfig;
+  typedef GridConfig<NoStatsTestEventConfig,40,40,1000> NoStatsTestGridConfig;
+  typedef Grid<NoStatsTestGridConfig> NoStatsTestGrid;
+  typedef SoASite<P3AtomConfig,false> NoStatsSoATestSite;
+
   typedef ElementTable<TestEventConfig> TestElementTable;
   typedef EventWindow<TestEventConfig> TestEventWindow;
 
+  /**
+     Milliseconds of CLOCK_MONOTONIC time since start, for the
+     timings tests and benchmarks log.
+   */
+  u32 ElapsedMsec(const timespec & start);
+
 } /* namespace MFM */
 
 #endif /*TEST_COMMON_H*/
@@ -30,5 +30,11 @@
 #include "ColorMap_Test.h"
 #include "FXP_Test.h"
 #include "ExternalConfig_Test.h"
+#include "LonglivedLock_Test.h"
+#include "SiteLayout_Test.h"
+#include "CpuTopology_Test.h"
+#include "SweepPlan_Test.h"
+#include "GridSnapshot_Test.h"
+#include "UlamClassRegistry_Test.h"
 
 #endif /*TESTS_H*/
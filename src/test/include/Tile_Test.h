@@ -15,6 +15,7 @@ namespace MFM {
 
     static void Test_tilePlaceAtom();
     static void Test_tileSquareDistances();
+    static void Test_tileActiveSiteSelection();
   };
 } /* namespace MFM */
 
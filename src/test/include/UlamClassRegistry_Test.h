@@ -0,0 +1,30 @@
+#ifndef ULAMCLASSREGISTRY_TEST_H      /* -*- C++ -*- */
+#define ULAMCLASSREGISTRY_TEST_H
+
+#include "Test_Common.h"
+
+namespace MFM {
+
+  /**
+   * Tests for finding registered ulam classes by mangled name, and
+   * for the cache of their resolved virtual calls
+   */
+  class UlamClassRegistry_Test
+  {
+  private:
+    static void Test_ulamClassRegistryLookup();
+    static void Test_ulamClassRegistryBenchmark();
+    static void Test_ulamVTableCache();
+    static void Test_ulamVTableCacheCalls();
+    static void Test_ulamVTableCacheBenchmark();
+
+  public:
+    static void Test_RunTests();
+
+    /**
+     * Wall-clock timings, for mfmbench rather than mfmtest
+     */
+    static void Test_RunBenchmarks();
+  };
+} /* namespace MFM */
+#endif /*ULAMCLASSREGISTRY_TEST_H*/
@@ -1,6 +1,11 @@
 #include "assert.h"
 #include "BitVector_Test.h"
+#include "Test_Common.h"  /* For ElapsedMsec */
 #include "itype.h"
+#include "BitField.h"
+#include "Random.h"
+#include "Logger.h"
+#include <time.h>     /* For clock_gettime */
 
 namespace MFM {
   const u32 vals[8] =
@@ -36,6 +41,7 @@ namespace MFM {
     Test_bitVectorStoreBits();
     Test_bitVectorReadWriteBV();
     Test_bitVectorPopulationCount();
+    Test_bitVectorFixedFields();
   }
 
   static BitVector<256> bits(vals);
@@ -503,4 +509,101 @@ namespace MFM {
     }
   }
 
+  /**
+     Check Read<POS,LEN> and Write<POS,LEN> against the runtime
+     Read and Write on a field, and that writing it leaves the rest
+     of the vector alone.
+   */
+  template <u32 POS, u32 LEN>
+  static void CheckFixedField()
+  {
+    BitVector<256> bv(vals);
+    const BitVector<256> orig(vals);
+    assert((bv.Read<POS,LEN>() == bv.Read(POS, LEN)));
+
+    const u32 value = 0x9e3779b9;
+    bv.Write<POS,LEN>(value);
+    assert((bv.Read<POS,LEN>() == (value & MakeMaskClip(LEN))));
+    assert(bv.Read(POS, LEN) == (value & MakeMaskClip(LEN)));
+    for (u32 i = 0; i < 256; ++i)
+    {
+      if (i < POS || i >= POS + LEN)
+      {
+        assert(bv.ReadBit(i) == orig.ReadBit(i));
+      }
+    }
+
+    BitVector<256> lv(vals);
+    const u64 lvalue = HexU64(0x0123456f, 0xedcba987);
+    lv.WriteLong<POS,LEN>(lvalue);
+    assert((lv.ReadLong<POS,LEN>() == lv.ReadLong(POS, LEN)));
+  }
+
+  void BitVector_Test::Test_bitVectorFixedFields()
+  {
+    CheckFixedField<0,0>();
+    CheckFixedField<0,1>();
+    CheckFixedField<0,32>();
+    CheckFixedField<9,16>();    // P3Atom type bits, within a unit
+    CheckFixedField<31,1>();
+    CheckFixedField<31,2>();    // Straddles
+    CheckFixedField<20,32>();
+    CheckFixedField<33,31>();
+    CheckFixedField<64,32>();
+    CheckFixedField<100,13>();
+    CheckFixedField<224,32>();  // The last unit
+
+    BitVector<256> bv(vals);
+    assert((bv.ReadLong<10,64>() == bv.ReadLong(10, 64)));
+    bv.WriteLong<190,64>(HexU64(0xfedcba98, 0x76543210));
+    assert(bv.ReadLong(190, 64) == HexU64(0xfedcba98, 0x76543210));
+
+    // BitField accessors compile to the fixed-position ones
+    typedef BitField<BV96, VD::U32, 16, 9> TypeField;
+    BV96 atom;
+    TypeField::Write(atom, 0xbeef);
+    assert(atom.Read(9, 16) == 0xbeef);
+    assert(TypeField::Read(atom) == 0xbeef);
+  }
+
+  void BitVector_Test::Test_RunBenchmarks()
+  {
+    const u32 ATOMS = 4096;
+    const u32 PASSES = 2000;
+    static BV96 atoms[ATOMS];
+    Random random(1);
+    for (u32 i = 0; i < ATOMS; ++i)
+    {
+      atoms[i].Write(9, 16, random.Create(1 << 16));
+    }
+
+    volatile u32 pos = 9, len = 16; // Keep the runtime reads runtime
+    u32 sumRuntime = 0, sumFixed = 0;
+    timespec start;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (u32 p = 0; p < PASSES; ++p)
+    {
+      for (u32 i = 0; i < ATOMS; ++i)
+      {
+        sumRuntime += atoms[i].Read(pos, len);
+      }
+    }
+    const u32 runtimeMsec = ElapsedMsec(start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (u32 p = 0; p < PASSES; ++p)
+    {
+      for (u32 i = 0; i < ATOMS; ++i)
+      {
+        sumFixed += atoms[i].Read<9,16>();
+      }
+    }
+    const u32 fixedMsec = ElapsedMsec(start);
+
+    assert(sumRuntime == sumFixed);
+    LOG.Message("BitVector 16-bit field reads, %d M: Read(pos,len) %d ms, Read<POS,LEN> %d ms",
+                (ATOMS * PASSES) >> 20, runtimeMsec, fixedMsec);
+  }
+
 } /* namespace MFM */
@@ -0,0 +1,123 @@
+#include "assert.h"
+#include "CpuTopology_Test.h"
+#include "CpuTopology.h"
+#include "Grid.h"
+
+namespace MFM {
+
+  void CpuTopology_Test::Test_RunTests() {
+    Test_cpuTopologyParse();
+    Test_cpuTopologyCompact();
+    Test_cpuTopologySpread();
+    Test_cpuTopologyGridPinning();
+  }
+
+  /**
+   * Two nodes, each one package of two cores with two hardware
+   * threads, numbered the way Linux usually does: the SMT siblings
+   * of cpus 0-3 are cpus 4-7.
+   */
+  static void MakeTwoNodeTopology(CpuTopology & topo)
+  {
+    for (u32 cpu = 0; cpu < 8; ++cpu)
+    {
+      const u32 phys = cpu % 4;      // Physical core, machine-wide
+      const u32 node = phys / 2;
+      topo.AddCpu(cpu, node, node, phys % 2);
+    }
+  }
+
+  void CpuTopology_Test::Test_cpuTopologyParse()
+  {
+    ThreadAffinity ta = AFFINITY_NONE;
+    assert(CpuTopology::ParseAffinity("compact", ta) && ta == AFFINITY_COMPACT);
+    assert(CpuTopology::ParseAffinity("spread", ta) && ta == AFFINITY_SPREAD);
+    assert(CpuTopology::ParseAffinity("none", ta) && ta == AFFINITY_NONE);
+    assert(!CpuTopology::ParseAffinity("scattered", ta) && ta == AFFINITY_NONE);
+    assert(!strcmp(CpuTopology::GetAffinityName(AFFINITY_SPREAD), "spread"));
+
+    CpuTopology topo;
+    topo.ReadFromSystem();
+    assert(topo.GetCpuCount() > 0);
+    topo.Arrange(AFFINITY_COMPACT);
+    assert(topo.GetNodeCount() > 0);
+  }
+
+  void CpuTopology_Test::Test_cpuTopologyCompact()
+  {
+    CpuTopology topo;
+    MakeTwoNodeTopology(topo);
+    topo.Arrange(AFFINITY_COMPACT);
+    assert(topo.GetNodeCount() == 2);
+
+    // Few threads: fill the first core's siblings, then its neighbor
+    const u32 expect[4] = { 0, 4, 1, 5 };
+    for (u32 k = 0; k < 4; ++k)
+    {
+      assert(topo.GetCpuForThread(k, 4).m_cpu == expect[k]);
+    }
+
+    // Many threads: runs of neighbors per CPU, all of node 0 first
+    for (u32 k = 0; k < 16; ++k)
+    {
+      const CpuTopology::Cpu & cpu = topo.GetCpuForThread(k, 16);
+      assert(cpu.m_node == (k < 8 ? 0u : 1u));
+      if (k & 1)
+      {
+        assert(cpu.m_cpu == topo.GetCpuForThread(k - 1, 16).m_cpu);
+      }
+    }
+  }
+
+  void CpuTopology_Test::Test_cpuTopologySpread()
+  {
+    CpuTopology topo;
+    MakeTwoNodeTopology(topo);
+    topo.Arrange(AFFINITY_SPREAD);
+
+    // Two threads: one per node
+    assert(topo.GetCpuForThread(0, 2).m_node == 0);
+    assert(topo.GetCpuForThread(1, 2).m_node == 1);
+
+    // Four threads: every physical core, no SMT siblings
+    const u32 expect[4] = { 0, 1, 2, 3 };
+    for (u32 k = 0; k < 4; ++k)
+    {
+      assert(topo.GetCpuForThread(k, 4).m_cpu == expect[k]);
+    }
+
+    // Eight threads: siblings only once the cores are used
+    const u32 expect8[8] = { 0, 1, 4, 5, 2, 3, 6, 7 };
+    for (u32 k = 0; k < 8; ++k)
+    {
+      assert(topo.GetCpuForThread(k, 8).m_cpu == expect8[k]);
+    }
+  }
+
+  void CpuTopology_Test::Test_cpuTopologyGridPinning()
+  {
+    ElementRegistry<TestEventConfig> ereg;
+    TestGrid grid(ereg,3,2, (GridLayoutPattern) GRID_LAYOUT_CHECKERBOARD);
+
+    grid.SetSeed(1);
+    grid.SetThreadAffinity(AFFINITY_COMPACT);
+    assert(grid.GetThreadAffinity() == AFFINITY_COMPACT);
+    grid.Init();
+    grid.InitThreads();
+
+    for (u32 x = 0; x < 3; ++x)
+    {
+      for (u32 y = 0; y < 2; ++y)
+      {
+        assert(grid.GetTileCpu(x, y) >= 0);
+      }
+    }
+
+    grid.Unpause();
+    SleepMsec(20);
+    grid.Pause();
+    assert(grid.GetTotalEventsExecuted() > 0);
+
+    grid.ShutdownTileThreads();
+  }
+} /* namespace MFM */
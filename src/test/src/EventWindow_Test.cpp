@@ -6,6 +6,9 @@
 #include "EventWindow_Test.h"
 #include "EventWindow.h"
 #include "Point.h"
+#include "WindowScanner.h"
+#include "Logger.h"
+#include <time.h>     /* For clock_gettime */
 
 namespace MFM {
 
@@ -14,6 +17,9 @@ namespace MFM {
     Test_EventWindowConstruction();
     Test_EventWindowNoLockOpen();
     Test_EventWindowWrite();
+    Test_EventWindowDirtySites();
+    Test_EventWindowEmptyFastPath();
+    Test_EventWindowTypeMatches();
   }
 
   void EventWindow_Test::Test_EventWindowConstruction()
@@ -107,4 +113,254 @@ namespace MFM {
 
   }
 
+  void EventWindow_Test::Test_EventWindowDirtySites()
+  {
+    TestTile tile;
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Element_Res<TestEventConfig>::THE_INSTANCE.AllocateTypeForTesting(etnm);
+    Element_Wall<TestEventConfig>::THE_INSTANCE.AllocateTypeForTesting(etnm);
+    tile.RegisterElement(Element_Res<TestEventConfig>::THE_INSTANCE);
+    tile.RegisterElement(Element_Wall<TestEventConfig>::THE_INSTANCE);
+
+    const u32 WALL_TYPE = Element_Wall<TestEventConfig>::THE_INSTANCE.GetType();
+    const u32 RES_TYPE = Element_Res<TestEventConfig>::THE_INSTANCE.GetType();
+
+    // One window wholly owned, so gathered by offset, and one that
+    // reaches into the cache, so checked site by site
+    const SPoint centers[2] = { SPoint(15, 20), SPoint(6, 6) };
+    const SPoint east(1, 0), southwest(-2, 1);
+
+    for (u32 c = 0; c < 2; ++c)
+    {
+      const SPoint & center = centers[c];
+      tile.PlaceAtom(TestAtom(WALL_TYPE,0,0,0), center);
+      tile.PlaceAtom(TestAtom(WALL_TYPE,0,0,0), center + southwest);
+
+      TestEventWindow & ew = tile.GetEventWindow();
+      assert(ew.InitForEvent(center, false));
+      assert(ew.GetRelativeAtomDirect(southwest).GetType() == WALL_TYPE);
+      assert(ew.IsLiveSiteDirect(east));
+
+      for (u32 i = 0; i < ew.GetBoundedSiteCount(); ++i)
+      {
+        assert(!ew.IsSiteDirty(i));
+      }
+
+      ew.SetRelativeAtomDirect(east, TestAtom(RES_TYPE,0,0,0));
+      const u32 eastIdx = ew.MapToIndexDirectValid(east);
+      for (u32 i = 0; i < ew.GetBoundedSiteCount(); ++i)
+      {
+        assert(ew.IsSiteDirty(i) == (i == eastIdx));
+      }
+
+      // A clean site is not stored, so this change behind the
+      // window's back survives
+      tile.PlaceAtom(TestAtom(RES_TYPE,0,0,0), center + southwest);
+
+      ew.StoreToTile();
+      ew.SetFree();
+
+      assert(tile.GetAtom(center + east)->GetType() == RES_TYPE);
+      assert(tile.GetAtom(center + southwest)->GetType() == RES_TYPE);
+      assert(tile.GetAtom(center)->GetType() == WALL_TYPE);
+    }
+  }
+
+  void EventWindow_Test::Test_EventWindowEmptyFastPath()
+  {
+    TestTile tile;
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Element_Wall<TestEventConfig>::THE_INSTANCE.AllocateTypeForTesting(etnm);
+    tile.RegisterElement(Element_Wall<TestEventConfig>::THE_INSTANCE);
+
+    TestEventWindow & ew = tile.GetEventWindow();
+    ew.SetEventWindowsExecuted(1000000); // make event 0 look very old to avoid recency reject
+
+    SPoint center(15, 20);
+    assert(tile.GetAtom(center)->GetType() == TestAtom::ATOM_EMPTY_TYPE);
+
+    // Empty centers count as executed events, without a window load
+    const u64 executed = ew.GetEventWindowsExecuted();
+    assert(ew.TryEventAt(center));
+    assert(ew.IsFree());
+    assert(ew.GetEventWindowsExecuted() == executed + 1);
+    assert(ew.GetEmptyCenterEvents() == 1);
+    assert(tile.GetSite(center).GetEventCount() == 1);
+
+    // Occupied centers take the full path.  (Use a fresh site, which
+    // RejectOnRecency can't refuse.)
+    const u32 WALL_TYPE = Element_Wall<TestEventConfig>::THE_INSTANCE.GetType();
+    SPoint other(16, 20);
+    tile.PlaceAtom(TestAtom(WALL_TYPE,0,0,0), other);
+    assert(ew.TryEventAt(other));
+    assert(ew.GetEventWindowsExecuted() == executed + 2);
+    assert(ew.GetEmptyCenterEvents() == 1);
+    assert(tile.GetEmptyCenterEvents() == 1);
+
+    // Empty centers are filtered on recency like any other: at the
+    // default warp, a site that just had an event is mostly refused
+    u32 accepted = 0;
+    u32 refused = 0;
+    for (u32 i = 0; i < 100; ++i)
+    {
+      if (ew.TryEventAt(center))
+      {
+        ++accepted;
+      }
+      else
+      {
+        ++refused;
+      }
+      assert(ew.IsFree());
+    }
+    assert(accepted > 0);
+    assert(refused > accepted);
+    assert(ew.GetEmptyCenterEvents() == 1 + accepted);
+    assert(ew.GetEventWindowsExecuted() == executed + 2 + accepted);
+  }
+
+  /**
+     The per-site scan WindowScanner::CountAtomsOfType used to do
+   */
+  static u32 ClassicCountAtomsOfType(const TestEventWindow & ew, u32 type, u32 radius)
+  {
+    const MDist<4> & md = MDist<4>::get();
+    u32 count = 0;
+    for (u32 i = md.GetFirstIndex(1); i <= md.GetLastIndex(radius); i++)
+    {
+      if (ew.IsLiveSiteDirect(md.GetPoint(i)) &&
+          ew.GetRelativeAtomDirect(md.GetPoint(i)).GetType() == type)
+      {
+        count++;
+      }
+    }
+    return count;
+  }
+
+  void EventWindow_Test::Test_EventWindowTypeMatches()
+  {
+    TestTile tile;
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Element_Res<TestEventConfig>::THE_INSTANCE.AllocateTypeForTesting(etnm);
+    Element_Wall<TestEventConfig>::THE_INSTANCE.AllocateTypeForTesting(etnm);
+    tile.RegisterElement(Element_Res<TestEventConfig>::THE_INSTANCE);
+    tile.RegisterElement(Element_Wall<TestEventConfig>::THE_INSTANCE);
+
+    const u32 WALL_TYPE = Element_Wall<TestEventConfig>::THE_INSTANCE.GetType();
+    const u32 RES_TYPE = Element_Res<TestEventConfig>::THE_INSTANCE.GetType();
+    const u32 EMPTY_TYPE = Element_Empty<TestEventConfig>::THE_INSTANCE.GetType();
+    const MDist<4> & md = MDist<4>::get();
+
+    // Owned, gathered by offset; and reaching into the cache, with
+    // sites that aren't live
+    const SPoint centers[2] = { SPoint(15, 20), SPoint(4, 5) };
+    Random random(3);
+    for (u32 c = 0; c < 2; ++c)
+    {
+      const SPoint & center = centers[c];
+      for (u32 i = 1; i < TestEventWindow::SITE_COUNT; ++i)
+      {
+        const SPoint pt = center + md.GetPoint(i);
+        if (tile.IsLiveSite(pt) && random.OneIn(3))
+        {
+          tile.PlaceAtom(TestAtom(random.OneIn(2) ? WALL_TYPE : RES_TYPE,0,0,0), pt);
+        }
+      }
+      tile.PlaceAtom(TestAtom(WALL_TYPE,0,0,0), center);
+
+      TestEventWindow & ew = tile.GetEventWindow();
+      assert(ew.InitForEvent(center, false));
+      WindowScanner<TestEventConfig> scanner(ew);
+
+      // Behind the packed types' back, as a behavior would
+      ew.SetRelativeAtomDirect(SPoint(1, 0), TestAtom(RES_TYPE,0,0,0));
+      ew.GetAtomBitStorage(md.FromPoint(SPoint(0, -2), 4)).WriteAtom(TestAtom(WALL_TYPE,0,0,0));
+      ew.SetRelativeAtomDirect(SPoint(-1, 1), TestAtom(EMPTY_TYPE,0,0,0));
+
+      const u32 types[3] = { WALL_TYPE, RES_TYPE, EMPTY_TYPE };
+      for (u32 t = 0; t < 3; ++t)
+      {
+        for (u32 radius = 1; radius <= 4; ++radius)
+        {
+          const u32 classic = ClassicCountAtomsOfType(ew, types[t], radius);
+          assert(scanner.CountAtomsOfType(types[t], radius) == classic);
+          assert(scanner.CanSeeAtomOfType(types[t], radius) == (classic > 0));
+
+          SPoint found;
+          assert(scanner.FindRandomLocationOfType(types[t], radius, found) == classic);
+          if (classic > 0)
+          {
+            assert(md.FromPoint(found, 4) >= (s32) md.GetFirstIndex(1));
+            assert(md.FromPoint(found, 4) <= (s32) md.GetLastIndex(radius));
+            assert(ew.GetRelativeAtomDirect(found).GetType() == types[t]);
+          }
+        }
+      }
+
+      // Every match is picked, eventually
+      TestEventWindow::SiteMask matches;
+      const u32 walls = ew.MatchTypeDirect(WALL_TYPE, 1, md.GetLastIndex(4), matches);
+      for (u32 n = 0; n < walls; ++n)
+      {
+        const u32 idx = TestEventWindow::SelectSiteDirect(matches, n);
+        assert(ew.GetAtomDirect(idx).GetType() == WALL_TYPE);
+        assert(n == 0 || idx > TestEventWindow::SelectSiteDirect(matches, n - 1));
+      }
+
+      ew.StoreToTile();
+      ew.SetFree();
+    }
+  }
+
+  void EventWindow_Test::Test_RunBenchmarks()
+  {
+    TestTile tile;
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Element_Res<TestEventConfig>::THE_INSTANCE.AllocateTypeForTesting(etnm);
+    tile.RegisterElement(Element_Res<TestEventConfig>::THE_INSTANCE);
+    const u32 RES_TYPE = Element_Res<TestEventConfig>::THE_INSTANCE.GetType();
+
+    const SPoint center(15, 20);
+    const MDist<4> & md = MDist<4>::get();
+    Random random(1);
+    for (u32 i = 0; i < TestEventWindow::SITE_COUNT; ++i)
+    {
+      if (random.OneIn(4))
+      {
+        tile.PlaceAtom(TestAtom(RES_TYPE,0,0,0), center + md.GetPoint(i));
+      }
+    }
+    tile.PlaceAtom(TestAtom(RES_TYPE,0,0,0), center);  // For a full-size window
+
+    TestEventWindow & ew = tile.GetEventWindow();
+    assert(ew.InitForEvent(center, false));
+    WindowScanner<TestEventConfig> scanner(ew);
+
+    const u32 SCANS = 200000;
+    for (u32 radius = 1; radius <= 4; ++radius)
+    {
+      timespec start;
+      u32 classicSum = 0, maskSum = 0;
+
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      for (u32 i = 0; i < SCANS; ++i)
+      {
+        classicSum += ClassicCountAtomsOfType(ew, RES_TYPE, radius);
+      }
+      const u32 classicMsec = ElapsedMsec(start);
+
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      for (u32 i = 0; i < SCANS; ++i)
+      {
+        maskSum += scanner.CountAtomsOfType(RES_TYPE, radius);
+      }
+      const u32 maskMsec = ElapsedMsec(start);
+
+      assert(classicSum == maskSum);
+      LOG.Message("CountAtomsOfType R=%d, %d scans: per-site %d ms, packed types %d ms",
+                  radius, SCANS, classicMsec, maskMsec);
+    }
+    ew.SetFree();
+  }
+
 } /* namespace MFM */
@@ -0,0 +1,409 @@
+#include "assert.h"
+#include "GridSnapshot_Test.h"
+#include "GridSnapshot.h"
+#include "SnapshotWriter.h"
+#include "AbstractDriver.h"
+#include "FileByteSource.h"
+#include "Element_Res.h"
+#include "Element_Dreg.h"
+#include <stdio.h>    /* For fopen */
+#include <stdlib.h>   /* For mkstemp, free */
+#include <string.h>   /* For strrchr */
+#include <unistd.h>   /* For unlink */
+#include <time.h>     /* For clock_gettime */
+
+namespace MFM {
+
+  void GridSnapshot_Test::Test_RunTests() {
+    Test_gridSnapshotRoundTrip();
+    Test_gridSnapshotRejects();
+    Test_gridSnapshotBackgroundWrite();
+    Test_gridSnapshotDeltas();
+    Test_gridSnapshotSparseDeltas();
+  }
+
+  template <class GC>
+  struct SnapshotTestDriver : public AbstractDriver<GC>
+  {
+    SnapshotTestDriver() : AbstractDriver<GC>(1,1,GRID_LAYOUT_CHECKERBOARD) { }
+    void ReinitEden() { FAIL(ILLEGAL_STATE); }
+    void DefineNeededElements() { FAIL(ILLEGAL_STATE); }
+  };
+
+  /**
+   * A grid, with its config and grid section, populated with Dregs
+   * and whatever they make, some base atoms, and event history.
+   */
+  template <class GC>
+  struct SnapshotWorld
+  {
+    typedef typename GC::EVENT_CONFIG EC;
+    typedef typename EC::ATOM_CONFIG::ATOM_TYPE T;
+
+    ElementRegistry<EC> m_ereg;
+    Grid<GC> m_grid;
+    SnapshotTestDriver<GC> m_driver;
+    ExternalConfig<GC> m_config;
+    ExternalConfigSectionGrid<GC> m_section;
+
+    SnapshotWorld(u32 width, u32 height, u32 seed, u32 attemptsPerTile)
+      : m_grid(m_ereg, width, height, GRID_LAYOUT_CHECKERBOARD)
+      , m_config(m_driver)
+      , m_section(m_config, m_grid)
+    {
+      m_config.RegisterSection(m_section);
+      m_grid.SetSeed(seed);
+      m_grid.SetSequential(true);
+      m_grid.Init();
+      m_grid.Needed(Element_Empty<EC>::THE_INSTANCE);
+      m_grid.Needed(Element_Dreg<EC>::THE_INSTANCE);
+      m_grid.Needed(Element_Res<EC>::THE_INSTANCE);
+      m_grid.InitThreads();
+
+      Random random(seed);
+      const T dreg = Element_Dreg<EC>::THE_INSTANCE.GetDefaultAtom();
+      const T res = Element_Res<EC>::THE_INSTANCE.GetDefaultAtom();
+      for (u32 i = 0; i < 20 * width * height; ++i)
+      {
+        SPoint pt(random.Create(m_grid.GetWidthSites()), random.Create(m_grid.GetHeightSites()));
+        m_grid.PlaceAtom(dreg, pt);
+        SPoint basept(random.Create(m_grid.GetWidthSites()), random.Create(m_grid.GetHeightSites()));
+        m_grid.PlaceAtomInSite(true, res, basept);
+      }
+      m_grid.Unpause();
+      m_grid.RunSequentialEvents(attemptsPerTile);
+      m_grid.Pause();
+    }
+
+    void SaveMFS(const char * path)
+    {
+      FILE * fp = fopen(path, "w");
+      assert(fp);
+      FileByteSink fs(fp);
+      m_config.Write(fs);
+      fs.Close();
+    }
+
+    bool LoadMFS(const char * path)
+    {
+      FileByteSource fs(path);
+      assert(fs.IsOpen());
+      m_config.SetByteSource(fs, path);
+      bool ok = m_config.Read();
+      fs.Close();
+      return ok;
+    }
+  };
+
+  static void MakeTempPath(char * path)
+  {
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+  }
+
+  static bool SameFileContents(const char * a, const char * b)
+  {
+    FILE * fa = fopen(a, "r");
+    FILE * fb = fopen(b, "r");
+    assert(fa && fb);
+    bool same = true;
+    while (same)
+    {
+      int ca = fgetc(fa);
+      int cb = fgetc(fb);
+      same = ca == cb;
+      if (ca == EOF) break;
+    }
+    fclose(fa);
+    fclose(fb);
+    return same;
+  }
+
+  template <class GC>
+  static void CheckRoundTrip(u32 loadThreads)
+  {
+    char mfs1[] = "/tmp/GridSnapshot_Test-XXXXXX";
+    char mfs2[] = "/tmp/GridSnapshot_Test-XXXXXX";
+    char mfb1[] = "/tmp/GridSnapshot_Test-XXXXXX";
+    char mfb2[] = "/tmp/GridSnapshot_Test-XXXXXX";
+    MakeTempPath(mfs1);
+    MakeTempPath(mfs2);
+    MakeTempPath(mfb1);
+    MakeTempPath(mfb2);
+
+    SnapshotWorld<GC> world(3, 2, 7, 200);
+    GridSnapshot<GC> snapshot(world.m_config, world.m_section);
+    snapshot.SetLoadThreads(loadThreads);
+
+    world.SaveMFS(mfs1);
+    assert(snapshot.Save(mfb1));
+    assert(GridSnapshot<GC>::IsSnapshotFile(mfb1));
+    assert(!GridSnapshot<GC>::IsSnapshotFile(mfs1));
+
+    // Snapshot -> grid -> .mfs gives back the original .mfs
+    world.m_grid.Clear();
+    assert(snapshot.Load(mfb1));
+    world.SaveMFS(mfs2);
+    assert(SameFileContents(mfs1, mfs2));
+
+    // .mfs -> grid -> snapshot gives back the original snapshot
+    world.m_grid.Clear();
+    assert(world.LoadMFS(mfs1));
+    assert(snapshot.Save(mfb2));
+    assert(SameFileContents(mfb1, mfb2));
+
+    unlink(mfs1);
+    unlink(mfs2);
+    unlink(mfb1);
+    unlink(mfb2);
+  }
+
+  void GridSnapshot_Test::Test_gridSnapshotRoundTrip()
+  {
+    CheckRoundTrip<TestGridConfig>(1);
+    CheckRoundTrip<TestGridConfig>(4);
+    CheckRoundTrip<SoATestGridConfig>(0);
+  }
+
+  void GridSnapshot_Test::Test_gridSnapshotRejects()
+  {
+    char mfb[] = "/tmp/GridSnapshot_Test-XXXXXX";
+    char bad[] = "/tmp/GridSnapshot_Test-XXXXXX";
+    MakeTempPath(mfb);
+    MakeTempPath(bad);
+
+    SnapshotWorld<TestGridConfig> world(2, 2, 3, 10);
+    GridSnapshot<TestGridConfig> snapshot(world.m_config, world.m_section);
+    assert(snapshot.Save(mfb));
+
+    // Truncated
+    {
+      FILE * in = fopen(mfb, "r");
+      FILE * out = fopen(bad, "w");
+      assert(in && out);
+      for (u32 i = 0; i < 5000; ++i)
+      {
+        fputc(fgetc(in), out);
+      }
+      fclose(in);
+      fclose(out);
+      assert(!snapshot.Load(bad));
+    }
+
+    // Saved from a grid of a different size
+    {
+      SnapshotWorld<TestGridConfig> other(3, 2, 3, 10);
+      GridSnapshot<TestGridConfig> otherSnapshot(other.m_config, other.m_section);
+      assert(!otherSnapshot.Load(mfb));
+    }
+
+    // Not a snapshot at all
+    assert(!snapshot.Load("/dev/null"));
+
+    unlink(mfb);
+    unlink(bad);
+  }
+
+  void GridSnapshot_Test::Test_gridSnapshotBackgroundWrite()
+  {
+    char mfb1[] = "/tmp/GridSnapshot_Test-XXXXXX";
+    char mfb2[] = "/tmp/GridSnapshot_Test-XXXXXX";
+    MakeTempPath(mfb1);
+    MakeTempPath(mfb2);
+
+    SnapshotWorld<TestGridConfig> world(3, 2, 11, 50);
+    GridSnapshot<TestGridConfig> snapshot(world.m_config, world.m_section);
+    assert(snapshot.Save(mfb1));
+
+    u64 length;
+    u8 * bytes = snapshot.Capture(length);
+    assert(bytes);
+    SnapshotWriter writer;
+    writer.Write(bytes, length, mfb2);
+
+    // The grid runs on while the capture is written
+    world.m_grid.Unpause();
+    world.m_grid.RunSequentialEvents(50);
+    world.m_grid.Pause();
+
+    assert(writer.Finish());
+    assert(SameFileContents(mfb1, mfb2));
+    assert(snapshot.Load(mfb2));
+
+    unlink(mfb1);
+    unlink(mfb2);
+  }
+
+  static void WriteDelta(u8 * before, u8 * after, const char * previousPath, const char * path)
+  {
+    u64 length;
+    u8 * bytes = GridSnapshot<TestGridConfig>::Diff(before, after, strrchr(previousPath, '/') + 1, length);
+    assert(bytes);
+    assert(GridSnapshot<TestGridConfig>::WriteFile(bytes, length, path));
+    free(bytes);
+  }
+
+  void GridSnapshot_Test::Test_gridSnapshotDeltas()
+  {
+    char key[] = "/tmp/GridSnapshot_Test-XXXXXX";
+    char delta1[] = "/tmp/GridSnapshot_Test-XXXXXX";
+    char delta2[] = "/tmp/GridSnapshot_Test-XXXXXX";
+    char delta3[] = "/tmp/GridSnapshot_Test-XXXXXX";
+    char full[] = "/tmp/GridSnapshot_Test-XXXXXX";
+    char rebuilt[] = "/tmp/GridSnapshot_Test-XXXXXX";
+    MakeTempPath(key);
+    MakeTempPath(delta1);
+    MakeTempPath(delta2);
+    MakeTempPath(delta3);
+    MakeTempPath(full);
+    MakeTempPath(rebuilt);
+
+    SnapshotWorld<TestGridConfig> world(3, 2, 13, 20);
+    GridSnapshot<TestGridConfig> snapshot(world.m_config, world.m_section);
+
+    u64 length0, length1, length2, length3;
+    u8 * capture0 = snapshot.Capture(length0);
+    assert(capture0);
+    assert(GridSnapshot<TestGridConfig>::WriteFile(capture0, length0, key));
+
+    world.m_grid.Unpause();
+    world.m_grid.RunSequentialEvents(20);
+    world.m_grid.Pause();
+    u8 * capture1 = snapshot.Capture(length1);
+    WriteDelta(capture0, capture1, key, delta1);
+
+    world.m_grid.Unpause();
+    world.m_grid.RunSequentialEvents(20);
+    world.m_grid.Pause();
+    u8 * capture2 = snapshot.Capture(length2);
+    {
+      // As an async autosave writes it
+      SnapshotWriter writer;
+      writer.WriteDiff(&GridSnapshot<TestGridConfig>::Diff, capture1, capture2,
+                       strrchr(delta1, '/') + 1, delta2);
+      assert(writer.Finish());
+    }
+
+    // Nothing ran, so nothing changed
+    u8 * capture3 = snapshot.Capture(length3);
+    WriteDelta(capture2, capture3, delta2, delta3);
+    {
+      u64 length;
+      u8 * bytes = GridSnapshot<TestGridConfig>::Diff(capture2, capture3, "x", length);
+      assert(((GridSnapshot<TestGridConfig>::DeltaHeader *) bytes)->m_changeCount == 0);
+      assert(length < length3 / 4);
+      free(bytes);
+    }
+
+    // Keyframe plus deltas rebuilds the same sites.  (Their event
+    // statistics are only as of when each last changed.)
+    world.m_grid.Clear();
+    assert(GridSnapshot<TestGridConfig>::IsSnapshotFile(delta3));
+    assert(snapshot.Load(delta3));
+    {
+      u64 length, lengthLoaded;
+      u8 * loaded = snapshot.Capture(lengthLoaded);
+      assert(loaded);
+      u8 * bytes = GridSnapshot<TestGridConfig>::Diff(capture3, loaded, "x", length);
+      assert(((GridSnapshot<TestGridConfig>::DeltaHeader *) bytes)->m_changeCount == 0);
+      free(bytes);
+      free(loaded);
+    }
+
+    // And saving that gives back what loading it did
+    assert(snapshot.Save(full));
+    world.m_grid.Clear();
+    assert(snapshot.Load(full));
+    assert(snapshot.Save(rebuilt));
+    assert(SameFileContents(full, rebuilt));
+
+    // Not without the whole chain
+    unlink(delta1);
+    assert(!snapshot.Load(delta3));
+
+    free(capture0);
+    free(capture1);
+    free(capture2);
+    free(capture3);
+    unlink(key);
+    unlink(delta2);
+    unlink(delta3);
+    unlink(full);
+    unlink(rebuilt);
+  }
+
+  void GridSnapshot_Test::Test_gridSnapshotSparseDeltas()
+  {
+    typedef TestGridConfig::EVENT_CONFIG::ATOM_CONFIG::ATOM_TYPE T;
+
+    SnapshotWorld<TestGridConfig> world(3, 2, 17, 0);
+    GridSnapshot<TestGridConfig> snapshot(world.m_config, world.m_section);
+
+    // A few atoms in a big empty grid
+    world.m_grid.Clear();
+    Random random(17);
+    const T res = Element_Res<TestEventConfig>::THE_INSTANCE.GetDefaultAtom();
+    for (u32 i = 0; i < 10; ++i)
+    {
+      SPoint pt(random.Create(world.m_grid.GetWidthSites()),
+                random.Create(world.m_grid.GetHeightSites()));
+      world.m_grid.PlaceAtom(res, pt);
+    }
+
+    u64 length0, length1, length;
+    u8 * capture0 = snapshot.Capture(length0);
+    assert(capture0);
+
+    // Enough events to land on nearly every site
+    world.m_grid.Unpause();
+    world.m_grid.RunSequentialEvents(3000);
+    world.m_grid.Pause();
+    u8 * capture1 = snapshot.Capture(length1);
+    assert(capture1);
+
+    // Only the few moves are changes, not all that event history
+    u8 * bytes = GridSnapshot<TestGridConfig>::Diff(capture0, capture1, "x", length);
+    assert(bytes);
+    assert(((GridSnapshot<TestGridConfig>::DeltaHeader *) bytes)->m_changeCount <= 20);
+    assert(length < length1 / 10);
+
+    free(bytes);
+    free(capture0);
+    free(capture1);
+  }
+
+  void GridSnapshot_Test::Test_RunBenchmarks()
+  {
+    char mfs[] = "/tmp/GridSnapshot_Test-XXXXXX";
+    char mfb[] = "/tmp/GridSnapshot_Test-XXXXXX";
+    MakeTempPath(mfs);
+    MakeTempPath(mfb);
+
+    SnapshotWorld<TestGridConfig> world(8, 4, 5, 100);  // 32 tiles
+    GridSnapshot<TestGridConfig> snapshot(world.m_config, world.m_section);
+    struct timespec start;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    world.SaveMFS(mfs);
+    const u32 mfsSave = ElapsedMsec(start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    assert(world.LoadMFS(mfs));
+    const u32 mfsLoad = ElapsedMsec(start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    assert(snapshot.Save(mfb));
+    const u32 mfbSave = ElapsedMsec(start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    assert(snapshot.Load(mfb));
+    const u32 mfbLoad = ElapsedMsec(start);
+
+    LOG.Message("32 tiles: .mfs save %d ms, load %d ms; snapshot save %d ms, load %d ms",
+                mfsSave, mfsLoad, mfbSave, mfbLoad);
+
+    unlink(mfs);
+    unlink(mfb);
+  }
+} /* namespace MFM */
@@ -2,9 +2,20 @@
 #include "Grid.h"
 #include "Grid_Test.h"
 #include "Element_Res.h"
+#include "Element_Dreg.h"
+#include "Element_Wall.h"
+#include <vector>
+#include <time.h>     /* For clock_gettime */
 
 namespace MFM {
 
+  /**
+   * How long the tests below run a grid to check what it did, and how
+   * long the benchmarks run one to time it.
+   */
+  static const u32 TEST_MSEC = 20;
+  static const u32 BENCH_MSEC = 200;
+
   void Grid_Test::Test_gridPlaceAtom()
   {
 
@@ -27,4 +38,834 @@ namespace MFM {
     assert(out->GetType() == atom.GetType());
 
   }
+
+  void Grid_Test::Test_gridPauseUnpause()
+  {
+    ElementRegistry<TestEventConfig> ereg;
+    TestGrid grid(ereg,3,2, (GridLayoutPattern) GRID_LAYOUT_CHECKERBOARD);
+
+    grid.SetSeed(1);
+    grid.Init();
+    grid.InitThreads();
+
+    u64 events = 0;
+    for (u32 i = 0; i < 10; ++i)
+    {
+      grid.Unpause();
+      SleepMsec(10);
+      grid.Pause();
+
+      u64 now = grid.GetTotalEventsExecuted();
+      assert(now > events);
+      events = now;
+    }
+
+    grid.ShutdownTileThreads();
+  }
+
+  /**
+   * Pause and unpause a grid driven by the given number of pool
+   * workers (0 for a thread per tile), including pausing it while it
+   * is already paused, when no tile is advancing to acknowledge.
+   */
+  static void PauseRepeatedly(u32 workers)
+  {
+    ElementRegistry<TestEventConfig> ereg;
+    TestGrid grid(ereg,3,2, (GridLayoutPattern) GRID_LAYOUT_CHECKERBOARD);
+
+    grid.SetSeed(1);
+    grid.SetWorkerThreads(workers);
+    grid.Init();
+    grid.InitThreads();
+
+    grid.Unpause();
+    SleepMsec(10);
+    grid.Pause();
+    const u64 events = grid.GetTotalEventsExecuted();
+    assert(events > 0);
+
+    // Pausing the paused grid neither hangs nor runs events
+    grid.Pause();
+    SleepMsec(10);
+    grid.Pause();
+    assert(grid.GetTotalEventsExecuted() == events);
+
+    grid.Unpause();
+    SleepMsec(10);
+    grid.Pause();
+    assert(grid.GetTotalEventsExecuted() > events);
+
+    grid.ShutdownTileThreads();
+  }
+
+  void Grid_Test::Test_gridPauseWhilePaused()
+  {
+    PauseRepeatedly(0);
+    PauseRepeatedly(2);
+  }
+
+  void Grid_Test::Test_gridWorkerPool()
+  {
+    ElementRegistry<TestEventConfig> ereg;
+    TestGrid grid(ereg,3,2, (GridLayoutPattern) GRID_LAYOUT_CHECKERBOARD);
+
+    grid.SetSeed(1);
+    grid.SetWorkerThreads(2);
+    assert(grid.GetWorkerThreads() == 2);
+
+    grid.Init();
+    grid.InitThreads();
+
+    grid.Unpause();
+    SleepMsec(100);
+    grid.Pause();
+
+    u64 events = grid.GetTotalEventsExecuted();
+    assert(events > 0);
+
+    // Paused workers leave the tiles alone
+    SleepMsec(50);
+    assert(grid.GetTotalEventsExecuted() == events);
+
+    // Every tile is in some deque, and someone did the work
+    TestGrid::WorkerStats ws;
+    u32 tiles = 0;
+    u64 busyAdvances = 0;
+    u32 w;
+    for (w = 0; grid.GetWorkerStats(w, ws); ++w)
+    {
+      tiles += ws.m_tiles;
+      busyAdvances += ws.m_busyAdvances;
+      assert(ws.m_utilization <= 100);
+      assert(ws.m_busyAdvances + ws.m_idleAdvances > 0);
+    }
+    assert(w == 2);
+    assert(tiles == 6);
+    assert(busyAdvances > 0);
+
+    grid.ShutdownTileThreads();
+  }
+
+  void Grid_Test::Test_gridWorkerSteal()
+  {
+    ElementRegistry<TestEventConfig> ereg;
+    TestGrid grid(ereg,3,2, (GridLayoutPattern) GRID_LAYOUT_CHECKERBOARD);
+
+    TestGrid::TileWorker victim;
+    victim.Init(grid, 0, 6);
+    for (u32 i = 0; i < 4; ++i)
+    {
+      victim.PushBack(i);
+    }
+
+    // Tiles come off the front, so a worker round-robins its own
+    u32 idx;
+    assert(victim.PopFront(idx) && idx == 0);
+    victim.PushBack(idx);
+
+    // Thieves take from the front too, and only while the victim
+    // would still have at least as many tiles as they do
+    assert(!victim.StealFront(idx, 3));
+    assert(victim.StealFront(idx, 2) && idx == 1);
+    assert(victim.GetCount() == 3);
+    assert(!victim.StealFront(idx, 2));
+    assert(victim.StealFront(idx, 1) && idx == 2);
+    assert(!victim.StealFront(idx, 1));
+    assert(victim.GetCount() == 2);
+
+    // The victim's own order is unharmed
+    assert(victim.PopFront(idx) && idx == 3);
+    assert(victim.PopFront(idx) && idx == 0);
+    assert(!victim.PopFront(idx));
+  }
+
+  /**
+   * Run a sparse grid for runMsec, logging and returning its useful
+   * (non-empty center) events per second.  Sets usefulPercent to the
+   * percent of all events that were useful.
+   */
+  static u32 UsefulEventsPerSecond(bool activeSites, u32 runMsec, u32 & usefulPercent)
+  {
+    ElementRegistry<TestEventConfig> ereg;
+    TestGrid grid(ereg,2,1, (GridLayoutPattern) GRID_LAYOUT_CHECKERBOARD);
+
+    grid.SetSeed(1);
+    grid.SetWorkerThreads(1);
+    grid.SetActiveSiteSelection(activeSites, 10);
+    grid.Init();
+    grid.Needed(Element_Res<TestEventConfig>::THE_INSTANCE);
+
+    TestAtom atom(Element_Res<TestEventConfig>::THE_INSTANCE.GetDefaultAtom());
+    Random random(1);
+    for (u32 i = 0; i < 20; ++i)
+    {
+      grid.PlaceAtom(atom, SPoint(random, grid.GetWidthSites(), grid.GetHeightSites()));
+    }
+
+    grid.InitThreads();
+
+    grid.Unpause();
+    SleepMsec(runMsec);
+    grid.Pause();
+
+    const u64 events = grid.GetTotalEventsExecuted();
+    const u64 useful = grid.GetTotalUsefulEvents();
+    grid.ShutdownTileThreads();
+
+    assert(events > 0);
+    usefulPercent = (u32) (100 * useful / events);
+    u32 ueps = (u32) (useful * 1000 / runMsec);
+    LOG.Message("%s site selection: %d useful events/sec (%d%% of events)",
+                activeSites ? "Active" : "Uniform", ueps, usefulPercent);
+    return ueps;
+  }
+
+  void Grid_Test::Test_gridActiveSiteSelection()
+  {
+    u32 uniformPercent, activePercent;
+    UsefulEventsPerSecond(false, TEST_MSEC, uniformPercent);
+    UsefulEventsPerSecond(true, TEST_MSEC, activePercent);
+
+    // 20 atoms in 2*(40-8)^2 sites: almost no uniform events are useful
+    assert(uniformPercent < 10);
+    assert(activePercent > 50);
+  }
+
+  static const u32 RES_COUNT = 400;
+
+  /**
+   * Scatter RES_COUNT Res over an Init'ed grid.
+   */
+  static void PlaceRes(TestGrid & grid)
+  {
+    grid.Needed(Element_Res<TestEventConfig>::THE_INSTANCE);
+
+    TestAtom atom(Element_Res<TestEventConfig>::THE_INSTANCE.GetDefaultAtom());
+    Random random(1);
+    for (u32 placed = 0; placed < RES_COUNT; )
+    {
+      SPoint pt(random, grid.GetWidthSites(), grid.GetHeightSites());
+      if (grid.GetAtom(pt)->GetType() == atom.GetType())
+      {
+        continue;
+      }
+      grid.PlaceAtom(atom, pt);
+      ++placed;
+    }
+  }
+
+  /**
+   * Pause a running grid with no cache update left between tiles.  A
+   * bare Pause can strand an update mid-channel, so a count taken
+   * after it may miss the atom riding in that update.  Instead stop
+   * originating events, wait for every connected CacheProcessor to
+   * go idle, and only then Pause.
+   */
+  static void PauseSettled(TestGrid & grid)
+  {
+    for (TestGrid::iterator_type i = grid.begin(); i != grid.end(); ++i)
+    {
+      grid.SetTileEnabled(i.At(), false);
+    }
+
+    SleepMsec(10);  // Let events already underway ship their updates
+    for (bool idle = false; !idle; )
+    {
+      idle = true;
+      for (TestGrid::iterator_type i = grid.begin(); idle && i != grid.end(); ++i)
+      {
+        for (Dir d = Dirs::NORTH; idle && d < Dirs::DIR_COUNT; ++d)
+        {
+          const CacheProcessor<TestEventConfig> & cp = i->GetCacheProcessor(d);
+          idle = !cp.IsConnected() || cp.IsIdle();
+        }
+      }
+      if (!idle)
+      {
+        SleepMsec(1);
+      }
+    }
+    grid.Pause();
+
+    for (TestGrid::iterator_type i = grid.begin(); i != grid.end(); ++i)
+    {
+      grid.SetTileEnabled(i.At(), true);
+    }
+  }
+
+  static const u32 DREG_COUNT = 10;
+
+  /**
+   * Scatter RES_COUNT Res and DREG_COUNT Dreg over an Init'ed grid, for
+   * runs that create and destroy atoms, and return a Dreg.
+   */
+  static TestAtom PlaceResAndDreg(TestGrid & grid)
+  {
+    PlaceRes(grid);
+    grid.Needed(Element_Dreg<TestEventConfig>::THE_INSTANCE);
+    grid.Needed(Element_Wall<TestEventConfig>::THE_INSTANCE);  // Dreg asks for its type
+    TestAtom dreg(Element_Dreg<TestEventConfig>::THE_INSTANCE.GetDefaultAtom());
+    for (u32 i = 0; i < DREG_COUNT; ++i)
+    {
+      grid.PlaceAtom(dreg, SPoint(7 + 9 * i, 5 + 6 * i));
+    }
+    return dreg;
+  }
+
+  /**
+   * Copy every site of grid into sites, row by row.
+   */
+  static void CollectSites(TestGrid & grid, std::vector<TestAtom> & sites)
+  {
+    sites.clear();
+    for (s32 y = 0; y < (s32) grid.GetHeightSites(); ++y)
+    {
+      for (s32 x = 0; x < (s32) grid.GetWidthSites(); ++x)
+      {
+        SPoint pt(x, y);
+        sites.push_back(*grid.GetAtom(pt));
+      }
+    }
+  }
+
+  /**
+   * Assert that two runs ended with the same sites.
+   */
+  static void AssertSameSites(const std::vector<TestAtom> & a, const std::vector<TestAtom> & b)
+  {
+    assert(a.size() == b.size());
+    for (u32 i = 0; i < a.size(); ++i)
+    {
+      assert(a[i] == b[i]);
+    }
+  }
+
+  /**
+   * Run a grid of diffusing Res for runMsec, with cache updates
+   * exchanged either in-process or as packets, and return its events
+   * per second.  Since Diffuse only swaps, every Res that crossed a
+   * tile boundary must have arrived intact.
+   */
+  static u32 EventsPerSecondWithCaches(bool shared, u32 runMsec)
+  {
+    ElementRegistry<TestEventConfig> ereg;
+    TestGrid grid(ereg,3,2, (GridLayoutPattern) GRID_LAYOUT_CHECKERBOARD);
+
+    grid.SetSeed(1);
+    grid.SetSharedCacheChannels(shared);
+    assert(grid.IsSharedCacheChannels() == shared);
+    grid.Init();
+    PlaceRes(grid);
+    TestAtom atom(Element_Res<TestEventConfig>::THE_INSTANCE.GetDefaultAtom());
+
+    grid.InitThreads();
+
+    grid.Unpause();
+    SleepMsec(runMsec);
+    PauseSettled(grid);
+
+    const u64 events = grid.GetTotalEventsExecuted();
+    grid.RecountAtoms();
+    const u32 resCount = grid.GetAtomCount(atom.GetType());
+    for (TestGrid::iterator_type i = grid.begin(); i != grid.end(); ++i)
+    {
+      for (Dir d = Dirs::NORTH; d < Dirs::DIR_COUNT; ++d)
+      {
+        CacheProcessor<TestEventConfig> & cp = i->GetCacheProcessor(d);
+        assert(!cp.IsConnected() || cp.IsSharedChannel() == shared);
+      }
+    }
+    grid.ShutdownTileThreads();
+
+    assert(events > 0);
+    assert(resCount == RES_COUNT);
+
+    u32 eps = (u32) (events * 1000 / runMsec);
+    LOG.Message("%s cache channels: %d events/sec",
+                shared ? "Shared" : "Packet", eps);
+    return eps;
+  }
+
+  void Grid_Test::Test_gridSharedCacheChannels()
+  {
+    // Shared channels hold an update back for as long as its packets
+    // would have taken at the modeled data rate
+    typedef SharedCacheChannel<TestEventConfig> TestChannel;
+    TestChannel sc;
+    for (u32 rate = 0; rate <= 1000; rate += 1000)
+    {
+      sc.SetDataRate(rate);
+      TestChannel::SharedUpdate * su = sc.GetOutboundUpdate(true);
+      assert(su);
+      su->m_center = SPoint(0, 0);
+      su->m_count = 1; // 6 + 15 + 2 bytes: 23 msec at 1000 bytes/sec
+      sc.PostUpdate(true);
+      assert(!sc.GetOutboundUpdate(true));
+      if (rate > 0)
+      {
+        assert(!sc.GetInboundUpdate(false));
+        SleepMsec(50);
+      }
+      assert(sc.GetInboundUpdate(false));
+      sc.ReleaseUpdate(false);
+    }
+    assert(sc.GetUpdatesPosted(true) == 2);
+    assert(sc.GetSitesPosted(true) == 2);
+
+    EventsPerSecondWithCaches(false, TEST_MSEC);
+    EventsPerSecondWithCaches(true, TEST_MSEC);
+  }
+
+  /**
+   * Run a grid of diffusing Res with cache deltas offered or not, at
+   * the given cache redundancy, check no Res went missing, and return
+   * the bytes shipped per cache update in the encoding that was used.
+   */
+  static u32 CacheBytesPerUpdate(bool deltas,
+                                u32 redundancy = CacheProcessor<TestEventConfig>::ADAPTIVE)
+  {
+    ElementRegistry<TestEventConfig> ereg;
+    TestGrid grid(ereg,3,2, (GridLayoutPattern) GRID_LAYOUT_CHECKERBOARD);
+
+    grid.SetSeed(1);
+    grid.SetCacheDeltaEncoding(deltas);
+    grid.SetCacheRedundancy(redundancy);
+    grid.Init();
+    PlaceRes(grid);
+    TestAtom atom(Element_Res<TestEventConfig>::THE_INSTANCE.GetDefaultAtom());
+
+    grid.InitThreads();
+    grid.Unpause();
+    SleepMsec(200);
+    PauseSettled(grid);
+
+    grid.RecountAtoms();
+    const u32 resCount = grid.GetAtomCount(atom.GetType());
+    const u32 fullBytes = grid.GetCacheBytesPerUpdate(false);
+    const u32 deltaBytes = grid.GetCacheBytesPerUpdate(true);
+    grid.ShutdownTileThreads();
+
+    assert(resCount == RES_COUNT);
+    if (!deltas)
+    {
+      assert(fullBytes > 0);
+      assert(deltaBytes == 0);
+    }
+
+    LOG.Message("Cache deltas %s: %d bytes/update full, %d bytes/update delta",
+                deltas ? "on" : "off", fullBytes, deltaBytes);
+    return deltas ? deltaBytes : fullBytes;
+  }
+
+  void Grid_Test::Test_gridCacheDeltaEncoding()
+  {
+    const u32 fullBytes = CacheBytesPerUpdate(false);
+    const u32 deltaBytes = CacheBytesPerUpdate(true);
+    assert(deltaBytes > 0);
+    assert(deltaBytes < fullBytes);
+  }
+
+  void Grid_Test::Test_gridCacheSpotChecks()
+  {
+    // A diffusing Res touches just two sites per event, so almost all
+    // of each update is redundant checks of untouched sites, which
+    // MIN redundancy sends all of, and MAX sends one in twenty of
+    const u32 minBytes = CacheBytesPerUpdate(false, CacheProcessor<TestEventConfig>::MIN);
+    const u32 maxBytes = CacheBytesPerUpdate(false, CacheProcessor<TestEventConfig>::MAX);
+    assert(minBytes > 2 * maxBytes);
+  }
+
+  /**
+   * Return how many live cache sites, over all tiles, hold a
+   * different atom than the site they cache.
+   */
+  static u32 CountStaleCacheSites(TestGrid & grid)
+  {
+    const s32 R = TestGrid::R;
+    u32 stale = 0;
+    for (TestGrid::iterator_type i = grid.begin(); i != grid.end(); ++i)
+    {
+      const SPoint origin = i.At() * SPoint(TestGrid::OWNED_WIDTH, TestGrid::OWNED_HEIGHT);
+      for (s32 y = 0; y < (s32) i->GetTileHeight(); ++y)
+      {
+        for (s32 x = 0; x < (s32) i->GetTileWidth(); ++x)
+        {
+          SPoint pt(x, y);
+          if (!i->IsInCache(pt) || !i->IsLiveSite(pt))
+          {
+            continue;
+          }
+          SPoint gpt = origin + pt - SPoint(R, R);
+          if (!(*i->GetAtom(pt) == *grid.GetAtom(gpt)))
+          {
+            ++stale;
+          }
+        }
+      }
+    }
+    return stale;
+  }
+
+  /**
+   * Assert that every live cache site of every tile holds the same
+   * atom as the site it caches.
+   */
+  static void AssertCachesExact(TestGrid & grid)
+  {
+    assert(CountStaleCacheSites(grid) == 0);
+  }
+
+  void Grid_Test::Test_gridCacheDeltaRepair()
+  {
+    ElementRegistry<TestEventConfig> ereg;
+    TestGrid grid(ereg,3,2, (GridLayoutPattern) GRID_LAYOUT_CHECKERBOARD);
+
+    grid.SetSeed(1);
+    grid.SetCacheDeltaEncoding(true);
+    grid.SetCacheRedundancy(CacheProcessor<TestEventConfig>::MIN);  // Check every site it sees
+    grid.Init();
+    PlaceRes(grid);
+    grid.Needed(Element_Wall<TestEventConfig>::THE_INSTANCE);
+
+    grid.InitThreads();
+    grid.Unpause();
+    SleepMsec(TEST_MSEC);
+    PauseSettled(grid);
+
+    // Wall up the empty cache sites of one tile behind its neighbors' backs
+    const TestAtom wall(Element_Wall<TestEventConfig>::THE_INSTANCE.GetDefaultAtom());
+    TestGrid::iterator_type corrupted = grid.begin();
+    u32 walls = 0;
+    for (s32 y = 0; y < (s32) corrupted->GetTileHeight(); ++y)
+    {
+      for (s32 x = 0; x < (s32) corrupted->GetTileWidth(); ++x)
+      {
+        SPoint pt(x, y);
+        if (corrupted->IsInCache(pt) && corrupted->IsLiveSite(pt) &&
+            Element_Empty<TestEventConfig>::THE_INSTANCE.IsType(corrupted->GetAtom(pt)->GetType()))
+        {
+          corrupted->PlaceAtom(wall, pt);
+          ++walls;
+        }
+      }
+    }
+    assert(walls > 0);
+    assert(CountStaleCacheSites(grid) == walls);
+
+    // Sites near tile corners are seldom in a neighbor's window
+    u32 msec = 0;
+    for (; CountStaleCacheSites(grid) > 0; msec += TEST_MSEC)
+    {
+      assert(msec < 5000);
+      grid.Unpause();
+      SleepMsec(TEST_MSEC);
+      grid.Pause();
+    }
+
+    // Deltas found the walls, and whole updates repaired them
+    u64 resends = 0;
+    for (TestGrid::iterator_type i = grid.begin(); i != grid.end(); ++i)
+    {
+      for (Dir d = Dirs::NORTH; d < Dirs::DIR_COUNT; ++d)
+      {
+        CacheProcessor<TestEventConfig> & cp = i->GetCacheProcessor(d);
+        if (cp.IsConnected())
+        {
+          assert(cp.IsDeltaEncodingNegotiated());
+          resends += cp.GetWholeResends();
+        }
+      }
+    }
+    grid.ShutdownTileThreads();
+
+    assert(resends > 0);
+    LOG.Message("Delta cache repair: %d stale sites fixed in %d msec, %d whole resends",
+                walls, msec, (u32) resends);
+  }
+
+  /**
+   * Run a grid of diffusing Res for runMsec with windows event
+   * windows at once per tile, check no Res went missing or
+   * multiplied, and return the events per second.
+   */
+  static u32 EventsPerSecondWithWindows(u32 windows, u32 runMsec)
+  {
+    ElementRegistry<TestEventConfig> ereg;
+    TestGrid grid(ereg,3,2, (GridLayoutPattern) GRID_LAYOUT_CHECKERBOARD);
+
+    grid.SetSeed(1);
+    grid.SetConcurrentWindows(windows);
+    grid.Init();
+    PlaceRes(grid);
+    TestAtom atom(Element_Res<TestEventConfig>::THE_INSTANCE.GetDefaultAtom());
+
+    grid.InitThreads();
+
+    grid.Unpause();
+    SleepMsec(runMsec);
+    PauseSettled(grid);
+
+    const u64 events = grid.GetTotalEventsExecuted();
+    grid.RecountAtoms();
+    const u32 resCount = grid.GetAtomCount(atom.GetType());
+    for (TestGrid::iterator_type i = grid.begin(); i != grid.end(); ++i)
+    {
+      assert(i->GetConcurrentWindows() == windows);
+      assert((i->GetSiteClaims() != 0) == (windows > 1));
+    }
+    grid.ShutdownTileThreads();
+
+    assert(events > 0);
+    assert(resCount == RES_COUNT);
+
+    u32 eps = (u32) (events * 1000 / runMsec);
+    LOG.Message("%d concurrent windows: %d events/sec", windows, eps);
+    return eps;
+  }
+
+  void Grid_Test::Test_gridConcurrentWindows()
+  {
+    // Windows whose centers are within 2R of each other overlap
+    enum { R = TestEventConfig::EVENT_WINDOW_RADIUS };
+    SiteClaimMap<R> claims;
+    claims.Allocate(40, 40);
+    const SPoint center(20, 20);
+    assert(claims.TryClaim(center, 1, 1));
+    assert(!claims.TryClaim(center, 2, 1));
+    assert(claims.TryClaim(center, 1, SiteClaimMap<R>::SITE_COUNT));
+    assert(!claims.TryClaim(center + SPoint(2 * R, 0), 2, SiteClaimMap<R>::SITE_COUNT));
+    assert(claims.GetOwner(center + SPoint(2 * R, 0)) == SiteClaimMap<R>::UNOWNED); // Given back
+    assert(!claims.TryClaim(center + SPoint(R, R), 2, SiteClaimMap<R>::SITE_COUNT));
+    assert(claims.TryClaim(center + SPoint(2 * R + 1, 0), 2, SiteClaimMap<R>::SITE_COUNT));
+    assert(claims.GetOwner(center + SPoint(R, 0)) == 1);
+    assert(claims.GetOwner(center + SPoint(R + 1, 0)) == 2);
+    claims.Release(center, 1);
+    assert(claims.GetOwner(center) == SiteClaimMap<R>::UNOWNED);
+    assert(claims.TryClaim(center + SPoint(R, R), 3, SiteClaimMap<R>::SITE_COUNT));
+    assert(claims.GetConflicts() == 3);
+
+    EventsPerSecondWithWindows(1, TEST_MSEC);
+    EventsPerSecondWithWindows(2, TEST_MSEC);
+    EventsPerSecondWithWindows(4, TEST_MSEC);
+  }
+
+  /**
+   * Run a grid of Res and Dreg deterministically for 20 rounds, in
+   * steps of roundsPerRun, on the given number of pool workers (0 for
+   * a thread per tile), set msec to how long the rounds took, and
+   * return its sites and event count.
+   */
+  static u64 RunDeterministically(u32 workers, u32 roundsPerRun, std::vector<TestAtom> & sites,
+                                  u32 & msec)
+  {
+    ElementRegistry<TestEventConfig> ereg;
+    TestGrid grid(ereg,3,2, (GridLayoutPattern) GRID_LAYOUT_CHECKERBOARD);
+
+    grid.SetSeed(1);
+    grid.SetWorkerThreads(workers);
+    grid.SetDeterministic(500);
+    assert(grid.IsDeterministic());
+    grid.Init();
+    PlaceResAndDreg(grid);
+
+    grid.InitThreads();
+    const u32 ROUNDS = 20;
+    timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (u32 done = 0; done < ROUNDS; done += roundsPerRun)
+    {
+      grid.RunRounds(roundsPerRun);
+    }
+    msec = ElapsedMsec(start);
+    assert(grid.GetRoundsCompleted() == ROUNDS);
+
+    const u64 events = grid.GetTotalEventsExecuted();
+    CollectSites(grid, sites);
+    grid.ShutdownTileThreads();
+
+    LOG.Message("Deterministic run, %d workers, %d rounds per run: %d events in %d msec, %d usec/round",
+                workers, roundsPerRun, (u32) events, msec, 1000 * msec / ROUNDS);
+    return events;
+  }
+
+  void Grid_Test::Test_gridDeterministic()
+  {
+    std::vector<TestAtom> tileThreadSites, oneWorkerSites, fourWorkerSites;
+    u32 msec;
+    const u64 tileThreadEvents = RunDeterministically(0, 20, tileThreadSites, msec);
+    const u64 oneWorkerEvents = RunDeterministically(1, 5, oneWorkerSites, msec);
+    const u64 fourWorkerEvents = RunDeterministically(4, 10, fourWorkerSites, msec);
+
+    assert(tileThreadEvents > 0);
+    assert(tileThreadEvents == oneWorkerEvents);
+    assert(tileThreadEvents == fourWorkerEvents);
+    AssertSameSites(tileThreadSites, oneWorkerSites);
+    AssertSameSites(tileThreadSites, fourWorkerSites);
+  }
+
+  /**
+   * Run a grid of Res and Dreg sequentially for attemptsPerTile event
+   * attempts per tile, and return its sites and event count.
+   */
+  static u64 RunSequentially(u32 attemptsPerTile, std::vector<TestAtom> & sites)
+  {
+    ElementRegistry<TestEventConfig> ereg;
+    TestGrid grid(ereg,3,2, (GridLayoutPattern) GRID_LAYOUT_CHECKERBOARD);
+
+    grid.SetSeed(1);
+    grid.SetSequential(true);
+    assert(grid.IsSequential());
+    grid.Init();
+    PlaceResAndDreg(grid);
+
+    grid.InitThreads();
+    grid.Unpause();
+    const u64 events = grid.RunSequentialEvents(attemptsPerTile);
+    grid.Pause();
+    assert(events == grid.GetTotalEventsExecuted());
+
+    AssertCachesExact(grid);
+    CollectSites(grid, sites);
+    grid.ShutdownTileThreads();
+    return events;
+  }
+
+  /**
+   * Run a grid of diffusing Res sequentially for runMsec, check that
+   * no Res went missing and every cache is exact, and return the
+   * events per second.
+   */
+  static u32 EventsPerSecondSequential(u32 runMsec)
+  {
+    ElementRegistry<TestEventConfig> ereg;
+    TestGrid grid(ereg,3,2, (GridLayoutPattern) GRID_LAYOUT_CHECKERBOARD);
+
+    grid.SetSeed(1);
+    grid.SetSequential(true);
+    grid.Init();
+    PlaceRes(grid);
+    TestAtom atom(Element_Res<TestEventConfig>::THE_INSTANCE.GetDefaultAtom());
+
+    grid.InitThreads();
+
+    grid.Unpause();
+    const u64 events = grid.RunSequentialFor(runMsec * 1000);
+    grid.Pause();
+
+    grid.RecountAtoms();
+    const u32 resCount = grid.GetAtomCount(atom.GetType());
+    AssertCachesExact(grid);
+    grid.ShutdownTileThreads();
+
+    assert(events > 0);
+    assert(resCount == RES_COUNT);
+
+    u32 eps = (u32) (events * 1000 / runMsec);
+    LOG.Message("Sequential: %d events/sec on one thread", eps);
+    return eps;
+  }
+
+  void Grid_Test::Test_gridSequential()
+  {
+    EventsPerSecondSequential(TEST_MSEC);
+
+    std::vector<TestAtom> firstSites, secondSites;
+    const u64 firstEvents = RunSequentially(5000, firstSites);
+    const u64 secondEvents = RunSequentially(5000, secondSites);
+
+    assert(firstEvents > 0);
+    assert(firstEvents == secondEvents);
+    AssertSameSites(firstSites, secondSites);
+  }
+
+  /**
+   * Run Res and Dreg sequentially, or threaded with the given number
+   * of concurrent windows, checking that the incrementally kept atom
+   * counts stay exact.
+   */
+  static void CheckIncrementalCounts(bool sequential, u32 windows)
+  {
+    ElementRegistry<TestEventConfig> ereg;
+    TestGrid grid(ereg,3,2, (GridLayoutPattern) GRID_LAYOUT_CHECKERBOARD);
+
+    grid.SetSeed(3);
+    grid.SetSequential(sequential);
+    grid.SetConcurrentWindows(windows);
+    grid.Init();
+    const TestAtom dreg = PlaceResAndDreg(grid);
+
+    // The first count is a recount; the counts are incremental after that
+    assert(grid.GetAtomCount(dreg.GetType()) == DREG_COUNT);
+
+    grid.InitThreads();
+    for (u32 i = 0; i < 5; ++i)
+    {
+      grid.Unpause();
+      if (sequential)
+      {
+        grid.RunSequentialEvents(200);
+      }
+      else
+      {
+        SleepMsec(20);
+      }
+      grid.Pause();
+      assert(grid.AuditAtomCounts() == 0);
+    }
+
+    // Counting while the tiles run, with a recount pending, must not
+    // lose their changes
+    for (u32 i = 0; !sequential && i < 100; ++i)
+    {
+      grid.Unpause();
+      SleepMsec(1);
+      grid.RecountAtoms();
+      grid.GetAtomCount(dreg.GetType());
+      SleepMsec(1);
+      grid.Pause();
+      assert(grid.AuditAtomCounts() == 0);
+    }
+    assert(grid.GetTotalEventsExecuted() > 0);
+    grid.ShutdownTileThreads();
+  }
+
+  void Grid_Test::Test_gridIncrementalAtomCounts()
+  {
+    CheckIncrementalCounts(true, 1);
+    CheckIncrementalCounts(false, 1);
+    CheckIncrementalCounts(false, 4);
+  }
+
+  void Grid_Test::Test_RunBenchmarks()
+  {
+    u32 uniformPercent, activePercent;
+    const u32 uniform = UsefulEventsPerSecond(false, BENCH_MSEC, uniformPercent);
+    const u32 active = UsefulEventsPerSecond(true, BENCH_MSEC, activePercent);
+    LOG.Message("Active/uniform useful events/sec: %d%%",
+                (u32) ((u64) 100 * active / MAX(1u, uniform)));
+
+    const u32 packet = EventsPerSecondWithCaches(false, BENCH_MSEC);
+    const u32 shared = EventsPerSecondWithCaches(true, BENCH_MSEC);
+    LOG.Message("Shared/packet cache channel events/sec: %d%%",
+                (u32) ((u64) 100 * shared / packet));
+
+    const u32 one = EventsPerSecondWithWindows(1, BENCH_MSEC);
+    for (u32 windows = 2; windows <= 4; windows *= 2)
+    {
+      const u32 eps = EventsPerSecondWithWindows(windows, BENCH_MSEC);
+      LOG.Message("%d/1 concurrent window events/sec: %d%%",
+                  windows, (u32) ((u64) 100 * eps / one));
+    }
+
+    const u32 sequential = EventsPerSecondSequential(BENCH_MSEC);
+    LOG.Message("Sequential/one window events/sec: %d%%",
+                (u32) ((u64) 100 * sequential / one));
+
+    std::vector<TestAtom> sites;
+    u32 oneWorkerMsec, fourWorkerMsec;
+    RunDeterministically(1, 20, sites, oneWorkerMsec);
+    RunDeterministically(4, 20, sites, fourWorkerMsec);
+    LOG.Message("4/1 worker deterministic round time: %d%%",
+                (u32) ((u64) 100 * fourWorkerMsec / MAX(1u, oneWorkerMsec)));
+  }
 } /* namespace MFM */
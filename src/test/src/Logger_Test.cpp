@@ -2,6 +2,9 @@
 #include "Logger_Test.h"
 #include "CharBufferByteSink.h"
 #include <stdlib.h>        /* For strtol */
+#include <stdio.h>         /* For sscanf */
+#include <pthread.h>
+#include <unistd.h>        /* For usleep */
 
 namespace MFM {
   typedef CharBufferByteSink<1024> CBS1K;
@@ -79,9 +82,130 @@ namespace MFM {
     }
   }
 
+  enum { ASYNC_THREADS = 4, ASYNC_RECORDS_PER_THREAD = 100 };
+
+  static void * AsyncLogRunner(void * arg) {
+    Logger & log = *(Logger *) arg;
+    static volatile u32 nextThread = 0;
+    u32 thread = __sync_fetch_and_add(&nextThread, 1) % ASYNC_THREADS;
+    for (u32 i = 0; i < ASYNC_RECORDS_PER_THREAD; ++i) {
+      log.Message("t%d r%d", thread, i);
+    }
+    return 0;
+  }
+
+  /**
+     A ByteSink that blocks its writer until told to go on.
+   */
+  class StallingByteSink : public ByteSink {
+  public:
+    volatile bool m_entered;
+    volatile bool m_stall;
+    u32 m_lines;
+    StallingByteSink() : m_entered(false), m_stall(true), m_lines(0) { }
+    virtual void WriteBytes(const u8 * data, const u32 len) {
+      m_entered = true;
+      while (m_stall) usleep(100);
+      for (u32 i = 0; i < len; ++i)
+        if (data[i] == '\n') ++m_lines;
+    }
+    virtual s32 CanWrite() { return 1; }
+  };
+
+  /**
+     A time stamper showing each record's sequence number, and
+     whether it was logged by the thread that made the stamper.
+   */
+  class TestClock : public ByteSerializable {
+  public:
+    const Logger & m_log;
+    pthread_t m_thread;
+    TestClock(const Logger & log) : m_log(log), m_thread(pthread_self()) { }
+    virtual Result PrintTo(ByteSink & byteSink, s32 argument = 0) {
+      const Logger::StampCapture & stamp = m_log.GetStampCapture();
+      byteSink.Printf("%d%s: ", (u32) stamp.m_sequence,
+                      pthread_equal(stamp.m_thread, m_thread) ? "" : "?");
+      return SUCCESS;
+    }
+    virtual Result ReadFrom(ByteSource & byteSource, s32 argument = 0) {
+      return UNSUPPORTED;
+    }
+  };
+
+  static void Test_Async() {
+    {
+      static CharBufferByteSink<32768> abuf;
+      Logger log(abuf,Logger::MESSAGE);
+      log.SetIncludeFlags((Logger::IncludeFlags) (Logger::INCLUDE_TEXT|Logger::INCLUDE_NEWLINE));
+      assert(log.StartAsync());
+      assert(log.IsAsync());
+
+      pthread_t threads[ASYNC_THREADS];
+      for (u32 i = 0; i < ASYNC_THREADS; ++i)
+        assert(!pthread_create(&threads[i], NULL, AsyncLogRunner, &log));
+      for (u32 i = 0; i < ASYNC_THREADS; ++i)
+        assert(!pthread_join(threads[i], NULL));
+      log.StopAsync();
+      assert(!log.IsAsync());
+      assert(log.GetDroppedRecords() == 0);
+
+      // Every record, each thread's in order
+      u32 next[ASYNC_THREADS] = { 0 };
+      u32 lines = 0;
+      for (const char * p = abuf.GetZString(); *p; ++lines) {
+        u32 thread, record;
+        assert(sscanf(p, "t%u r%u", &thread, &record) == 2);
+        assert(thread < ASYNC_THREADS);
+        assert(record == next[thread]++);
+        p = strchr(p, '\n');
+        assert(p);
+        ++p;
+      }
+      assert(lines == ASYNC_THREADS * ASYNC_RECORDS_PER_THREAD);
+
+      // Synchronous again
+      abuf.Reset();
+      log.Message("done");
+      assert(!strcmp("done\n", abuf.GetZString()));
+    }
+    {
+      // Overflow a ring while the drainer is stuck in the sink
+      StallingByteSink sbs;
+      Logger log(sbs,Logger::MESSAGE);
+      log.SetIncludeFlags((Logger::IncludeFlags) (Logger::INCLUDE_TEXT|Logger::INCLUDE_NEWLINE));
+      assert(log.StartAsync());
+      log.Message("first");
+      while (!sbs.m_entered) usleep(100);
+
+      const u32 extra = 10;
+      for (u32 i = 0; i < Logger::ASYNC_RING_RECORDS + extra; ++i) {
+        log.Message("r%d", i);
+      }
+      assert(log.GetDroppedRecords() == extra + 1);  // 'first' still holds its slot
+
+      sbs.m_stall = false;
+      log.StopAsync();
+      assert(sbs.m_lines == 1 + Logger::ASYNC_RING_RECORDS - 1 + 1); // + dropped note
+    }
+    {
+      // Stamps are captured when logged, though printed when written
+      static CharBufferByteSink<256> abuf;
+      Logger log(abuf,Logger::MESSAGE);
+      TestClock clock(log);
+      log.SetIncludeFlags((Logger::IncludeFlags) (Logger::INCLUDE_TIMESTAMP|Logger::INCLUDE_TEXT|Logger::INCLUDE_NEWLINE));
+      log.SetTimeStamper(&clock);
+      assert(log.StartAsync());
+      log.Message("a");
+      log.Message("b");
+      log.StopAsync();
+      assert(!strcmp("1: a\n2: b\n", abuf.GetZString()));
+    }
+  }
+
   void Logger_Test::Test_RunTests() {
     Test_Basic();
     Test_IfLog();
+    Test_Async();
   }
 
 } /* namespace MFM */
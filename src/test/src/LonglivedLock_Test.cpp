@@ -0,0 +1,120 @@
+#include "LonglivedLock_Test.h"
+#include <assert.h>  /* For assert */
+#include <pthread.h> /* For pthread_create */
+#include "itype.h"
+
+namespace MFM {
+
+  void LonglivedLock_Test::Test_RunTests() {
+    Test_longlivedLockOwnership();
+    Test_longlivedLockCounters();
+    Test_longlivedLockContention();
+  }
+
+  void LonglivedLock_Test::Test_longlivedLockOwnership()
+  {
+    LonglivedLock lock;
+    int a, b;
+
+    assert(lock.GetOwnerIndex() == 0);
+    assert(lock.TryLock(&a));
+    assert(lock.GetOwnerIndex() == &a);
+    assert(!lock.TryLock(&b));
+    assert(lock.GetOwnerIndex() == &a);
+
+    // Relocking or unlocking by the wrong owner is an error
+    bool failed = false;
+    unwind_protect({ failed = true; },{ lock.TryLock(&a); });
+    assert(failed);
+
+    failed = false;
+    unwind_protect({ failed = true; },{ lock.Unlock(&b); });
+    assert(failed);
+    assert(lock.GetOwnerIndex() == &a);
+
+    assert(lock.Unlock(&a));
+    assert(lock.GetOwnerIndex() == 0);
+    assert(lock.TryLock(&b));
+    assert(lock.Unlock(&b));
+  }
+
+  void LonglivedLock_Test::Test_longlivedLockCounters()
+  {
+    LonglivedLock lock;
+    int a, b;
+
+    assert(lock.GetAttempts() == 0);
+    assert(lock.TryLock(&a));
+    assert(!lock.TryLock(&b));
+    assert(!lock.TryLock(&b));
+    assert(lock.Unlock(&a));
+    assert(lock.TryLock(&b));
+    assert(lock.Unlock(&b));
+
+    assert(lock.GetAttempts() == 4);
+    assert(lock.GetFailures() == 2);
+    assert(lock.GetAcquisitions() == 2);
+    assert(lock.GetHoldSamples() == 1);  // Only the first was timed
+
+    lock.ResetCounters();
+    assert(lock.GetAttempts() == 0);
+    assert(lock.GetFailures() == 0);
+    assert(lock.GetAcquisitions() == 0);
+    assert(lock.GetHoldSamples() == 0);
+    assert(lock.GetHoldNanos() == 0);
+  }
+
+  struct LonglivedLockContender
+  {
+    LonglivedLock * m_lock;
+    u32 * m_shared;
+    u32 m_wins;
+  };
+
+  static void * ContendForLock(void * arg)
+  {
+    LonglivedLockContender & c = *(LonglivedLockContender *) arg;
+    for (u32 i = 0; i < 100000; ++i)
+    {
+      if (c.m_lock->TryLock(&c))
+      {
+        // Non-atomic read-modify-write, safe only under the lock
+        *c.m_shared = *c.m_shared + 1;
+        ++c.m_wins;
+        c.m_lock->Unlock(&c);
+      }
+    }
+    return NULL;
+  }
+
+  void LonglivedLock_Test::Test_longlivedLockContention()
+  {
+    enum { THREADS = 4 };
+    LonglivedLock lock;
+    u32 shared = 0;
+    LonglivedLockContender contenders[THREADS];
+    pthread_t threads[THREADS];
+
+    for (u32 i = 0; i < THREADS; ++i)
+    {
+      contenders[i].m_lock = &lock;
+      contenders[i].m_shared = &shared;
+      contenders[i].m_wins = 0;
+      assert(!pthread_create(&threads[i], NULL, ContendForLock, &contenders[i]));
+    }
+
+    u32 wins = 0;
+    for (u32 i = 0; i < THREADS; ++i)
+    {
+      assert(!pthread_join(threads[i], NULL));
+      wins += contenders[i].m_wins;
+    }
+
+    assert(shared == wins);
+    assert(lock.GetAcquisitions() == wins);
+    assert(lock.GetAttempts() == THREADS * 100000);
+    assert(lock.GetAttempts() == wins + lock.GetFailures());
+    assert(lock.GetOwnerIndex() == 0);
+  }
+
+} /* namespace MFM */
@@ -1,12 +1,17 @@
 #include "assert.h"
 #include "Random_Test.h"
+#include "Test_Common.h"  /* For ElapsedMsec */
 #include "itype.h"
+#include "Logger.h"
+#include <time.h>     /* For clock_gettime */
 
 namespace MFM {
 
   void Random_Test::Test_RunTests() {
     Test_randomSetSeed();
     Test_randomDeterministics();
+    Test_randomFill();
+    Test_randomSplit();
   }
 
   Random & Random_Test::setup()
@@ -70,4 +75,136 @@ namespace MFM {
     }
   }
 
+  void Random_Test::Test_randomFill()
+  {
+    const u32 NUMS = 1000;
+    u32 nums[NUMS];
+
+    // Raw fills match Create() draw for draw
+    Random r1(7), r2(7);
+    r1.Fill(nums, NUMS);
+    for (u32 i = 0; i < NUMS; ++i) {
+      assert(nums[i]==r2.Create());
+    }
+
+    // Bounded fills stay in range and cover it
+    for (u32 max = 1; max < 100000; max *= 3) {
+      bool seen[3] = { false, false, false };
+      r1.Fill(nums, NUMS, max);
+      for (u32 i = 0; i < NUMS; ++i) {
+        assert(nums[i] < max);
+        if (max == 3) seen[nums[i]] = true;
+      }
+      if (max == 3) assert(seen[0] && seen[1] && seen[2]);
+    }
+
+    // And are reproducible
+    u32 again[NUMS];
+    r1.SetSeed(9);
+    r1.Fill(nums, NUMS, 1000);
+    r2.SetSeed(9);
+    r2.Fill(again, NUMS, 1000);
+    for (u32 i = 0; i < NUMS; ++i) {
+      assert(nums[i]==again[i]);
+    }
+  }
+
+  void Random_Test::Test_randomSplit()
+  {
+    const u32 STREAMS = 4;
+    const u32 NUMS = 100;
+    u32 nums[STREAMS][NUMS];
+
+    Random source(1), streams[STREAMS];
+    for (u32 s = 0; s < STREAMS; ++s) {
+      source.Split(streams[s]);
+      for (u32 i = 0; i < NUMS; ++i) {
+        nums[s][i] = streams[s].Create();
+      }
+    }
+
+    // The streams differ from each other..
+    for (u32 s = 1; s < STREAMS; ++s) {
+      u32 countSame = 0;
+      for (u32 i = 0; i < NUMS; ++i) {
+        if (nums[s][i]==nums[0][i]) ++countSame;
+      }
+      assert(countSame < NUMS);
+    }
+
+    // ..and are the same from the same seed
+    source.SetSeed(1);
+    for (u32 s = 0; s < STREAMS; ++s) {
+      Random stream;
+      source.Split(stream);
+      for (u32 i = 0; i < NUMS; ++i) {
+        assert(nums[s][i]==stream.Create());
+      }
+    }
+
+    // Jump takes a seeded Random somewhere else, reproducibly
+    Random r1(5), r2(5);
+    r1.Jump();
+    u32 countSame = 0;
+    for (u32 i = 0; i < NUMS; ++i) {
+      if (r1.Create()==r2.Create()) ++countSame;
+    }
+    assert(countSame < NUMS);
+    r1.SetSeed(5);
+    r2.SetSeed(5);
+    r1.Jump();
+    r2.Jump();
+    for (u32 i = 0; i < NUMS; ++i) {
+      assert(r1.Create()==r2.Create());
+    }
+  }
+
+  template <class GEN>
+  static u32 TimeDraws(GEN & gen, u32 draws, u32 & sum)
+  {
+    timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (u32 i = 0; i < draws; ++i) {
+      sum += (u32) gen.Next();
+    }
+    return ElapsedMsec(start);
+  }
+
+  void Random_Test::Test_RunBenchmarks()
+  {
+    const u32 DRAWS = 20000000;
+    u32 sum = 0;
+
+    RandMT mt(1);
+    Xoshiro128 xo(1);
+    const u32 mtMsec = TimeDraws(mt, DRAWS, sum);
+    const u32 xoMsec = TimeDraws(xo, DRAWS, sum);
+    LOG.Message("%d raw draws: RandMT %d ms, Xoshiro128 %d ms",
+                DRAWS, mtMsec, xoMsec);
+
+    // The mix an event's inner loop makes, through Random
+    Random random(1);
+    timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (u32 i = 0; i < DRAWS / 4; ++i) {
+      sum += random.Create(41);
+      sum += random.OneIn(3);
+      sum += random.CreateBits(5);
+      sum += (u32) random.Between(-2, 2);
+    }
+    const u32 mixMsec = ElapsedMsec(start);
+
+    const u32 FILLS = 1000;
+    u32 nums[FILLS];
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (u32 i = 0; i < DRAWS / FILLS; ++i) {
+      random.Fill(nums, FILLS, 41);
+      sum += nums[i % FILLS];
+    }
+    const u32 fillMsec = ElapsedMsec(start);
+
+    LOG.Message("%d Random draws: mixed calls %d ms, Fill(..,41) %d ms (%08x)",
+                DRAWS, mixMsec, fillMsec, sum);
+  }
+
 } /* namespace MFM */
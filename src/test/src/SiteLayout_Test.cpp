@@ -0,0 +1,238 @@
+#include "assert.h"
+#include "SiteLayout_Test.h"
+#include "Element_Res.h"
+#include "CharBufferByteSink.h"
+#include "ZStringByteSource.h"
+
+namespace MFM {
+
+  void SiteLayout_Test::Test_RunTests() {
+    Test_siteLayoutSoAAccess();
+    Test_siteLayoutSaveLoad();
+    Test_siteLayoutNoStats();
+  }
+
+  void SiteLayout_Test::Test_siteLayoutSoAAccess()
+  {
+    ElementRegistry<SoATestEventConfig> ereg;
+    SoATestGrid grid(ereg,2,2, (GridLayoutPattern) GRID_LAYOUT_CHECKERBOARD);
+
+    grid.SetSeed(1);
+    grid.Init();
+    grid.Needed(Element_Res<SoATestEventConfig>::THE_INSTANCE);
+
+    TestAtom atom(Element_Res<SoATestEventConfig>::THE_INSTANCE.GetDefaultAtom());
+    SPoint gloc(5, 10);
+    grid.PlaceAtom(atom, gloc);
+    assert(grid.GetAtom(gloc)->GetType() == atom.GetType());
+
+    // Every site reaches its own slot in the parallel arrays
+    Tile<SoATestEventConfig> & tile = grid.GetTile(SPoint(0,0));
+    SPoint a(4,4), b(5,4);
+    assert(&tile.GetSite(a).GetAtom() != &tile.GetSite(b).GetAtom());
+    assert(&tile.GetSite(a).GetAtom() + 1 == &tile.GetSite(b).GetAtom());
+    assert(tile.GetWritableAtom(a) == &tile.GetSite(a).GetAtom());
+    assert(tile.GetAtom(b) == &tile.GetSite(b).GetAtom());
+    assert(&tile.GetPlaneAtom(tile.GetSiteInTileNumber(a)) == &tile.GetSite(a).GetAtom());
+    assert(&tile.GetPlaneBase(tile.GetSiteInTileNumber(b)) == &tile.GetSite(b).GetBase());
+
+    tile.GetSite(a).RecordEventAtSite(7);
+    tile.GetSite(a).RecordEventAtSite(9);
+    assert(tile.GetSite(a).GetEventCount() == 2);
+    assert(tile.GetSite(b).GetEventCount() == 0);
+    assert(tile.GetSite(a).GetWriteAge() == 2);
+    tile.GetSite(a).MarkChanged();
+    assert(tile.GetSite(a).GetWriteAge() == 0);
+
+    tile.GetSite(b).SetPaint(0xff123456);
+    assert(tile.GetSite(b).GetPaint() == 0xff123456);
+    assert(tile.GetSite(a).GetPaint() != 0xff123456);
+  }
+
+  /**
+   * Names atom types by their type number, like an MFS file does
+   */
+  template <class GRID>
+  struct TypeNumberFormatter : public AtomTypeFormatter<P3AtomConfig>
+  {
+    GRID & m_grid;
+
+    TypeNumberFormatter(GRID & grid) : m_grid(grid) { }
+
+    virtual bool ParseAtomType(LineCountingByteSource & in, TestAtom & dest)
+    {
+      u32 type;
+      if (2 != in.Scanf("T%x", &type)) return false;
+      const Element<typename GRID::EC> * elt = m_grid.LookupElement(type);
+      if (!elt) return false;
+      dest = elt->GetDefaultAtom();
+      return true;
+    }
+
+    virtual void PrintAtomType(const TestAtom & atom, ByteSink & bs)
+    {
+      bs.Printf("T%04x", atom.GetType());
+    }
+  };
+
+  void SiteLayout_Test::Test_siteLayoutSaveLoad()
+  {
+    ElementRegistry<SoATestEventConfig> ereg;
+    SoATestGrid grid(ereg,2,2, (GridLayoutPattern) GRID_LAYOUT_CHECKERBOARD);
+
+    grid.SetSeed(1);
+    grid.Init();
+    grid.Needed(Element_Res<SoATestEventConfig>::THE_INSTANCE);
+
+    Tile<SoATestEventConfig> & tile = grid.GetTile(SPoint(0,0));
+    TypeNumberFormatter<SoATestGrid> atf(grid);
+
+    SPoint from(6,6), to(7,9);
+    TestAtom atom(Element_Res<SoATestEventConfig>::THE_INSTANCE.GetDefaultAtom());
+    tile.GetSite(from).PutAtom(atom);
+    tile.GetSite(from).RecordEventAtSite(3);
+    tile.GetSite(from).SetPaint(0xff010203);
+
+    OString512 text;
+    tile.SaveSite(from, text, atf);
+
+    ZStringByteSource zbs(text.GetZString());
+    LineCountingByteSource lcbs;
+    lcbs.SetByteSource(zbs);
+    assert(tile.LoadSite(to, lcbs, atf));
+
+    assert(tile.GetSite(to).GetAtom().GetType() == atom.GetType());
+    assert(tile.GetSite(to).GetEventCount() == 1);
+    assert(tile.GetSite(to).GetPaint() == 0xff010203);
+
+    // And the AoS layout writes the same text
+    ElementRegistry<TestEventConfig> aosreg;
+    TestGrid aosgrid(aosreg,2,2, (GridLayoutPattern) GRID_LAYOUT_CHECKERBOARD);
+    aosgrid.SetSeed(1);
+    aosgrid.Init();
+    aosgrid.Needed(Element_Res<TestEventConfig>::THE_INSTANCE);
+
+    Tile<TestEventConfig> & aostile = aosgrid.GetTile(SPoint(0,0));
+    aostile.GetSite(from).PutAtom(atom);
+    aostile.GetSite(from).RecordEventAtSite(3);
+    aostile.GetSite(from).SetPaint(0xff010203);
+
+    TypeNumberFormatter<TestGrid> aosatf(aosgrid);
+    OString512 aostext;
+    aostile.SaveSite(from, aostext, aosatf);
+    assert(aostext.Equals(text));
+  }
+
+  void SiteLayout_Test::Test_siteLayoutNoStats()
+  {
+    assert(!NoStatsTestEventConfig::SITE_STATS);
+    assert(TestEventConfig::SITE_STATS);
+    assert(sizeof(NoStatsTestSite) + 3 * sizeof(u64) <= sizeof(TestSite));
+
+    ElementRegistry<NoStatsTestEventConfig> ereg;
+    NoStatsTestGrid grid(ereg,2,2, (GridLayoutPattern) GRID_LAYOUT_CHECKERBOARD);
+
+    grid.SetSeed(1);
+    grid.Init();
+    grid.Needed(Element_Res<NoStatsTestEventConfig>::THE_INSTANCE);
+
+    Tile<NoStatsTestEventConfig> & tile = grid.GetTile(SPoint(0,0));
+    SPoint from(6,6), to(7,9);
+    TestAtom atom(Element_Res<NoStatsTestEventConfig>::THE_INSTANCE.GetDefaultAtom());
+    tile.GetSite(from).PutAtom(atom);
+    tile.GetSite(from).RecordEventAtSite(3);
+    tile.GetSite(from).Sense(TOUCH_TYPE_HEAVY);
+    assert(tile.GetSite(from).GetEventCount() == 0);
+    assert(tile.GetSite(from).GetWriteAge() == 0);
+    assert(tile.GetSite(from).RecentTouch() == TOUCH_TYPE_NONE);
+
+    // Saves still load, with the statistics read as zero
+    TypeNumberFormatter<NoStatsTestGrid> atf(grid);
+    OString512 text;
+    tile.SaveSite(from, text, atf);
+
+    ZStringByteSource zbs(text.GetZString());
+    LineCountingByteSource lcbs;
+    lcbs.SetByteSource(zbs);
+    assert(tile.LoadSite(to, lcbs, atf));
+    assert(tile.GetSite(to).GetAtom().GetType() == atom.GetType());
+    assert(tile.GetSite(to).GetEventCount() == 0);
+
+    // And the grid runs events without them
+    grid.PlaceAtom(atom, SPoint(20, 20));
+    grid.SetWorkerThreads(1);
+    grid.InitThreads();
+    grid.Unpause();
+    SleepMsec(100);
+    grid.Pause();
+    assert(grid.GetTotalEventsExecuted() > 0);
+    grid.ShutdownTileThreads();
+
+    // A statless SoA tile keeps no statistics array at all
+    assert(sizeof(SiteStorage<NoStatsSoATestSite, 100>) + 100 * 3 * sizeof(u64)
+           <= sizeof(SiteStorage<SoATestSite, 100>));
+  }
+
+  template <class GRID>
+  static u32 EventsPerSecond(GRID & grid, Element<typename GRID::EC> & res, const char * label)
+  {
+    grid.SetSeed(1);
+    grid.SetWorkerThreads(1);
+    grid.Init();
+    grid.Needed(res);
+
+    // A quarter-full world, so events do some real work
+    TestAtom atom(res.GetDefaultAtom());
+    Random random(1);
+    for (u32 x = 0; x < grid.GetWidthSites(); ++x)
+    {
+      for (u32 y = 0; y < grid.GetHeightSites(); ++y)
+      {
+        if (random.OneIn(4))
+        {
+          grid.PlaceAtom(atom, SPoint(x, y));
+        }
+      }
+    }
+
+    grid.InitThreads();
+
+    const u32 RUN_MSEC = 300;
+    grid.Unpause();
+    SleepMsec(RUN_MSEC);
+    grid.Pause();
+
+    u64 events = grid.GetTotalEventsExecuted();
+    grid.ShutdownTileThreads();
+
+    u32 eps = (u32) (events * 1000 / RUN_MSEC);
+    LOG.Message("%s site layout, R=%d: %d events/sec", label, GRID::R, eps);
+    return eps;
+  }
+
+  void SiteLayout_Test::Test_RunBenchmarks()
+  {
+    u32 aos, soa;
+    {
+      ElementRegistry<TestEventConfig> ereg;
+      TestGrid grid(ereg,2,2, (GridLayoutPattern) GRID_LAYOUT_CHECKERBOARD);
+      aos = EventsPerSecond(grid, Element_Res<TestEventConfig>::THE_INSTANCE, "AoS");
+    }
+    {
+      ElementRegistry<SoATestEventConfig> ereg;
+      SoATestGrid grid(ereg,2,2, (GridLayoutPattern) GRID_LAYOUT_CHECKERBOARD);
+      soa = EventsPerSecond(grid, Element_Res<SoATestEventConfig>::THE_INSTANCE, "SoA");
+    }
+    u32 nostats;
+    {
+      ElementRegistry<NoStatsTestEventConfig> ereg;
+      NoStatsTestGrid grid(ereg,2,2, (GridLayoutPattern) GRID_LAYOUT_CHECKERBOARD);
+      nostats = EventsPerSecond(grid, Element_Res<NoStatsTestEventConfig>::THE_INSTANCE,
+                                "Statsless AoS");
+    }
+    assert(aos > 0 && soa > 0 && nostats > 0);
+    LOG.Message("SoA/AoS events/sec: %d%%", (u32) ((u64) 100 * soa / aos));
+    LOG.Message("No stats/AoS events/sec: %d%%", (u32) ((u64) 100 * nostats / aos));
+  }
+
+} /* namespace MFM */
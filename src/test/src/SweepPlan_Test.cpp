@@ -0,0 +1,111 @@
+#include "assert.h"
+#include "SweepPlan_Test.h"
+#include "SweepPlan.h"
+#include <stdio.h>   /* for fopen */
+#include <stdlib.h>  /* for mkstemp */
+#include <string.h>  /* for strcmp */
+#include <unistd.h>  /* for close, unlink */
+
+namespace MFM {
+
+  void SweepPlan_Test::Test_RunTests() {
+    Test_sweepPlanParseRun();
+    Test_sweepPlanParseErrors();
+    Test_sweepPlanReadFile();
+  }
+
+  void SweepPlan_Test::Test_sweepPlanParseRun()
+  {
+    SweepRun run;
+    const char * error = 0;
+
+    assert(SweepPlan::ParseRun("17", run, error));
+    assert(run.m_seed == 17);
+    assert(run.m_settingCount == 0);
+    assert(!strcmp(run.m_label, ""));
+
+    assert(SweepPlan::ParseRun("  3\tDm.pDIFFUSION=0.5   2:-40 ", run, error));
+    assert(run.m_seed == 3);
+    assert(run.m_settingCount == 2);
+    assert(!strcmp(run.m_label, "Dm.pDIFFUSION=0.5 2:-40"));
+
+    const SweepSetting & e = run.m_settings[0];
+    assert(!e.m_isTileParameter);
+    assert(!strcmp(e.m_symbol, "Dm"));
+    assert(!strcmp(e.m_tag, "pDIFFUSION"));
+    assert(!strcmp(e.m_text, "0.5"));
+
+    const SweepSetting & t = run.m_settings[1];
+    assert(t.m_isTileParameter);
+    assert(t.m_key == 2);
+    assert(t.m_value == -40);
+  }
+
+  void SweepPlan_Test::Test_sweepPlanParseErrors()
+  {
+    SweepRun run;
+    const char * error = 0;
+
+    assert(!SweepPlan::ParseRun("", run, error));
+    assert(!SweepPlan::ParseRun("0 1:2", run, error));        // Zero seed
+    assert(!SweepPlan::ParseRun("x1 1:2", run, error));
+    assert(!SweepPlan::ParseRun("1x 1:2", run, error));
+    assert(!SweepPlan::ParseRun("1 1:", run, error));
+    assert(!SweepPlan::ParseRun("1 :2", run, error));
+    assert(!SweepPlan::ParseRun("1 1:2x", run, error));
+    assert(!SweepPlan::ParseRun("1 pDIFFUSION=3", run, error));  // No symbol
+    assert(!SweepPlan::ParseRun("1 Dmx.pDIFFUSION=3", run, error));
+    assert(!SweepPlan::ParseRun("1 Dm.=3", run, error));
+    assert(!SweepPlan::ParseRun("1 Dm.pDIFFUSION=", run, error));
+    assert(!SweepPlan::ParseRun("1 Dm.pDIFFUSION=\"3\"", run, error));
+    assert(!SweepPlan::ParseRun("1 Dm.pPAIR=1,2", run, error));
+    assert(!SweepPlan::ParseRun("1 bogus", run, error));
+
+    error = 0;
+    assert(!SweepPlan::ParseRun("1 0:0 0:0 0:0 0:0 0:0 0:0 0:0 0:0 "
+                                "0:0 0:0 0:0 0:0 0:0 0:0 0:0 0:0 0:0", run, error));
+    assert(error && !strcmp(error, "Too many settings"));
+  }
+
+  void SweepPlan_Test::Test_sweepPlanReadFile()
+  {
+    char path[] = "/tmp/SweepPlan_Test-XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+
+    FILE * file = fopen(path, "w");
+    assert(file);
+    fprintf(file, "# seed settings\n\n");
+    for (u32 i = 1; i <= 40; ++i)
+    {
+      fprintf(file, "%u 0:%u\n", i, 2 * i);
+    }
+    fprintf(file, "  # indented comment\n41\n");
+    fclose(file);
+
+    SweepPlan plan;
+    assert(plan.ReadFile(path));
+    assert(plan.GetRunCount() == 41);
+    for (u32 i = 0; i < 40; ++i)
+    {
+      const SweepRun & run = plan.GetRun(i);
+      assert(run.m_seed == i + 1);
+      assert(run.m_settingCount == 1);
+      assert(run.m_settings[0].m_value == (s32) (2 * (i + 1)));
+    }
+    assert(plan.GetRun(40).m_seed == 41);
+    assert(plan.GetRun(40).m_settingCount == 0);
+
+    file = fopen(path, "a");
+    assert(file);
+    fprintf(file, "42 nonsense\n");
+    fclose(file);
+
+    SweepPlan bad;
+    assert(!bad.ReadFile(path));
+
+    unlink(path);
+    assert(!bad.ReadFile(path));
+  }
+} /* namespace MFM */
@@ -1 +1,13 @@
 #include "Test_Common.h"
+
+namespace MFM {
+
+  u32 ElapsedMsec(const timespec & start)
+  {
+    timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (u32) ((end.tv_sec - start.tv_sec) * 1000 +
+                  (end.tv_nsec - start.tv_nsec) / 1000000);
+  }
+
+} /* namespace MFM */
@@ -9,6 +9,7 @@ namespace MFM {
   void Tile_Test::Test_RunTests() {
     Test_tileSquareDistances();
     Test_tilePlaceAtom();
+    Test_tileActiveSiteSelection();
   }
 
   void Tile_Test::Test_tileSquareDistances()
@@ -58,4 +59,52 @@ namespace MFM {
 
     assert(other.GetType() == atom.GetType());
   }
+  void Tile_Test::Test_tileActiveSiteSelection()
+  {
+    TestTile tile;
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Element_Res<TestEventConfig>::THE_INSTANCE.AllocateTypeForTesting(etnm);
+    tile.RegisterElement(Element_Res<TestEventConfig>::THE_INSTANCE);
+    const TestAtom res(Element_Res<TestEventConfig>::THE_INSTANCE.GetDefaultAtom());
+
+    SPoint a(10, 12), b(20, 7);
+    tile.PlaceAtom(res, a);
+
+    // Atoms placed before enabling are found by the rebuild
+    tile.SetActiveSiteSelection(true, 0);
+    assert(tile.GetActiveSiteCount() == 1);
+    for (u32 i = 0; i < 100; ++i)
+    {
+      assert(tile.GetEventCenterCoord() == a);
+    }
+
+    // And later placements update the set as they happen
+    tile.PlaceAtom(res, b);
+    tile.PlaceAtom(tile.GetEmptyAtom(), a);
+    assert(tile.GetActiveSiteCount() == 1);
+    for (u32 i = 0; i < 100; ++i)
+    {
+      assert(tile.GetEventCenterCoord() == b);
+    }
+
+    // Cache sites are never event centers
+    tile.PlaceAtom(res, SPoint(1, 1));
+    assert(tile.GetActiveSiteCount() == 1);
+
+    // With no active sites, fall back to uniform
+    tile.PlaceAtom(tile.GetEmptyAtom(), b);
+    assert(tile.GetActiveSiteCount() == 0);
+    bool sawOther = false;
+    for (u32 i = 0; i < 100; ++i)
+    {
+      SPoint pt = tile.GetEventCenterCoord();
+      assert(tile.IsOwnedSite(pt));
+      sawOther |= (pt != b);
+    }
+    assert(sawOther);
+
+    tile.SetActiveSiteSelection(false, 100);
+    assert(tile.GetActiveSiteCount() == 0);
+  }
+
 } /* namespace MFM */
@@ -0,0 +1,367 @@
+#include "assert.h"
+#include "UlamClassRegistry_Test.h"
+#include "UlamClassRegistry.h"
+#include "UlamClass.h"
+#include "UlamRef.h"
+#include "UlamContextRestricted.h"
+#include "Logger.h"
+#include <stdio.h>    /* For snprintf */
+#include <time.h>     /* For clock_gettime */
+
+namespace MFM {
+
+  static void TestVirtualFunction() { }
+
+  /**
+     A bare ulam class: a mangled name, a registration number, a
+     vtable whose every entry is TestVirtualFunction, overridden by
+     the class m_override, and, like culam's, a table of base
+     classes to search: class n derives from n-1..n-BASES+1, each
+     8 bits further along.
+   */
+  class TestUlamClass : public UlamClass<TestEventConfig>
+  {
+    char m_mangled[32];
+    u32 m_regnum;
+    const UlamClass<TestEventConfig> * m_override;
+
+  public:
+    static u32 s_vtableLookups;
+
+    TestUlamClass() : m_regnum(0), m_override(0) { m_mangled[0] = '\0'; }
+
+    void Init(u32 regnum)
+    {
+      m_regnum = regnum;
+      m_override = this;
+      snprintf(m_mangled, sizeof(m_mangled), "Uq_10108Class%03d10", regnum);
+    }
+
+    void SetOverride(const UlamClass<TestEventConfig> * override)
+    {
+      m_override = override;
+    }
+
+    virtual const char * GetMangledClassName() const { return m_mangled; }
+    virtual u32 GetMangledClassNameAsStringIndex() const { return 0; }
+    virtual u32 GetUlamClassNameAsStringIndex(bool, bool) const { return 0; }
+    virtual u32 GetRegistrationNumber() const { return m_regnum; }
+
+    virtual u32 GetVTStartOffsetForClassByRegNum(u32 rn) const
+    {
+      ++s_vtableLookups;
+      return rn;
+    }
+
+    virtual VfuncPtr getVTableEntry(u32 idx) const
+    {
+      return &TestVirtualFunction;
+    }
+
+    virtual const UlamClass<TestEventConfig> * getVTableEntryUlamClassPtr(u32 idx) const
+    {
+      return m_override;
+    }
+
+    enum { BASES = 6 };
+
+    virtual bool internalCMethodImplementingIs(const u32 regid) const
+    {
+      return internalCMethodImplementingGetRelativePositionOfBaseClass(regid) >= 0;
+    }
+
+    virtual bool internalCMethodImplementingIs(const UlamClass<TestEventConfig> * cptrarg) const
+    {
+      return internalCMethodImplementingIs(cptrarg->GetRegistrationNumber());
+    }
+
+    virtual s32 internalCMethodImplementingGetRelativePositionOfBaseClass(const u32 regid) const
+    {
+      for (u32 i = 0; i < BASES; ++i)
+      {
+        if (m_regnum == regid + i) return (s32) (8 * i);
+      }
+      return -1;
+    }
+
+    virtual s32 internalCMethodImplementingGetRelativePositionOfBaseClass(const UlamClass<TestEventConfig> * cptrarg) const
+    {
+      return internalCMethodImplementingGetRelativePositionOfBaseClass(cptrarg->GetRegistrationNumber());
+    }
+
+    virtual u32 GetClassLength() const { return 64; }
+
+    virtual u32 GetClassDataMembersSize() const { return 16; }
+  };
+
+  u32 TestUlamClass::s_vtableLookups = 0;
+
+  typedef UlamClassRegistry<TestEventConfig> TestUlamClassRegistry;
+
+  enum { CLASS_COUNT = 400 };
+
+  static TestUlamClass testClasses[CLASS_COUNT];
+
+  static void RegisterTestClasses(TestUlamClassRegistry & ucr)
+  {
+    // Registering out of order, as libraries may
+    for (u32 i = 0; i < CLASS_COUNT; ++i)
+    {
+      const u32 regnum = (i * 7) % CLASS_COUNT;
+      testClasses[regnum].Init(regnum);
+      assert(ucr.RegisterUlamClass(testClasses[regnum]));
+    }
+  }
+
+  void UlamClassRegistry_Test::Test_RunTests()
+  {
+    Test_ulamClassRegistryLookup();
+    Test_ulamVTableCache();
+    Test_ulamVTableCacheCalls();
+  }
+
+  void UlamClassRegistry_Test::Test_RunBenchmarks()
+  {
+    Test_ulamClassRegistryBenchmark();
+    Test_ulamVTableCacheBenchmark();
+  }
+
+  void UlamClassRegistry_Test::Test_ulamClassRegistryLookup()
+  {
+    TestUlamClassRegistry * ucr = new TestUlamClassRegistry();
+    RegisterTestClasses(*ucr);
+
+    for (u32 i = 0; i < CLASS_COUNT; ++i)
+    {
+      const char * mangled = testClasses[i].GetMangledClassName();
+      assert(ucr->GetUlamClassIndex(mangled) == (s32) i);
+      assert(ucr->GetUlamClassByMangledName(mangled) == &testClasses[i]);
+      assert(ucr->IsRegisteredUlamClass(mangled));
+    }
+
+    // Registering again changes nothing
+    assert(!ucr->RegisterUlamClass(testClasses[5]));
+    assert(ucr->GetUlamClassIndex(testClasses[5].GetMangledClassName()) == 5);
+
+    // Arrays of a class find the class
+    assert(ucr->GetUlamClassIndex("Uq_13108Class01210") == 12);
+
+    // Unregistered names, and arrays of them, don't
+    assert(ucr->GetUlamClassIndex("Uq_10108Class99910") == -1);
+    assert(ucr->GetUlamClassIndex("Uq_13108Class99910") == -1);
+    assert(ucr->GetUlamClassIndex("Uq_10104Fail10") == -1);
+    assert(!ucr->IsRegisteredUlamClass("Ut_102321i"));
+    assert(ucr->GetUlamClassByMangledName("Uq_10104Fail10") == 0);
+
+    // Copies, as each tile takes from the hero tile, find them too
+    TestUlamClassRegistry * copy = new TestUlamClassRegistry();
+    *copy = *ucr;
+    assert(copy->GetUlamClassIndex(testClasses[CLASS_COUNT - 1].GetMangledClassName())
+           == CLASS_COUNT - 1);
+
+    delete copy;
+    delete ucr;
+  }
+
+  /**
+     GetUlamClassIndex as it was: parse the name, then compare it
+     with each registered class in turn.
+   */
+  static s32 ClassicGetUlamClassIndex(const TestUlamClassRegistry & ucr, const char * mangledName)
+  {
+    UlamTypeInfo uti;
+    OString512 scalarName;
+    if (!uti.InitFrom(mangledName))
+      FAIL(ILLEGAL_ARGUMENT);
+    if (uti.GetArrayLength() > 0)
+    {
+      uti.MakeScalar();
+      uti.PrintMangled(scalarName);
+      mangledName = scalarName.GetZString();
+    }
+    for (u32 i = 0; i < ucr.m_registeredUlamClassCount; ++i)
+    {
+      UlamClass<TestEventConfig> * uc = ucr.m_registeredUlamClasses[i];
+      if (uc && !strcmp(uc->GetMangledClassName(), mangledName))
+        return (s32) i;
+    }
+    return -1;
+  }
+
+  void UlamClassRegistry_Test::Test_ulamClassRegistryBenchmark()
+  {
+    TestUlamClassRegistry * ucr = new TestUlamClassRegistry();
+    RegisterTestClasses(*ucr);
+
+    // Each class looked up ROUNDS times, as a large .mfs load might
+    const u32 ROUNDS = 100;
+    timespec start;
+    s32 classicSum = 0, hashedSum = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (u32 r = 0; r < ROUNDS; ++r)
+    {
+      for (u32 i = 0; i < CLASS_COUNT; ++i)
+      {
+        classicSum += ClassicGetUlamClassIndex(*ucr, testClasses[i].GetMangledClassName());
+      }
+    }
+    const u32 classicMsec = ElapsedMsec(start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (u32 r = 0; r < ROUNDS; ++r)
+    {
+      for (u32 i = 0; i < CLASS_COUNT; ++i)
+      {
+        hashedSum += ucr->GetUlamClassIndex(testClasses[i].GetMangledClassName());
+      }
+    }
+    const u32 hashedMsec = ElapsedMsec(start);
+
+    assert(classicSum == hashedSum);
+    LOG.Message("GetUlamClassIndex, %d classes x %d: linear %d ms, hashed %d ms",
+                CLASS_COUNT, ROUNDS, classicMsec, hashedMsec);
+    delete ucr;
+  }
+
+  void UlamClassRegistry_Test::Test_ulamVTableCache()
+  {
+    typedef UlamVTableCache<TestEventConfig> Cache;
+
+    TestUlamClassRegistry * ucr = new TestUlamClassRegistry();
+    RegisterTestClasses(*ucr);
+    testClasses[3].SetOverride(&testClasses[2]);
+    Cache & cache = ucr->GetVTableCache();
+    cache.ResetCounts();
+
+    // The first resolution asks the vtable; the rest don't
+    VfuncPtr vfunc = 0;
+    TestUlamClass::s_vtableLookups = 0;
+    for (u32 i = 0; i < 10; ++i)
+    {
+      assert(ucr->ResolveVTableSlot(3, 7, 1, vfunc) == &testClasses[2]);
+      assert(vfunc == &TestVirtualFunction);
+    }
+    assert(TestUlamClass::s_vtableLookups == 1);
+    assert(cache.GetHits() == 9);
+    assert(cache.GetMisses() == 1);
+
+    // Calls from an effective self are cached apart from bare slots
+    Cache::Resolution res;
+    assert(!cache.Find(5, 3, 7, 1, res));
+    res.m_vfunc = &TestVirtualFunction;
+    res.m_ovclass = &testClasses[2];
+    res.m_ovclassrelpos = 12;
+    res.m_ovclasslen = 34;
+    res.m_ovclassIsElement = false;
+    cache.Insert(5, 3, 7, 1, res);
+
+    Cache::Resolution found;
+    assert(cache.Find(5, 3, 7, 1, found));
+    assert(found.m_ovclass == &testClasses[2]);
+    assert(found.m_ovclassrelpos == 12);
+    assert(found.m_ovclasslen == 34);
+    assert(!cache.Find(5, 3, 7, 2, found));
+    assert(!cache.Find(6, 3, 7, 1, found));
+
+    // Keys too large to pack are never cached
+    cache.Insert(5, 3, 7, 0x10000, res);
+    assert(!cache.Find(5, 3, 7, 0x10000, found));
+
+    // Registering a class forgets everything
+    TestUlamClass extra;
+    extra.Init(CLASS_COUNT);
+    assert(ucr->RegisterUlamClass(extra));
+    assert(!cache.Find(5, 3, 7, 1, found));
+    TestUlamClass::s_vtableLookups = 0;
+    assert(ucr->ResolveVTableSlot(3, 7, 1, vfunc) == &testClasses[2]);
+    assert(TestUlamClass::s_vtableLookups == 1);
+
+    testClasses[3].SetOverride(&testClasses[3]);
+    delete ucr;
+  }
+
+  /**
+     Make count virtual calls of function 1, declared by class 11 and
+     overridden by class 12 in the vtable of class 13, from an
+     effective self of class 15, returning the sum of their
+     positions.
+   */
+  static u32 MakeVirtualCalls(const UlamContext<TestEventConfig> & uc, u32 count)
+  {
+    TestAtom atom;
+    AtomBitStorage<TestEventConfig> stg(atom);
+    UlamRef<TestEventConfig> self(0, 64, stg, &testClasses[15], UlamRef<TestEventConfig>::CLASSIC, uc);
+    u32 sum = 0;
+    for (u32 i = 0; i < count; ++i)
+    {
+      VfuncPtr vfunc = 0;
+      UlamRef<TestEventConfig> call(self, &testClasses[13], 1, 11, vfunc);
+      assert(vfunc == &TestVirtualFunction);
+      sum += call.GetPos() + call.GetLen();
+    }
+    return sum;
+  }
+
+  void UlamClassRegistry_Test::Test_ulamVTableCacheCalls()
+  {
+    TestUlamClassRegistry * ucr = new TestUlamClassRegistry();
+    RegisterTestClasses(*ucr);
+    testClasses[13].SetOverride(&testClasses[12]);
+
+    ElementTable<TestEventConfig> et;
+    UlamContext<TestEventConfig> uncached(et);             // Has no registry, so no cache
+    UlamContextRestricted<TestEventConfig> cached(et, *ucr);
+
+    // Class 12 is 3 bases along from class 15, with 16 bits of data members
+    assert(MakeVirtualCalls(uncached, 1) == 3 * 8 + 16);
+    assert(MakeVirtualCalls(cached, 1) == 3 * 8 + 16);
+
+    // After the first call, the cache answers every one
+    UlamVTableCache<TestEventConfig> & cache = ucr->GetVTableCache();
+    cache.ResetCounts();
+    assert(MakeVirtualCalls(cached, 100) == 100 * (3 * 8 + 16));
+    assert(cache.GetMisses() == 0);
+    assert(cache.GetHits() >= 100);
+
+    testClasses[13].SetOverride(&testClasses[13]);
+    delete ucr;
+  }
+
+  void UlamClassRegistry_Test::Test_ulamVTableCacheBenchmark()
+  {
+    TestUlamClassRegistry * ucr = new TestUlamClassRegistry();
+    RegisterTestClasses(*ucr);
+    testClasses[13].SetOverride(&testClasses[12]);
+
+    ElementTable<TestEventConfig> et;
+    UlamContext<TestEventConfig> uncached(et);             // Has no registry, so no cache
+    UlamContextRestricted<TestEventConfig> cached(et, *ucr);
+
+    // Class 12 is 3 bases along from class 15, with 16 bits of data members
+    assert(MakeVirtualCalls(uncached, 1) == 3 * 8 + 16);
+    assert(MakeVirtualCalls(cached, 1) == 3 * 8 + 16);
+
+    const u32 CALLS = 10000000;
+    timespec start;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    const u32 uncachedSum = MakeVirtualCalls(uncached, CALLS);
+    const u32 uncachedMsec = ElapsedMsec(start);
+
+    UlamVTableCache<TestEventConfig> & cache = ucr->GetVTableCache();
+    cache.ResetCounts();
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    const u32 cachedSum = MakeVirtualCalls(cached, CALLS);
+    const u32 cachedMsec = ElapsedMsec(start);
+
+    assert(uncachedSum == cachedSum);
+    assert(cache.GetMisses() == 0);
+    LOG.Message("%d ulam virtual calls resolved: uncached %d ms, cached %d ms",
+                CALLS, uncachedMsec, cachedMsec);
+
+    testClasses[13].SetOverride(&testClasses[13]);
+    delete ucr;
+  }
+
+} /* namespace MFM */